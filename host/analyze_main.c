@@ -0,0 +1,493 @@
+// Offline analyzer: run the sniffer analytics over pcap files on a pool of threads
+#include "pcap_reader.h"
+#include "ieee80211.h"
+#include "airtime.h"
+#include "seq_tracker.h"
+#include "traffic_stats.h"
+#include "assoc_graph.h"
+#include "rate_stats.h"
+#include "rogue_ap.h"
+#include "hll.h"
+#include "frame_format.h"
+#include <getopt.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define ANALYZE_MAX_THREADS          64
+#define ANALYZE_DEFAULT_TOP          10
+
+/**
+ * @brief Totals of one channel
+ */
+typedef struct {
+    uint64_t frames;
+    uint64_t bytes;
+    uint64_t airtime_us;
+    hll_t devices;               // Distinct transmitters
+} channel_totals_t;
+
+/**
+ * @brief Aggregation state of one worker; every part of it can be merged
+ */
+typedef struct {
+    seq_tracker_t seq;
+    traffic_stats_t traffic;
+    assoc_graph_t assoc;
+    rate_stats_t rates;
+    rogue_ap_t aps;
+    hll_t devices;
+    channel_totals_t channels[256];          // Indexed by channel number
+    uint64_t subtypes[4][16];                // Indexed by type and subtype
+
+    uint32_t files;
+    uint64_t file_bytes;
+    uint64_t records;
+    uint64_t skipped;            // Records without a usable frame
+    uint64_t malformed;          // Frames the MAC header parser rejected
+    uint64_t frames;
+    uint64_t duplicates;
+    uint64_t bytes;
+    uint64_t capture_us;         // Sum of the time spans of the files
+} analysis_t;
+
+typedef struct {
+    pthread_t thread;
+    analysis_t *analysis;
+    seq_tracker_t *file_seq;     // Sequence state of the file being read
+} worker_t;
+
+typedef struct {
+    const char *path;
+    off_t size;
+} input_file_t;
+
+// Work queue: files are handed out largest first
+static input_file_t *inputs;
+static int input_count;
+static atomic_int next_input;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void analysis_init(analysis_t *a) {
+    memset(a, 0, sizeof(*a));
+    seq_tracker_init(&a->seq);
+    traffic_stats_init(&a->traffic);
+    assoc_graph_init(&a->assoc);
+    rate_stats_init(&a->rates);
+    rogue_ap_init(&a->aps);
+}
+
+// Fold the results of src into dst
+static void analysis_merge(analysis_t *dst, const analysis_t *src) {
+    seq_tracker_merge(&dst->seq, &src->seq);
+    traffic_stats_merge(&dst->traffic, &src->traffic);
+    assoc_graph_merge(&dst->assoc, &src->assoc);
+    rate_stats_merge(&dst->rates, &src->rates);
+    rogue_ap_merge(&dst->aps, &src->aps);
+    hll_merge(&dst->devices, &src->devices);
+
+    for (int ch = 0; ch < 256; ch++) {
+        const channel_totals_t *in = &src->channels[ch];
+        if (!in->frames) continue;
+        dst->channels[ch].frames += in->frames;
+        dst->channels[ch].bytes += in->bytes;
+        dst->channels[ch].airtime_us += in->airtime_us;
+        hll_merge(&dst->channels[ch].devices, &in->devices);
+    }
+    for (int t = 0; t < 4; t++) {
+        for (int s = 0; s < 16; s++) {
+            dst->subtypes[t][s] += src->subtypes[t][s];
+        }
+    }
+
+    dst->files += src->files;
+    dst->file_bytes += src->file_bytes;
+    dst->records += src->records;
+    dst->skipped += src->skipped;
+    dst->malformed += src->malformed;
+    dst->frames += src->frames;
+    dst->duplicates += src->duplicates;
+    dst->bytes += src->bytes;
+    dst->capture_us += src->capture_us;
+}
+
+// Run one frame through the same analytics as the sniffer's packet handler
+static void analyze_frame(analysis_t *a, seq_tracker_t *file_seq, const pcap_frame_t *frame) {
+    frame_info_t info;
+    if (!ieee80211_parse_frame(frame->data, frame->len, &info)) {
+        a->malformed++;
+        return;
+    }
+    info.rssi = frame->rssi;
+    info.channel = frame->channel;
+    info.timestamp_us = frame->ts_us;
+
+    // Captures only carry a legacy rate; frames without one get no airtime
+    airtime_phy_t phy;
+    int code = frame->rate ? airtime_legacy_code(frame->rate) : -1;
+    bool have_phy = code >= 0 && airtime_phy_from_legacy_code(code, &phy);
+    channel_totals_t *ch = &a->channels[info.channel];
+    if (have_phy) {
+        ch->airtime_us += airtime_duration_us(&phy, frame->len + 4);
+    }
+
+    // Retransmissions count as air time and retries, not as traffic
+    bool duplicate = seq_tracker_update(file_seq, &info, 0);
+    rate_stats_update(&a->rates, &info, have_phy ? &phy : NULL);
+    if (duplicate) {
+        a->duplicates++;
+        return;
+    }
+    traffic_stats_update(&a->traffic, &info);
+    assoc_graph_update(&a->assoc, &info);
+    rogue_ap_update(&a->aps, &info);
+    if (info.addr2) {
+        hll_add(&a->devices, info.addr2, 6);
+        hll_add(&ch->devices, info.addr2, 6);
+    }
+
+    ch->frames++;
+    ch->bytes += frame->len;
+    a->subtypes[info.type & 3][info.subtype & 15]++;
+    a->frames++;
+    a->bytes += frame->len;
+}
+
+// Analyze one file; sequence state starts fresh, since each file may come from another receiver
+static void analyze_file(worker_t *w, const char *path) {
+    analysis_t *a = w->analysis;
+    pcap_reader_t reader;
+    pcap_frame_t frame;
+
+    if (!pcap_reader_open(&reader, path)) {
+        return;
+    }
+    seq_tracker_init(w->file_seq);
+    uint64_t first_us = UINT64_MAX, last_us = 0;
+    while (pcap_reader_next(&reader, &frame)) {
+        analyze_frame(a, w->file_seq, &frame);
+        if (frame.ts_us < first_us) first_us = frame.ts_us;
+        if (frame.ts_us > last_us) last_us = frame.ts_us;
+    }
+    if (last_us > first_us) {
+        a->capture_us += last_us - first_us;
+    }
+    seq_tracker_merge(&a->seq, w->file_seq);
+
+    a->files++;
+    a->file_bytes += reader.bytes;
+    a->records += reader.records;
+    a->skipped += reader.skipped;
+    pcap_reader_close(&reader);
+}
+
+static void *worker_main(void *arg) {
+    worker_t *w = arg;
+
+    for (;;) {
+        int i = atomic_fetch_add(&next_input, 1);
+        if (i >= input_count) {
+            break;
+        }
+        analyze_file(w, inputs[i].path);
+    }
+    return NULL;
+}
+
+static int compare_size_desc(const void *a, const void *b) {
+    const input_file_t *x = a, *y = b;
+    return (x->size < y->size) - (x->size > y->size);
+}
+
+// Tables are ordered by count, ties by address, so the output does not
+// depend on the order the files were read in
+
+// Order (SSID, BSS) rows by beacons seen; the row's first member is the SSID
+static int compare_bss_seen(const void *a, const void *b) {
+    const rogue_bss_t *x = ((const rogue_bss_t *const *)a)[1];
+    const rogue_bss_t *y = ((const rogue_bss_t *const *)b)[1];
+    if (x->seen != y->seen) {
+        return (x->seen < y->seen) - (x->seen > y->seen);
+    }
+    int order = strcmp(((const rogue_ssid_t *const *)a)[0]->ssid, ((const rogue_ssid_t *const *)b)[0]->ssid);
+    return order ? order : memcmp(x->bssid, y->bssid, 6);
+}
+
+static int compare_traffic_frames(const void *a, const void *b) {
+    const traffic_entry_t *x = a, *y = b;
+    uint64_t fx = (uint64_t)x->counters.frames[0] + x->counters.frames[1] + x->counters.frames[2];
+    uint64_t fy = (uint64_t)y->counters.frames[0] + y->counters.frames[1] + y->counters.frames[2];
+    return fx != fy ? (fx < fy) - (fx > fy) : memcmp(x->addr, y->addr, 6);
+}
+
+static int compare_edge_frames(const void *a, const void *b) {
+    const assoc_edge_t *x = a, *y = b;
+    if (x->frames != y->frames) {
+        return (x->frames < y->frames) - (x->frames > y->frames);
+    }
+    int order = memcmp(x->bssid, y->bssid, 6);
+    return order ? order : memcmp(x->station, y->station, 6);
+}
+
+static int compare_rate_frames(const void *a, const void *b) {
+    const rate_entry_t *x = a, *y = b;
+    if (x->hist.frames != y->hist.frames) {
+        return (x->hist.frames < y->hist.frames) - (x->hist.frames > y->hist.frames);
+    }
+    return memcmp(x->addr, y->addr, 6);
+}
+
+static void print_summary(const analysis_t *a, int threads, uint64_t wall_ns) {
+    double wall_s = wall_ns / 1e9;
+
+    printf("Files:       %u (%.1f MB) on %d thread%s in %.3f s\n",
+           a->files, a->file_bytes / 1e6, threads, threads == 1 ? "" : "s", wall_s);
+    printf("Records:     %llu (%llu unusable, %llu malformed)\n",
+           (unsigned long long)a->records, (unsigned long long)a->skipped, (unsigned long long)a->malformed);
+    printf("Frames:      %llu unique, %llu retransmissions, %.1f MB\n",
+           (unsigned long long)a->frames, (unsigned long long)a->duplicates, a->bytes / 1e6);
+    printf("Captured:    %.1f s (summed over files)\n", a->capture_us / 1e6);
+    printf("Throughput:  %.0f records/s, %.1f MB/s\n",
+           wall_s > 0 ? a->records / wall_s : 0, wall_s > 0 ? a->file_bytes / 1e6 / wall_s : 0);
+    printf("Devices:     ~%u distinct transmitters\n", (unsigned)hll_estimate(&a->devices));
+    printf("Completeness: %.1f%% (%u missed on channel, %u off channel)\n",
+           seq_coverage_permille(&a->seq.total) / 10.0,
+           (unsigned)a->seq.total.missed_on_channel, (unsigned)a->seq.total.missed_off_channel);
+
+    // Entries recycled by a full table; their counts are lost, and with
+    // them the guarantee that the tables below are the same for any -j
+    uint32_t evicted[] = {
+        a->traffic.tx_table.evictions, a->traffic.link_table.evictions, a->assoc.table.evictions,
+        a->rates.bss_table.evictions, a->seq.table.evictions, a->aps.ssid_table.evictions,
+    };
+    printf("Evicted:     %u transmitters, %u links, %u associations, %u BSS rates, %u sequence, %u SSIDs\n",
+           (unsigned)evicted[0], (unsigned)evicted[1], (unsigned)evicted[2], (unsigned)evicted[3],
+           (unsigned)evicted[4], (unsigned)evicted[5]);
+    for (size_t i = 0; i < sizeof(evicted) / sizeof(evicted[0]); i++) {
+        if (evicted[i]) {
+            fprintf(stderr, "warning: analytics tables overflowed; top lists may depend on file order and -j\n");
+            break;
+        }
+    }
+}
+
+static void print_frame_types(const analysis_t *a) {
+    printf("\nFrame types:\n");
+    printf("  %-14s %7s %12s %7s\n", "type", "subtype", "frames", "share");
+    for (int t = 0; t < 4; t++) {
+        for (int s = 0; s < 16; s++) {
+            uint64_t n = a->subtypes[t][s];
+            if (!n) continue;
+            printf("  %-14s %7d %12llu %6.1f%%\n", get_frame_type_str((t << 2) | (s << 4)), s,
+                   (unsigned long long)n, 100.0 * n / a->frames);
+        }
+    }
+}
+
+static void print_channels(const analysis_t *a, double span_s) {
+    printf("\nChannels:\n");
+    printf("  %-7s %12s %10s %12s %6s %8s\n", "channel", "frames", "MB", "airtime ms", "busy", "devices");
+    for (int ch = 0; ch < 256; ch++) {
+        const channel_totals_t *c = &a->channels[ch];
+        if (!c->frames) continue;
+        char label[8];
+        snprintf(label, sizeof(label), ch ? "%d" : "?", ch);
+        printf("  %-7s %12llu %10.2f %12.1f %5.1f%% %8u\n", label,
+               (unsigned long long)c->frames, c->bytes / 1e6, c->airtime_us / 1e3,
+               span_s > 0 ? c->airtime_us / 1e4 / span_s : 0, (unsigned)hll_estimate(&c->devices));
+    }
+}
+
+static void print_aps(const analysis_t *a, int top) {
+    static struct {
+        const rogue_ssid_t *ssid;
+        const rogue_bss_t *bss;
+    } rows[ROGUE_MAX_SSIDS * ROGUE_MAX_BSS_PER_SSID];
+    const rogue_ap_t *aps = &a->aps;
+    char mac[18];
+    int count = 0;
+
+    for (uint16_t slot = aps->ssid_table.lru_head; slot != MAC_TABLE_NONE; slot = aps->ssid_nodes[slot].lru_next) {
+        for (int i = 0; i < aps->ssids[slot].bss_count; i++) {
+            rows[count].ssid = &aps->ssids[slot];
+            rows[count].bss = &aps->ssids[slot].bss[i];
+            count++;
+        }
+    }
+    qsort(rows, count, sizeof(rows[0]), compare_bss_seen);
+
+    printf("\nAccess points (%d):\n", count);
+    printf("  %-32s %-17s %4s %-5s %5s %8s %s\n", "ssid", "bssid", "ch", "auth", "rssi", "beacons", "flags");
+    for (int i = 0; i < count && i < top; i++) {
+        const rogue_bss_t *bss = rows[i].bss;
+        format_mac_addr(mac, bss->bssid);
+        printf("  %-32s %-17s %4u %-5s %5d %8u %s%s%s\n", rows[i].ssid->ssid, mac, bss->channel,
+               rogue_ap_auth_name(bss->auth), bss->rssi, (unsigned)bss->seen,
+               bss->flags & ROGUE_FLAG_DOWNGRADE ? "downgrade " : "",
+               bss->flags & ROGUE_FLAG_FINGERPRINT ? "fingerprint " : "",
+               bss->flags & ROGUE_FLAG_CHANNEL ? "channel" : "");
+    }
+}
+
+static void print_talkers(const analysis_t *a, int top) {
+    static traffic_snapshot_t snapshot;
+    char mac[18];
+
+    traffic_stats_snapshot(&a->traffic, &snapshot);
+    qsort(snapshot.transmitters, snapshot.transmitter_count, sizeof(traffic_entry_t), compare_traffic_frames);
+
+    printf("\nTop talkers:\n");
+    printf("  %-17s %10s %10s %10s %12s %4s %5s\n", "transmitter", "mgmt", "ctrl", "data", "bytes", "ch", "rssi");
+    for (int i = 0; i < snapshot.transmitter_count && i < top; i++) {
+        const traffic_entry_t *e = &snapshot.transmitters[i];
+        format_mac_addr(mac, e->addr);
+        printf("  %-17s %10u %10u %10u %12llu %4u %5d\n", mac,
+               (unsigned)e->counters.frames[IEEE80211_TYPE_MGMT], (unsigned)e->counters.frames[IEEE80211_TYPE_CTRL],
+               (unsigned)e->counters.frames[IEEE80211_TYPE_DATA], (unsigned long long)e->counters.bytes,
+               e->counters.channel, e->counters.rssi_ewma / 16);
+    }
+}
+
+static void print_associations(const analysis_t *a, int top) {
+    static assoc_edge_t edges[ASSOC_GRAPH_MAX_EDGES];
+    char bssid[18], station[18];
+
+    int count = assoc_graph_get_edges(&a->assoc, NULL, edges, ASSOC_GRAPH_MAX_EDGES);
+    qsort(edges, count, sizeof(assoc_edge_t), compare_edge_frames);
+
+    printf("\nAssociations (%d):\n", count);
+    printf("  %-17s %-17s %10s %4s\n", "bssid", "station", "frames", "ch");
+    for (int i = 0; i < count && i < top; i++) {
+        format_mac_addr(bssid, edges[i].bssid);
+        format_mac_addr(station, edges[i].station);
+        printf("  %-17s %-17s %10u %4u\n", bssid, station, (unsigned)edges[i].frames, edges[i].channel);
+    }
+}
+
+static void print_rates(const analysis_t *a, int top) {
+    static rate_entry_t entries[RATE_MAX_BSSIDS];
+    char mac[18];
+
+    int count = rate_stats_export(&a->rates, true, entries, RATE_MAX_BSSIDS);
+    qsort(entries, count, sizeof(rate_entry_t), compare_rate_frames);
+
+    printf("\nData rates per BSS:\n");
+    printf("  %-17s %10s %7s %-10s\n", "bssid", "frames", "retry", "top rate");
+    for (int i = 0; i < count && i < top; i++) {
+        const rate_hist_t *h = &entries[i].hist;
+        int best = 0;
+        for (int b = 1; b < RATE_BINS; b++) {
+            if (h->bins[b] > h->bins[best]) best = b;
+        }
+        format_mac_addr(mac, entries[i].addr);
+        printf("  %-17s %10u %6.1f%% %-10s\n", mac, (unsigned)h->frames,
+               h->frames ? 100.0 * h->retries / h->frames : 0,
+               h->bins[best] ? rate_stats_bin_name(best) : "-");
+    }
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options] capture.pcap...\n"
+            "  -j THREADS  worker threads (default: online CPUs)\n"
+            "  -n TOP      rows per table (default %d)\n"
+            "Files are shared out whole, largest first; each thread keeps its own\n"
+            "analytics state and the states are merged once all files are read.\n",
+            prog, ANALYZE_DEFAULT_TOP);
+}
+
+int main(int argc, char **argv) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cpus > 0 ? (int)cpus : 1;
+    int top = ANALYZE_DEFAULT_TOP;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "j:n:h")) != -1) {
+        switch (opt) {
+            case 'j': threads = atoi(optarg); break;
+            case 'n': top = atoi(optarg); break;
+            default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind >= argc || threads < 1 || top < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    input_count = argc - optind;
+    inputs = calloc(input_count, sizeof(input_file_t));
+    if (!inputs) {
+        return 1;
+    }
+    for (int i = 0; i < input_count; i++) {
+        struct stat st;
+        inputs[i].path = argv[optind + i];
+        inputs[i].size = stat(inputs[i].path, &st) == 0 ? st.st_size : 0;
+    }
+    qsort(inputs, input_count, sizeof(input_file_t), compare_size_desc);
+
+    // More threads than files would only sit idle
+    if (threads > input_count) threads = input_count;
+    if (threads > ANALYZE_MAX_THREADS) threads = ANALYZE_MAX_THREADS;
+
+    worker_t workers[ANALYZE_MAX_THREADS];
+    for (int i = 0; i < threads; i++) {
+        workers[i].analysis = malloc(sizeof(analysis_t));
+        workers[i].file_seq = malloc(sizeof(seq_tracker_t));
+        if (!workers[i].analysis || !workers[i].file_seq) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+        analysis_init(workers[i].analysis);
+    }
+
+    uint64_t start_ns = now_ns();
+    atomic_store(&next_input, 0);
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]) != 0) {
+            fprintf(stderr, "Failed to start worker %d\n", i);
+            return 1;
+        }
+    }
+    worker_main(&workers[0]);
+
+    // Reduce into the first worker's state
+    analysis_t *total = workers[0].analysis;
+    for (int i = 1; i < threads; i++) {
+        pthread_join(workers[i].thread, NULL);
+        analysis_merge(total, workers[i].analysis);
+    }
+    uint64_t wall_ns = now_ns() - start_ns;
+
+    if (!total->files) {
+        fprintf(stderr, "No readable capture files\n");
+        return 1;
+    }
+    double span_s = total->capture_us / 1e6;
+    print_summary(total, threads, wall_ns);
+    if (total->frames) {
+        print_frame_types(total);
+        print_channels(total, span_s);
+        print_aps(total, top);
+        print_talkers(total, top);
+        print_associations(total, top);
+        print_rates(total, top);
+    }
+
+    for (int i = 0; i < threads; i++) {
+        free(workers[i].analysis);
+        free(workers[i].file_seq);
+    }
+    free(inputs);
+    return 0;
+}
@@ -0,0 +1,391 @@
+// Microbenchmarks of the capture and API hot paths, compared against a committed baseline
+#include "wifi_sniffer.h"
+#include "sniffer_profile.h"
+#include "traffic_gen.h"
+#include "frame_format.h"
+#include "esp_log.h"
+#ifdef BENCH_HAVE_CJSON
+#include "api_json.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Each measurement runs at least this long; the best of BENCH_RUNS is kept
+#define BENCH_MIN_NS                 100000000ull
+#define BENCH_RUNS                   5
+#define BENCH_DEFAULT_TOLERANCE_PCT  25
+#define BENCH_MAX_RESULTS            32
+
+/**
+ * @brief A benchmark: runs its operation iters times
+ */
+typedef struct {
+    const char *name;
+    void (*run)(uint32_t iters, uint32_t param);
+    uint32_t param;
+    const char *extra;           // Additional metric reported from the same runs, or NULL
+} bench_t;
+
+/**
+ * @brief One measured metric
+ */
+typedef struct {
+    char name[48];
+    double ns_per_op;
+    uint64_t ops;
+} bench_result_t;
+
+// Keeps results observable so the compiler cannot drop the work
+static volatile uint32_t sink;
+
+// Time charged to the STORE stage (copy into the capture buffer) by the handler hooks
+static uint64_t store_ns;
+static uint32_t store_frames;
+static uint64_t stage_last_ns;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void sniffer_profile_begin(void) {
+    stage_last_ns = now_ns();
+}
+
+void sniffer_profile_mark(sniffer_stage_t stage) {
+    uint64_t now = now_ns();
+    if (stage == SNIFFER_STAGE_STORE) {
+        store_ns += now - stage_last_ns;
+        store_frames++;
+    }
+    stage_last_ns = now;
+}
+
+// ---- Frame classification and formatting ----
+
+static void bench_frame_type_str(uint32_t iters, uint32_t param) {
+    (void)param;
+    uint32_t acc = 0;
+    for (uint32_t i = 0; i < iters; i++) {
+        acc += (uint8_t)get_frame_type_str((uint16_t)(i * 4))[0];
+    }
+    sink = acc;
+}
+
+static void bench_format_mac_addr(uint32_t iters, uint32_t param) {
+    (void)param;
+    uint8_t mac[6] = {0x24, 0x0A, 0xC4, 0x00, 0x00, 0x00};
+    char text[18];
+    uint32_t acc = 0;
+    for (uint32_t i = 0; i < iters; i++) {
+        mac[5] = i;
+        mac[4] = i >> 8;
+        format_mac_addr(text, mac);
+        acc += (uint8_t)text[16];
+    }
+    sink = acc;
+}
+
+// ---- Packet handler ----
+
+static wifi_promiscuous_pkt_t *handler_pkt;
+static uint16_t handler_len;
+
+// Data frame of a given length, fed through the whole handler
+static void bench_handler(uint32_t iters, uint32_t param) {
+    (void)param;
+    for (uint32_t i = 0; i < iters; i++) {
+        // Vary the sequence number so the retransmission check lets every frame through
+        handler_pkt->payload[22] = (i << 4) & 0xF0;
+        handler_pkt->payload[23] = i >> 4;
+        wifi_sniffer_inject(handler_pkt, handler_len, -60, 6, 108);
+    }
+}
+
+static void setup_handler_frame(uint32_t len) {
+    static const uint8_t header[] = {
+        0x08, 0x01, 0x2C, 0x00,
+        0x10, 0x27, 0xF5, 0x00, 0x00, 0x01,   // BSSID
+        0xF0, 0x18, 0x98, 0x00, 0x00, 0x02,   // Station
+        0x10, 0x27, 0xF5, 0x00, 0x00, 0x01,
+        0x00, 0x00,
+        0xAA, 0xAA, 0x03, 0x00, 0x00, 0x00, 0x08, 0x00,
+    };
+    memset(handler_pkt->payload, 0x5A, len);
+    memcpy(handler_pkt->payload, header, sizeof(header));
+    handler_len = len;
+}
+
+// ---- API JSON ----
+
+#ifdef BENCH_HAVE_CJSON
+static wifi_ap_record_t *scan_records;
+static packet_info_t **json_packets;
+
+static void bench_scan_json(uint32_t iters, uint32_t count) {
+    for (uint32_t i = 0; i < iters; i++) {
+        cJSON *root = api_json_scan_results(scan_records, count);
+        char *text = cJSON_PrintUnformatted(root);
+        sink = text[1];
+        free(text);
+        cJSON_Delete(root);
+    }
+}
+
+static void bench_packets_json(uint32_t iters, uint32_t count) {
+    for (uint32_t i = 0; i < iters; i++) {
+        cJSON *root = api_json_packets(json_packets, count);
+        char *text = cJSON_PrintUnformatted(root);
+        sink = text[1];
+        free(text);
+        cJSON_Delete(root);
+    }
+}
+
+// Scan records and captured frames shaped like real ones, from the traffic generator
+static void setup_json_inputs(void) {
+    traffic_gen_config_t config;
+    traffic_gen_t *gen = malloc(sizeof(*gen));
+    traffic_gen_default_config(&config);
+    traffic_gen_init(gen, &config);
+
+    scan_records = calloc(500, sizeof(wifi_ap_record_t));
+    for (int i = 0; i < 500; i++) {
+        wifi_ap_record_t *ap = &scan_records[i];
+        memcpy(ap->bssid, gen->aps[i % TRAFFIC_GEN_MAX_APS].mac, 6);
+        ap->bssid[5] ^= i >> 6;
+        snprintf((char *)ap->ssid, sizeof(ap->ssid), i % 10 == 9 ? "" : "Network-%03d", i);
+        ap->primary = (i % 3) * 5 + 1;
+        ap->rssi = -40 - i % 50;
+        ap->authmode = i % WIFI_AUTH_MAX;
+        ap->phy_11n = i & 1;
+    }
+
+    json_packets = calloc(1000, sizeof(packet_info_t *));
+    for (int i = 0; i < 1000; i++) {
+        packet_info_t *p = calloc(1, sizeof(packet_info_t));
+        traffic_gen_frame_t frame;
+        p->orig_length = traffic_gen_next(gen, p->data, sizeof(p->data), &frame);
+        p->length = p->orig_length;
+        p->rssi = frame.rssi;
+        p->channel = frame.channel;
+        json_packets[i] = p;
+    }
+    free(gen);
+}
+#endif
+
+static const bench_t benches[] = {
+    {"frame_type_str", bench_frame_type_str, 0, NULL},
+    {"format_mac_addr", bench_format_mac_addr, 0, NULL},
+    {"handler_data_64", bench_handler, 64, "handler_copy_64"},
+    {"handler_data_1500", bench_handler, 1500, "handler_copy_1500"},
+#ifdef BENCH_HAVE_CJSON
+    {"scan_json_50", bench_scan_json, 50, NULL},
+    {"scan_json_200", bench_scan_json, 200, NULL},
+    {"scan_json_500", bench_scan_json, 500, NULL},
+    {"packets_json_10", bench_packets_json, 10, NULL},
+    {"packets_json_100", bench_packets_json, 100, NULL},
+    {"packets_json_1000", bench_packets_json, 1000, NULL},
+#endif
+};
+
+// Find the iteration count that takes BENCH_MIN_NS, then keep the best of several runs
+static void measure(const bench_t *bench, bench_result_t *result, bench_result_t *extra) {
+    uint32_t iters = 1;
+    uint64_t elapsed;
+
+    if (bench->run == bench_handler) {
+        setup_handler_frame(bench->param);
+    }
+    for (;;) {
+        uint64_t t0 = now_ns();
+        bench->run(iters, bench->param);
+        elapsed = now_ns() - t0;
+        if (elapsed >= BENCH_MIN_NS / 10 || iters >= (1u << 30)) {
+            break;
+        }
+        iters *= 2;
+    }
+    iters = (uint32_t)((double)iters * BENCH_MIN_NS / (elapsed ? elapsed : 1)) + 1;
+
+    double best = 0, best_extra = 0;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        store_ns = 0;
+        store_frames = 0;
+        uint64_t t0 = now_ns();
+        bench->run(iters, bench->param);
+        double ns = (double)(now_ns() - t0) / iters;
+        if (run == 0 || ns < best) best = ns;
+        if (store_frames) {
+            double ns_extra = (double)store_ns / store_frames;
+            if (run == 0 || ns_extra < best_extra) best_extra = ns_extra;
+        }
+    }
+
+    snprintf(result->name, sizeof(result->name), "%s", bench->name);
+    result->ns_per_op = best;
+    result->ops = (uint64_t)iters * BENCH_RUNS;
+    if (extra) {
+        snprintf(extra->name, sizeof(extra->name), "%s", bench->extra);
+        extra->ns_per_op = best_extra;
+        extra->ops = result->ops;
+    }
+}
+
+// Look a metric up in a baseline file (name,ns_per_op,ops; '#' starts a comment)
+static bool baseline_lookup(FILE *f, const char *name, double *ns_per_op) {
+    char line[160];
+    rewind(f);
+    while (fgets(line, sizeof(line), f)) {
+        char key[48];
+        double value;
+        if (line[0] == '#' || sscanf(line, "%47[^,],%lf", key, &value) != 2) {
+            continue;
+        }
+        if (strcmp(key, name) == 0) {
+            *ns_per_op = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Count baseline metrics that were not measured, e.g. because cJSON was missing
+static int baseline_missing(FILE *f, const bench_result_t *results, int count, const char *filter) {
+    char line[160];
+    int missing = 0;
+    rewind(f);
+    while (fgets(line, sizeof(line), f)) {
+        char key[48];
+        double value;
+        if (line[0] == '#' || sscanf(line, "%47[^,],%lf", key, &value) != 2) {
+            continue;
+        }
+        if (filter && !strstr(key, filter)) {
+            continue;
+        }
+        int i = 0;
+        while (i < count && strcmp(results[i].name, key) != 0) {
+            i++;
+        }
+        if (i == count) {
+            fprintf(stderr, "%-20s %12.1f %12s %8s\n", key, value, "-", "MISSING");
+            missing++;
+        }
+    }
+    return missing;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [--baseline FILE] [--tolerance PCT] [--write FILE] [--filter TEXT]\n"
+            "  Prints name,ns_per_op,ops as CSV. With --baseline, exits with 1 if any\n"
+            "  metric is more than PCT percent (default %d) slower than the baseline,\n"
+            "  or was not measured at all.\n",
+            prog, BENCH_DEFAULT_TOLERANCE_PCT);
+}
+
+int main(int argc, char **argv) {
+    const char *baseline_path = NULL, *write_path = NULL, *filter = NULL;
+    double tolerance = BENCH_DEFAULT_TOLERANCE_PCT;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--write") == 0 && i + 1 < argc) {
+            write_path = argv[++i];
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    esp_log_level_set("*", ESP_LOG_ERROR);
+    handler_pkt = calloc(1, sizeof(wifi_promiscuous_pkt_t) + 2048);
+#ifdef BENCH_HAVE_CJSON
+    setup_json_inputs();
+#else
+    fprintf(stderr, "note: built without cJSON; JSON benchmarks are skipped\n");
+#endif
+    // The benchmarks run the handler flat out; measure full-fidelity capture
+    load_governor_config_t governor_config;
+    load_governor_default_config(&governor_config);
+    governor_config.enabled = false;
+    wifi_sniffer_set_governor(&governor_config);
+    if (!start_wifi_sniffer(6, 0)) {
+        fprintf(stderr, "failed to start the sniffer\n");
+        return 1;
+    }
+
+    bench_result_t results[BENCH_MAX_RESULTS];
+    int count = 0;
+    for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+        if (filter && !strstr(benches[i].name, filter)) {
+            continue;
+        }
+        bench_result_t *extra = benches[i].extra ? &results[count + 1] : NULL;
+        measure(&benches[i], &results[count], extra);
+        count += extra ? 2 : 1;
+    }
+    stop_wifi_sniffer();
+
+    printf("name,ns_per_op,ops\n");
+    for (int i = 0; i < count; i++) {
+        printf("%s,%.1f,%llu\n", results[i].name, results[i].ns_per_op, (unsigned long long)results[i].ops);
+    }
+
+    if (write_path) {
+        FILE *f = fopen(write_path, "w");
+        if (!f) {
+            perror(write_path);
+            return 1;
+        }
+        fprintf(f, "# Reference timings for sniffer_bench; refresh with --write on the reference machine\n");
+        fprintf(f, "name,ns_per_op,ops\n");
+        for (int i = 0; i < count; i++) {
+            fprintf(f, "%s,%.1f,%llu\n", results[i].name, results[i].ns_per_op,
+                    (unsigned long long)results[i].ops);
+        }
+        fclose(f);
+    }
+
+    int regressions = 0;
+    if (baseline_path) {
+        FILE *f = fopen(baseline_path, "r");
+        if (!f) {
+            perror(baseline_path);
+            return 1;
+        }
+        fprintf(stderr, "\n%-20s %12s %12s %8s\n", "metric", "baseline ns", "current ns", "change");
+        for (int i = 0; i < count; i++) {
+            double base;
+            if (!baseline_lookup(f, results[i].name, &base) || base <= 0) {
+                fprintf(stderr, "%-20s %12s %12.1f %8s\n", results[i].name, "-", results[i].ns_per_op, "new");
+                continue;
+            }
+            double change = (results[i].ns_per_op / base - 1) * 100;
+            bool regressed = change > tolerance;
+            regressions += regressed;
+            fprintf(stderr, "%-20s %12.1f %12.1f %+7.1f%%%s\n", results[i].name, base, results[i].ns_per_op,
+                    change, regressed ? "  REGRESSION" : "");
+        }
+        int missing = baseline_missing(f, results, count, filter);
+        fclose(f);
+        if (regressions) {
+            fprintf(stderr, "%d metric(s) more than %.0f%% slower than the baseline\n", regressions, tolerance);
+        }
+        if (missing) {
+            fprintf(stderr, "%d baseline metric(s) not measured\n", missing);
+            regressions += missing;
+        }
+    }
+    return regressions ? 1 : 0;
+}
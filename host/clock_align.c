@@ -0,0 +1,143 @@
+#include "clock_align.h"
+#include <math.h>
+#include <string.h>
+
+// Line parameters of a fit: local - local0 = intercept + slope * (tsf - tsf0)
+typedef struct {
+    double intercept;
+    double slope;
+    double rms;
+} clock_line_t;
+
+static void fit_reset(clock_fit_t *fit, uint64_t tsf, uint64_t local_us) {
+    memset(fit, 0, sizeof(*fit));
+    fit->tsf0 = tsf;
+    fit->local0 = local_us;
+}
+
+static bool fit_line(const clock_fit_t *fit, clock_line_t *line) {
+    double n = fit->count;
+    double det = n * fit->sxx - fit->sx * fit->sx;
+    if (fit->count < 2 || det <= 0) {
+        return false;
+    }
+
+    line->slope = (n * fit->sxy - fit->sx * fit->sy) / det;
+    line->intercept = (fit->sy - line->slope * fit->sx) / n;
+    double sse = fit->syy - line->intercept * fit->sy - line->slope * fit->sxy;
+    line->rms = sse > 0 ? sqrt(sse / n) : 0;
+    return line->slope > 0;
+}
+
+// Reset the beacon timing of a device
+void clock_beacons_init(clock_beacons_t *beacons) {
+    mac_table_init(&beacons->table, beacons->nodes, beacons->buckets,
+                   CLOCK_ALIGN_MAX_APS, CLOCK_ALIGN_HASH_BUCKETS, 6);
+    beacons->beacons = 0;
+    beacons->resets = 0;
+}
+
+// Account one beacon or probe response
+void clock_beacons_add(clock_beacons_t *beacons, const uint8_t *bssid, uint64_t tsf, uint64_t local_us) {
+    bool is_new;
+    int slot = mac_table_touch(&beacons->table, bssid, &is_new);
+    clock_fit_t *fit = &beacons->fits[slot];
+
+    if (is_new) {
+        fit_reset(fit, tsf, local_us);
+    } else if (tsf < fit->last_tsf) {
+        // The AP restarted; its old TSF says nothing about the new one
+        fit_reset(fit, tsf, local_us);
+        beacons->resets++;
+    }
+
+    double x = (double)(tsf - fit->tsf0);
+    double y = (double)(int64_t)(local_us - fit->local0);
+    fit->sx += x;
+    fit->sy += y;
+    fit->sxx += x * x;
+    fit->sxy += x * y;
+    fit->syy += y * y;
+    fit->count++;
+    fit->last_tsf = tsf;
+    beacons->beacons++;
+}
+
+// Map one device's clock onto another's through the AP both heard best
+bool clock_align_pair(const clock_beacons_t *dev, const clock_beacons_t *ref, clock_map_t *map,
+                      clock_link_t *link) {
+    const clock_fit_t *best_dev = NULL, *best_ref = NULL;
+    int best_slot = -1;
+    uint32_t best_count = 0;
+    clock_line_t dev_line, ref_line;
+
+    for (int slot = 0; slot < CLOCK_ALIGN_MAX_APS; slot++) {
+        if (!mac_table_in_use(&dev->table, slot)) continue;
+        const clock_fit_t *d = &dev->fits[slot];
+        int ref_slot = mac_table_find(&ref->table, mac_table_key(&dev->table, slot));
+        if (ref_slot < 0) continue;
+        const clock_fit_t *r = &ref->fits[ref_slot];
+
+        uint32_t count = d->count < r->count ? d->count : r->count;
+        if (count < CLOCK_ALIGN_MIN_BEACONS || count <= best_count) continue;
+        clock_line_t dl, rl;
+        if (!fit_line(d, &dl) || !fit_line(r, &rl)) continue;
+        double slope = rl.slope / dl.slope;
+        if (fabs(slope - 1.0) * 1e6 > CLOCK_ALIGN_MAX_DRIFT_PPM) continue;
+
+        best_dev = d;
+        best_ref = r;
+        best_slot = slot;
+        best_count = count;
+        dev_line = dl;
+        ref_line = rl;
+    }
+    if (!best_dev) {
+        return false;
+    }
+
+    // Both devices timed the same TSF; eliminate it:
+    // ref = local0_r + c_r + b_r * (tsf - tsf0_r), tsf = tsf0_d + (dev - local0_d - c_d) / b_d
+    map->src0 = best_dev->local0;
+    map->dst0 = best_ref->local0;
+    map->slope = ref_line.slope / dev_line.slope;
+    map->offset = ref_line.intercept + ref_line.slope * (double)(int64_t)(best_dev->tsf0 - best_ref->tsf0) -
+                  map->slope * dev_line.intercept;
+
+    if (link) {
+        memcpy(link->bssid, mac_table_key(&dev->table, best_slot), 6);
+        link->beacons = best_count;
+        link->rms_us = sqrt(dev_line.rms * dev_line.rms + ref_line.rms * ref_line.rms);
+    }
+    return true;
+}
+
+// Get the map that leaves times unchanged
+void clock_map_identity(clock_map_t *map) {
+    map->src0 = 0;
+    map->dst0 = 0;
+    map->offset = 0;
+    map->slope = 1.0;
+}
+
+// Chain two maps: out(t) = outer(inner(t))
+void clock_map_compose(const clock_map_t *outer, const clock_map_t *inner, clock_map_t *out) {
+    clock_map_t result;
+
+    result.src0 = inner->src0;
+    result.dst0 = outer->dst0;
+    result.slope = outer->slope * inner->slope;
+    result.offset = outer->offset +
+                    outer->slope * ((double)(int64_t)(inner->dst0 - outer->src0) + inner->offset);
+    *out = result;
+}
+
+// Map a time (clamped at 0)
+uint64_t clock_map_apply(const clock_map_t *map, uint64_t t) {
+    double delta = map->offset + map->slope * (double)(int64_t)(t - map->src0);
+    int64_t rounded = llround(delta);
+    if (rounded < 0 && (uint64_t)-rounded > map->dst0) {
+        return 0;
+    }
+    return map->dst0 + rounded;
+}
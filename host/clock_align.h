@@ -0,0 +1,102 @@
+#ifndef CLOCK_ALIGN_H
+#define CLOCK_ALIGN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "mac_table.h"
+
+// APs tracked per device; least recently heard are evicted
+#define CLOCK_ALIGN_MAX_APS          256
+#define CLOCK_ALIGN_HASH_BUCKETS     128
+// Beacons an AP needs on both devices before its TSF is used to align them
+#define CLOCK_ALIGN_MIN_BEACONS      8
+// Fits implying a larger rate difference between two clocks are rejected
+#define CLOCK_ALIGN_MAX_DRIFT_PPM    1000
+
+/**
+ * @brief Least-squares fit of a device's receive time against one AP's TSF
+ *
+ * Sums are kept relative to the first beacon so they stay exact in doubles.
+ */
+typedef struct {
+    uint64_t tsf0;
+    uint64_t local0;
+    uint64_t last_tsf;
+    uint32_t count;
+    double sx, sy, sxx, sxy, syy;
+} clock_fit_t;
+
+/**
+ * @brief Beacon timing seen by one device, per AP
+ */
+typedef struct {
+    mac_table_t table;
+    mac_table_node_t nodes[CLOCK_ALIGN_MAX_APS];
+    uint16_t buckets[CLOCK_ALIGN_HASH_BUCKETS];
+    clock_fit_t fits[CLOCK_ALIGN_MAX_APS];
+    uint32_t beacons;
+    uint32_t resets;             // TSF went backwards (AP restart) and the fit restarted
+} clock_beacons_t;
+
+/**
+ * @brief Affine map between two device clocks: dst0 + offset + slope * (t - src0)
+ */
+typedef struct {
+    uint64_t src0;
+    uint64_t dst0;
+    double offset;
+    double slope;
+} clock_map_t;
+
+/**
+ * @brief Result of aligning one device to another
+ */
+typedef struct {
+    uint8_t bssid[6];            // AP whose TSF linked the two clocks
+    uint32_t beacons;            // Beacons used, the smaller of the two devices' counts
+    double rms_us;               // Combined residual of the two fits
+} clock_link_t;
+
+/**
+ * @brief Reset the beacon timing of a device
+ */
+void clock_beacons_init(clock_beacons_t *beacons);
+
+/**
+ * @brief Account one beacon or probe response
+ *
+ * @param beacons Beacon timing of the receiving device
+ * @param bssid Transmitting AP
+ * @param tsf Timestamp field of the frame (AP clock, us)
+ * @param local_us Receive time on the device's clock
+ */
+void clock_beacons_add(clock_beacons_t *beacons, const uint8_t *bssid, uint64_t tsf, uint64_t local_us);
+
+/**
+ * @brief Map one device's clock onto another's through the AP both heard best
+ *
+ * @param dev Beacon timing of the device to align
+ * @param ref Beacon timing of the device whose clock is the target
+ * @param map Set to the map from dev time to ref time
+ * @param link Set to the AP used and the fit quality (may be NULL)
+ * @return false if no AP was heard often enough by both
+ */
+bool clock_align_pair(const clock_beacons_t *dev, const clock_beacons_t *ref, clock_map_t *map,
+                      clock_link_t *link);
+
+/**
+ * @brief Get the map that leaves times unchanged
+ */
+void clock_map_identity(clock_map_t *map);
+
+/**
+ * @brief Chain two maps: out(t) = outer(inner(t))
+ */
+void clock_map_compose(const clock_map_t *outer, const clock_map_t *inner, clock_map_t *out);
+
+/**
+ * @brief Map a time (clamped at 0)
+ */
+uint64_t clock_map_apply(const clock_map_t *map, uint64_t t);
+
+#endif /* CLOCK_ALIGN_H */
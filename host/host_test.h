@@ -0,0 +1,39 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+// Minimal checks for the host unit tests; unlike assert() they stay on in
+// release builds and keep going after a failure so one run reports them all
+#include <stdio.h>
+
+static int host_test_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        host_test_failures++; \
+    } \
+} while (0)
+
+#define CHECK_EQ(actual, expected) do { \
+    long long a_ = (long long)(actual), e_ = (long long)(expected); \
+    if (a_ != e_) { \
+        fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, a_, e_); \
+        host_test_failures++; \
+    } \
+} while (0)
+
+// Check that actual is within tolerance of expected (both converted to double)
+#define CHECK_NEAR(actual, expected, tolerance) do { \
+    double a_ = (double)(actual), e_ = (double)(expected); \
+    if (a_ < e_ - (tolerance) || a_ > e_ + (tolerance)) { \
+        fprintf(stderr, "%s:%d: %s is %g, expected %g +/- %g\n", __FILE__, __LINE__, #actual, a_, e_, \
+                (double)(tolerance)); \
+        host_test_failures++; \
+    } \
+} while (0)
+
+// Exit status for main(): nonzero if any check failed
+#define HOST_TEST_RESULT() (host_test_failures ? (fprintf(stderr, "%d check(s) failed\n", \
+                                                          host_test_failures), 1) : 0)
+
+#endif /* HOST_TEST_H */
@@ -0,0 +1,342 @@
+// Merge captures from several boards into one time-ordered pcapng, one interface per board
+#include "pcap_reader.h"
+#include "clock_align.h"
+#include "ieee80211.h"
+#include "frame_format.h"
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MERGE_MAX_DEVICES            32
+
+// pcapng block types and the byte-order magic of the section header
+#define PCAPNG_BLOCK_SHB             0x0A0D0D0A
+#define PCAPNG_BLOCK_IDB             0x00000001
+#define PCAPNG_BLOCK_EPB             0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC      0x1A2B3C4D
+#define PCAPNG_OPT_END               0
+#define PCAPNG_OPT_IF_NAME           2
+
+/**
+ * @brief One board's capture
+ */
+typedef struct {
+    const char *path;
+    clock_beacons_t beacons;
+    clock_map_t map;             // Board time to reference time
+    clock_link_t link;
+    int linked_to;               // Device aligned through, -1 for the reference or if unaligned
+    bool aligned;
+
+    pcap_reader_t reader;
+    pcap_frame_t frame;          // Next frame of the stream
+    uint64_t next_us;            // Its aligned timestamp
+    uint32_t linktype;
+    uint64_t frames;
+    uint64_t reordered;          // Frames older than the one before them on the same board
+} device_t;
+
+static device_t devices[MERGE_MAX_DEVICES];
+static int device_count;
+
+// Collect the beacon timing of one capture
+static bool scan_beacons(device_t *dev) {
+    pcap_reader_t reader;
+    pcap_frame_t frame;
+    frame_info_t info;
+
+    if (!pcap_reader_open(&reader, dev->path)) {
+        return false;
+    }
+    dev->linktype = reader.linktype;
+    clock_beacons_init(&dev->beacons);
+    while (pcap_reader_next(&reader, &frame)) {
+        dev->frames++;
+        if (!ieee80211_parse_frame(frame.data, frame.len, &info) || !ieee80211_is_beacon_like(&info) ||
+            !info.addr3 || info.body_len < 8) {
+            continue;
+        }
+        uint64_t tsf = 0;
+        for (int i = 7; i >= 0; i--) {
+            tsf = (tsf << 8) | info.body[i];
+        }
+        clock_beacons_add(&dev->beacons, info.addr3, tsf, frame.ts_us);
+    }
+    pcap_reader_close(&reader);
+    return true;
+}
+
+// Align every board to the first, directly or through a chain of boards that share an AP
+static void align_devices(void) {
+    clock_map_identity(&devices[0].map);
+    devices[0].aligned = true;
+    devices[0].linked_to = -1;
+
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        for (int d = 1; d < device_count; d++) {
+            device_t *dev = &devices[d];
+            if (dev->aligned) continue;
+
+            // Prefer the aligned board that shares the best-heard AP
+            int best = -1;
+            clock_map_t best_map;
+            clock_link_t best_link = {0};
+            for (int m = 0; m < device_count; m++) {
+                clock_map_t map;
+                clock_link_t link;
+                if (m == d || !devices[m].aligned) continue;
+                if (clock_align_pair(&dev->beacons, &devices[m].beacons, &map, &link) &&
+                    link.beacons > best_link.beacons) {
+                    best = m;
+                    best_map = map;
+                    best_link = link;
+                }
+            }
+            if (best < 0) continue;
+
+            clock_map_compose(&devices[best].map, &best_map, &dev->map);
+            dev->link = best_link;
+            dev->linked_to = best;
+            dev->aligned = true;
+            progress = true;
+        }
+    }
+
+    for (int d = 1; d < device_count; d++) {
+        if (!devices[d].aligned) {
+            clock_map_identity(&devices[d].map);
+            devices[d].linked_to = -1;
+        }
+    }
+}
+
+static void write_u16(FILE *f, uint16_t v) {
+    fwrite(&v, sizeof(v), 1, f);
+}
+
+static void write_u32(FILE *f, uint32_t v) {
+    fwrite(&v, sizeof(v), 1, f);
+}
+
+static void write_padding(FILE *f, uint32_t len) {
+    static const uint8_t zeros[4] = {0};
+    fwrite(zeros, 1, (4 - (len & 3)) & 3, f);
+}
+
+// Section header and one interface description per board, in host byte order
+static void write_header(FILE *f) {
+    write_u32(f, PCAPNG_BLOCK_SHB);
+    write_u32(f, 28);
+    write_u32(f, PCAPNG_BYTE_ORDER_MAGIC);
+    write_u16(f, 1);
+    write_u16(f, 0);
+    write_u32(f, 0xFFFFFFFF);   // Section length not given
+    write_u32(f, 0xFFFFFFFF);
+    write_u32(f, 28);
+
+    for (int d = 0; d < device_count; d++) {
+        const char *name = strrchr(devices[d].path, '/');
+        name = name ? name + 1 : devices[d].path;
+        uint32_t name_len = strlen(name);
+        uint32_t padded = (name_len + 3) & ~3u;
+        uint32_t len = 20 + 4 + padded + 4;
+
+        write_u32(f, PCAPNG_BLOCK_IDB);
+        write_u32(f, len);
+        write_u16(f, devices[d].linktype);
+        write_u16(f, 0);
+        write_u32(f, PCAP_READER_SNAPLEN);
+        write_u16(f, PCAPNG_OPT_IF_NAME);
+        write_u16(f, name_len);
+        fwrite(name, 1, name_len, f);
+        write_padding(f, name_len);
+        write_u16(f, PCAPNG_OPT_END);
+        write_u16(f, 0);
+        write_u32(f, len);
+    }
+}
+
+// Enhanced packet block with the original record and the aligned timestamp (us)
+static void write_packet(FILE *f, int interface, uint64_t ts_us, const pcap_frame_t *frame) {
+    uint32_t len = 28 + ((frame->record_len + 3) & ~3u) + 4;
+
+    write_u32(f, PCAPNG_BLOCK_EPB);
+    write_u32(f, len);
+    write_u32(f, interface);
+    write_u32(f, ts_us >> 32);
+    write_u32(f, ts_us & 0xFFFFFFFF);
+    write_u32(f, frame->record_len);
+    write_u32(f, frame->orig_len);
+    fwrite(frame->record, 1, frame->record_len, f);
+    write_padding(f, frame->record_len);
+    write_u32(f, len);
+}
+
+// Min-heap of device indices, ordered by the aligned time of their next frame
+static int heap[MERGE_MAX_DEVICES];
+static int heap_size;
+
+static bool heap_less(int a, int b) {
+    return devices[heap[a]].next_us < devices[heap[b]].next_us ||
+           (devices[heap[a]].next_us == devices[heap[b]].next_us && heap[a] < heap[b]);
+}
+
+static void heap_swap(int a, int b) {
+    int t = heap[a];
+    heap[a] = heap[b];
+    heap[b] = t;
+}
+
+static void heap_sift_down(int i) {
+    for (;;) {
+        int smallest = i;
+        int l = 2 * i + 1, r = 2 * i + 2;
+        if (l < heap_size && heap_less(l, smallest)) smallest = l;
+        if (r < heap_size && heap_less(r, smallest)) smallest = r;
+        if (smallest == i) return;
+        heap_swap(i, smallest);
+        i = smallest;
+    }
+}
+
+static void heap_push(int d) {
+    int i = heap_size++;
+    heap[i] = d;
+    while (i > 0 && heap_less(i, (i - 1) / 2)) {
+        heap_swap(i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+// Load the next frame of a stream; false at its end
+static bool advance(device_t *dev) {
+    uint64_t prev_us = dev->next_us;
+    if (!pcap_reader_next(&dev->reader, &dev->frame)) {
+        return false;
+    }
+    dev->next_us = clock_map_apply(&dev->map, dev->frame.ts_us);
+    if (dev->next_us < prev_us) {
+        dev->reordered++;
+    }
+    return true;
+}
+
+// k-way merge of all streams into the output
+static uint64_t merge_streams(FILE *out) {
+    uint64_t written = 0;
+
+    heap_size = 0;
+    for (int d = 0; d < device_count; d++) {
+        devices[d].next_us = 0;
+        devices[d].reordered = 0;
+        if (!pcap_reader_open(&devices[d].reader, devices[d].path)) {
+            continue;
+        }
+        if (advance(&devices[d])) {
+            heap_push(d);
+        }
+    }
+
+    while (heap_size > 0) {
+        device_t *dev = &devices[heap[0]];
+        write_packet(out, heap[0], dev->next_us, &dev->frame);
+        written++;
+        if (!advance(dev)) {
+            heap[0] = heap[--heap_size];
+        }
+        heap_sift_down(0);
+    }
+
+    for (int d = 0; d < device_count; d++) {
+        pcap_reader_close(&devices[d].reader);
+    }
+    return written;
+}
+
+static void print_alignment(void) {
+    char mac[18];
+
+    printf("%-3s %-28s %9s %8s  %-17s %8s %10s %12s %8s\n",
+           "if", "file", "frames", "beacons", "via AP", "shared", "drift ppm", "offset ms", "rms us");
+    for (int d = 0; d < device_count; d++) {
+        const device_t *dev = &devices[d];
+        printf("%-3d %-28s %9llu %8u  ", d, dev->path, (unsigned long long)dev->frames, (unsigned)dev->beacons.beacons);
+        if (d == 0) {
+            printf("%-17s\n", "(reference)");
+        } else if (!dev->aligned) {
+            printf("%-17s\n", "(no shared AP, own clock)");
+        } else {
+            // Offset at the first beacon the fit used
+            uint64_t t = dev->map.src0;
+            double offset_ms = ((double)clock_map_apply(&dev->map, t) - (double)t) / 1e3;
+            format_mac_addr(mac, dev->link.bssid);
+            printf("%-17s %8u %10.2f %12.3f %8.1f", mac, (unsigned)dev->link.beacons,
+                   (dev->map.slope - 1.0) * 1e6, offset_ms, dev->link.rms_us);
+            if (dev->linked_to > 0) {
+                printf("  (via if %d)", dev->linked_to);
+            }
+            printf("\n");
+        }
+    }
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s -o merged.pcapng board1.pcap board2.pcap...\n"
+            "The first file's clock is the reference. Every other board is aligned\n"
+            "through the TSF of an AP both heard (at least %d beacons each), directly\n"
+            "or through other boards; each board becomes one pcapng interface.\n",
+            prog, CLOCK_ALIGN_MIN_BEACONS);
+}
+
+int main(int argc, char **argv) {
+    const char *out_path = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "o:h")) != -1) {
+        switch (opt) {
+            case 'o': out_path = optarg; break;
+            default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    device_count = argc - optind;
+    if (!out_path || device_count < 1 || device_count > MERGE_MAX_DEVICES) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    for (int d = 0; d < device_count; d++) {
+        devices[d].path = argv[optind + d];
+        if (!scan_beacons(&devices[d])) {
+            return 1;
+        }
+    }
+    align_devices();
+
+    FILE *out = fopen(out_path, "wb");
+    if (!out) {
+        perror(out_path);
+        return 1;
+    }
+    write_header(out);
+    uint64_t written = merge_streams(out);
+    if (fclose(out) != 0) {
+        perror(out_path);
+        return 1;
+    }
+
+    print_alignment();
+    uint64_t reordered = 0;
+    for (int d = 0; d < device_count; d++) {
+        reordered += devices[d].reordered;
+    }
+    printf("Wrote %llu frames to %s", (unsigned long long)written, out_path);
+    if (reordered) {
+        printf(" (%llu were out of order within their own file)", (unsigned long long)reordered);
+    }
+    printf("\n");
+    return 0;
+}
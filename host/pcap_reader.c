@@ -0,0 +1,165 @@
+#include "pcap_reader.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Radiotap flags bit: frame includes the FCS
+#define RADIOTAP_F_FCS               0x10
+
+// stdio buffer per open file, so streaming large captures takes few read calls
+#define READER_IO_BUFFER             (1 << 20)
+
+// Channel number of a centre frequency in MHz (0 if unknown)
+static uint8_t channel_from_freq(uint16_t freq) {
+    if (freq == 2484) return 14;
+    if (freq >= 2412 && freq <= 2472) return (freq - 2407) / 5;
+    if (freq >= 5000 && freq <= 5900) return (freq - 5000) / 5;
+    return 0;
+}
+
+// Parse the radiotap fields the ESP receive metadata carries; returns the header length or -1
+static int parse_radiotap(const uint8_t *data, uint32_t len, pcap_frame_t *frame, bool *has_fcs) {
+    // Alignment and size of fields 0-14; later fields are never needed
+    static const uint8_t field_align[15] = {8, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1, 1, 1, 1, 2};
+    static const uint8_t field_size[15] = {8, 1, 1, 4, 2, 1, 1, 2, 2, 2, 1, 1, 1, 1, 2};
+
+    if (len < 8 || data[0] != 0) {
+        return -1;
+    }
+    uint16_t hdr_len = data[2] | (data[3] << 8);
+    if (hdr_len < 8 || hdr_len > len) {
+        return -1;
+    }
+
+    // Skip extended present bitmaps; only the first one is interpreted
+    uint32_t present = data[4] | (data[5] << 8) | (data[6] << 16) | ((uint32_t)data[7] << 24);
+    uint32_t off = 8;
+    uint32_t word = present;
+    while ((word & 0x80000000u) && off + 4 <= hdr_len) {
+        word = data[off] | (data[off + 1] << 8) | (data[off + 2] << 16) | ((uint32_t)data[off + 3] << 24);
+        off += 4;
+    }
+
+    *has_fcs = false;
+    for (int field = 0; field < 15; field++) {
+        if (!(present & (1u << field))) {
+            continue;
+        }
+        off = (off + field_align[field] - 1) & ~(uint32_t)(field_align[field] - 1);
+        if (off + field_size[field] > hdr_len) {
+            break;
+        }
+        const uint8_t *p = data + off;
+        switch (field) {
+            case 1: *has_fcs = (p[0] & RADIOTAP_F_FCS) != 0; break;
+            case 2: frame->rate = p[0]; break;
+            case 3: frame->channel = channel_from_freq(p[0] | (p[1] << 8)); break;
+            case 5: frame->rssi = (int8_t)p[0]; break;
+        }
+        off += field_size[field];
+    }
+    return hdr_len;
+}
+
+static uint32_t read_u32(const uint8_t *p, bool swap) {
+    uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    return swap ? __builtin_bswap32(v) : v;
+}
+
+// Open a capture file and check its header
+bool pcap_reader_open(pcap_reader_t *reader, const char *path) {
+    memset(reader, 0, sizeof(*reader));
+    reader->path = path;
+    reader->f = fopen(path, "rb");
+    if (!reader->f) {
+        perror(path);
+        return false;
+    }
+    setvbuf(reader->f, NULL, _IOFBF, READER_IO_BUFFER);
+
+    uint8_t hdr[24];
+    if (fread(hdr, 1, sizeof(hdr), reader->f) != sizeof(hdr)) {
+        fprintf(stderr, "%s: truncated pcap header\n", path);
+        pcap_reader_close(reader);
+        return false;
+    }
+    uint32_t magic = read_u32(hdr, false);
+    reader->swap = magic == 0xD4C3B2A1 || magic == 0x4D3CB2A1;
+    reader->nanos = magic == 0xA1B23C4D || magic == 0x4D3CB2A1;
+    if (!reader->swap && magic != 0xA1B2C3D4 && !reader->nanos) {
+        fprintf(stderr, "%s: not a pcap file\n", path);
+        pcap_reader_close(reader);
+        return false;
+    }
+    reader->linktype = read_u32(hdr + 20, reader->swap) & 0xFFFF;
+    if (reader->linktype != LINKTYPE_RADIOTAP && reader->linktype != LINKTYPE_IEEE802_11) {
+        fprintf(stderr, "%s: unsupported link type %u (need 105 or 127)\n", path, (unsigned)reader->linktype);
+        pcap_reader_close(reader);
+        return false;
+    }
+
+    reader->buf = malloc(PCAP_READER_SNAPLEN);
+    if (!reader->buf) {
+        pcap_reader_close(reader);
+        return false;
+    }
+    reader->bytes = sizeof(hdr);
+    return true;
+}
+
+// Read the next usable frame
+bool pcap_reader_next(pcap_reader_t *reader, pcap_frame_t *frame) {
+    uint8_t rec[16];
+
+    while (fread(rec, 1, sizeof(rec), reader->f) == sizeof(rec)) {
+        uint32_t incl = read_u32(rec + 8, reader->swap);
+        if (incl > PCAP_READER_SNAPLEN || fread(reader->buf, 1, incl, reader->f) != incl) {
+            fprintf(stderr, "%s: truncated record %u\n", reader->path, (unsigned)reader->records);
+            return false;
+        }
+        reader->records++;
+        reader->bytes += sizeof(rec) + incl;
+
+        memset(frame, 0, sizeof(*frame));
+        uint32_t sub = read_u32(rec + 4, reader->swap);
+        frame->ts_us = (uint64_t)read_u32(rec, reader->swap) * 1000000 + (reader->nanos ? sub / 1000 : sub);
+        frame->rssi = -60;
+
+        uint32_t off = 0;
+        bool has_fcs = false;
+        if (reader->linktype == LINKTYPE_RADIOTAP) {
+            int hdr_len = parse_radiotap(reader->buf, incl, frame, &has_fcs);
+            if (hdr_len < 0) {
+                reader->skipped++;
+                continue;
+            }
+            off = hdr_len;
+        }
+        uint32_t len = incl - off;
+        if (has_fcs) {
+            len = len >= 4 ? len - 4 : 0;
+        }
+        // The ESP receive path carries a 12-bit length that includes the FCS
+        if (len < 10 || len + 4 > 4095) {
+            reader->skipped++;
+            continue;
+        }
+
+        frame->len = len;
+        frame->data = reader->buf + off;
+        frame->record = reader->buf;
+        frame->record_len = incl;
+        frame->orig_len = read_u32(rec + 12, reader->swap);
+        return true;
+    }
+    return false;
+}
+
+// Close the file and free the buffer
+void pcap_reader_close(pcap_reader_t *reader) {
+    if (reader->f) {
+        fclose(reader->f);
+        reader->f = NULL;
+    }
+    free(reader->buf);
+    reader->buf = NULL;
+}
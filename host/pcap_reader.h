@@ -0,0 +1,69 @@
+#ifndef PCAP_READER_H
+#define PCAP_READER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// pcap link types the reader understands
+#define LINKTYPE_IEEE802_11          105
+#define LINKTYPE_RADIOTAP            127
+
+// Largest record the reader accepts
+#define PCAP_READER_SNAPLEN          65536
+
+/**
+ * @brief One 802.11 frame read from a capture file
+ *
+ * data and record point into the reader's buffer and are only valid until
+ * the next read.
+ */
+typedef struct {
+    uint64_t ts_us;              // Capture timestamp
+    uint16_t len;                // Frame length, FCS excluded
+    int8_t rssi;                 // -60 if the file does not say
+    uint8_t channel;             // 0 if the file does not say
+    uint8_t rate;                // 500 kbps units, 0 if the file does not say
+    const uint8_t *data;
+    const uint8_t *record;       // Whole record as stored, link-layer header included
+    uint32_t record_len;
+    uint32_t orig_len;           // Length on the wire, as recorded
+} pcap_frame_t;
+
+/**
+ * @brief Streaming reader of a pcap file (radiotap or bare 802.11)
+ */
+typedef struct {
+    const char *path;
+    FILE *f;
+    bool swap;                   // File is in the other byte order
+    bool nanos;                  // Timestamps are in nanoseconds
+    uint32_t linktype;
+    uint8_t *buf;
+    uint32_t records;            // Records read, skipped ones included
+    uint32_t skipped;            // Records that did not hold a usable frame
+    uint64_t bytes;              // File bytes consumed
+} pcap_reader_t;
+
+/**
+ * @brief Open a capture file and check its header
+ *
+ * @return false (with a message on stderr) if the file cannot be used
+ */
+bool pcap_reader_open(pcap_reader_t *reader, const char *path);
+
+/**
+ * @brief Read the next usable frame
+ *
+ * Records without a usable 802.11 frame are skipped and counted.
+ *
+ * @return false at the end of the file or on a truncated record
+ */
+bool pcap_reader_next(pcap_reader_t *reader, pcap_frame_t *frame);
+
+/**
+ * @brief Close the file and free the buffer
+ */
+void pcap_reader_close(pcap_reader_t *reader);
+
+#endif /* PCAP_READER_H */
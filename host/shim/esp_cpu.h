@@ -0,0 +1,13 @@
+#ifndef ESP_CPU_H
+#define ESP_CPU_H
+
+#include <stdint.h>
+
+typedef uint32_t esp_cpu_cycle_count_t;
+
+/**
+ * @brief CPU cycle counter; the host pretends to run at 1 GHz (see esp_rom_sys.h)
+ */
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void);
+
+#endif /* ESP_CPU_H */
@@ -0,0 +1,10 @@
+#ifndef ESP_ROM_SYS_H
+#define ESP_ROM_SYS_H
+
+#include <stdint.h>
+
+static inline uint32_t esp_rom_get_cpu_ticks_per_us(void) {
+    return 1000;
+}
+
+#endif /* ESP_ROM_SYS_H */
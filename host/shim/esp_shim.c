@@ -0,0 +1,432 @@
+// Host implementations of the ESP-IDF and FreeRTOS calls the sniffer uses
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_system.h"
+#include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// ---- esp_err / esp_log ----
+
+const char *esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK: return "ESP_OK";
+        case ESP_FAIL: return "ESP_FAIL";
+        case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+        default: return "UNKNOWN ERROR";
+    }
+}
+
+static esp_log_level_t log_level = ESP_LOG_INFO;
+static vprintf_like_t log_vprintf = vprintf;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level) {
+    (void)tag;
+    log_level = level;
+}
+
+vprintf_like_t esp_log_set_vprintf(vprintf_like_t func) {
+    vprintf_like_t previous = log_vprintf;
+    log_vprintf = func;
+    return previous;
+}
+
+static int log_to_stderr(const char *format, va_list args) {
+    return vfprintf(stderr, format, args);
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...) {
+    static const char letters[] = "NEWIDV";
+    if (level > log_level) {
+        return;
+    }
+
+    // Keep stdout for program output; logs go to stderr unless redirected
+    vprintf_like_t sink = log_vprintf == vprintf ? log_to_stderr : log_vprintf;
+    va_list args;
+    fprintf(stderr, "%c (%lld) %s: ", letters[level], (long long)(esp_timer_get_time() / 1000), tag);
+    va_start(args, format);
+    sink(format, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
+
+// ---- esp_timer ----
+
+int64_t esp_timer_get_time(void) {
+    static struct timespec start;
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (start.tv_sec == 0 && start.tv_nsec == 0) {
+        start = now;
+    }
+    return (int64_t)(now.tv_sec - start.tv_sec) * 1000000 + (now.tv_nsec - start.tv_nsec) / 1000;
+}
+
+// ---- esp_system ----
+
+uint32_t esp_get_free_heap_size(void) {
+    return 200 * 1024;
+}
+
+// ---- esp_cpu ----
+
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (esp_cpu_cycle_count_t)((uint64_t)now.tv_sec * 1000000000u + now.tv_nsec);
+}
+
+// ---- Tasks ----
+
+struct sim_task {
+    pthread_t thread;
+    TaskFunction_t fn;
+    void *arg;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify;
+    volatile int deleted;
+};
+
+static __thread struct sim_task *current_task = NULL;
+
+// Absolute deadline for a wait of the given number of ticks
+static struct timespec deadline_after(TickType_t ticks) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += ticks / 1000;
+    ts.tv_nsec += (long)(ticks % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return ts;
+}
+
+static void *task_entry(void *param) {
+    current_task = param;
+    current_task->fn(current_task->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                       UBaseType_t priority, TaskHandle_t *handle) {
+    (void)name;
+    (void)stack;
+    (void)priority;
+    // Task records are never freed, so stale handles stay safe to use
+    struct sim_task *task = calloc(1, sizeof(*task));
+    if (!task) {
+        return pdFAIL;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    pthread_mutex_init(&task->lock, NULL);
+    pthread_cond_init(&task->cond, NULL);
+
+    if (handle) {
+        *handle = task;
+    }
+    if (pthread_create(&task->thread, NULL, task_entry, task) != 0) {
+        if (handle) {
+            *handle = NULL;
+        }
+        free(task);
+        return pdFAIL;
+    }
+    pthread_detach(task->thread);
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task == NULL || task == current_task) {
+        pthread_exit(NULL);
+    }
+    // Threads cannot be killed safely while they hold a lock; stop at the next delay
+    task->deleted = 1;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    struct timespec ts = {ticks / 1000, (long)(ticks % 1000) * 1000000};
+    if (current_task && current_task->deleted) {
+        pthread_exit(NULL);
+    }
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+    if (current_task && current_task->deleted) {
+        pthread_exit(NULL);
+    }
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(esp_timer_get_time() / 1000);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+    struct sim_task *task = current_task;
+    if (!task) {
+        vTaskDelay(ticks);
+        return 0;
+    }
+
+    struct timespec deadline = deadline_after(ticks);
+    pthread_mutex_lock(&task->lock);
+    while (task->notify == 0 && !task->deleted) {
+        if (ticks != portMAX_DELAY) {
+            if (pthread_cond_timedwait(&task->cond, &task->lock, &deadline) == ETIMEDOUT) {
+                break;
+            }
+        } else {
+            pthread_cond_wait(&task->cond, &task->lock);
+        }
+    }
+    uint32_t value = task->notify;
+    if (value) {
+        task->notify = clear ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&task->lock);
+    return value;
+}
+
+void xTaskNotifyGive(TaskHandle_t task) {
+    pthread_mutex_lock(&task->lock);
+    task->notify++;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+}
+
+// ---- Queues and semaphores ----
+
+struct sim_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+    uint8_t items[];
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    struct sim_queue *queue = calloc(1, sizeof(*queue) + (size_t)length * item_size);
+    if (!queue) {
+        return NULL;
+    }
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->changed, NULL);
+    queue->length = length;
+    queue->item_size = item_size;
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->changed);
+    free(queue);
+}
+
+// Wait on the queue condition until pred holds or the timeout expires
+static int queue_wait(struct sim_queue *queue, int (*pred)(struct sim_queue *), TickType_t ticks) {
+    struct timespec deadline = deadline_after(ticks);
+    while (!pred(queue)) {
+        if (ticks == 0) {
+            return 0;
+        }
+        if (ticks == portMAX_DELAY) {
+            pthread_cond_wait(&queue->changed, &queue->lock);
+        } else if (pthread_cond_timedwait(&queue->changed, &queue->lock, &deadline) == ETIMEDOUT) {
+            return pred(queue);
+        }
+    }
+    return 1;
+}
+
+static int queue_has_space(struct sim_queue *queue) {
+    return queue->count < queue->length;
+}
+
+static int queue_has_item(struct sim_queue *queue) {
+    return queue->count > 0;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    pthread_mutex_lock(&queue->lock);
+    if (!queue_wait(queue, queue_has_space, ticks)) {
+        pthread_mutex_unlock(&queue->lock);
+        return pdFALSE;
+    }
+    UBaseType_t tail = (queue->head + queue->count) % queue->length;
+    memcpy(queue->items + (size_t)tail * queue->item_size, item, queue->item_size);
+    queue->count++;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+    pthread_mutex_lock(&queue->lock);
+    if (!queue_wait(queue, queue_has_item, ticks)) {
+        pthread_mutex_unlock(&queue->lock);
+        return pdFALSE;
+    }
+    memcpy(item, queue->items + (size_t)queue->head * queue->item_size, queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return count;
+}
+
+struct sim_semaphore {
+    pthread_mutex_t mutex;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    struct sim_semaphore *sem = calloc(1, sizeof(*sem));
+    if (sem) {
+        pthread_mutex_init(&sem->mutex, NULL);
+    }
+    return sem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    if (ticks == portMAX_DELAY) {
+        return pthread_mutex_lock(&sem->mutex) == 0 ? pdTRUE : pdFALSE;
+    }
+    struct timespec deadline = deadline_after(ticks);
+    return pthread_mutex_timedlock(&sem->mutex, &deadline) == 0 ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    return pthread_mutex_unlock(&sem->mutex) == 0 ? pdTRUE : pdFALSE;
+}
+
+// ---- esp_wifi ----
+
+static pthread_mutex_t wifi_lock = PTHREAD_MUTEX_INITIALIZER;
+static wifi_promiscuous_cb_t rx_cb = NULL;
+static bool promiscuous = false;
+static uint32_t filter_mask = WIFI_PROMIS_FILTER_MASK_ALL;
+static uint8_t tuned_channel = 1;
+static wifi_mode_t wifi_mode = WIFI_MODE_AP;
+
+esp_err_t esp_wifi_set_promiscuous_rx_cb(wifi_promiscuous_cb_t cb) {
+    pthread_mutex_lock(&wifi_lock);
+    rx_cb = cb;
+    pthread_mutex_unlock(&wifi_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_promiscuous(bool en) {
+    pthread_mutex_lock(&wifi_lock);
+    promiscuous = en;
+    pthread_mutex_unlock(&wifi_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_promiscuous_filter(const wifi_promiscuous_filter_t *filter) {
+    pthread_mutex_lock(&wifi_lock);
+    filter_mask = filter->filter_mask;
+    pthread_mutex_unlock(&wifi_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_channel(uint8_t primary, wifi_second_chan_t second) {
+    (void)second;
+    if (primary == 0 || (primary > 14 && primary < 32) || primary > 177) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&wifi_lock);
+    tuned_channel = primary;
+    pthread_mutex_unlock(&wifi_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_channel(uint8_t *primary, wifi_second_chan_t *second) {
+    pthread_mutex_lock(&wifi_lock);
+    *primary = tuned_channel;
+    pthread_mutex_unlock(&wifi_lock);
+    if (second) {
+        *second = WIFI_SECOND_CHAN_NONE;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_mode(wifi_mode_t *mode) {
+    *mode = wifi_mode;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode) {
+    wifi_mode = mode;
+    return ESP_OK;
+}
+
+// Scans find nothing; they only take the radio's time, as on the device
+esp_err_t esp_wifi_scan_start(const wifi_scan_config_t *config, bool block) {
+    uint32_t dwell_ms = config->scan_type == WIFI_SCAN_TYPE_ACTIVE ? config->scan_time.active.max
+                                                                    : config->scan_time.passive;
+    int channels = config->channel ? 1 : 13;
+    if (block) {
+        vTaskDelay(pdMS_TO_TICKS(dwell_ms * channels));
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_scan_get_ap_num(uint16_t *number) {
+    *number = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_scan_get_ap_records(uint16_t *number, wifi_ap_record_t *ap_records) {
+    (void)ap_records;
+    *number = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_clear_ap_list(void) {
+    return ESP_OK;
+}
+
+// No stations ever join the simulated softAP
+esp_err_t esp_wifi_ap_get_sta_list(wifi_sta_list_t *sta) {
+    sta->num = 0;
+    return ESP_OK;
+}
+
+// Hand a frame to the registered promiscuous callback, as the driver would
+bool sim_wifi_deliver(wifi_promiscuous_pkt_t *pkt, wifi_promiscuous_pkt_type_t type, bool honor_channel) {
+    pthread_mutex_lock(&wifi_lock);
+    wifi_promiscuous_cb_t cb = promiscuous ? rx_cb : NULL;
+    bool wanted = (filter_mask & (1u << type)) != 0;
+    bool on_channel = !honor_channel || pkt->rx_ctrl.channel == tuned_channel;
+    pthread_mutex_unlock(&wifi_lock);
+
+    if (!cb || !wanted || !on_channel) {
+        return false;
+    }
+    // The driver calls back from the WiFi task; here the replay thread plays that role
+    cb(pkt, type);
+    return true;
+}
@@ -0,0 +1,10 @@
+#ifndef ESP_SYSTEM_H
+#define ESP_SYSTEM_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+// The host has no heap limit; reports what a device with WiFi up typically has free
+uint32_t esp_get_free_heap_size(void);
+
+#endif /* ESP_SYSTEM_H */
@@ -0,0 +1,30 @@
+#ifndef ESP_WIFI_H
+#define ESP_WIFI_H
+
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+
+typedef void (*wifi_promiscuous_cb_t)(void *buf, wifi_promiscuous_pkt_type_t type);
+
+esp_err_t esp_wifi_set_promiscuous_rx_cb(wifi_promiscuous_cb_t cb);
+esp_err_t esp_wifi_set_promiscuous(bool en);
+esp_err_t esp_wifi_set_promiscuous_filter(const wifi_promiscuous_filter_t *filter);
+esp_err_t esp_wifi_set_channel(uint8_t primary, wifi_second_chan_t second);
+esp_err_t esp_wifi_get_channel(uint8_t *primary, wifi_second_chan_t *second);
+esp_err_t esp_wifi_get_mode(wifi_mode_t *mode);
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode);
+esp_err_t esp_wifi_scan_start(const wifi_scan_config_t *config, bool block);
+esp_err_t esp_wifi_scan_get_ap_num(uint16_t *number);
+esp_err_t esp_wifi_scan_get_ap_records(uint16_t *number, wifi_ap_record_t *ap_records);
+esp_err_t esp_wifi_clear_ap_list(void);
+esp_err_t esp_wifi_ap_get_sta_list(wifi_sta_list_t *sta);
+
+/**
+ * @brief Hand a frame to the registered promiscuous callback, as the driver would
+ *
+ * @param honor_channel Drop frames received on a channel other than the tuned one
+ * @return false if the frame was filtered out (promiscuous off, type mask or channel)
+ */
+bool sim_wifi_deliver(wifi_promiscuous_pkt_t *pkt, wifi_promiscuous_pkt_type_t type, bool honor_channel);
+
+#endif /* ESP_WIFI_H */
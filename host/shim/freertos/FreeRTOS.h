@@ -0,0 +1,37 @@
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE                       1
+#define pdFALSE                      0
+#define pdPASS                       1
+#define pdFAIL                       0
+#define portMAX_DELAY                0xFFFFFFFFu
+// 1 kHz tick
+#define portTICK_PERIOD_MS           1
+#define pdMS_TO_TICKS(ms)            ((TickType_t)(ms))
+#define tskIDLE_PRIORITY             0
+
+// Critical sections become a mutex per lock; there is no interrupt masking to emulate
+typedef struct {
+    pthread_mutex_t mutex;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { PTHREAD_MUTEX_INITIALIZER }
+#define portENTER_CRITICAL(mux)      pthread_mutex_lock(&(mux)->mutex)
+#define portEXIT_CRITICAL(mux)       pthread_mutex_unlock(&(mux)->mutex)
+
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+#endif /* FREERTOS_H */
@@ -0,0 +1,7 @@
+#ifndef SDKCONFIG_H
+#define SDKCONFIG_H
+
+// Host simulation: legacy rx_ctrl layout, no HE fields
+#define CONFIG_SOC_WIFI_HE_SUPPORT   0
+
+#endif /* SDKCONFIG_H */
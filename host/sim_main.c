@@ -0,0 +1,443 @@
+// Host simulation: replay a pcap or synthetic traffic through the real sniffer pipeline
+#include "wifi_sniffer.h"
+#include "sniffer_profile.h"
+#include "latency_hist.h"
+#include "load_gen.h"
+#include "traffic_gen.h"
+#include "pcap_reader.h"
+#include "esp_wifi.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const char *TAG = "sim";
+
+// Frames drained per consumer poll, and the poll period
+#define CONSUMER_BATCH               32
+#define CONSUMER_POLL_MS             10
+
+/**
+ * @brief One frame loaded from the capture file
+ */
+typedef struct {
+    uint64_t ts_us;              // Capture timestamp
+    uint16_t len;                // Frame length, FCS excluded
+    int8_t rssi;
+    uint8_t channel;             // 0 if the file does not say
+    uint8_t rate;                // 500 kbps units, 0 if the file does not say
+    uint8_t *data;
+} sim_frame_t;
+
+// Stage times charged by the handler hooks (only the replay thread runs the handler)
+static uint64_t stage_ns[SNIFFER_STAGE_COUNT];
+static uint32_t stage_frames[SNIFFER_STAGE_COUNT];
+static uint64_t stage_last_ns;
+
+// Consumer state
+static volatile bool consumer_stop = false;
+static volatile bool consumer_done = false;
+static latency_hist_t queue_latency;
+static uint32_t consumed = 0;
+
+static const char *stage_names[SNIFFER_STAGE_COUNT] = {
+    "parse", "security", "filter", "analytics", "dedup", "store"
+};
+
+// Monotonic time in nanoseconds
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void sniffer_profile_begin(void) {
+    stage_last_ns = now_ns();
+}
+
+void sniffer_profile_mark(sniffer_stage_t stage) {
+    uint64_t now = now_ns();
+    stage_ns[stage] += now - stage_last_ns;
+    stage_frames[stage]++;
+    stage_last_ns = now;
+}
+
+// ESP legacy rate code of a rate in 500 kbps units (falls back to the basic rate of the band)
+static uint8_t legacy_code_from_rate(uint8_t rate, uint8_t channel) {
+    int code = airtime_legacy_code(rate);
+    if (code >= 0) {
+        return code;
+    }
+    return channel > 14 ? 0x0B : 0x00;
+}
+
+// Load every frame of a pcap file into memory, so file I/O stays out of the measurement
+static sim_frame_t *load_pcap(const char *path, size_t *count) {
+    pcap_reader_t reader;
+    if (!pcap_reader_open(&reader, path)) {
+        return NULL;
+    }
+
+    sim_frame_t *frames = NULL;
+    size_t n = 0, capacity = 0;
+    pcap_frame_t in;
+    while (pcap_reader_next(&reader, &in)) {
+        if (n == capacity) {
+            capacity = capacity ? capacity * 2 : 1024;
+            sim_frame_t *grown = realloc(frames, capacity * sizeof(*frames));
+            if (!grown) {
+                break;
+            }
+            frames = grown;
+        }
+        sim_frame_t frame = {
+            .ts_us = in.ts_us,
+            .len = in.len,
+            .rssi = in.rssi,
+            .channel = in.channel,
+            .rate = in.rate,
+            .data = malloc(in.len),
+        };
+        if (!frame.data) {
+            break;
+        }
+        memcpy(frame.data, in.data, in.len);
+        frames[n++] = frame;
+    }
+    pcap_reader_close(&reader);
+    *count = n;
+    return frames;
+}
+
+// Stand-in for a reader of the capture buffer (web UI, UDP or UART export)
+static void consumer_task(void *pvParameters) {
+    (void)pvParameters;
+    void *packets[CONSUMER_BATCH];
+
+    while (!consumer_stop) {
+        int n = get_captured_packets(packets, CONSUMER_BATCH);
+        uint64_t now = esp_timer_get_time();
+        for (int i = 0; i < n; i++) {
+            packet_info_t *packet = packets[i];
+            latency_hist_add(&queue_latency, (uint32_t)(now - packet->timestamp_us));
+            free(packet);
+        }
+        consumed += n;
+        if (n < CONSUMER_BATCH) {
+            vTaskDelay(pdMS_TO_TICKS(CONSUMER_POLL_MS));
+        }
+    }
+    consumer_done = true;
+    vTaskDelete(NULL);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [options] capture.pcap\n"
+            "       %s -g [options]\n"
+            "  -r            replay at the original pace (default: as fast as possible)\n"
+            "  -c CHANNEL    sniffer channel, 0 to hop (default 1)\n"
+            "  -f FILTER     sniffer filter 0-5 as in start_wifi_sniffer() (default 0)\n"
+            "  -n LOOPS      replay the file this many times (default 1)\n"
+            "  -H            drop frames not on the tuned channel, as the radio would\n"
+            "  -v            show sniffer logs\n"
+            "  -T BSSID      follow this BSS from channel -c (0 to search); use with -r -H\n"
+            "  -G            let the overload governor lower capture fidelity (off: replays run flat out)\n"
+            "synthetic traffic (-g):\n"
+            "  -p FPS        frames per second, 0 for as fast as possible (default 0)\n"
+            "  -d SECONDS    run length (default 2)\n"
+            "  -m MIX        beacon,probe,data,control weights (default 20,10,55,15)\n"
+            "  -a APS        access points (default 16)\n"
+            "  -t STATIONS   clients (default 128)\n"
+            "  -l CHANNELS   channel list (default 1,6,11)\n"
+            "  -S SEED       generator seed (default 1)\n",
+            prog, prog);
+}
+
+// Replay the loaded frames through the driver shim; returns frames delivered
+static uint32_t replay(const sim_frame_t *frames, size_t count, int loops, int channel, bool realtime,
+                       bool honor_channel, latency_hist_t *handler_ns, uint32_t *rejected) {
+    // Reusable driver buffer, large enough for any frame plus its FCS
+    wifi_promiscuous_pkt_t *pkt = calloc(1, sizeof(*pkt) + 4096);
+    uint32_t delivered = 0;
+
+    for (int loop = 0; pkt && loop < loops; loop++) {
+        uint64_t loop_start_us = esp_timer_get_time();
+        for (size_t i = 0; i < count; i++) {
+            const sim_frame_t *frame = &frames[i];
+
+            if (realtime) {
+                uint64_t due = loop_start_us + (frame->ts_us - frames[0].ts_us);
+                int64_t wait = (int64_t)(due - esp_timer_get_time());
+                if (wait > 0) {
+                    struct timespec ts = {wait / 1000000, (wait % 1000000) * 1000};
+                    nanosleep(&ts, NULL);
+                }
+            }
+
+            // What the driver would hand over: rx_ctrl plus the frame with its FCS
+            uint8_t frame_channel = frame->channel ? frame->channel : (channel ? channel : 1);
+            memset(&pkt->rx_ctrl, 0, sizeof(pkt->rx_ctrl));
+            pkt->rx_ctrl.rssi = frame->rssi;
+            pkt->rx_ctrl.rate = legacy_code_from_rate(frame->rate, frame_channel);
+            pkt->rx_ctrl.channel = frame_channel;
+            pkt->rx_ctrl.sig_len = frame->len + 4;
+            pkt->rx_ctrl.noise_floor = -95;
+            memcpy(pkt->payload, frame->data, frame->len);
+            memset(pkt->payload + frame->len, 0, 4);
+
+            static const wifi_promiscuous_pkt_type_t types[4] = {
+                WIFI_PKT_MGMT, WIFI_PKT_CTRL, WIFI_PKT_DATA, WIFI_PKT_MISC
+            };
+            wifi_promiscuous_pkt_type_t type = types[(frame->data[0] >> 2) & 0x03];
+
+            uint64_t t0 = now_ns();
+            bool ok = sim_wifi_deliver(pkt, type, honor_channel);
+            uint64_t t1 = now_ns();
+            if (ok) {
+                delivered++;
+                latency_hist_add(handler_ns, (uint32_t)(t1 - t0));
+            } else {
+                (*rejected)++;
+            }
+        }
+    }
+    free(pkt);
+    return delivered;
+}
+
+// Let the consumer catch up with what was delivered, then stop it
+static void drain_consumer(uint32_t delivered) {
+    for (int i = 0; i < 100 && consumed < delivered; i++) {
+        uint32_t before = consumed;
+        vTaskDelay(pdMS_TO_TICKS(CONSUMER_POLL_MS * 2));
+        if (consumed == before) {
+            break;
+        }
+    }
+    consumer_stop = true;
+    while (!consumer_done) {
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+}
+
+static void print_latency_row(const char *name, const latency_hist_t *hist) {
+    printf("  %-14s %9u %9u %9u %9u\n", name, latency_hist_mean(hist), latency_hist_percentile(hist, 500),
+           latency_hist_percentile(hist, 990), hist->max);
+}
+
+// Capture buffer counters, queue latency and handler stage times
+static void print_pipeline_report(const capture_class_stats_t classes[CAPTURE_CLASS_COUNT], uint16_t peak) {
+    uint32_t offered = 0, lost = 0;
+
+    printf("\nCapture buffer   captured  evicted  dropped     peak\n");
+    for (int c = 0; c < CAPTURE_CLASS_COUNT; c++) {
+        printf("  %-12s %10u %8u %8u %8u\n", capture_buffer_class_name(c), classes[c].captured,
+               classes[c].evicted, classes[c].dropped, classes[c].peak);
+        offered += classes[c].captured + classes[c].dropped;
+        lost += classes[c].evicted + classes[c].dropped;
+    }
+    printf("  %-12s %37u of %d\n", "all", peak, CAPTURE_BUFFER_CAPACITY);
+    printf("  loss %.2f%% of %u frames reaching the buffer, %u consumed\n",
+           offered ? lost * 100.0 / offered : 0, offered, consumed);
+
+    printf("\nLatency                mean       p50       p99       max\n");
+    print_latency_row("queue (us)", &queue_latency);
+
+    printf("\nHandler stage      frames   mean ns\n");
+    for (int s = 0; s < SNIFFER_STAGE_COUNT; s++) {
+        printf("  %-12s %10u %9.0f\n", stage_names[s], stage_frames[s],
+               stage_frames[s] ? (double)stage_ns[s] / stage_frames[s] : 0);
+    }
+}
+
+static bool parse_mac(const char *str, uint8_t *mac) {
+    unsigned int b[6];
+    if (sscanf(str, "%2x:%2x:%2x:%2x:%2x:%2x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != 6) {
+        return false;
+    }
+    for (int i = 0; i < 6; i++) {
+        mac[i] = b[i];
+    }
+    return true;
+}
+
+static void print_follow_report(const follow_target_t *follow) {
+    uint64_t total_us = follow->locked_us + follow->searching_us;
+    printf("\nFollow target    state %s on channel %u, beacon interval %.1f ms\n",
+           follow_target_state_name(follow->state), follow->channel, follow->interval_us / 1e3);
+    printf("  beacons %u, announcements %u, CSA switches %u, moves %u\n",
+           follow->beacons, follow->announcements, follow->csa_switches, follow->moves);
+    printf("  losses %u, reacquisitions %u (mean %.0f ms, max %.0f ms), sweeps %u\n",
+           follow->losses, follow->reacquisitions,
+           follow->reacquisitions ? follow->reacquire_total_us / 1e3 / follow->reacquisitions : 0,
+           follow->reacquire_max_us / 1e3, follow->sweeps);
+    printf("  locked %.3f s (%.1f%%), searching %.3f s\n", follow->locked_us / 1e6,
+           total_us ? follow->locked_us * 100.0 / total_us : 0, follow->searching_us / 1e6);
+}
+
+static void print_governor_report(const load_governor_t *gov) {
+    printf("\nGovernor         level %s, %u steps down, %u up, %u truncated, %u skipped\n",
+           load_governor_level_name(gov->level), gov->steps_down, gov->steps_up, gov->truncated, gov->skipped);
+    printf("  last window: callback %u%%, churn %u/s\n", gov->busy_pct, gov->churn_fps);
+    for (int i = 0; i < LOAD_LEVEL_COUNT; i++) {
+        printf("  %-10s %10u frames %9.3f s\n", load_governor_level_name(i), gov->frames[i], gov->level_us[i] / 1e6);
+    }
+}
+
+int main(int argc, char **argv) {
+    bool realtime = false, honor_channel = false, generate = false, follow_target = false, governed = false;
+    uint8_t follow_bssid[6];
+    int channel = 1, filter = 0, loops = 1;
+    uint32_t fps = 0, seconds = 2;
+    traffic_gen_config_t config;
+    bool valid = true;
+    int opt;
+
+    traffic_gen_default_config(&config);
+    esp_log_level_set("*", ESP_LOG_WARN);
+    while ((opt = getopt(argc, argv, "rc:f:n:HvT:Ggp:d:m:a:t:l:S:")) != -1) {
+        switch (opt) {
+            case 'r': realtime = true; break;
+            case 'c': channel = atoi(optarg); break;
+            case 'f': filter = atoi(optarg); break;
+            case 'n': loops = atoi(optarg) > 0 ? atoi(optarg) : 1; break;
+            case 'H': honor_channel = true; break;
+            case 'v': esp_log_level_set("*", ESP_LOG_INFO); break;
+            case 'T':
+                follow_target = parse_mac(optarg, follow_bssid);
+                valid &= follow_target;
+                break;
+            case 'G': governed = true; break;
+            case 'g': generate = true; break;
+            case 'p': fps = strtoul(optarg, NULL, 10); break;
+            case 'd': seconds = strtoul(optarg, NULL, 10); break;
+            case 'm':
+                valid &= traffic_gen_parse_list(optarg, config.mix, TRAFFIC_GEN_KIND_COUNT) == TRAFFIC_GEN_KIND_COUNT;
+                break;
+            case 'a': config.aps = atoi(optarg); break;
+            case 't': config.stations = atoi(optarg); break;
+            case 'l': {
+                int count = traffic_gen_parse_list(optarg, config.channels, TRAFFIC_GEN_MAX_CHANNELS);
+                valid &= count > 0;
+                config.channel_count = count > 0 ? count : 0;
+                break;
+            }
+            case 'S': config.seed = strtoul(optarg, NULL, 10); break;
+            default: usage(argv[0]); return 2;
+        }
+    }
+    if (!valid || optind != argc - (generate ? 0 : 1) || filter < 0 || filter > 5 || channel < 0 ||
+        seconds == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    size_t count = 0;
+    sim_frame_t *frames = NULL;
+    if (!generate) {
+        frames = load_pcap(argv[optind], &count);
+        if (!frames || count == 0) {
+            ESP_LOGE(TAG, "No frames to replay");
+            return 1;
+        }
+    }
+
+    load_governor_config_t governor_config;
+    load_governor_default_config(&governor_config);
+    governor_config.enabled = governed;
+    wifi_sniffer_set_governor(&governor_config);
+    if (!start_wifi_sniffer(channel, filter)) {
+        ESP_LOGE(TAG, "Failed to start sniffer");
+        return 1;
+    }
+    if (follow_target && !wifi_sniffer_follow(follow_bssid, channel)) {
+        ESP_LOGE(TAG, "Failed to follow target");
+        return 1;
+    }
+    TaskHandle_t consumer = NULL;
+    xTaskCreate(consumer_task, "consumer", 4096, NULL, 5, &consumer);
+
+    capture_class_stats_t classes[CAPTURE_CLASS_COUNT];
+    uint16_t peak;
+    if (generate) {
+        // The same generator task the firmware runs behind /api/loadgen
+        if (!load_gen_start(&config, fps, seconds * 1000)) {
+            ESP_LOGE(TAG, "Failed to start load generator");
+            return 1;
+        }
+        load_gen_status_t status;
+        do {
+            vTaskDelay(pdMS_TO_TICKS(50));
+            load_gen_get_status(&status);
+        } while (status.running);
+        drain_consumer(status.injected);
+        wifi_sniffer_get_class_stats(classes);
+        peak = wifi_sniffer_get_buffer_peak(false);
+        load_governor_t governor;
+        wifi_sniffer_get_governor(&governor);
+        stop_wifi_sniffer();
+
+        double achieved = status.elapsed_ms ? status.injected * 1000.0 / status.elapsed_ms : 0;
+        printf("Generated %u frames in %.3f s: %.0f frames/s", status.injected, status.elapsed_ms / 1e3, achieved);
+        if (fps) {
+            printf(" of %u requested", fps);
+        }
+        printf("\n ");
+        for (int k = 0; k < TRAFFIC_GEN_KIND_COUNT; k++) {
+            printf(" %s %u", traffic_gen_kind_name(k), status.kinds[k]);
+        }
+        printf("\n  population: %u APs, %u stations on %u channels\n", config.aps, config.stations,
+               config.channel_count);
+        print_pipeline_report(classes, peak);
+        printf("\nHandler (ns)        mean       p50       p99     p99.9       max\n");
+        printf("  %-14s %9u %9u %9u %9u %9u\n", "inject", status.handler_mean_ns, status.handler_p50_ns,
+               status.handler_p99_ns, status.handler_p999_ns, status.handler_max_ns);
+        if (governed) {
+            print_governor_report(&governor);
+        }
+        return 0;
+    }
+
+    latency_hist_t handler_ns;
+    latency_hist_init(&handler_ns);
+    uint32_t rejected = 0;
+    uint64_t span_us = frames[count - 1].ts_us - frames[0].ts_us;
+    uint64_t start_us = esp_timer_get_time();
+    uint32_t delivered = replay(frames, count, loops, channel, realtime, honor_channel, &handler_ns, &rejected);
+    uint64_t elapsed_us = esp_timer_get_time() - start_us;
+
+    drain_consumer(delivered);
+    wifi_sniffer_get_class_stats(classes);
+    peak = wifi_sniffer_get_buffer_peak(false);
+    follow_target_t follow;
+    wifi_sniffer_get_follow(&follow);
+    load_governor_t governor;
+    wifi_sniffer_get_governor(&governor);
+    stop_wifi_sniffer();
+
+    double seconds_taken = elapsed_us / 1e6;
+    printf("Replayed %zu frames x %d (%.3f s of capture) in %.3f s%s\n",
+           count, loops, span_us / 1e6, seconds_taken, realtime ? " (real time)" : "");
+    printf("  delivered %u (%.0f frames/s), rejected by radio filter %u\n",
+           delivered, seconds_taken > 0 ? delivered / seconds_taken : 0, rejected);
+    print_pipeline_report(classes, peak);
+    print_latency_row("handler (ns)", &handler_ns);
+    if (follow_target) {
+        print_follow_report(&follow);
+    }
+    if (governed) {
+        print_governor_report(&governor);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        free(frames[i].data);
+    }
+    free(frames);
+    return 0;
+}
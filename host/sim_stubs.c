@@ -0,0 +1,31 @@
+// Stand-ins for firmware modules that need ESP-IDF components the host build lacks
+#include "sim_stubs.h"
+#include "capture_storage.h"
+#include "trigger_capture.h"
+
+sim_stub_pushes_t sim_storage_pushes;
+sim_stub_pushes_t sim_trigger_pushes;
+
+static void record_push(sim_stub_pushes_t *pushes, uint16_t caplen, uint16_t len) {
+    pushes->frames++;
+    pushes->caplen = caplen;
+    pushes->len = len;
+}
+
+// Flash recording needs the FAT partition; host builds only note what would be recorded
+void capture_storage_push(const uint8_t *frame, uint16_t caplen, uint16_t len, int8_t rssi, uint8_t channel,
+                          uint8_t rate, uint64_t timestamp_us) {
+    (void)frame;
+    (void)rssi;
+    (void)channel;
+    (void)rate;
+    (void)timestamp_us;
+    record_push(&sim_storage_pushes, caplen, len);
+}
+
+// Trigger captures are saved to the FAT partition too
+void trigger_capture_push(const frame_info_t *info, const uint8_t *frame, uint16_t caplen, uint8_t rate) {
+    (void)frame;
+    (void)rate;
+    record_push(&sim_trigger_pushes, caplen, info->length);
+}
@@ -0,0 +1,19 @@
+#ifndef SIM_STUBS_H
+#define SIM_STUBS_H
+
+#include <stdint.h>
+
+/**
+ * @brief What a stand-in was handed, for host tests to check
+ */
+typedef struct {
+    uint32_t frames;
+    uint16_t caplen;             // Of the last frame
+    uint16_t len;
+} sim_stub_pushes_t;
+
+// Frames offered to flash recording and to the trigger slots
+extern sim_stub_pushes_t sim_storage_pushes;
+extern sim_stub_pushes_t sim_trigger_pushes;
+
+#endif /* SIM_STUBS_H */
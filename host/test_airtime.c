@@ -0,0 +1,147 @@
+// Host test: frame durations against the 802.11 TXTIME formulas, and channel slot eviction
+#include "host_test.h"
+#include "airtime.h"
+#include <string.h>
+
+typedef struct {
+    airtime_phy_t phy;
+    uint16_t psdu_len;
+    uint32_t expected_us;
+} duration_case_t;
+
+// Expected values worked out by hand from the preamble lengths and data bits per symbol
+static const duration_case_t durations[] = {
+    // DSSS: 192/96 us PLCP, then 8 * len / Mbps
+    {{AIRTIME_PHY_DSSS, 2, 1, 20, 0, false}, 100, 192 + 800},
+    {{AIRTIME_PHY_DSSS, 22, 1, 20, 0, true}, 100, 96 + 73},
+    {{AIRTIME_PHY_DSSS, 11, 1, 20, 0, false}, 1500, 192 + 2182},
+    // OFDM: 20 us + 4 us per ceil((16 + 8 * len + 6) / NDBPS) symbols
+    {{AIRTIME_PHY_OFDM, 12, 1, 20, 0, false}, 100, 20 + 4 * 35},
+    {{AIRTIME_PHY_OFDM, 108, 1, 20, 0, false}, 1500, 20 + 4 * 56},
+    {{AIRTIME_PHY_OFDM, 108, 1, 20, 0, false}, 14, 20 + 4 * 1},
+    // HT mixed format: 32 us + 4 us per HT-LTF
+    {{AIRTIME_PHY_HT, 7, 1, 20, 800, false}, 1500, 36 + 4 * 47},
+    {{AIRTIME_PHY_HT, 0, 1, 20, 800, false}, 100, 36 + 4 * 32},
+    {{AIRTIME_PHY_HT, 15, 2, 40, 400, false}, 1500, 84},      // 40 + 12 * 3.6 = 83.2
+    // VHT: 36 us + 4 us per VHT-LTF
+    {{AIRTIME_PHY_VHT, 9, 1, 80, 400, false}, 1500, 69},      // 40 + 8 * 3.6 = 68.8
+    {{AIRTIME_PHY_VHT, 4, 2, 40, 800, false}, 1500, 44 + 4 * 19},
+    // HE SU: 36 us + (6.4 + GI) per HE-LTF, 12.8 us + GI symbols
+    {{AIRTIME_PHY_HE, 11, 2, 80, 800, false}, 1500, 64},      // 50.4 + 1 * 13.6
+    {{AIRTIME_PHY_HE, 0, 1, 20, 3200, false}, 100, 174},      // 45.6 + 8 * 16.0 = 173.6
+    {{AIRTIME_PHY_HE, 7, 1, 20, 0, false}, 1500, 193},       // GI defaults to 0.8 us: 43.2 + 11 * 13.6
+};
+
+static void check_durations(void) {
+    for (size_t i = 0; i < sizeof(durations) / sizeof(durations[0]); i++) {
+        const duration_case_t *c = &durations[i];
+        uint32_t us = airtime_duration_us(&c->phy, c->psdu_len);
+        if (us != c->expected_us) {
+            fprintf(stderr, "case %zu: format %u rate %u\n", i, c->phy.format, c->phy.rate);
+        }
+        CHECK_EQ(us, c->expected_us);
+    }
+
+    // Parameters no PHY can carry
+    airtime_phy_t bad = {AIRTIME_PHY_HT, 7, 1, 80, 800, false};
+    CHECK_EQ(airtime_duration_us(&bad, 100), 0);
+    bad = (airtime_phy_t){AIRTIME_PHY_VHT, 10, 1, 20, 800, false};
+    CHECK_EQ(airtime_duration_us(&bad, 100), 0);
+    bad = (airtime_phy_t){AIRTIME_PHY_DSSS, 0, 1, 20, 0, false};
+    CHECK_EQ(airtime_duration_us(&bad, 100), 0);
+    bad = (airtime_phy_t){AIRTIME_PHY_HE, 12, 1, 20, 800, false};
+    CHECK_EQ(airtime_duration_us(&bad, 100), 0);
+}
+
+static void check_legacy_codes(void) {
+    airtime_phy_t phy;
+    CHECK(airtime_phy_from_legacy_code(0x0B, &phy));
+    CHECK_EQ(phy.format, AIRTIME_PHY_OFDM);
+    CHECK_EQ(phy.rate, 12);
+    CHECK(airtime_phy_from_legacy_code(0x07, &phy));
+    CHECK_EQ(phy.format, AIRTIME_PHY_DSSS);
+    CHECK(phy.short_preamble);
+    CHECK(!airtime_phy_from_legacy_code(0x04, &phy));
+    CHECK(!airtime_phy_from_legacy_code(0x10, &phy));
+
+    CHECK_EQ(airtime_legacy_code(12), 0x0B);
+    CHECK_EQ(airtime_legacy_code(22), 0x03);
+    CHECK_EQ(airtime_legacy_code(13), -1);
+    CHECK_EQ(airtime_legacy_code(0), -1);
+}
+
+static const airtime_channel_t *find_channel(const airtime_t *at, uint8_t channel) {
+    for (int i = 0; i < AIRTIME_MAX_CHANNELS; i++) {
+        if (at->channels[i].channel == channel) return &at->channels[i];
+    }
+    return NULL;
+}
+
+// Hopping over more channels than there are slots keeps the most recent ones
+static void check_eviction(void) {
+    static airtime_t at;
+    static const uint8_t hop[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13,
+                                  36, 40, 44, 48, 52, 56, 60, 64, 100, 149, 165};
+    const int hops = sizeof(hop) / sizeof(hop[0]);
+    uint64_t now_us = 1000000;
+
+    airtime_init(&at, now_us);
+    for (int i = 0; i < hops; i++) {
+        airtime_dwell_begin(&at, hop[i], now_us);
+        // 25% busy: ten 2.5 ms frames in 100 ms, one of them straddling the hop
+        for (int f = 0; f < 10; f++) {
+            airtime_update(&at, hop[i], 2500, now_us + f * 10000);
+        }
+        airtime_update(&at, i > 0 ? hop[i - 1] : 0, 2500, now_us + 50000);
+        now_us += 100000;
+    }
+    airtime_dwell_end(&at, now_us);
+
+    CHECK_EQ(at.evictions, hops - AIRTIME_MAX_CHANNELS);
+    CHECK_EQ(at.dropped_frames, hops);
+    for (int i = 0; i < hops; i++) {
+        const airtime_channel_t *ch = find_channel(&at, hop[i]);
+        if (i < hops - AIRTIME_MAX_CHANNELS) {
+            CHECK(ch == NULL);
+            continue;
+        }
+        CHECK(ch != NULL);
+        if (ch) {
+            CHECK_EQ(ch->frames, 10);
+            CHECK_EQ(ch->count, 1);
+            CHECK_EQ(ch->busy_us, 25000);
+            CHECK_EQ(airtime_sample(ch, 0)->busy_permille, 250);
+        }
+    }
+
+    // Revisiting a channel refreshes it, so the next eviction takes the one after it
+    uint8_t oldest = hop[hops - AIRTIME_MAX_CHANNELS];
+    uint8_t second = hop[hops - AIRTIME_MAX_CHANNELS + 1];
+    airtime_dwell_begin(&at, oldest, now_us);
+    airtime_dwell_begin(&at, 1, now_us + 100000);
+    airtime_dwell_end(&at, now_us + 200000);
+    CHECK(find_channel(&at, oldest) != NULL);
+    CHECK(find_channel(&at, second) == NULL);
+    CHECK(find_channel(&at, 1) != NULL);
+    CHECK_EQ(at.evictions, hops - AIRTIME_MAX_CHANNELS + 1);
+
+    // Without a hopper dwells roll over on their own
+    airtime_init(&at, 0);
+    for (uint64_t t = 0; t < 3 * AIRTIME_MAX_DWELL_US; t += 1000) {
+        airtime_update(&at, 6, 100, t);
+    }
+    const airtime_channel_t *ch = find_channel(&at, 6);
+    CHECK(ch != NULL);
+    if (ch) {
+        CHECK_EQ(ch->count, 2);
+        CHECK_EQ(airtime_sample(ch, 0)->busy_permille, 100);
+    }
+    CHECK_EQ(at.evictions, 0);
+}
+
+int main(void) {
+    check_durations();
+    check_legacy_codes();
+    check_eviction();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,238 @@
+// Host test: UDP export batches, checked in C and over loopback by tools/udp_receiver.py
+#include "host_test.h"
+#include "export_batch.h"
+#include "pcap.h"
+#include "pcap_reader.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define FRAMES                       192
+// Batch sequence number the sender skips, as if the datagram was lost
+#define SKIPPED_SEQ                  5
+#define MAX_DATAGRAMS                64
+
+typedef struct {
+    uint8_t data[EXPORT_BATCH_MAX_LEN];
+    size_t len;
+} datagram_t;
+
+static datagram_t datagrams[MAX_DATAGRAMS];
+static int datagram_count = 0;
+
+static uint16_t frame_len(int i) {
+    return 24 + (i * 53) % 600;
+}
+
+static void fill_frame(int i, uint8_t *frame) {
+    for (int j = 0; j < frame_len(i); j++) {
+        frame[j] = (uint8_t)(i * 11 + j);
+    }
+}
+
+static uint32_t get_le32(const uint8_t *p) {
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// Batch FRAMES frames the way the export task does: finish when the next one does not fit
+static void build_datagrams(void) {
+    static export_batch_t batch;
+    uint8_t frame[1024];
+    uint32_t seq = 0;
+
+    export_batch_reset(&batch);
+    for (int i = 0; i < FRAMES; i++) {
+        fill_frame(i, frame);
+        if (!export_batch_add(&batch, frame, frame_len(i), frame_len(i), -45, 11, 12, 1700000000000000ull + i)) {
+            datagram_t *d = &datagrams[datagram_count++];
+            if (seq == SKIPPED_SEQ) {
+                seq++;
+            }
+            d->len = export_batch_finish(&batch, seq++, 3);
+            memcpy(d->data, batch.data, d->len);
+            export_batch_reset(&batch);
+            CHECK(export_batch_add(&batch, frame, frame_len(i), frame_len(i), -45, 11, 12,
+                                   1700000000000000ull + i));
+        }
+    }
+    datagram_t *d = &datagrams[datagram_count++];
+    d->len = export_batch_finish(&batch, seq, 3);
+    memcpy(d->data, batch.data, d->len);
+}
+
+// What a collector sees: headers, sequence gaps and the records inside
+static void check_datagrams(void) {
+    uint32_t expected_seq = 0, lost = 0;
+    int next_frame = 0;
+
+    for (int b = 0; b < datagram_count; b++) {
+        const datagram_t *d = &datagrams[b];
+        CHECK(d->len <= EXPORT_BATCH_MAX_LEN);
+        CHECK_EQ(get_le32(d->data), EXPORT_BATCH_MAGIC);
+        CHECK_EQ(d->data[4], EXPORT_BATCH_VERSION);
+        uint16_t count = d->data[6] | d->data[7] << 8;
+        uint32_t seq = get_le32(d->data + 8);
+        CHECK_EQ(get_le32(d->data + 12), 3);
+        lost += seq - expected_seq;
+        expected_seq = seq + 1;
+
+        size_t off = EXPORT_BATCH_HEADER_LEN;
+        for (uint16_t r = 0; r < count; r++) {
+            uint32_t incl = get_le32(d->data + off + 8);
+            CHECK_EQ(get_le32(d->data + off + 4), next_frame);
+            CHECK_EQ(incl, PCAP_RADIOTAP_LEN + frame_len(next_frame));
+            CHECK_EQ(d->data[off + PCAP_RECORD_PREFIX_LEN], (uint8_t)(next_frame * 11));
+            off += PCAP_RECORD_HEADER_LEN + incl;
+            next_frame++;
+        }
+        CHECK_EQ(off, d->len);
+    }
+    CHECK_EQ(next_frame, FRAMES);
+    CHECK_EQ(lost, 1);
+}
+
+static void check_limits(void) {
+    static export_batch_t batch;
+    static uint8_t frame[2000];
+
+    // A frame larger than a datagram is truncated; orig_len keeps the size on air
+    export_batch_reset(&batch);
+    CHECK(export_batch_add(&batch, frame, sizeof(frame), sizeof(frame), -45, 1, 2, 0));
+    CHECK_EQ(batch.len, EXPORT_BATCH_MAX_LEN);
+    CHECK_EQ(get_le32(batch.data + EXPORT_BATCH_HEADER_LEN + 12), PCAP_RADIOTAP_LEN + sizeof(frame));
+
+    // A full batch refuses the next record and stays as it was
+    CHECK(!export_batch_add(&batch, frame, 1, 1, -45, 1, 2, 1));
+    CHECK_EQ(batch.len, EXPORT_BATCH_MAX_LEN);
+    CHECK_EQ(batch.count, 1);
+}
+
+// Start the receiver on a free loopback port; its stderr goes to log_path
+static pid_t start_receiver(const char *python, const char *script, const char *out_path, const char *log_path,
+                            int *port) {
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    socklen_t addr_len = sizeof(addr);
+    int probe = socket(AF_INET, SOCK_DGRAM, 0);
+    bind(probe, (struct sockaddr *)&addr, sizeof(addr));
+    getsockname(probe, (struct sockaddr *)&addr, &addr_len);
+    *port = ntohs(addr.sin_port);
+    close(probe);
+
+    char port_arg[8];
+    snprintf(port_arg, sizeof(port_arg), "%d", *port);
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (!freopen(log_path, "w", stderr)) _exit(127);
+        execl(python, python, script, "-b", "127.0.0.1", "-p", port_arg, "-o", out_path, (char *)NULL);
+        _exit(127);
+    }
+    return pid;
+}
+
+// Wait until the receiver's log holds a line starting with prefix
+static bool wait_for_log(const char *log_path, const char *prefix, char *line, size_t line_len) {
+    for (int tries = 0; tries < 500; tries++) {
+        FILE *f = fopen(log_path, "r");
+        bool found = false;
+        while (f && fgets(line, line_len, f)) {
+            // Reports start with a carriage return
+            const char *text = line[0] == '\r' ? line + 1 : line;
+            if (strncmp(text, prefix, strlen(prefix)) == 0) {
+                memmove(line, text, strlen(text) + 1);
+                found = true;
+            }
+        }
+        if (f) fclose(f);
+        if (found) return true;
+        usleep(10000);
+    }
+    return false;
+}
+
+// Send the datagrams over loopback to tools/udp_receiver.py and read its pcap back
+static void check_receiver(const char *python, const char *script) {
+    char out_path[] = "/tmp/test_export_out_XXXXXX";
+    char log_path[] = "/tmp/test_export_log_XXXXXX";
+    int fds[2] = {mkstemp(out_path), mkstemp(log_path)};
+    if (fds[0] < 0 || fds[1] < 0) {
+        CHECK(!"temporary files");
+        return;
+    }
+    close(fds[0]);
+    close(fds[1]);
+
+    int port;
+    char line[256];
+    pid_t pid = start_receiver(python, script, out_path, log_path, &port);
+    if (pid < 0 || !wait_for_log(log_path, "Listening", line, sizeof(line))) {
+        CHECK(!"receiver did not start");
+        if (pid > 0) kill(pid, SIGKILL);
+        return;
+    }
+
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(port),
+                               .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    for (int b = 0; b < datagram_count; b++) {
+        sendto(sock, datagrams[b].data, datagrams[b].len, 0, (struct sockaddr *)&addr, sizeof(addr));
+        // Anything that is not a batch is reported as malformed
+        if (b == 2) {
+            sendto(sock, "hello", 5, 0, (struct sockaddr *)&addr, sizeof(addr));
+        }
+    }
+    close(sock);
+
+    // Give the receiver time to drain the socket, then stop it for its summary
+    usleep(300000);
+    kill(pid, SIGTERM);
+    int status;
+    waitpid(pid, &status, 0);
+
+    unsigned batches = 0, frames = 0, lost = 0, late = 0, bad = 0, dropped = 0;
+    CHECK(wait_for_log(log_path, "", line, sizeof(line)));
+    CHECK_EQ(sscanf(line, "%u batches, %u frames, %u batches lost, %u late, %u malformed, %u dropped on device",
+                    &batches, &frames, &lost, &late, &bad, &dropped), 6);
+    CHECK_EQ(batches, datagram_count);
+    CHECK_EQ(frames, FRAMES);
+    CHECK_EQ(lost, 1);
+    CHECK_EQ(late, 0);
+    CHECK_EQ(bad, 1);
+    CHECK_EQ(dropped, 3);
+
+    pcap_reader_t reader;
+    pcap_frame_t frame;
+    uint8_t expected[1024];
+    CHECK(pcap_reader_open(&reader, out_path));
+    for (int i = 0; i < FRAMES; i++) {
+        if (!pcap_reader_next(&reader, &frame)) {
+            CHECK(!"record missing");
+            break;
+        }
+        fill_frame(i, expected);
+        CHECK_EQ(frame.ts_us, 1700000000000000ull + i);
+        CHECK_EQ(frame.len, frame_len(i));
+        CHECK_EQ(frame.channel, 11);
+        CHECK(memcmp(frame.data, expected, frame_len(i)) == 0);
+    }
+    CHECK(!pcap_reader_next(&reader, &frame));
+    pcap_reader_close(&reader);
+
+    remove(out_path);
+    remove(log_path);
+}
+
+// Usage: test_export_batch [python3 path/to/udp_receiver.py]
+int main(int argc, char **argv) {
+    check_limits();
+    build_datagrams();
+    check_datagrams();
+    if (argc > 2) {
+        check_receiver(argv[1], argv[2]);
+    }
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,189 @@
+// Host test: follow-target session against a scripted AP that announces a channel switch, goes silent and returns elsewhere
+#include "host_test.h"
+#include "follow_target.h"
+#include <string.h>
+
+// Poll period of the follow task in wifi_sniffer.c
+#define POLL_US                      20000
+#define BEACON_INTERVAL_TU           100
+#define BEACON_INTERVAL_US           (BEACON_INTERVAL_TU * 1024)
+
+static const uint8_t bssid[6] = {0x24, 0x0A, 0xC4, 0x00, 0x00, 0x48};
+static const uint8_t plan[] = {1, 6, 11, 3, 9, 13, 2, 4, 5, 7, 8, 10, 12};
+
+// The scripted AP and the radio listening for it
+static struct {
+    uint64_t now_us;
+    uint64_t next_beacon_us;
+    uint8_t ap_channel;
+    bool silent;
+    uint8_t csa_channel;         // Announced channel while csa_count > 0
+    uint8_t csa_count;           // Beacons left before the switch
+    uint8_t tuned;               // Channel the follower asked for at the last poll
+    uint64_t locked_at_us;       // Last time the follower went from searching to locked
+} sim;
+
+// 2.4 GHz neighbours overlap, so a beacon is heard one channel away too
+static bool hears(uint8_t tuned, uint8_t channel) {
+    return tuned && (tuned == channel || tuned + 1 == channel || tuned == channel + 1);
+}
+
+static void deliver(follow_target_t *ft, const uint8_t *frame, size_t len) {
+    frame_info_t info;
+    CHECK(ieee80211_parse_frame(frame, len, &info));
+    info.channel = sim.tuned;
+    info.timestamp_us = sim.now_us;
+    CHECK(follow_target_observe(ft, &info));
+}
+
+// Beacon with the DS element, and the channel switch announcement while one is running
+static void send_beacon(follow_target_t *ft) {
+    uint8_t frame[64] = {0x80, 0x00};
+    memset(frame + 4, 0xFF, 6);
+    memcpy(frame + 10, bssid, 6);
+    memcpy(frame + 16, bssid, 6);
+    size_t len = 24 + 8;
+    frame[len++] = BEACON_INTERVAL_TU & 0xFF;
+    frame[len++] = BEACON_INTERVAL_TU >> 8;
+    frame[len++] = 0x01;
+    frame[len++] = 0x00;
+    static const uint8_t ssid[] = {IEEE80211_IE_SSID, 4, 'f', 'o', 'l', 'o'};
+    memcpy(frame + len, ssid, sizeof(ssid));
+    len += sizeof(ssid);
+    frame[len++] = IEEE80211_IE_DS_PARAMS;
+    frame[len++] = 1;
+    frame[len++] = sim.ap_channel;
+    if (sim.csa_count) {
+        frame[len++] = IEEE80211_IE_CSA;
+        frame[len++] = 3;
+        frame[len++] = 1;
+        frame[len++] = sim.csa_channel;
+        frame[len++] = sim.csa_count;
+    }
+    deliver(ft, frame, len);
+}
+
+// Run the AP and the follow task for a while, 1 ms at a time
+static void run(follow_target_t *ft, uint64_t duration_us) {
+    uint64_t end_us = sim.now_us + duration_us;
+    for (; sim.now_us < end_us; sim.now_us += 1000) {
+        if (sim.now_us % POLL_US == 0) {
+            sim.tuned = follow_target_poll(ft, sim.now_us);
+        }
+        if (sim.now_us < sim.next_beacon_us) {
+            continue;
+        }
+        sim.next_beacon_us += BEACON_INTERVAL_US;
+
+        // The announced switch happens where the count would reach 0
+        if (sim.csa_count == 0 && sim.csa_channel) {
+            sim.ap_channel = sim.csa_channel;
+            sim.csa_channel = 0;
+        }
+        if (!sim.silent && hears(sim.tuned, sim.ap_channel)) {
+            follow_state_t before = ft->state;
+            send_beacon(ft);
+            if (before == FOLLOW_SEARCHING && ft->state == FOLLOW_LOCKED) {
+                sim.locked_at_us = sim.now_us;
+            }
+        }
+        if (sim.csa_count) {
+            sim.csa_count--;
+        }
+    }
+}
+
+// Data frames of the BSS leak onto neighbouring channels; they never move or refresh the lock
+static void check_leaked_data(follow_target_t *ft) {
+    uint8_t frame[24] = {0x08, 0x02};
+    memset(frame + 4, 0x02, 6);
+    memcpy(frame + 10, bssid, 6);
+    memcpy(frame + 16, bssid, 6);
+    uint64_t last_heard_us = ft->last_heard_us;
+    CHECK(sim.now_us > last_heard_us);
+    uint8_t tuned = sim.tuned;
+    sim.tuned = ft->channel + 1;
+    deliver(ft, frame, sizeof(frame));
+    CHECK_EQ(ft->state, FOLLOW_LOCKED);
+    CHECK_EQ(ft->channel, 6);
+    CHECK_EQ(ft->moves, 0);
+    CHECK_EQ(ft->last_heard_us, last_heard_us);
+
+    // On the locked channel they are a sign of life
+    sim.tuned = ft->channel;
+    deliver(ft, frame, sizeof(frame));
+    CHECK_EQ(ft->last_heard_us, sim.now_us);
+    sim.tuned = tuned;
+}
+
+int main(void) {
+    static follow_target_t ft;
+    memset(&sim, 0, sizeof(sim));
+    sim.now_us = 1000000;
+    sim.next_beacon_us = sim.now_us + 7000;
+    sim.ap_channel = 6;
+    follow_target_init(&ft, bssid, 6, plan, sizeof(plan), sim.now_us);
+    CHECK_EQ(ft.state, FOLLOW_LOCKED);
+    CHECK_EQ(ft.channel, 6);
+
+    // Steady beacons on channel 6
+    run(&ft, 2000000);
+    CHECK_EQ(ft.state, FOLLOW_LOCKED);
+    CHECK_EQ(ft.channel, 6);
+    CHECK_EQ(ft.interval_us, BEACON_INTERVAL_US);
+    CHECK(ft.beacons >= 19 && ft.beacons <= 20);
+    check_leaked_data(&ft);
+
+    // The AP announces a move to 11 five beacons ahead; the follower waits for the count
+    sim.csa_channel = 11;
+    sim.csa_count = 5;
+    run(&ft, 3 * BEACON_INTERVAL_US);
+    CHECK_EQ(ft.channel, 6);
+    CHECK(ft.csa_pending);
+    CHECK_EQ(ft.announcements, 1);
+    run(&ft, 1000000);
+    CHECK_EQ(ft.state, FOLLOW_LOCKED);
+    CHECK_EQ(ft.channel, 11);
+    CHECK_EQ(ft.csa_switches, 1);
+    CHECK_EQ(ft.announcements, 1);
+    CHECK_EQ(ft.losses, 0);
+    uint32_t beacons = ft.beacons;
+    run(&ft, 1000000);
+    CHECK(ft.beacons - beacons >= 9);
+
+    // Silence for 3 s, then the AP returns on channel 5 without an announcement
+    sim.silent = true;
+    sim.ap_channel = 5;
+    uint64_t silent_at_us = sim.now_us;
+    // The last beacon came up to one interval before the silence
+    run(&ft, (FOLLOW_LOST_BEACONS - 1) * BEACON_INTERVAL_US - POLL_US);
+    CHECK_EQ(ft.state, FOLLOW_LOCKED);
+    CHECK_EQ(ft.channel, 11);
+    run(&ft, BEACON_INTERVAL_US + 2 * POLL_US);
+    CHECK_EQ(ft.state, FOLLOW_SEARCHING);
+    CHECK_EQ(ft.losses, 1);
+    CHECK_EQ(ft.channel, plan[0]);
+    run(&ft, silent_at_us + 3000000 - sim.now_us);
+    CHECK_EQ(ft.state, FOLLOW_SEARCHING);
+    CHECK(ft.sweeps >= 1);
+    CHECK_EQ(ft.reacquisitions, 0);
+
+    // Heard on 4, 5 or 6, the DS element puts the lock on 5
+    uint64_t back_at_us = sim.now_us;
+    sim.silent = false;
+    run(&ft, 3000000);
+    CHECK_EQ(ft.state, FOLLOW_LOCKED);
+    CHECK_EQ(ft.channel, 5);
+    CHECK_EQ(ft.reacquisitions, 1);
+    CHECK_EQ(ft.losses, 1);
+    CHECK_EQ(ft.moves, 0);
+    CHECK(sim.locked_at_us >= back_at_us);
+    CHECK(sim.locked_at_us - back_at_us <= sizeof(plan) * FOLLOW_SEARCH_DWELL_MS * 1000 + BEACON_INTERVAL_US);
+    CHECK_EQ(ft.reacquire_max_us, sim.locked_at_us - ft.lost_us);
+
+    // Every polled interval is accounted to one state or the other
+    CHECK_NEAR((double)(ft.locked_us + ft.searching_us), (double)(sim.now_us - 1000000), POLL_US);
+    CHECK(strcmp(follow_target_state_name(ft.state), "locked") == 0);
+
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,90 @@
+// Host test: frames reach flash recording and the trigger slots cut to the overload governor's level
+#include "host_test.h"
+#include "sim_stubs.h"
+#include "sniffer_profile.h"
+#include "wifi_sniffer.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define FRAME_LEN                    1000
+#define HEADER_LEN                   24
+
+// The stage profiler is sim_main's; this test does not time stages
+void sniffer_profile_begin(void) {
+}
+
+void sniffer_profile_mark(sniffer_stage_t stage) {
+    (void)stage;
+}
+
+static load_level_t governor_level(void) {
+    load_governor_t governor;
+    wifi_sniffer_get_governor(&governor);
+    return governor.level;
+}
+
+int main(void) {
+    // Free heap always under the low mark: every window is overloaded and
+    // the governor steps down one level per window
+    load_governor_config_t config;
+    load_governor_default_config(&config);
+    config.raise_windows = 1;
+    config.heap_low_bytes = UINT32_MAX;
+    config.heap_high_bytes = UINT32_MAX;
+    wifi_sniffer_set_governor(&config);
+    CHECK(start_wifi_sniffer(6, 0));
+
+    // To-DS data frame, so it is neither sampled in as important nor left unparsed
+    wifi_promiscuous_pkt_t *pkt = calloc(1, sizeof(*pkt) + FRAME_LEN + 4);
+    pkt->payload[0] = 0x08;
+    pkt->payload[1] = 0x01;
+    memset(pkt->payload + 4, 0x02, 18);
+    pkt->payload[9] = 0x50;
+
+    uint32_t offered[LOAD_LEVEL_COUNT] = {0};
+    uint32_t stored[LOAD_LEVEL_COUNT] = {0};
+    for (int i = 0; i < 10000 && governor_level() != LOAD_LEVEL_COUNTERS; i++) {
+        usleep(1000);
+        load_level_t level = governor_level();
+        sim_stub_pushes_t before = sim_storage_pushes;
+        uint32_t triggers = sim_trigger_pushes.frames;
+        CHECK(wifi_sniffer_inject(pkt, FRAME_LEN, -50, 6, 12));
+        offered[level]++;
+        if (sim_storage_pushes.frames == before.frames) {
+            continue;
+        }
+        stored[level]++;
+
+        static const uint16_t expected[LOAD_LEVEL_COUNT] = {
+            [LOAD_LEVEL_FULL]     = FRAME_LEN,
+            [LOAD_LEVEL_SNAPLEN]  = LOAD_GOVERNOR_SNAPLEN,
+            [LOAD_LEVEL_HEADERS]  = HEADER_LEN,
+            [LOAD_LEVEL_SAMPLED]  = HEADER_LEN,
+        };
+        CHECK_EQ(sim_storage_pushes.caplen, expected[level]);
+        CHECK_EQ(sim_storage_pushes.len, FRAME_LEN);
+        CHECK_EQ(sim_trigger_pushes.frames, triggers + 1);
+        CHECK_EQ(sim_trigger_pushes.caplen, expected[level]);
+        CHECK_EQ(sim_trigger_pushes.len, FRAME_LEN);
+    }
+    CHECK_EQ(governor_level(), LOAD_LEVEL_COUNTERS);
+
+    // Every level was seen; only sampling and counters leave frames out
+    for (int level = LOAD_LEVEL_FULL; level < LOAD_LEVEL_COUNTERS; level++) {
+        CHECK(offered[level] > 0);
+    }
+    CHECK_EQ(stored[LOAD_LEVEL_FULL], offered[LOAD_LEVEL_FULL]);
+    CHECK_EQ(stored[LOAD_LEVEL_SNAPLEN], offered[LOAD_LEVEL_SNAPLEN]);
+    CHECK_EQ(stored[LOAD_LEVEL_HEADERS], offered[LOAD_LEVEL_HEADERS]);
+    CHECK_EQ(stored[LOAD_LEVEL_SAMPLED], offered[LOAD_LEVEL_SAMPLED] / LOAD_GOVERNOR_SAMPLE_N);
+
+    // At the counters level nothing is recorded
+    uint32_t frames = sim_storage_pushes.frames;
+    CHECK(wifi_sniffer_inject(pkt, FRAME_LEN, -50, 6, 12));
+    CHECK_EQ(sim_storage_pushes.frames, frames);
+
+    stop_wifi_sniffer();
+    free(pkt);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,178 @@
+// Host test: HyperLogLog estimates against known cardinalities of synthetic MAC streams
+#include "host_test.h"
+#include "hll.h"
+#include <math.h>
+#include <string.h>
+
+// Standard error of a p=8 sketch is 1.04 / sqrt(256), 6.5%
+#define HLL_STD_ERROR                (1.04 / 16.0)
+#define TRIALS                       40
+
+static uint32_t rng = 31;
+
+static uint32_t next_random(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+// A MAC that no other trial uses: a running serial number, scrambled
+static uint32_t serial = 0;
+
+static void next_mac(uint8_t mac[6]) {
+    uint32_t r = next_random();
+    serial++;
+    mac[0] = 0x02 | (r & 0xFC);
+    mac[1] = r >> 8;
+    mac[2] = serial >> 24;
+    mac[3] = serial >> 16;
+    mac[4] = serial >> 8;
+    mac[5] = serial;
+}
+
+static double relative_error(uint32_t estimate, uint32_t truth) {
+    return fabs((double)estimate - truth) / truth;
+}
+
+// One sketch per cardinality, each within three standard errors
+static void check_single_sketches(void) {
+    static const uint32_t cardinalities[] = {10, 100, 500, 1000, 5000, 20000, 100000};
+    uint8_t mac[6];
+
+    for (size_t c = 0; c < sizeof(cardinalities) / sizeof(cardinalities[0]); c++) {
+        uint32_t n = cardinalities[c];
+        hll_t hll;
+        hll_clear(&hll);
+        for (uint32_t i = 0; i < n; i++) {
+            next_mac(mac);
+            hll_add(&hll, mac, 6);
+            // Repeats of a device must not count again
+            hll_add(&hll, mac, 6);
+        }
+        double err = relative_error(hll_estimate(&hll), n);
+        if (err > 3 * HLL_STD_ERROR) {
+            fprintf(stderr, "n=%u: estimate %u, error %.1f%%\n", n, hll_estimate(&hll), err * 100);
+        }
+        CHECK(err <= 3 * HLL_STD_ERROR);
+    }
+
+    hll_t empty;
+    hll_clear(&empty);
+    CHECK_EQ(hll_estimate(&empty), 0);
+}
+
+// Over many trials the RMS error stays near the theoretical standard error
+static void check_rms_error(void) {
+    static const uint32_t cardinalities[] = {300, 3000, 30000};
+    uint8_t mac[6];
+
+    for (size_t c = 0; c < sizeof(cardinalities) / sizeof(cardinalities[0]); c++) {
+        uint32_t n = cardinalities[c];
+        double sum_sq = 0;
+        for (int t = 0; t < TRIALS; t++) {
+            hll_t hll;
+            hll_clear(&hll);
+            for (uint32_t i = 0; i < n; i++) {
+                next_mac(mac);
+                hll_add(&hll, mac, 6);
+            }
+            double err = relative_error(hll_estimate(&hll), n);
+            sum_sq += err * err;
+        }
+        double rms = sqrt(sum_sq / TRIALS);
+        if (rms > 1.5 * HLL_STD_ERROR) {
+            fprintf(stderr, "n=%u: RMS error %.1f%%\n", n, rms * 100);
+        }
+        CHECK(rms <= 1.5 * HLL_STD_ERROR);
+    }
+}
+
+// Merging sketches of two sets equals sketching their union
+static void check_merge(void) {
+    hll_t a, b, both;
+    uint8_t mac[6];
+    hll_clear(&a);
+    hll_clear(&b);
+    hll_clear(&both);
+
+    for (int i = 0; i < 4000; i++) {
+        next_mac(mac);
+        hll_add(i < 2500 ? &a : &b, mac, 6);
+        hll_add(&both, mac, 6);
+        // 500 devices are in both sets
+        if (i >= 2000 && i < 2500) {
+            hll_add(&b, mac, 6);
+        }
+    }
+    hll_merge(&a, &b);
+    CHECK(memcmp(&a, &both, sizeof(hll_t)) == 0);
+    CHECK(relative_error(hll_estimate(&a), 4000) <= 3 * HLL_STD_ERROR);
+}
+
+// Build a to-DS data frame from a station to its AP and account it
+static void add_station_frame(hll_stats_t *stats, const uint8_t *bssid, const uint8_t *station, uint8_t channel,
+                              uint64_t timestamp_us) {
+    uint8_t frame[24] = {0x08, 0x01};
+    memcpy(frame + 4, bssid, 6);
+    memcpy(frame + 10, station, 6);
+    memcpy(frame + 16, bssid, 6);
+
+    frame_info_t info;
+    CHECK(ieee80211_parse_frame(frame, sizeof(frame), &info));
+    info.channel = channel;
+    info.rssi = -50;
+    info.timestamp_us = timestamp_us;
+    hll_stats_update(stats, &info);
+}
+
+// Per-channel and per-BSSID counts fed from frames, and window expiry
+static void check_stats(void) {
+    static hll_stats_t stats;
+    static hll_counts_t counts;
+    static const uint8_t bssid_a[6] = {0x24, 0x0A, 0xC4, 0x00, 0x00, 0x01};
+    static const uint8_t bssid_b[6] = {0x24, 0x0A, 0xC4, 0x00, 0x00, 0x02};
+    uint8_t mac[6];
+    uint64_t now_us = 1000000;
+
+    hll_stats_init(&stats);
+    for (int i = 0; i < 1500; i++) {
+        next_mac(mac);
+        add_station_frame(&stats, bssid_a, mac, 6, now_us);
+        add_station_frame(&stats, bssid_a, mac, 6, now_us + 10);
+        now_us += 1000;
+    }
+    for (int i = 0; i < 200; i++) {
+        next_mac(mac);
+        add_station_frame(&stats, bssid_b, mac, 11, now_us);
+        now_us += 1000;
+    }
+
+    hll_stats_counts(&stats, &counts);
+    CHECK_EQ(counts.channel_count, 2);
+    CHECK_EQ(counts.bssid_count, 2);
+    for (int i = 0; i < counts.channel_count; i++) {
+        uint32_t truth = counts.channels[i].channel == 6 ? 1500 : 200;
+        CHECK(relative_error(counts.channels[i].devices, truth) <= 3 * HLL_STD_ERROR);
+    }
+    for (int i = 0; i < counts.bssid_count; i++) {
+        uint32_t truth = memcmp(counts.bssids[i].bssid, bssid_a, 6) == 0 ? 1500 : 200;
+        CHECK(relative_error(counts.bssids[i].devices, truth) <= 3 * HLL_STD_ERROR);
+    }
+    CHECK(relative_error(counts.total_devices, 1700) <= 3 * HLL_STD_ERROR);
+
+    // Two idle windows later only the new device is left
+    now_us += 2ull * HLL_WINDOW_S * 1000000;
+    next_mac(mac);
+    add_station_frame(&stats, bssid_b, mac, 11, now_us);
+    hll_stats_counts(&stats, &counts);
+    CHECK_EQ(counts.total_devices, 1);
+}
+
+int main(void) {
+    check_single_sketches();
+    check_rms_error();
+    check_merge();
+    check_stats();
+    return HOST_TEST_RESULT();
+}
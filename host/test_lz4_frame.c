@@ -0,0 +1,298 @@
+// Host test: LZ4 frames decoded by a reference decoder (and the lz4 CLI when given its path)
+#include "host_test.h"
+#include "lz4_frame.h"
+#include "pcap.h"
+#include "pcap_store.h"
+#include "pcap_reader.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_INPUT                    (4 * LZ4_MAX_BLOCK)
+
+static const char *lz4_program = NULL;
+static lz4_state_t state;
+static uint8_t input[MAX_INPUT];
+static uint8_t framed[MAX_INPUT + 64 * LZ4_BLOCK_HEADER_LEN];
+static uint8_t decoded[MAX_INPUT];
+
+static uint32_t get_le32(const uint8_t *p) {
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// Decode one LZ4 block, straight from the format description; -1 if it is malformed
+static long decode_block(const uint8_t *src, size_t len, uint8_t *dst, size_t dst_cap) {
+    size_t ip = 0, op = 0;
+    while (ip < len) {
+        uint8_t token = src[ip++];
+        size_t lit_len = token >> 4;
+        if (lit_len == 15) {
+            uint8_t b;
+            do {
+                if (ip >= len) return -1;
+                lit_len += b = src[ip++];
+            } while (b == 255);
+        }
+        if (ip + lit_len > len || op + lit_len > dst_cap) return -1;
+        memcpy(dst + op, src + ip, lit_len);
+        ip += lit_len;
+        op += lit_len;
+        if (ip == len) break;
+
+        if (ip + 2 > len) return -1;
+        size_t offset = src[ip] | src[ip + 1] << 8;
+        ip += 2;
+        size_t match_len = (token & 15) + 4;
+        if ((token & 15) == 15) {
+            uint8_t b;
+            do {
+                if (ip >= len) return -1;
+                match_len += b = src[ip++];
+            } while (b == 255);
+        }
+        if (offset == 0 || offset > op || op + match_len > dst_cap) return -1;
+        // Byte by byte: matches may overlap their own output
+        for (size_t i = 0; i < match_len; i++, op++) {
+            dst[op] = dst[op - offset];
+        }
+    }
+    return (long)op;
+}
+
+// Decode a whole frame; -1 if it is malformed
+static long decode_frame(const uint8_t *src, size_t len, uint8_t *dst, size_t dst_cap) {
+    if (len < LZ4_FRAME_HEADER_LEN + LZ4_FRAME_END_LEN || get_le32(src) != 0x184D2204) return -1;
+    size_t ip = LZ4_FRAME_HEADER_LEN, op = 0;
+    for (;;) {
+        if (ip + 4 > len) return -1;
+        uint32_t size = get_le32(src + ip);
+        ip += 4;
+        if (size == 0) break;
+        uint32_t block_len = size & 0x7FFFFFFF;
+        if (block_len > LZ4_MAX_BLOCK || ip + block_len > len) return -1;
+        if (size & 0x80000000u) {
+            if (op + block_len > dst_cap) return -1;
+            memcpy(dst + op, src + ip, block_len);
+            op += block_len;
+        } else {
+            long n = decode_block(src + ip, block_len, dst + op, dst_cap - op);
+            if (n < 0) return -1;
+            op += n;
+        }
+        ip += block_len;
+    }
+    return ip == len ? (long)op : -1;
+}
+
+// Decompress a file with the lz4 CLI; -1 if it fails
+static long cli_decode(const char *path, uint8_t *dst, size_t dst_cap) {
+    char out_path[] = "/tmp/test_lz4_frame_out_XXXXXX";
+    int fd = mkstemp(out_path);
+    if (fd < 0) return -1;
+    close(fd);
+
+    char command[512];
+    snprintf(command, sizeof(command), "'%s' -d -q -f -c '%s' > '%s'", lz4_program, path, out_path);
+    long n = -1;
+    if (system(command) == 0) {
+        FILE *f = fopen(out_path, "rb");
+        if (f) {
+            n = (long)fread(dst, 1, dst_cap, f);
+            fclose(f);
+        }
+    }
+    remove(out_path);
+    return n;
+}
+
+// Frame an input in blocks of block_len, as the recorder does per write-behind buffer
+static size_t compress_input(size_t len, size_t block_len) {
+    size_t out = lz4_frame_header(framed);
+    for (size_t off = 0; off < len; off += block_len) {
+        size_t n = len - off < block_len ? len - off : block_len;
+        out += lz4_frame_block(&state, input + off, n, framed + out);
+    }
+    return out + lz4_frame_end(framed + out);
+}
+
+// Round trip an input through the reference decoder and, if available, the CLI
+static size_t check_round_trip(const char *name, size_t len, size_t block_len) {
+    size_t framed_len = compress_input(len, block_len);
+    size_t blocks = (len + block_len - 1) / block_len;
+    CHECK(framed_len <= LZ4_FRAME_HEADER_LEN + len + blocks * LZ4_BLOCK_HEADER_LEN + LZ4_FRAME_END_LEN);
+
+    long n = decode_frame(framed, framed_len, decoded, sizeof(decoded));
+    if (n != (long)len || memcmp(decoded, input, len) != 0) {
+        fprintf(stderr, "%s: reference decoder gave %ld bytes of %zu\n", name, n, len);
+        host_test_failures++;
+    }
+
+    if (lz4_program) {
+        char path[] = "/tmp/test_lz4_frame_XXXXXX";
+        int fd = mkstemp(path);
+        if (fd >= 0 && write(fd, framed, framed_len) == (ssize_t)framed_len) {
+            n = cli_decode(path, decoded, sizeof(decoded));
+            if (n != (long)len || memcmp(decoded, input, len) != 0) {
+                fprintf(stderr, "%s: lz4 CLI gave %ld bytes of %zu\n", name, n, len);
+                host_test_failures++;
+            }
+        } else {
+            CHECK(!"temporary file");
+        }
+        if (fd >= 0) close(fd);
+        remove(path);
+    }
+    return framed_len;
+}
+
+// Beacon-like records: same frame every time, only the capture time and TSF move
+static size_t beacon_pcap(uint8_t *out, size_t cap) {
+    uint8_t beacon[] = {
+        0x80, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x24, 0x0A, 0xC4, 0x11, 0x22, 0x33,
+        0x24, 0x0A, 0xC4, 0x11, 0x22, 0x33, 0x00, 0x00, 0, 0, 0, 0, 0, 0, 0, 0, 0x64, 0x00, 0x11, 0x04,
+        0x00, 0x08, 'H', 'o', 'm', 'e', 'W', 'i', 'F', 'i', 0x01, 0x08, 0x82, 0x84, 0x8B, 0x96, 0x0C, 0x12,
+        0x18, 0x24, 0x03, 0x01, 0x06,
+    };
+    size_t len = 0;
+    pcap_global_header(out);
+    len += PCAP_GLOBAL_HEADER_LEN;
+    for (uint64_t ts = 1700000000000000ull; len + PCAP_RECORD_PREFIX_LEN + sizeof(beacon) <= cap; ts += 102400) {
+        uint64_t tsf = ts - 1699999990000000ull;
+        for (int i = 0; i < 8; i++) {
+            beacon[24 + i] = tsf >> (8 * i);
+        }
+        len += pcap_record_prefix(out + len, ts, sizeof(beacon), sizeof(beacon), -55, 6, 2);
+        memcpy(out + len, beacon, sizeof(beacon));
+        len += sizeof(beacon);
+    }
+    return len;
+}
+
+static void check_inputs(void) {
+    uint32_t rng = 39;
+
+    // Empty input, single bytes and inputs too short to hold a match
+    check_round_trip("empty", 0, LZ4_MAX_BLOCK);
+    input[0] = 0xC5;
+    check_round_trip("one byte", 1, LZ4_MAX_BLOCK);
+    memset(input, 'a', 13);
+    check_round_trip("13 bytes", 13, LZ4_MAX_BLOCK);
+
+    // Random data does not shrink; it grows by the block headers only
+    for (size_t i = 0; i < MAX_INPUT; i++) {
+        rng = rng * 1664525u + 1013904223u;
+        input[i] = rng >> 24;
+    }
+    size_t framed_len = check_round_trip("random", MAX_INPUT, PCAP_STORE_BUFFER_SIZE);
+    CHECK_EQ(framed_len, LZ4_FRAME_HEADER_LEN + MAX_INPUT + (MAX_INPUT / PCAP_STORE_BUFFER_SIZE) * LZ4_BLOCK_HEADER_LEN +
+             LZ4_FRAME_END_LEN);
+    check_round_trip("random, 64 KB blocks", MAX_INPUT, LZ4_MAX_BLOCK);
+
+    // Long runs need the 255-byte length continuations
+    memset(input, 0, LZ4_MAX_BLOCK);
+    CHECK(check_round_trip("zeros", LZ4_MAX_BLOCK, LZ4_MAX_BLOCK) < 400);
+
+    // Text-like data with short repeats
+    for (size_t i = 0; i < 50000; i++) {
+        rng = rng * 1664525u + 1013904223u;
+        input[i] = "abcdefgh"[(rng >> 24) % 8];
+    }
+    check_round_trip("small alphabet", 50000, PCAP_STORE_BUFFER_SIZE);
+
+    // Repeated beacons compress about 7x in 8 KB blocks (lz4 -1 manages 7.7x in 64 KB ones)
+    size_t pcap_len = beacon_pcap(input, MAX_INPUT);
+    framed_len = check_round_trip("beacon pcap", pcap_len, PCAP_STORE_BUFFER_SIZE);
+    CHECK(framed_len * 6 < pcap_len);
+}
+
+// Compressed segments written through pcap_store decode to valid captures
+static void check_store(void) {
+    char dir[] = "/tmp/test_lz4_store_XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror(dir);
+        host_test_failures++;
+        return;
+    }
+
+    pcap_store_config_t config;
+    memset(&config, 0, sizeof(config));
+    snprintf(config.dir, sizeof(config.dir), "%s", dir);
+    snprintf(config.prefix, sizeof(config.prefix), "cap");
+    config.max_segment_bytes = 1 << 20;
+    config.max_files = 4;
+    config.compress = true;
+
+    pcap_store_t store;
+    CHECK(pcap_store_open(&store, &config));
+    size_t pcap_len = beacon_pcap(input, MAX_INPUT);
+    // The store writes its own header; the body goes in write-behind buffer sized blocks
+    size_t off = PCAP_GLOBAL_HEADER_LEN, records = 0;
+    while (off < pcap_len) {
+        size_t n = 0;
+        while (off + n < pcap_len) {
+            size_t rec = PCAP_RECORD_HEADER_LEN + get_le32(input + off + n + 8);
+            if (n + rec > PCAP_STORE_BUFFER_SIZE) break;
+            n += rec;
+            records++;
+        }
+        size_t block_len = lz4_frame_block(&state, input + off, n, framed);
+        CHECK(pcap_store_write(&store, framed, block_len, 1000000));
+        off += n;
+    }
+    pcap_store_close(&store);
+
+    pcap_segment_t segment;
+    CHECK_EQ(pcap_store_list(&store, &segment, 1), 1);
+    CHECK(segment.compressed);
+    char path[PCAP_STORE_MAX_PATH];
+    uint32_t index;
+    CHECK(pcap_store_path(&store, segment.name, path, sizeof(path), &index));
+
+    FILE *f = fopen(path, "rb");
+    size_t file_len = f ? fread(framed, 1, sizeof(framed), f) : 0;
+    if (f) fclose(f);
+    CHECK_EQ(file_len, segment.size);
+    CHECK(file_len * 6 < pcap_len);
+
+    long n = decode_frame(framed, file_len, decoded, sizeof(decoded));
+    CHECK_EQ(n, pcap_len);
+    CHECK(n == (long)pcap_len && memcmp(decoded, input, pcap_len) == 0);
+    if (lz4_program) {
+        n = cli_decode(path, decoded, sizeof(decoded));
+        CHECK_EQ(n, pcap_len);
+        CHECK(n == (long)pcap_len && memcmp(decoded, input, pcap_len) == 0);
+    }
+
+    // And the decoded capture reads back record for record
+    char pcap_path[PCAP_STORE_MAX_PATH + 8];
+    snprintf(pcap_path, sizeof(pcap_path), "%s/out.pcap", dir);
+    f = fopen(pcap_path, "wb");
+    if (f) {
+        fwrite(decoded, 1, pcap_len, f);
+        fclose(f);
+    }
+    pcap_reader_t reader;
+    pcap_frame_t frame;
+    size_t read = 0;
+    if (pcap_reader_open(&reader, pcap_path)) {
+        while (pcap_reader_next(&reader, &frame)) {
+            read++;
+        }
+        pcap_reader_close(&reader);
+    }
+    CHECK_EQ(read, records);
+
+    remove(pcap_path);
+    remove(path);
+    rmdir(dir);
+}
+
+// Usage: test_lz4_frame [path to the lz4 CLI]
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        lz4_program = argv[1];
+    }
+    check_inputs();
+    check_store();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,60 @@
+// Host test: uploaded MAC lists take the four usual spellings and count malformed ones, whatever the chunking
+#include "host_test.h"
+#include "mac_filter.h"
+#include <string.h>
+
+static const char list[] =
+    "[\"24:0a:c4:00:00:32\", \"24-0A-C4-00-00-33\", \"240a.c400.0034\", \"240AC4000035\",\n"
+    // Mixed, misplaced, leading, trailing and doubled separators, too many digits
+    "24:0a-c4:00:00:36 240:ac4:00:00:37 :24:0a:c4:00:00:38 24:0a:c4:00:00:39:\n"
+    "24::0a:c4:00:00:3a 24.0ac4.0000.3b 240ac4.00003c 240ac400003d00\n"
+    // Short words are neither addresses nor rejected
+    "{\"mode\": \"watch\", \"face\": 12}]";
+
+static const uint8_t listed[4][6] = {
+    {0x24, 0x0A, 0xC4, 0x00, 0x00, 0x32},
+    {0x24, 0x0A, 0xC4, 0x00, 0x00, 0x33},
+    {0x24, 0x0A, 0xC4, 0x00, 0x00, 0x34},
+    {0x24, 0x0A, 0xC4, 0x00, 0x00, 0x35},
+};
+
+// Parse the list in chunks of the given size
+static void check_chunks(size_t chunk) {
+    mac_filter_t *filter = mac_filter_create(MAC_FILTER_WATCH, 16);
+    mac_list_parser_t parser;
+    mac_list_parser_init(&parser);
+    uint32_t overflow = 0;
+    for (size_t i = 0; i < sizeof(list) - 1; i += chunk) {
+        size_t len = sizeof(list) - 1 - i < chunk ? sizeof(list) - 1 - i : chunk;
+        overflow += mac_list_parse(&parser, list + i, len, filter);
+    }
+    overflow += mac_list_parse(&parser, NULL, 0, filter);
+    mac_filter_finalize(filter);
+
+    CHECK_EQ(overflow, 0);
+    CHECK_EQ(parser.rejected, 8);
+    CHECK_EQ(filter->count, 4);
+    for (int i = 0; i < 4; i++) {
+        CHECK(mac_filter_contains(filter, listed[i]));
+    }
+    mac_filter_destroy(filter);
+}
+
+int main(void) {
+    check_chunks(sizeof(list));
+    check_chunks(1);
+    check_chunks(7);
+
+    // Addresses beyond the capacity are reported separately from malformed ones
+    mac_filter_t *filter = mac_filter_create(MAC_FILTER_IGNORE, 2);
+    mac_list_parser_t parser;
+    mac_list_parser_init(&parser);
+    const char *three = "02:00:00:00:00:01\n02:00:00:00:00:02\n02:00:00:00:00:03";
+    uint32_t overflow = mac_list_parse(&parser, three, strlen(three), filter);
+    overflow += mac_list_parse(&parser, NULL, 0, filter);
+    CHECK_EQ(overflow, 1);
+    CHECK_EQ(parser.rejected, 0);
+    mac_filter_destroy(filter);
+
+    return HOST_TEST_RESULT();
+}
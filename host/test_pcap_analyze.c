@@ -0,0 +1,109 @@
+// Host test: pcap_analyze prints the same tables whatever the file order and thread count
+#include "host_test.h"
+#include "pcap.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define HEAVY_FRAMES                 5000
+#define LIGHT_TALKERS                300
+#define LIGHT_FRAMES                 2
+
+static const uint8_t bssid[6] = {0x24, 0x0A, 0xC4, 0x00, 0x00, 0x45};
+
+// To-DS data frames of one station, numbered from 0
+static void write_frames(FILE *f, uint16_t station, int count, uint64_t *ts_us) {
+    uint8_t prefix[PCAP_RECORD_PREFIX_LEN];
+    uint8_t frame[64] = {0x08, 0x01};
+    memcpy(frame + 4, bssid, 6);
+    frame[10] = 0x02;
+    frame[14] = station >> 8;
+    frame[15] = station & 0xFF;
+    memcpy(frame + 16, bssid, 6);
+    for (int i = 0; i < count; i++) {
+        uint16_t seq = (i & 0xFFF) << 4;
+        frame[22] = seq & 0xFF;
+        frame[23] = seq >> 8;
+        *ts_us += 1000;
+        pcap_record_prefix(prefix, *ts_us, sizeof(frame), sizeof(frame), -50, 6, 12);
+        fwrite(prefix, 1, sizeof(prefix), f);
+        fwrite(frame, 1, sizeof(frame), f);
+    }
+}
+
+static bool write_capture(char *path, bool heavy) {
+    int fd = mkstemp(path);
+    FILE *f = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    uint8_t header[PCAP_GLOBAL_HEADER_LEN];
+    pcap_global_header(header);
+    fwrite(header, 1, sizeof(header), f);
+    uint64_t ts_us = 1700000000000000ull;
+    if (heavy) {
+        write_frames(f, 0xFFFF, HEAVY_FRAMES, &ts_us);
+    } else {
+        for (uint16_t station = 0; station < LIGHT_TALKERS; station++) {
+            write_frames(f, station, LIGHT_FRAMES, &ts_us);
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+// Run the analyzer and keep its output without the timing lines
+static void run(const char *program, int threads, const char *first, const char *second, char *out, size_t size) {
+    char command[1024];
+    snprintf(command, sizeof(command), "'%s' -j %d -n 3 '%s' '%s'", program, threads, first, second);
+    FILE *p = popen(command, "r");
+    if (!p) {
+        CHECK(!"popen");
+        return;
+    }
+    char line[256];
+    size_t len = 0;
+    out[0] = '\0';
+    while (fgets(line, sizeof(line), p)) {
+        if (strncmp(line, "Files:", 6) == 0 || strncmp(line, "Throughput:", 11) == 0) continue;
+        len += snprintf(out + len, len < size ? size - len : 0, "%s", line);
+    }
+    CHECK_EQ(pclose(p), 0);
+    CHECK(len < size);
+}
+
+// Usage: test_pcap_analyze path/to/pcap_analyze
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s path/to/pcap_analyze\n", argv[0]);
+        return 1;
+    }
+    char heavy[] = "/tmp/test_analyze_heavy_XXXXXX";
+    char light[] = "/tmp/test_analyze_light_XXXXXX";
+    if (!write_capture(heavy, true) || !write_capture(light, false)) {
+        return 1;
+    }
+
+    static char reference[16384], output[16384];
+    run(argv[1], 1, heavy, light, reference, sizeof(reference));
+    CHECK(strstr(reference, "Evicted:     0 transmitters, 0 links, 0 associations") != NULL);
+    // The heavy station tops the talkers: the second line after the title
+    const char *row = strstr(reference, "Top talkers:\n");
+    for (int i = 0; row && i < 2; i++) {
+        row = strchr(row, '\n') + 1;
+    }
+    CHECK(row && strncmp(row, "  02:00:00:00:ff:ff          0          0       5000", 52) == 0);
+
+    // Files named the other way round, and one thread per file
+    run(argv[1], 1, light, heavy, output, sizeof(output));
+    CHECK(strcmp(output, reference) == 0);
+    run(argv[1], 2, heavy, light, output, sizeof(output));
+    CHECK(strcmp(output, reference) == 0);
+
+    remove(heavy);
+    remove(light);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,85 @@
+// Host test: records written by the firmware's pcap writer read back through the host reader
+#include "host_test.h"
+#include "pcap.h"
+#include "pcap_reader.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    uint64_t ts_us;
+    uint16_t len;
+    uint16_t orig_len;
+    int8_t rssi;
+    uint8_t channel;
+    uint8_t rate;
+} record_t;
+
+static const record_t records[] = {
+    {1700000000123456ull, 24, 24, -42, 1, 2},        // Short CCK frame on 2.4 GHz
+    {1700000000200000ull, 300, 300, -71, 36, 12},    // OFDM frame on 5 GHz
+    {1700000001000001ull, 64, 1500, -88, 14, 0},     // Truncated to a snaplen, rate unknown
+    {1700000002999999ull, 4000, 4000, -30, 165, 108},
+};
+
+#define RECORD_COUNT (sizeof(records) / sizeof(records[0]))
+
+static void write_capture(FILE *f) {
+    uint8_t header[PCAP_GLOBAL_HEADER_LEN];
+    uint8_t prefix[PCAP_RECORD_PREFIX_LEN];
+    uint8_t frame[4096];
+
+    pcap_global_header(header);
+    fwrite(header, 1, sizeof(header), f);
+    for (size_t i = 0; i < RECORD_COUNT; i++) {
+        const record_t *r = &records[i];
+        for (uint16_t j = 0; j < r->len; j++) {
+            frame[j] = (uint8_t)(i * 31 + j);
+        }
+        pcap_record_prefix(prefix, r->ts_us, r->len, r->orig_len, r->rssi, r->channel, r->rate);
+        fwrite(prefix, 1, sizeof(prefix), f);
+        fwrite(frame, 1, r->len, f);
+    }
+    // A record cut short by a reset mid-write
+    pcap_record_prefix(prefix, 0, 100, 100, 0, 1, 0);
+    fwrite(prefix, 1, sizeof(prefix), f);
+    fwrite(frame, 1, 10, f);
+}
+
+int main(void) {
+    char path[] = "/tmp/test_pcap_reader_XXXXXX";
+    int fd = mkstemp(path);
+    FILE *f = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    write_capture(f);
+    fclose(f);
+
+    pcap_reader_t reader;
+    pcap_frame_t frame;
+    CHECK(pcap_reader_open(&reader, path));
+    CHECK_EQ(reader.linktype, LINKTYPE_RADIOTAP);
+    for (size_t i = 0; i < RECORD_COUNT; i++) {
+        const record_t *r = &records[i];
+        if (!pcap_reader_next(&reader, &frame)) {
+            CHECK(!"record missing");
+            break;
+        }
+        CHECK_EQ(frame.ts_us, r->ts_us);
+        CHECK_EQ(frame.len, r->len);
+        CHECK_EQ(frame.orig_len, PCAP_RADIOTAP_LEN + r->orig_len);
+        CHECK_EQ(frame.rssi, r->rssi);
+        CHECK_EQ(frame.channel, r->channel);
+        CHECK_EQ(frame.rate, r->rate);
+        CHECK_EQ(frame.data[0], (uint8_t)(i * 31));
+        CHECK_EQ(frame.data[r->len - 1], (uint8_t)(i * 31 + r->len - 1));
+    }
+    CHECK(!pcap_reader_next(&reader, &frame));
+    CHECK_EQ(reader.records, RECORD_COUNT);
+    CHECK_EQ(reader.skipped, 0);
+    pcap_reader_close(&reader);
+
+    remove(path);
+    return HOST_TEST_RESULT();
+}
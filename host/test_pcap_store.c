@@ -0,0 +1,217 @@
+// Host test: write-behind ring and rotating segments, read back against the records written
+#include "host_test.h"
+#include "pcap.h"
+#include "pcap_reader.h"
+#include "pcap_store.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SEGMENT_BYTES                20000
+#define MAX_FILES                    3
+#define RECORDS                      400
+
+static uint8_t ring_memory[PCAP_STORE_BUFFERS * PCAP_STORE_BUFFER_SIZE];
+
+// Frame i is 60 + i % 700 bytes, each byte derived from i and its offset
+static uint16_t record_len(uint32_t i) {
+    return 60 + i % 700;
+}
+
+static void fill_frame(uint32_t i, uint8_t *frame) {
+    for (uint16_t j = 0; j < record_len(i); j++) {
+        frame[j] = (uint8_t)(i * 7 + j);
+    }
+}
+
+// Records never straddle buffers, the writer sees them in order, and a full ring drops
+static void check_ring(void) {
+    pcap_ring_t ring;
+    uint8_t prefix[PCAP_RECORD_PREFIX_LEN];
+    uint8_t frame[1024];
+    const uint8_t *data;
+    size_t len;
+
+    pcap_ring_init(&ring, ring_memory);
+    CHECK(!pcap_ring_peek(&ring, &data, &len));
+
+    uint32_t appended = 0, sealed = 0;
+    for (uint32_t i = 0; ; i++) {
+        pcap_record_prefix(prefix, i, record_len(i), record_len(i), -60, 6, 2);
+        fill_frame(i, frame);
+        pcap_ring_result_t result = pcap_ring_append(&ring, prefix, sizeof(prefix), frame, record_len(i), i);
+        if (result == PCAP_RING_DROPPED) break;
+        appended++;
+        sealed += result == PCAP_RING_SEALED;
+    }
+    CHECK_EQ(sealed, PCAP_STORE_BUFFERS - 1);
+    CHECK_EQ(ring.frames, appended);
+    CHECK_EQ(ring.dropped_frames, 1);
+    CHECK_EQ(ring.full, PCAP_STORE_BUFFERS);
+
+    // Walk the sealed buffers record by record
+    uint32_t next = 0;
+    while (pcap_ring_peek(&ring, &data, &len)) {
+        CHECK(len <= PCAP_STORE_BUFFER_SIZE);
+        size_t off = 0;
+        while (off < len) {
+            uint32_t incl = data[off + 8] | data[off + 9] << 8 | data[off + 10] << 16 | (uint32_t)data[off + 11] << 24;
+            CHECK_EQ(incl, PCAP_RADIOTAP_LEN + record_len(next));
+            CHECK_EQ(data[off + PCAP_RECORD_PREFIX_LEN], (uint8_t)(next * 7));
+            off += PCAP_RECORD_HEADER_LEN + incl;
+            next++;
+        }
+        CHECK_EQ(off, len);
+        pcap_ring_release(&ring);
+    }
+    CHECK_EQ(next, appended);
+
+    // A partial buffer is only sealed once its first record is old enough
+    pcap_record_prefix(prefix, 0, 100, 100, -60, 6, 2);
+    pcap_ring_append(&ring, prefix, sizeof(prefix), frame, 100, 5000000);
+    CHECK(!pcap_ring_seal(&ring, 4000000));
+    CHECK(pcap_ring_seal(&ring, 5000000));
+    CHECK(pcap_ring_peek(&ring, &data, &len));
+    CHECK_EQ(len, PCAP_RECORD_PREFIX_LEN + 100);
+}
+
+// Drain a ring of records [first, first + count) into the store
+static void store_records(pcap_store_t *store, uint32_t first, uint32_t count, uint64_t now_us) {
+    pcap_ring_t ring;
+    uint8_t prefix[PCAP_RECORD_PREFIX_LEN];
+    uint8_t frame[1024];
+    const uint8_t *data;
+    size_t len;
+
+    pcap_ring_init(&ring, ring_memory);
+    for (uint32_t i = first; i < first + count; i++) {
+        pcap_record_prefix(prefix, 1000000 + i, record_len(i), record_len(i), -60, 6, 2);
+        fill_frame(i, frame);
+        if (pcap_ring_append(&ring, prefix, sizeof(prefix), frame, record_len(i), now_us) == PCAP_RING_SEALED) {
+            while (pcap_ring_peek(&ring, &data, &len)) {
+                CHECK(pcap_store_write(store, data, len, now_us));
+                pcap_ring_release(&ring);
+            }
+        }
+    }
+    pcap_ring_seal(&ring, now_us);
+    while (pcap_ring_peek(&ring, &data, &len)) {
+        CHECK(pcap_store_write(store, data, len, now_us));
+        pcap_ring_release(&ring);
+    }
+}
+
+// Read every retained segment back; records must be consecutive and end at the last one written
+static void check_segments(const pcap_store_t *store, uint32_t expected_files, uint32_t last_record) {
+    pcap_segment_t segments[8];
+    int count = pcap_store_list(store, segments, 8);
+    CHECK_EQ(count, expected_files);
+
+    int64_t next = -1;
+    for (int s = 0; s < count; s++) {
+        char path[PCAP_STORE_MAX_PATH];
+        uint32_t index;
+        CHECK(pcap_store_path(store, segments[s].name, path, sizeof(path), &index));
+        CHECK_EQ(index, segments[s].index);
+        if (s > 0) {
+            CHECK_EQ(segments[s].index, segments[s - 1].index + 1);
+        }
+        CHECK(segments[s].size <= SEGMENT_BYTES);
+
+        pcap_reader_t reader;
+        pcap_frame_t frame;
+        if (!pcap_reader_open(&reader, path)) {
+            CHECK(!"segment does not open");
+            continue;
+        }
+        while (pcap_reader_next(&reader, &frame)) {
+            uint32_t i = (uint32_t)(frame.ts_us - 1000000);
+            if (next >= 0) {
+                CHECK_EQ(i, next);
+            }
+            CHECK_EQ(frame.len, record_len(i));
+            CHECK_EQ(frame.data[frame.len - 1], (uint8_t)(i * 7 + frame.len - 1));
+            next = i + 1;
+        }
+        CHECK_EQ(reader.skipped, 0);
+        pcap_reader_close(&reader);
+    }
+    CHECK_EQ(next, last_record + 1);
+}
+
+static void remove_all(const char *dir) {
+    char path[PCAP_STORE_MAX_PATH + 32];
+    for (uint32_t index = 0; index < 64; index++) {
+        snprintf(path, sizeof(path), "%s/cap_%05u.pcap", dir, index);
+        remove(path);
+    }
+    rmdir(dir);
+}
+
+static void check_store(void) {
+    char dir[] = "/tmp/test_pcap_store_XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror(dir);
+        host_test_failures++;
+        return;
+    }
+
+    pcap_store_config_t config;
+    memset(&config, 0, sizeof(config));
+    snprintf(config.dir, sizeof(config.dir), "%s", dir);
+    snprintf(config.prefix, sizeof(config.prefix), "cap");
+    config.max_segment_bytes = SEGMENT_BYTES;
+    config.max_files = MAX_FILES;
+
+    // Size rotation with retention: only the newest segments are kept
+    pcap_store_t store;
+    CHECK(pcap_store_open(&store, &config));
+    CHECK_EQ(store.next_index, 0);
+    store_records(&store, 0, RECORDS, 1000000);
+    CHECK(store.segments > MAX_FILES);
+    CHECK_EQ(store.removed, store.segments - MAX_FILES);
+    CHECK_EQ(store.write_errors, 0);
+    pcap_store_sync(&store);
+    check_segments(&store, MAX_FILES, RECORDS - 1);
+    pcap_store_close(&store);
+    uint32_t segments = store.segments;
+
+    // A restart continues the numbering and retention of the segments on disk
+    CHECK(pcap_store_open(&store, &config));
+    CHECK_EQ(store.first_index, segments - MAX_FILES);
+    CHECK_EQ(store.next_index, segments);
+    store_records(&store, RECORDS, 10, 2000000);
+    CHECK_EQ(store.segments, 1);
+    CHECK_EQ(store.removed, 1);
+    check_segments(&store, MAX_FILES, RECORDS + 9);
+
+    // Age rotation: a write after the limit opens a new segment
+    pcap_store_close(&store);
+    config.max_segment_bytes = 1000000;
+    config.max_segment_ms = 2000;
+    CHECK(pcap_store_open(&store, &config));
+    store_records(&store, RECORDS + 10, 5, 3000000);
+    store_records(&store, RECORDS + 15, 5, 4999999);
+    CHECK_EQ(store.segments, 1);
+    store_records(&store, RECORDS + 20, 5, 5000000);
+    CHECK_EQ(store.segments, 2);
+    check_segments(&store, MAX_FILES, RECORDS + 24);
+
+    // Downloads only resolve names of this store's segments
+    char path[PCAP_STORE_MAX_PATH];
+    uint32_t index;
+    CHECK(!pcap_store_path(&store, "../cap_00001.pcap", path, sizeof(path), &index));
+    CHECK(!pcap_store_path(&store, "other_00001.pcap", path, sizeof(path), &index));
+    CHECK(!pcap_store_path(&store, "cap_00001.txt", path, sizeof(path), &index));
+    CHECK(pcap_store_path(&store, "CAP_00002.PCAP", path, sizeof(path), &index));
+    CHECK_EQ(index, 2);
+
+    pcap_store_close(&store);
+    remove_all(dir);
+}
+
+int main(void) {
+    check_ring();
+    check_store();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,202 @@
+// Host test: per-transmitter and per-BSSID rate histograms against exact counts of a mixed-PHY stream
+#include "host_test.h"
+#include "rate_stats.h"
+#include <string.h>
+
+#define APS                          4
+#define STATIONS                     24
+#define FRAMES                       20000
+
+// Exact counters, indexed by device: stations first, then APs
+typedef struct {
+    uint8_t mac[6];
+    rate_hist_t hist;
+} truth_t;
+
+static truth_t tx_truth[STATIONS + APS];
+static truth_t bss_truth[APS];
+static uint32_t rng = 36;
+
+static uint32_t next_random(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static void device_mac(int device, uint8_t mac[6]) {
+    memset(mac, 0, 6);
+    mac[0] = device < STATIONS ? 0x02 : 0x24;
+    mac[4] = 0x36;
+    mac[5] = device;
+}
+
+// A PHY from the mix seen on a busy network; NULL for frames without rate information
+static const airtime_phy_t *random_phy(airtime_phy_t *phy) {
+    memset(phy, 0, sizeof(*phy));
+    switch (next_random() % 6) {
+        case 0:
+            return NULL;
+        case 1:
+            airtime_phy_from_legacy_code(next_random() % 16, phy);
+            if (phy->rate == 0) {
+                airtime_phy_from_legacy_code(0x0B, phy);
+            }
+            return phy;
+        case 2:
+            phy->format = AIRTIME_PHY_HT;
+            phy->rate = next_random() % 16;
+            phy->bandwidth = next_random() % 2 ? 40 : 20;
+            return phy;
+        case 3:
+            phy->format = AIRTIME_PHY_VHT;
+            phy->rate = next_random() % 10;
+            phy->nss = 1 + next_random() % 2;
+            phy->bandwidth = 80;
+            return phy;
+        default:
+            phy->format = AIRTIME_PHY_HE;
+            phy->rate = next_random() % 12;
+            phy->nss = 1 + next_random() % 2;
+            phy->bandwidth = 20;
+            return phy;
+    }
+}
+
+static void truth_account(rate_hist_t *hist, const airtime_phy_t *phy, bool retry, int bin) {
+    hist->frames++;
+    hist->retries += retry;
+    if (bin >= 0) {
+        hist->bins[bin]++;
+    }
+    if (phy) {
+        uint8_t nss = phy->format == AIRTIME_PHY_HT ? phy->rate / 8 + 1 : phy->nss;
+        if (nss > hist->max_nss) hist->max_nss = nss;
+        if (phy->bandwidth > hist->max_bandwidth) hist->max_bandwidth = phy->bandwidth;
+    }
+}
+
+// Expected bin, worked out independently of rate_stats_bin()
+static int expected_bin(const airtime_phy_t *phy) {
+    static const uint8_t legacy[RATE_LEGACY_BINS] = {2, 4, 11, 22, 12, 18, 24, 36, 48, 72, 96, 108};
+    if (!phy) return -1;
+    if (phy->format == AIRTIME_PHY_DSSS || phy->format == AIRTIME_PHY_OFDM) {
+        for (int i = 0; i < RATE_LEGACY_BINS; i++) {
+            if (legacy[i] == phy->rate) return i;
+        }
+        return -1;
+    }
+    return RATE_LEGACY_BINS + (phy->format == AIRTIME_PHY_HT ? phy->rate % 8 : phy->rate);
+}
+
+static void check_export(const rate_stats_t *stats, bool bssids, const truth_t *truth, int truth_count) {
+    rate_entry_t entries[RATE_MAX_TRANSMITTERS];
+    int count = rate_stats_export(stats, bssids, entries, RATE_MAX_TRANSMITTERS);
+    CHECK_EQ(count, truth_count);
+    for (int i = 0; i < count; i++) {
+        const truth_t *t = NULL;
+        for (int j = 0; j < truth_count; j++) {
+            if (memcmp(truth[j].mac, entries[i].addr, 6) == 0) t = &truth[j];
+        }
+        if (!t) {
+            CHECK(!"entry not in the ground truth");
+            continue;
+        }
+        const rate_hist_t *h = &entries[i].hist;
+        CHECK(memcmp(h->bins, t->hist.bins, sizeof(h->bins)) == 0);
+        CHECK_EQ(h->frames, t->hist.frames);
+        CHECK_EQ(h->retries, t->hist.retries);
+        CHECK_EQ(h->max_nss, t->hist.max_nss);
+        CHECK_EQ(h->max_bandwidth, t->hist.max_bandwidth);
+    }
+}
+
+static void check_bins(void) {
+    airtime_phy_t phy = {AIRTIME_PHY_OFDM, 108, 1, 20, 0, false};
+    CHECK_EQ(rate_stats_bin(&phy), 11);
+    CHECK(strcmp(rate_stats_bin_name(11), "54M") == 0);
+    phy = (airtime_phy_t){AIRTIME_PHY_DSSS, 11, 1, 20, 0, false};
+    CHECK(strcmp(rate_stats_bin_name(rate_stats_bin(&phy)), "5.5M") == 0);
+    phy = (airtime_phy_t){AIRTIME_PHY_OFDM, 13, 1, 20, 0, false};
+    CHECK_EQ(rate_stats_bin(&phy), -1);
+    // HT MCS is folded per stream
+    phy = (airtime_phy_t){AIRTIME_PHY_HT, 15, 0, 40, 400, false};
+    CHECK(strcmp(rate_stats_bin_name(rate_stats_bin(&phy)), "MCS7") == 0);
+    phy = (airtime_phy_t){AIRTIME_PHY_HT, 32, 0, 40, 400, false};
+    CHECK_EQ(rate_stats_bin(&phy), -1);
+    phy = (airtime_phy_t){AIRTIME_PHY_HE, 11, 2, 80, 800, false};
+    CHECK(strcmp(rate_stats_bin_name(rate_stats_bin(&phy)), "MCS11") == 0);
+    phy = (airtime_phy_t){AIRTIME_PHY_VHT, 12, 1, 80, 800, false};
+    CHECK_EQ(rate_stats_bin(&phy), -1);
+    CHECK(strcmp(rate_stats_bin_name(RATE_BINS), "unknown") == 0);
+}
+
+int main(void) {
+    static rate_stats_t all, first_half, second_half, merged;
+    check_bins();
+
+    for (int d = 0; d < STATIONS + APS; d++) {
+        device_mac(d, tx_truth[d].mac);
+    }
+    for (int a = 0; a < APS; a++) {
+        device_mac(STATIONS + a, bss_truth[a].mac);
+    }
+
+    rate_stats_init(&all);
+    rate_stats_init(&first_half);
+    rate_stats_init(&second_half);
+    for (int f = 0; f < FRAMES; f++) {
+        int station = next_random() % STATIONS;
+        int ap = station % APS;
+        bool uplink = next_random() % 2;
+        bool retry = next_random() % 8 == 0;
+        uint32_t kind = next_random() % 10;
+        airtime_phy_t phy_buf;
+        const airtime_phy_t *phy = random_phy(&phy_buf);
+
+        // Data both ways, plus beacons that must not be counted
+        uint8_t frame[32] = {0x08, (uint8_t)((uplink ? 0x01 : 0x02) | (retry ? IEEE80211_FCTL_RETRY : 0))};
+        const uint8_t *sta_mac = tx_truth[station].mac, *ap_mac = bss_truth[ap].mac;
+        memcpy(frame + 4, uplink ? ap_mac : sta_mac, 6);
+        memcpy(frame + 10, uplink ? sta_mac : ap_mac, 6);
+        memcpy(frame + 16, ap_mac, 6);
+        if (kind == 0) {
+            frame[0] = 0x80;
+            frame[1] = 0;
+            memset(frame + 4, 0xFF, 6);
+            memcpy(frame + 10, ap_mac, 6);
+        }
+
+        frame_info_t info;
+        CHECK(ieee80211_parse_frame(frame, sizeof(frame), &info));
+        rate_stats_update(&all, &info, phy);
+        rate_stats_update(f < FRAMES / 2 ? &first_half : &second_half, &info, phy);
+
+        if (kind != 0) {
+            int bin = expected_bin(phy);
+            truth_account(&tx_truth[uplink ? station : STATIONS + ap].hist, phy, retry, bin);
+            truth_account(&bss_truth[ap].hist, phy, retry, bin);
+        }
+    }
+
+    check_export(&all, false, tx_truth, STATIONS + APS);
+    check_export(&all, true, bss_truth, APS);
+
+    // Two halves merged give the same histograms as one pass
+    rate_stats_init(&merged);
+    rate_stats_merge(&merged, &first_half);
+    rate_stats_merge(&merged, &second_half);
+    check_export(&merged, false, tx_truth, STATIONS + APS);
+    check_export(&merged, true, bss_truth, APS);
+
+    // Retry ratios come out near the 1 in 8 the stream used
+    rate_entry_t bss[APS];
+    CHECK_EQ(rate_stats_export(&all, true, bss, APS), APS);
+    for (int a = 0; a < APS; a++) {
+        CHECK_NEAR((double)bss[a].hist.retries / bss[a].hist.frames, 0.125, 0.02);
+        CHECK_EQ(bss[a].hist.max_nss, 2);
+        CHECK_EQ(bss[a].hist.max_bandwidth, 80);
+    }
+
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,95 @@
+// Host test: beacon fingerprints ignore per-beacon elements and probe responses, and still catch a changed layout
+#include "host_test.h"
+#include "rogue_ap.h"
+#include <string.h>
+
+static const uint8_t bssid[6] = {0x24, 0x0A, 0xC4, 0x00, 0x00, 0x34};
+static uint32_t rng = 34;
+
+static uint32_t next_random(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static size_t put_ie(uint8_t *frame, size_t len, uint8_t id, const uint8_t *data, uint8_t ie_len) {
+    frame[len++] = id;
+    frame[len++] = ie_len;
+    memcpy(frame + len, data, ie_len);
+    return len + ie_len;
+}
+
+// WPA2 beacon or probe response; the volatile elements come and go at random
+static uint8_t send(rogue_ap_t *index, uint8_t subtype, bool volatile_ies, bool tkip, uint64_t now_us) {
+    static const uint8_t ssid[] = {'c', 'o', 'r', 'p'};
+    static const uint8_t rates[] = {0x82, 0x84, 0x8B, 0x96};
+    static const uint8_t ds[] = {6};
+    uint8_t rsn[] = {0x01, 0x00, 0x00, 0x0F, 0xAC, 0x04, 0x01, 0x00, 0x00, 0x0F, 0xAC, 0x04,
+                     0x01, 0x00, 0x00, 0x0F, 0xAC, 0x02, 0x00, 0x00};
+    if (tkip) {
+        rsn[5] = 0x02;
+    }
+    uint8_t scratch[8];
+    for (size_t i = 0; i < sizeof(scratch); i++) {
+        scratch[i] = next_random();
+    }
+
+    uint8_t frame[160] = {subtype << 4, 0x00};
+    memset(frame + 4, 0xFF, 6);
+    memcpy(frame + 10, bssid, 6);
+    memcpy(frame + 16, bssid, 6);
+    size_t len = 24 + 8;
+    frame[len++] = 0x64;
+    frame[len++] = 0x00;
+    frame[len++] = 0x11;
+    frame[len++] = 0x04;
+    len = put_ie(frame, len, IEEE80211_IE_SSID, ssid, sizeof(ssid));
+    len = put_ie(frame, len, 1, rates, sizeof(rates));
+    len = put_ie(frame, len, IEEE80211_IE_DS_PARAMS, ds, sizeof(ds));
+    if (volatile_ies) {
+        len = put_ie(frame, len, IEEE80211_IE_TIM, scratch, 2 + next_random() % 4);
+        if (next_random() & 1) len = put_ie(frame, len, IEEE80211_IE_BSS_LOAD, scratch, 5);
+        if (next_random() & 1) len = put_ie(frame, len, IEEE80211_IE_CSA, scratch, 3);
+        if (next_random() & 1) len = put_ie(frame, len, IEEE80211_IE_QUIET, scratch, 6);
+        if (next_random() & 1) len = put_ie(frame, len, IEEE80211_IE_EXT_CSA, scratch, 4);
+    }
+    len = put_ie(frame, len, IEEE80211_IE_RSN, rsn, sizeof(rsn));
+
+    frame_info_t info;
+    CHECK(ieee80211_parse_frame(frame, len, &info));
+    info.channel = 6;
+    info.rssi = -40;
+    info.timestamp_us = now_us;
+    rogue_ap_update(index, &info);
+    return index->ssids[0].bss[0].flags;
+}
+
+int main(void) {
+    static rogue_ap_t index;
+    rogue_ap_init(&index);
+    uint64_t now_us = 1000000;
+
+    // The first beacon has none of the volatile elements, the following ones any mix of them
+    CHECK_EQ(send(&index, IEEE80211_STYPE_BEACON, false, false, now_us), 0);
+    uint32_t fingerprint = index.ssids[0].bss[0].fingerprint;
+    CHECK(fingerprint != 0);
+    for (int i = 0; i < 200; i++) {
+        now_us += 102400;
+        CHECK_EQ(send(&index, IEEE80211_STYPE_BEACON, true, false, now_us), 0);
+    }
+    CHECK_EQ(index.ssids[0].bss[0].fingerprint, fingerprint);
+
+    // Probe responses leave out the TIM and often add elements; they are not fingerprinted
+    CHECK_EQ(send(&index, IEEE80211_STYPE_PROBE_RESP, false, false, now_us + 1000), 0);
+    CHECK_EQ(index.ssids[0].bss[0].fingerprint, fingerprint);
+    CHECK_EQ(index.ssids[0].bss[0].seen, 202);
+    CHECK_EQ(index.alerts, 0);
+
+    // A clone advertising other ciphers under the same BSSID is flagged
+    now_us += 102400;
+    CHECK_EQ(send(&index, IEEE80211_STYPE_BEACON, true, true, now_us), ROGUE_FLAG_FINGERPRINT);
+    CHECK_EQ(index.alerts, 1);
+
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,241 @@
+// Host test: sequence-gap counters against the ground truth of simulated lossy and hopping captures
+#include "host_test.h"
+#include "seq_tracker.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define STATIONS                     20
+// Sequence spaces used per station: TID 0, TID 6 and non-QoS
+#define SPACES                       3
+#define FRAMES                       60000
+#define DWELL_US                     100000
+
+static const uint8_t bssid[6] = {0x24, 0x0A, 0xC4, 0x00, 0x00, 0x37};
+
+// What a station sent, and what an ideal counter over the heard frames would report
+typedef struct {
+    uint8_t mac[6];
+    uint8_t channel;
+    uint16_t next_seq[SPACES];
+    bool heard_any[SPACES];
+    uint32_t unheard_run[SPACES];   // Frames sent and never heard since the last heard one
+    seq_counters_t truth;
+} station_t;
+
+static station_t stations[STATIONS];
+static uint32_t rng = 37;
+
+static uint32_t next_random(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+// Build and account a to-DS data frame; QoS with the TID of the space, plain data for the last space
+static bool send_frame(seq_tracker_t *tracker, const station_t *sta, int space, uint16_t seq, bool retry,
+                       uint64_t now_us, uint64_t dwell_start_us) {
+    static const uint8_t tids[SPACES] = {0, 6, 0};
+    uint8_t frame[26 + 8] = {0};
+    bool qos = space < SPACES - 1;
+    frame[0] = qos ? 0x88 : 0x08;
+    frame[1] = 0x01 | (retry ? IEEE80211_FCTL_RETRY : 0);
+    memcpy(frame + 4, bssid, 6);
+    memcpy(frame + 10, sta->mac, 6);
+    memcpy(frame + 16, bssid, 6);
+    frame[22] = (seq << 4) & 0xF0;
+    frame[23] = seq >> 4;
+    frame[24] = tids[space];
+
+    frame_info_t info;
+    CHECK(ieee80211_parse_frame(frame, qos ? sizeof(frame) : sizeof(frame) - 2, &info));
+    CHECK(info.has_seq);
+    CHECK_EQ(info.seq, seq);
+    info.channel = sta->channel;
+    info.timestamp_us = now_us;
+    return seq_tracker_update(tracker, &info, dwell_start_us);
+}
+
+static void init_stations(bool spread) {
+    static const uint8_t channels[3] = {1, 6, 11};
+    memset(stations, 0, sizeof(stations));
+    for (int i = 0; i < STATIONS; i++) {
+        station_t *sta = &stations[i];
+        sta->mac[0] = 0x02;
+        sta->mac[4] = 0x37;
+        sta->mac[5] = i;
+        sta->channel = spread ? channels[i % 3] : 6;
+        for (int s = 0; s < SPACES; s++) {
+            sta->next_seq[s] = next_random() & 0x0FFF;
+        }
+    }
+}
+
+// A unique frame got through: the frames since the last one heard become misses
+static void heard_unique(station_t *sta, int space, bool off_channel) {
+    if (sta->heard_any[space]) {
+        if (off_channel) {
+            sta->truth.missed_off_channel += sta->unheard_run[space];
+        } else {
+            sta->truth.missed_on_channel += sta->unheard_run[space];
+        }
+    }
+    sta->heard_any[space] = true;
+    sta->unheard_run[space] = 0;
+    sta->truth.received++;
+}
+
+static void check_totals(const seq_tracker_t *tracker) {
+    seq_counters_t sum = {0};
+    seq_entry_t entries[SEQ_MAX_TRANSMITTERS];
+    int count = seq_tracker_export(tracker, entries, SEQ_MAX_TRANSMITTERS);
+    CHECK_EQ(count, STATIONS);
+
+    for (int i = 0; i < count; i++) {
+        const station_t *sta = &stations[entries[i].addr[5]];
+        CHECK(memcmp(entries[i].addr, sta->mac, 6) == 0);
+        CHECK_EQ(entries[i].channel, sta->channel);
+        CHECK_EQ(entries[i].counters.received, sta->truth.received);
+        CHECK_EQ(entries[i].counters.duplicates, sta->truth.duplicates);
+        CHECK_EQ(entries[i].counters.missed_on_channel, sta->truth.missed_on_channel);
+        CHECK_EQ(entries[i].counters.missed_off_channel, sta->truth.missed_off_channel);
+        sum.received += sta->truth.received;
+        sum.duplicates += sta->truth.duplicates;
+        sum.missed_on_channel += sta->truth.missed_on_channel;
+        sum.missed_off_channel += sta->truth.missed_off_channel;
+    }
+    CHECK_EQ(tracker->total.received, sum.received);
+    CHECK_EQ(tracker->total.duplicates, sum.duplicates);
+    CHECK_EQ(tracker->total.missed_on_channel, sum.missed_on_channel);
+    CHECK_EQ(tracker->total.missed_off_channel, sum.missed_off_channel);
+
+    // Per-channel counters add up to the stations on each channel
+    for (int c = 0; c < SEQ_MAX_CHANNELS; c++) {
+        if (tracker->channels[c] == 0) continue;
+        uint32_t received = 0, missed = 0;
+        for (int i = 0; i < STATIONS; i++) {
+            if (stations[i].channel != tracker->channels[c]) continue;
+            received += stations[i].truth.received;
+            missed += stations[i].truth.missed_on_channel + stations[i].truth.missed_off_channel;
+        }
+        CHECK_EQ(tracker->channel_counters[c].received, received);
+        CHECK_EQ(tracker->channel_counters[c].missed_on_channel + tracker->channel_counters[c].missed_off_channel,
+                 missed);
+    }
+}
+
+// Fixed channel with 10% loss; lost frames are retried, and some heard ones too (lost ACK)
+static void check_lossy_channel(void) {
+    static seq_tracker_t tracker;
+    seq_tracker_init(&tracker);
+    init_stations(false);
+
+    uint64_t now_us = 1000000;
+    for (int f = 0; f < FRAMES; f++, now_us += 1000) {
+        station_t *sta = &stations[next_random() % STATIONS];
+        int space = next_random() % SPACES;
+        uint16_t seq = sta->next_seq[space];
+        sta->next_seq[space] = (seq + 1) & 0x0FFF;
+
+        bool have = false;
+        for (int attempt = 0; attempt < 3; attempt++) {
+            bool heard = next_random() % 10 != 0;
+            if (heard) {
+                bool duplicate = send_frame(&tracker, sta, space, seq, attempt > 0, now_us + attempt * 100, 0);
+                CHECK_EQ(duplicate, have);
+                if (have) {
+                    sta->truth.duplicates++;
+                } else {
+                    heard_unique(sta, space, false);
+                }
+                have = true;
+            }
+            // The sender stops once acked; one ACK in ten is lost
+            if (heard && next_random() % 10 != 0) break;
+        }
+        if (!have) {
+            sta->unheard_run[space]++;
+        }
+    }
+
+    check_totals(&tracker);
+    CHECK(tracker.total.duplicates > 0);
+    CHECK(tracker.total.missed_on_channel > 0);
+    CHECK_EQ(tracker.total.missed_off_channel, 0);
+}
+
+// Lossless channels, but the radio hops 1/6/11 and only hears the one it is on
+static void check_hopping(void) {
+    static const uint8_t hop[3] = {1, 6, 11};
+    static seq_tracker_t tracker, merged;
+    seq_tracker_init(&tracker);
+    init_stations(true);
+
+    uint64_t start_us = 1000000, now_us = start_us;
+    for (int f = 0; f < FRAMES; f++, now_us += 1000) {
+        uint64_t dwell = (now_us - start_us) / DWELL_US;
+        uint64_t dwell_start_us = start_us + dwell * DWELL_US;
+        uint8_t listening = hop[dwell % 3];
+
+        station_t *sta = &stations[next_random() % STATIONS];
+        int space = next_random() % SPACES;
+        uint16_t seq = sta->next_seq[space];
+        sta->next_seq[space] = (seq + 1) & 0x0FFF;
+
+        if (sta->channel == listening) {
+            CHECK(!send_frame(&tracker, sta, space, seq, false, now_us, dwell_start_us));
+            heard_unique(sta, space, true);
+        } else {
+            sta->unheard_run[space]++;
+        }
+    }
+
+    check_totals(&tracker);
+    CHECK_EQ(tracker.total.missed_on_channel, 0);
+    // A third of the time on each channel: about two thirds of the frames are missed
+    CHECK_NEAR(seq_coverage_permille(&tracker.total), 333, 20);
+
+    // Merging into an empty tracker keeps every counter
+    seq_tracker_init(&merged);
+    seq_tracker_merge(&merged, &tracker);
+    CHECK(memcmp(&merged.total, &tracker.total, sizeof(seq_counters_t)) == 0);
+    check_totals(&merged);
+}
+
+// Counter wrap, resets and reordering
+static void check_edges(void) {
+    static seq_tracker_t tracker;
+    seq_tracker_init(&tracker);
+    init_stations(false);
+    station_t *sta = &stations[0];
+
+    // 4093 then 1: 4094, 4095 and 0 were missed across the wrap
+    send_frame(&tracker, sta, 2, 4093, false, 1000, 0);
+    send_frame(&tracker, sta, 2, 1, false, 2000, 0);
+    CHECK_EQ(tracker.total.missed_on_channel, 3);
+
+    // A jump past SEQ_MAX_GAP is a reset, a step back is reordering; neither counts
+    send_frame(&tracker, sta, 2, 1 + SEQ_MAX_GAP + 1, false, 3000, 0);
+    send_frame(&tracker, sta, 2, 100, false, 4000, 0);
+    CHECK_EQ(tracker.total.missed_on_channel, 3);
+    CHECK_EQ(tracker.total.received, 4);
+
+    // TIDs are separate spaces: interleaving them is no loss
+    send_frame(&tracker, sta, 0, 10, false, 5000, 0);
+    send_frame(&tracker, sta, 1, 500, false, 6000, 0);
+    send_frame(&tracker, sta, 0, 11, false, 7000, 0);
+    send_frame(&tracker, sta, 1, 501, false, 8000, 0);
+    CHECK_EQ(tracker.total.missed_on_channel, 3);
+
+    // A retry is only a duplicate with the same fragment and the Retry bit
+    CHECK(!send_frame(&tracker, sta, 0, 11, false, 9000, 0));
+    CHECK(send_frame(&tracker, sta, 0, 11, true, 10000, 0));
+    CHECK_EQ(tracker.total.duplicates, 1);
+}
+
+int main(void) {
+    check_lossy_channel();
+    check_hopping();
+    check_edges();
+    return HOST_TEST_RESULT();
+}
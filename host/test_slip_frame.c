@@ -0,0 +1,273 @@
+// Host test: SLIP-framed pcap stream with loss and line noise, decoded in C and by tools/slip_decoder.py
+#include "host_test.h"
+#include "pcap.h"
+#include "pcap_reader.h"
+#include "slip_frame.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define RECORDS                      50
+// Record sent as a console log line instead, and record corrupted on the line
+#define REPLACED_RECORD              20
+#define CORRUPTED_RECORD             35
+#define MAX_FRAME                    512
+
+static uint8_t stream[64 * 1024];
+static size_t stream_len = 0;
+
+static uint16_t frame_len(int k) {
+    return 24 + (k * 37) % 300;
+}
+
+// Frame bytes run through every value, END and ESC included
+static void fill_frame(int k, uint8_t *frame) {
+    for (int j = 0; j < frame_len(k); j++) {
+        frame[j] = (uint8_t)(k * 13 + j);
+    }
+}
+
+static void append(const uint8_t *data, size_t len) {
+    memcpy(stream + stream_len, data, len);
+    stream_len += len;
+}
+
+// The sender's side: header, records, then the in-band stats frame
+static void build_stream(void) {
+    uint8_t encoded[SLIP_FRAME_BOUND(PCAP_RECORD_PREFIX_LEN + MAX_FRAME)];
+    uint8_t header[PCAP_GLOBAL_HEADER_LEN];
+    uint8_t prefix[PCAP_RECORD_PREFIX_LEN];
+    uint8_t frame[MAX_FRAME];
+    uint16_t seq = 0;
+
+    pcap_global_header(header);
+    append(encoded, slip_frame_encode(SLIP_FRAME_PCAP_HEADER, seq++, NULL, 0, header, sizeof(header),
+                                      encoded, sizeof(encoded)));
+
+    for (int k = 1; k <= RECORDS; k++) {
+        pcap_record_prefix(prefix, 1700000000000000ull + k, frame_len(k), frame_len(k), -50, 6, 2);
+        fill_frame(k, frame);
+        size_t len = slip_frame_encode(SLIP_FRAME_PCAP_RECORD, seq++, prefix, sizeof(prefix), frame, frame_len(k),
+                                       encoded, sizeof(encoded));
+        CHECK(len > 0);
+
+        if (k == REPLACED_RECORD) {
+            static const char log_line[] = "I (12345) wifi:station: 24:0a:c4:11:22:33 join, AID=1\r\n";
+            append((const uint8_t *)log_line, sizeof(log_line) - 1);
+            continue;
+        }
+        if (k == CORRUPTED_RECORD) {
+            // Flip a bit that keeps the byte an ordinary one, so only the CRC catches it
+            for (size_t i = len / 2; i < len; i++) {
+                uint8_t flipped = encoded[i] ^ 0x01;
+                if (encoded[i] < SLIP_END && flipped < SLIP_END) {
+                    encoded[i] = flipped;
+                    break;
+                }
+            }
+        }
+        append(encoded, len);
+    }
+
+    uint8_t stats[16] = {RECORDS, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0};
+    append(encoded, slip_frame_encode(SLIP_FRAME_STATS, seq++, stats, sizeof(stats), NULL, 0,
+                                      encoded, sizeof(encoded)));
+}
+
+// Receiver state, mirroring tools/slip_decoder.py
+typedef struct {
+    uint8_t frame[SLIP_FRAME_OVERHEAD + PCAP_RECORD_PREFIX_LEN + MAX_FRAME + 64];
+    size_t len;
+    bool escaped;
+    bool overflow;
+    int32_t expected;            // Next sequence number, -1 before the first frame
+    uint32_t records;
+    uint32_t bad;
+    uint32_t lost;
+    uint32_t stats_frames;
+    int last_record;
+} decoder_t;
+
+static void decode_frame(decoder_t *d) {
+    const uint8_t *f = d->frame;
+    if (d->overflow || d->len < SLIP_FRAME_OVERHEAD) {
+        d->bad++;
+        return;
+    }
+    uint16_t seq = f[1] | f[2] << 8;
+    uint16_t length = f[3] | f[4] << 8;
+    uint16_t crc = f[d->len - 2] | f[d->len - 1] << 8;
+    if (length != d->len - SLIP_FRAME_OVERHEAD || slip_crc16(f, d->len - 2, 0xFFFF) != crc) {
+        d->bad++;
+        return;
+    }
+    if (d->expected >= 0 && seq != d->expected) {
+        d->lost += (uint16_t)(seq - d->expected);
+    }
+    d->expected = (uint16_t)(seq + 1);
+
+    const uint8_t *content = f + 5;
+    switch (f[0]) {
+        case SLIP_FRAME_PCAP_HEADER:
+            CHECK_EQ(length, PCAP_GLOBAL_HEADER_LEN);
+            break;
+        case SLIP_FRAME_PCAP_RECORD: {
+            // Records carry their index in the timestamp's microseconds
+            uint8_t expected[MAX_FRAME];
+            int k = content[4] | content[5] << 8;
+            fill_frame(k, expected);
+            CHECK(k > d->last_record);
+            CHECK_EQ(length, PCAP_RECORD_PREFIX_LEN + frame_len(k));
+            CHECK(memcmp(content + PCAP_RECORD_PREFIX_LEN, expected, frame_len(k)) == 0);
+            d->last_record = k;
+            d->records++;
+            break;
+        }
+        case SLIP_FRAME_STATS:
+            d->stats_frames++;
+            break;
+        default:
+            CHECK(!"unknown frame type");
+    }
+}
+
+static void decode(decoder_t *d, const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        uint8_t byte = data[i];
+        if (byte == SLIP_END) {
+            if (d->len || d->overflow) {
+                decode_frame(d);
+            }
+            d->len = 0;
+            d->escaped = false;
+            d->overflow = false;
+            continue;
+        }
+        if (d->escaped) {
+            byte = byte == SLIP_ESC_END ? SLIP_END : byte == SLIP_ESC_ESC ? SLIP_ESC : byte;
+            d->escaped = false;
+        } else if (byte == SLIP_ESC) {
+            d->escaped = true;
+            continue;
+        }
+        if (d->len == sizeof(d->frame)) {
+            d->overflow = true;
+        } else {
+            d->frame[d->len++] = byte;
+        }
+    }
+}
+
+static void check_encoding(void) {
+    // CRC-16/CCITT-FALSE check value
+    CHECK_EQ(slip_crc16((const uint8_t *)"123456789", 9, 0xFFFF), 0x29B1);
+
+    // Content made only of special bytes stays within the worst case bound
+    uint8_t content[64];
+    uint8_t encoded[SLIP_FRAME_BOUND(sizeof(content))];
+    memset(content, SLIP_END, sizeof(content));
+    size_t len = slip_frame_encode(SLIP_FRAME_STATS, 0xC0DB, NULL, 0, content, sizeof(content),
+                                   encoded, sizeof(encoded));
+    CHECK(len > 2 * sizeof(content));
+    CHECK(len <= sizeof(encoded));
+    CHECK_EQ(encoded[0], SLIP_END);
+    CHECK_EQ(encoded[len - 1], SLIP_END);
+    for (size_t i = 1; i < len - 1; i++) {
+        CHECK(encoded[i] != SLIP_END);
+    }
+
+    decoder_t d;
+    memset(&d, 0, sizeof(d));
+    d.expected = -1;
+    decode(&d, encoded, len);
+    CHECK_EQ(d.bad, 0);
+    CHECK_EQ(d.expected, 0xC0DC);
+
+    // Too small a buffer fails instead of writing past it
+    CHECK_EQ(slip_frame_encode(SLIP_FRAME_PCAP_RECORD, 0, NULL, 0, content, sizeof(content), encoded, 100), 0);
+}
+
+static void check_stream(void) {
+    decoder_t d;
+    memset(&d, 0, sizeof(d));
+    d.expected = -1;
+    build_stream();
+
+    // Feed in uneven chunks, as reads from a serial port return
+    for (size_t off = 0, chunk = 1; off < stream_len; off += chunk, chunk = chunk * 7 % 97 + 1) {
+        decode(&d, stream + off, off + chunk <= stream_len ? chunk : stream_len - off);
+    }
+    CHECK_EQ(d.records, RECORDS - 2);
+    CHECK_EQ(d.lost, 2);
+    CHECK_EQ(d.bad, 2);
+    CHECK_EQ(d.stats_frames, 1);
+    CHECK_EQ(d.last_record, RECORDS);
+}
+
+// Run tools/slip_decoder.py over the same stream and read its pcap back
+static void check_python_decoder(const char *python, const char *script) {
+    char in_path[] = "/tmp/test_slip_in_XXXXXX";
+    char out_path[] = "/tmp/test_slip_out_XXXXXX";
+    char log_path[] = "/tmp/test_slip_log_XXXXXX";
+    int fds[3] = {mkstemp(in_path), mkstemp(out_path), mkstemp(log_path)};
+    if (fds[0] < 0 || fds[1] < 0 || fds[2] < 0) {
+        CHECK(!"temporary files");
+        return;
+    }
+    FILE *f = fdopen(fds[0], "wb");
+    fwrite(stream, 1, stream_len, f);
+    fclose(f);
+    close(fds[1]);
+    close(fds[2]);
+
+    char command[1024];
+    snprintf(command, sizeof(command), "'%s' '%s' '%s' -b 0 -o '%s' 2> '%s'", python, script, in_path, out_path,
+             log_path);
+    CHECK_EQ(system(command), 0);
+
+    // Last line of the summary: "<records> records, <lost> frames lost, <bad> bad frames"
+    char line[256] = "", last[256] = "";
+    f = fopen(log_path, "r");
+    while (f && fgets(line, sizeof(line), f)) {
+        memcpy(last, line, sizeof(last));
+    }
+    if (f) fclose(f);
+    unsigned records = 0, lost = 0, bad = 0;
+    CHECK_EQ(sscanf(last, "%u records, %u frames lost, %u bad frames", &records, &lost, &bad), 3);
+    CHECK_EQ(records, RECORDS - 2);
+    CHECK_EQ(lost, 2);
+    CHECK_EQ(bad, 2);
+
+    pcap_reader_t reader;
+    pcap_frame_t frame;
+    uint8_t expected[MAX_FRAME];
+    CHECK(pcap_reader_open(&reader, out_path));
+    for (int k = 1; k <= RECORDS; k++) {
+        if (k == REPLACED_RECORD || k == CORRUPTED_RECORD) continue;
+        if (!pcap_reader_next(&reader, &frame)) {
+            CHECK(!"record missing");
+            break;
+        }
+        fill_frame(k, expected);
+        CHECK_EQ(frame.ts_us, 1700000000000000ull + k);
+        CHECK_EQ(frame.len, frame_len(k));
+        CHECK(memcmp(frame.data, expected, frame_len(k)) == 0);
+    }
+    CHECK(!pcap_reader_next(&reader, &frame));
+    pcap_reader_close(&reader);
+
+    remove(in_path);
+    remove(out_path);
+    remove(log_path);
+}
+
+// Usage: test_slip_frame [python3 path/to/slip_decoder.py]
+int main(int argc, char **argv) {
+    check_encoding();
+    check_stream();
+    if (argc > 2) {
+        check_python_decoder(argv[1], argv[2]);
+    }
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,133 @@
+// Host test: the security analytics see every frame from the first one of a session, and what the MAC list lets through
+#include "host_test.h"
+#include "sim_stubs.h"
+#include "sniffer_profile.h"
+#include "wifi_sniffer.h"
+#include <stdlib.h>
+#include <string.h>
+
+// The stage profiler is sim_main's; this test does not time stages
+void sniffer_profile_begin(void) {
+}
+
+void sniffer_profile_mark(sniffer_stage_t stage) {
+    (void)stage;
+}
+
+static wifi_promiscuous_pkt_t *pkt;
+
+static const uint8_t ap[6] = {0x24, 0x0A, 0xC4, 0x00, 0x00, 0x34};
+
+static void inject(const uint8_t *frame, uint16_t len) {
+    memcpy(pkt->payload, frame, len);
+    CHECK(wifi_sniffer_inject(pkt, len, -50, 6, 12));
+}
+
+static void send_beacon(void) {
+    static const uint8_t beacon[] = {
+        0x80, 0x00, 0x00, 0x00,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0x24, 0x0A, 0xC4, 0x00, 0x00, 0x34,
+        0x24, 0x0A, 0xC4, 0x00, 0x00, 0x34,
+        0x00, 0x00,
+        0, 0, 0, 0, 0, 0, 0, 0, 0x64, 0x00, 0x01, 0x04,
+        IEEE80211_IE_SSID, 4, 'l', 'a', 'b', '1',
+        IEEE80211_IE_DS_PARAMS, 1, 6,
+    };
+    inject(beacon, sizeof(beacon));
+}
+
+static uint32_t rogue_seen(void) {
+    static rogue_ap_t index;
+    wifi_sniffer_get_rogue_index(&index);
+    for (int i = 0; i < ROGUE_MAX_SSIDS; i++) {
+        if (mac_table_in_use(&index.ssid_table, i) && strcmp(index.ssids[i].ssid, "lab1") == 0 &&
+            memcmp(index.ssids[i].bss[0].bssid, ap, 6) == 0) {
+            return index.ssids[i].bss[0].seen;
+        }
+    }
+    return 0;
+}
+
+// The evil-twin index takes the very first beacon, before anyone has read it
+static void check_first_beacon(void) {
+    CHECK(start_wifi_sniffer(6, 0));
+    send_beacon();
+    CHECK_EQ(rogue_seen(), 1);
+    stop_wifi_sniffer();
+}
+
+// A watch list of one station leaves out the attacker, yet the flood is still
+// detected and the AP still indexed
+static void check_watch_list(void) {
+    static const uint8_t watched[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x33};
+    mac_filter_t *filter = mac_filter_create(MAC_FILTER_WATCH, 1);
+    CHECK(mac_filter_add(filter, watched));
+    mac_filter_finalize(filter);
+    wifi_sniffer_set_mac_filter(filter);
+
+    CHECK(start_wifi_sniffer(6, 0));
+    uint32_t seen = rogue_seen();
+    send_beacon();
+    CHECK_EQ(rogue_seen(), seen + 1);
+
+    // Broadcast deauths from the AP's address, one sequence number each
+    uint8_t deauth[26] = {0xC0, 0x00};
+    memset(deauth + 4, 0xFF, 6);
+    memcpy(deauth + 10, ap, 6);
+    memcpy(deauth + 16, ap, 6);
+    deauth[24] = 7;
+    for (int i = 0; i < WIDS_DEFAULT_DEAUTH; i++) {
+        deauth[22] = (i << 4) & 0xF0;
+        deauth[23] = i >> 4;
+        inject(deauth, sizeof(deauth));
+    }
+    wids_alert_t alerts[WIDS_ALERT_RING];
+    int count = wifi_sniffer_get_wids_alerts(0, alerts, WIDS_ALERT_RING);
+    CHECK(count >= 1);
+    CHECK_EQ(alerts[0].category, WIDS_CAT_DEAUTH);
+    CHECK(memcmp(alerts[0].mac, ap, 6) == 0);
+
+    // The list itself still applies to everything else
+    mac_filter_t info;
+    CHECK(wifi_sniffer_get_mac_filter_info(&info));
+    CHECK(info.bloom_rejects + info.false_positives >= WIDS_DEFAULT_DEAUTH);
+    stop_wifi_sniffer();
+    wifi_sniffer_set_mac_filter(NULL);
+}
+
+// Frames too short to parse are recorded, unless only listed addresses are wanted
+static void check_unparsed(void) {
+    static const uint8_t runt[16] = {0x08, 0x00};
+    CHECK(start_wifi_sniffer(6, 0));
+    uint32_t frames = sim_storage_pushes.frames;
+    uint32_t unparsed = wifi_sniffer_get_unparsed_count();
+    inject(runt, sizeof(runt));
+    CHECK_EQ(sim_storage_pushes.frames, frames + 1);
+
+    mac_filter_t *filter = mac_filter_create(MAC_FILTER_IGNORE, 1);
+    CHECK(mac_filter_add(filter, ap));
+    mac_filter_finalize(filter);
+    wifi_sniffer_set_mac_filter(filter);
+    inject(runt, sizeof(runt));
+    CHECK_EQ(sim_storage_pushes.frames, frames + 2);
+
+    filter = mac_filter_create(MAC_FILTER_WATCH, 1);
+    CHECK(mac_filter_add(filter, ap));
+    mac_filter_finalize(filter);
+    wifi_sniffer_set_mac_filter(filter);
+    inject(runt, sizeof(runt));
+    CHECK_EQ(sim_storage_pushes.frames, frames + 2);
+    CHECK_EQ(wifi_sniffer_get_unparsed_count(), unparsed + 3);
+    stop_wifi_sniffer();
+    wifi_sniffer_set_mac_filter(NULL);
+}
+
+int main(void) {
+    pkt = calloc(1, sizeof(*pkt) + 256);
+    check_first_beacon();
+    check_watch_list();
+    check_unparsed();
+    free(pkt);
+    return HOST_TEST_RESULT();
+}
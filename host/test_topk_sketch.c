@@ -0,0 +1,145 @@
+// Host test: top-K talker estimates against exact counts on a Zipf-distributed stream
+#include "host_test.h"
+#include "topk_sketch.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KEYS                         2000
+#define FRAMES                       60000
+#define ZIPF_S                       1.1
+// Stream spans 8 s, inside the 10 s window
+#define FRAME_SPACING_US             133
+
+static double cdf[KEYS];
+static uint32_t true_frames[KEYS];
+static uint64_t true_bytes[KEYS];
+
+static uint32_t rng = 30;
+
+static double next_uniform(void) {
+    rng = rng * 1664525u + 1013904223u;
+    return (rng >> 8) / (double)(1u << 24);
+}
+
+// Key rank drawn from the Zipf distribution
+static int next_key(void) {
+    double u = next_uniform();
+    int lo = 0, hi = KEYS - 1;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (cdf[mid] < u) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+static void key_mac(int key, uint8_t mac[6]) {
+    mac[0] = 0x02;
+    mac[1] = 0x30;
+    mac[2] = 0;
+    mac[3] = 0;
+    mac[4] = key >> 8;
+    mac[5] = key;
+}
+
+static int mac_key(const uint8_t mac[6]) {
+    return (mac[4] << 8) | mac[5];
+}
+
+// Check one metric's ranking against the exact counts
+static void check_ranking(const topk_window_t *window, topk_metric_t metric, uint64_t now_us,
+                          uint64_t expected_total) {
+    static topk_result_t results[TOPK_CAPACITY * TOPK_MAX_EPOCHS];
+    uint32_t max_error = 0, total = 0;
+    int count = topk_window_query(window, metric, now_us, results, TOPK_CAPACITY * TOPK_MAX_EPOCHS,
+                                  &max_error, &total);
+    CHECK(count > 0);
+    CHECK_EQ(total, expected_total);
+    CHECK(max_error <= expected_total / TOPK_CAPACITY);
+
+    bool reported[KEYS] = {false};
+    for (int i = 0; i < count; i++) {
+        int key = mac_key(results[i].mac);
+        uint64_t truth = metric == TOPK_METRIC_FRAMES ? true_frames[key] : true_bytes[key];
+        reported[key] = true;
+
+        // Every estimate brackets the true weight, within the reported bound
+        CHECK(results[i].estimate >= truth);
+        CHECK(results[i].estimate - results[i].error <= truth);
+        CHECK(results[i].error <= max_error);
+        if (i > 0) {
+            CHECK(results[i - 1].estimate >= results[i].estimate);
+        }
+    }
+
+    // Any key heavier than the bound cannot be missing
+    for (int key = 0; key < KEYS; key++) {
+        uint64_t truth = metric == TOPK_METRIC_FRAMES ? true_frames[key] : true_bytes[key];
+        if (truth > max_error) {
+            CHECK(reported[key]);
+        }
+    }
+}
+
+int main(void) {
+    // Zipf CDF over the key ranks
+    double sum = 0;
+    for (int i = 0; i < KEYS; i++) {
+        sum += 1.0 / pow(i + 1, ZIPF_S);
+        cdf[i] = sum;
+    }
+    for (int i = 0; i < KEYS; i++) {
+        cdf[i] /= sum;
+    }
+
+    static topk_sketch_t sketch;
+    topk_sketch_init(&sketch);
+
+    uint8_t frame[24] = {0x08, 0x00};
+    uint64_t total_bytes = 0;
+    uint64_t now_us = 5000000;
+    for (int i = 0; i < FRAMES; i++) {
+        int key = next_key();
+        uint16_t length = 40 + (uint16_t)(next_uniform() * 1400);
+        key_mac(key, frame + 10);
+
+        frame_info_t info;
+        memset(&info, 0, sizeof(info));
+        info.type = IEEE80211_TYPE_DATA;
+        info.addr2 = frame + 10;
+        info.length = length;
+        info.timestamp_us = now_us;
+        topk_sketch_update(&sketch, &info);
+
+        true_frames[key]++;
+        true_bytes[key] += length;
+        total_bytes += length;
+        now_us += FRAME_SPACING_US;
+    }
+
+    const topk_window_t *window = topk_sketch_window(&sketch, 10);
+    CHECK(window != NULL);
+    CHECK(topk_sketch_window(&sketch, 11) == NULL);
+    if (window) {
+        check_ranking(window, TOPK_METRIC_FRAMES, now_us, FRAMES);
+        check_ranking(window, TOPK_METRIC_BYTES, now_us, total_bytes);
+
+        // The heaviest key of a skewed stream is ranked first
+        topk_result_t top;
+        CHECK_EQ(topk_window_query(window, TOPK_METRIC_FRAMES, now_us, &top, 1, NULL, NULL), 1);
+        CHECK_EQ(mac_key(top.mac), 0);
+
+        // A window with no traffic for longer than its length reports nothing
+        uint32_t total = 1;
+        CHECK_EQ(topk_window_query(window, TOPK_METRIC_FRAMES, now_us + 20000000, &top, 1, NULL, &total), 0);
+        CHECK_EQ(total, 0);
+    }
+
+    // The longer windows saw the same stream
+    window = topk_sketch_window(&sketch, 300);
+    if (window) {
+        check_ranking(window, TOPK_METRIC_FRAMES, now_us, FRAMES);
+    }
+
+    return HOST_TEST_RESULT();
+}
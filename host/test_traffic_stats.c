@@ -0,0 +1,175 @@
+// Host test: traffic counters against exact per-key ground truth, merging and batched export
+#include "host_test.h"
+#include "traffic_stats.h"
+#include "traffic_gen.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define FRAMES                       20000
+#define MAX_KEYS                     256
+
+// Exact counters of one key, found by linear search
+typedef struct {
+    uint8_t key[12];
+    uint32_t frames[3];
+    uint64_t bytes;
+    uint8_t channel;
+    uint64_t first_seen_us;
+    uint64_t last_seen_us;
+} truth_t;
+
+typedef struct {
+    truth_t entries[MAX_KEYS];
+    int count;
+} truth_table_t;
+
+static void truth_account(truth_table_t *table, const uint8_t *key, const frame_info_t *info) {
+    truth_t *t = NULL;
+    for (int i = 0; i < table->count; i++) {
+        if (memcmp(table->entries[i].key, key, 12) == 0) {
+            t = &table->entries[i];
+            break;
+        }
+    }
+    if (!t) {
+        if (table->count == MAX_KEYS) {
+            return;
+        }
+        t = &table->entries[table->count++];
+        memset(t, 0, sizeof(*t));
+        memcpy(t->key, key, 12);
+        t->first_seen_us = info->timestamp_us;
+    }
+    if (info->type <= IEEE80211_TYPE_DATA) {
+        t->frames[info->type]++;
+    }
+    t->bytes += info->length;
+    t->channel = info->channel;
+    t->last_seen_us = info->timestamp_us;
+}
+
+static const truth_t *truth_find(const truth_table_t *table, const uint8_t *addr, const uint8_t *station) {
+    uint8_t key[12];
+    memcpy(key, addr, 6);
+    memcpy(key + 6, station, 6);
+    for (int i = 0; i < table->count; i++) {
+        if (memcmp(table->entries[i].key, key, 12) == 0) {
+            return &table->entries[i];
+        }
+    }
+    return NULL;
+}
+
+// Check every entry of a table against the ground truth, and that none is missing
+static void check_entries(const traffic_entry_t *entries, int count, const truth_table_t *truth) {
+    CHECK_EQ(count, truth->count);
+    for (int i = 0; i < count; i++) {
+        const traffic_entry_t *e = &entries[i];
+        const truth_t *t = truth_find(truth, e->addr, e->station);
+        if (!t) {
+            CHECK(!"entry not in the ground truth");
+            continue;
+        }
+        for (int type = 0; type < 3; type++) {
+            CHECK_EQ(e->counters.frames[type], t->frames[type]);
+        }
+        CHECK_EQ(e->counters.bytes, t->bytes);
+        CHECK_EQ(e->counters.channel, t->channel);
+        CHECK_EQ(e->counters.first_seen_us, t->first_seen_us);
+        CHECK_EQ(e->counters.last_seen_us, t->last_seen_us);
+    }
+}
+
+int main(void) {
+    static traffic_stats_t all, first_half, second_half, merged;
+    static traffic_snapshot_t snapshot;
+    static truth_table_t tx_truth, link_truth;
+    traffic_gen_t *gen = malloc(sizeof(traffic_gen_t));
+    traffic_gen_config_t config;
+
+    // A population that fits the tables, so nothing is evicted
+    traffic_gen_default_config(&config);
+    config.seed = 28;
+    config.aps = 8;
+    config.stations = 60;
+    config.random_mac_permille = 0;
+    CHECK(traffic_gen_init(gen, &config));
+
+    traffic_stats_init(&all);
+    traffic_stats_init(&first_half);
+    traffic_stats_init(&second_half);
+    uint32_t total_frames = 0;
+    uint64_t total_bytes = 0;
+
+    uint8_t buf[2048];
+    for (uint32_t i = 0; i < FRAMES; i++) {
+        traffic_gen_frame_t meta;
+        uint16_t len = traffic_gen_next(gen, buf, sizeof(buf), &meta);
+        frame_info_t info;
+        if (!ieee80211_parse_frame(buf, len, &info)) {
+            CHECK(!"generated frame did not parse");
+            continue;
+        }
+        info.rssi = meta.rssi;
+        info.channel = meta.channel;
+        info.timestamp_us = 1000000 + (uint64_t)i * 150;
+
+        traffic_stats_update(&all, &info);
+        traffic_stats_update(i < FRAMES / 2 ? &first_half : &second_half, &info);
+        total_frames++;
+        total_bytes += len;
+
+        uint8_t key[12] = {0};
+        if (info.addr2) {
+            memcpy(key, info.addr2, 6);
+            truth_account(&tx_truth, key, &info);
+        }
+        const uint8_t *station = ieee80211_station_addr(&info);
+        if (station) {
+            memcpy(key, info.bssid, 6);
+            memcpy(key + 6, station, 6);
+            truth_account(&link_truth, key, &info);
+        }
+    }
+    CHECK(tx_truth.count > 0 && tx_truth.count <= TRAFFIC_MAX_TRANSMITTERS);
+    CHECK(link_truth.count > 0 && link_truth.count <= TRAFFIC_MAX_LINKS);
+
+    // Live state against the ground truth
+    traffic_stats_snapshot(&all, &snapshot);
+    CHECK_EQ(snapshot.total_frames, total_frames);
+    CHECK_EQ(snapshot.total_bytes, total_bytes);
+    check_entries(snapshot.transmitters, snapshot.transmitter_count, &tx_truth);
+    check_entries(snapshot.links, snapshot.link_count, &link_truth);
+
+    // Snapshots are most recently heard first
+    for (int i = 1; i < snapshot.transmitter_count; i++) {
+        CHECK(snapshot.transmitters[i - 1].counters.last_seen_us >= snapshot.transmitters[i].counters.last_seen_us);
+    }
+
+    // Two partial states merged give the same counters as one pass
+    traffic_stats_init(&merged);
+    traffic_stats_merge(&merged, &first_half);
+    traffic_stats_merge(&merged, &second_half);
+    traffic_stats_snapshot(&merged, &snapshot);
+    CHECK_EQ(snapshot.total_frames, total_frames);
+    CHECK_EQ(snapshot.total_bytes, total_bytes);
+    check_entries(snapshot.transmitters, snapshot.transmitter_count, &tx_truth);
+    check_entries(snapshot.links, snapshot.link_count, &link_truth);
+
+    // Batched export covers the same entries as the snapshot
+    for (int links = 0; links < 2; links++) {
+        traffic_entry_t batch[7];
+        static traffic_entry_t exported[TRAFFIC_MAX_LINKS];
+        int cursor = 0, total = 0, count;
+        while ((count = traffic_stats_export(&all, links, &cursor, batch, 7)) > 0) {
+            CHECK(count <= 7);
+            memcpy(&exported[total], batch, count * sizeof(batch[0]));
+            total += count;
+        }
+        CHECK_EQ(traffic_stats_export(&all, links, &cursor, batch, 7), 0);
+        check_entries(exported, total, links ? &link_truth : &tx_truth);
+    }
+
+    free(gen);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,235 @@
+// Host test: trigger window ring wrap, burst conditions, and pre/post frames kept until the capture is saved
+#include "host_test.h"
+#include "trigger_window.h"
+#include <string.h>
+
+static uint8_t memory[TRIGGER_WINDOW_BYTES];
+static uint32_t rng = 49;
+
+static uint32_t next_random(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static const uint8_t station[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x49};
+static const uint8_t ap[6] = {0x24, 0x0A, 0xC4, 0x00, 0x00, 0x49};
+
+// Frames are numbered by the caller; the number leads the prefix and fills the data
+static uint8_t push(trigger_window_t *w, uint32_t id, uint8_t subtype, uint16_t data_len, uint64_t now_us) {
+    uint8_t prefix[PCAP_RECORD_PREFIX_LEN] = {0};
+    static uint8_t data[TRIGGER_SNAPLEN];
+    memcpy(prefix, &id, sizeof(id));
+    memset(data, (uint8_t)id, data_len);
+
+    frame_info_t info;
+    memset(&info, 0, sizeof(info));
+    info.type = IEEE80211_TYPE_MGMT;
+    info.subtype = subtype;
+    info.addr1 = station;
+    info.addr2 = ap;
+    info.addr3 = ap;
+    info.timestamp_us = now_us;
+    return trigger_window_push(w, &info, prefix, sizeof(prefix), data, data_len);
+}
+
+// The record with sequence number seq holds frame id, intact
+static bool record_is(const trigger_window_t *w, uint32_t seq, uint32_t id, uint16_t data_len) {
+    uint16_t len = 0;
+    const uint8_t *record = trigger_window_record(w, seq, &len);
+    if (!record || len != PCAP_RECORD_PREFIX_LEN + data_len || memcmp(record, &id, sizeof(id)) != 0) {
+        return false;
+    }
+    for (uint16_t i = 0; i < data_len; i++) {
+        if (record[PCAP_RECORD_PREFIX_LEN + i] != (uint8_t)id) return false;
+    }
+    return true;
+}
+
+static trigger_config_t deauth_config(uint16_t pre, uint16_t post) {
+    trigger_config_t config = {
+        .frames = TRIGGER_FRAME_BIT(IEEE80211_TYPE_MGMT, IEEE80211_STYPE_DEAUTH),
+        .pre = pre,
+        .post = post,
+    };
+    return config;
+}
+
+// Random-length records wrap the ring many times; the newest ones stay readable and in order
+static void check_wrap(void) {
+    static trigger_window_t w;
+    trigger_window_init(&w, memory, sizeof(memory));
+    trigger_config_t config = deauth_config(10, 10);
+    CHECK(trigger_window_arm(&w, 0, &config));
+
+    static uint16_t lens[5000];
+    uint64_t bytes = 0;
+    for (uint32_t id = 0; id < 5000; id++) {
+        lens[id] = next_random() % (TRIGGER_SNAPLEN + 1);
+        bytes += PCAP_RECORD_PREFIX_LEN + lens[id];
+        CHECK_EQ(push(&w, id, IEEE80211_STYPE_BEACON, lens[id], id * 1000), 0);
+    }
+    CHECK_EQ(w.frames, 5000);
+    CHECK_EQ(w.bytes, bytes);
+    CHECK_EQ(w.dropped, 0);
+    CHECK(bytes > 20 * sizeof(memory));
+
+    // Everything still held is intact, and it fills most of the ring
+    uint32_t held_bytes = 0;
+    for (uint32_t seq = w.first_seq; seq != w.next_seq; seq++) {
+        CHECK(record_is(&w, seq, seq, lens[seq]));
+        held_bytes += PCAP_RECORD_PREFIX_LEN + lens[seq];
+    }
+    CHECK(held_bytes <= sizeof(memory));
+    CHECK(held_bytes > sizeof(memory) - 2 * TRIGGER_RECORD_MAX_LEN);
+    uint16_t len;
+    CHECK(trigger_window_record(&w, w.first_seq - 1, &len) == NULL);
+    CHECK(trigger_window_record(&w, w.next_seq, &len) == NULL);
+
+    // Tiny records run into the record index limit before the memory
+    for (uint32_t id = 5000; id < 5000 + 2 * TRIGGER_WINDOW_RECORDS; id++) {
+        push(&w, id, IEEE80211_STYPE_BEACON, 0, id * 1000);
+    }
+    CHECK_EQ(w.next_seq - w.first_seq, TRIGGER_WINDOW_RECORDS);
+    CHECK(record_is(&w, w.first_seq, w.first_seq, 0));
+}
+
+// The burst-th match within burst_ms fires, not earlier and not when spread out
+static void check_burst(void) {
+    static trigger_window_t w;
+    trigger_window_init(&w, memory, sizeof(memory));
+    trigger_config_t config = deauth_config(0, 0);
+    config.burst = 5;
+    config.burst_ms = 100;
+    CHECK(trigger_window_arm(&w, 1, &config));
+
+    // One deauth every 30 ms: any 5 span 120 ms
+    uint32_t id = 0;
+    uint64_t now_us = 1000000;
+    for (int i = 0; i < 20; i++, now_us += 30000) {
+        CHECK_EQ(push(&w, id++, IEEE80211_STYPE_DEAUTH, 30, now_us), 0);
+        push(&w, id++, IEEE80211_STYPE_BEACON, 30, now_us + 1000);
+    }
+    CHECK_EQ(w.slots[1].matches, 20);
+    CHECK_EQ(w.slots[1].fired, 0);
+
+    // Frames of other kinds or addresses do not count
+    config.match_addr = true;
+    memcpy(config.addr, station, 6);
+    config.addr[5] ^= 1;
+    CHECK(trigger_window_arm(&w, 2, &config));
+
+    // After a pause, one every 20 ms: the fifth fires slot 1, with no post frames it is ready at once
+    now_us += 200000;
+    uint8_t ready = 0;
+    for (int i = 0; i < 5; i++, now_us += 20000) {
+        ready = push(&w, id++, IEEE80211_STYPE_DEAUTH, 30, now_us);
+        CHECK_EQ(ready & 0x02, i == 4 ? 0x02 : 0);
+    }
+    CHECK_EQ(w.slots[1].state, TRIGGER_READY);
+    CHECK_EQ(w.slots[1].trigger_seq, id - 1);
+    CHECK_EQ(w.slots[1].end_seq, id);
+    CHECK_EQ(w.slots[2].state, TRIGGER_ARMED);
+    CHECK_EQ(w.slots[2].matches, 0);
+
+    // A bad burst or slot is refused
+    config.burst = TRIGGER_MAX_BURST + 1;
+    CHECK(!trigger_window_arm(&w, 0, &config));
+    config.burst = 1;
+    CHECK(!trigger_window_arm(&w, TRIGGER_SLOTS, &config));
+}
+
+// Pre and post frames of full length survive until the capture is saved
+static void check_retention(void) {
+    static trigger_window_t w;
+    trigger_window_init(&w, memory, sizeof(memory));
+
+    // More than the window can keep is refused
+    trigger_config_t config = deauth_config(200, 200);
+    CHECK(!trigger_window_arm(&w, 0, &config));
+    config = deauth_config(TRIGGER_MAX_FRAMES / 2 + 1, TRIGGER_MAX_FRAMES / 2);
+    CHECK(!trigger_window_arm(&w, 0, &config));
+
+    uint16_t pre = TRIGGER_MAX_FRAMES / 2, post = TRIGGER_MAX_FRAMES - pre;
+    config = deauth_config(pre, post);
+    config.rearm = true;
+    CHECK(trigger_window_arm(&w, 0, &config));
+    // A second slot that never fires keeps the window taking frames
+    trigger_config_t other = deauth_config(0, 0);
+    other.match_addr = true;
+    CHECK(trigger_window_arm(&w, 1, &other));
+
+    // Fill and wrap the window with full-length frames, then trigger
+    uint32_t id = 0;
+    uint64_t now_us = 1000000;
+    for (; id < 300; id++, now_us += 1000) {
+        push(&w, id, IEEE80211_STYPE_BEACON, TRIGGER_SNAPLEN, now_us);
+    }
+    uint32_t trigger_id = id;
+    CHECK_EQ(push(&w, id++, IEEE80211_STYPE_DEAUTH, TRIGGER_SNAPLEN, now_us), 0);
+    trigger_slot_t *slot = &w.slots[0];
+    CHECK_EQ(slot->state, TRIGGER_COLLECTING);
+    CHECK_EQ(slot->trigger_seq, trigger_id);
+    CHECK_EQ(slot->first_seq, trigger_id - pre);
+
+    // Post frames, the last one completes the capture
+    uint8_t ready = 0;
+    for (uint16_t i = 0; i < post; i++, now_us += 1000) {
+        ready = push(&w, id++, IEEE80211_STYPE_BEACON, TRIGGER_SNAPLEN, now_us);
+        CHECK_EQ(ready, i + 1 == post ? 0x01 : 0);
+    }
+    CHECK_EQ(slot->state, TRIGGER_READY);
+    CHECK_EQ(slot->end_seq, trigger_id + 1 + post);
+    CHECK_EQ(w.dropped, 0);
+
+    // Until it is saved, more frames are dropped rather than overwrite it
+    for (int i = 0; i < 50; i++, now_us += 1000) {
+        CHECK_EQ(push(&w, id++, IEEE80211_STYPE_DEAUTH, TRIGGER_SNAPLEN, now_us), 0);
+    }
+    CHECK(w.dropped > 0);
+    CHECK_EQ(slot->fired, 1);
+    for (uint32_t seq = slot->first_seq; seq != slot->end_seq; seq++) {
+        CHECK(record_is(&w, seq, seq, TRIGGER_SNAPLEN));
+    }
+
+    // Saved: the slot re-arms and the window rolls on
+    uint32_t dropped = w.dropped;
+    trigger_window_saved(&w, 0, slot->fired, 0);
+    CHECK_EQ(slot->state, TRIGGER_ARMED);
+    CHECK_EQ(slot->saved, 1);
+    for (int i = 0; i < 200; i++, now_us += 1000) {
+        push(&w, id++, IEEE80211_STYPE_BEACON, TRIGGER_SNAPLEN, now_us);
+    }
+    CHECK_EQ(w.dropped, dropped);
+    uint16_t len;
+    CHECK(trigger_window_record(&w, trigger_id, &len) == NULL);
+}
+
+// A capture whose post frames never come is closed by the timeout with what it has
+static void check_post_timeout(void) {
+    static trigger_window_t w;
+    trigger_window_init(&w, memory, sizeof(memory));
+    trigger_config_t config = deauth_config(3, 20);
+    CHECK(trigger_window_arm(&w, 3, &config));
+
+    uint64_t now_us = 5000000;
+    for (uint32_t id = 0; id < 10; id++) {
+        push(&w, id, id == 5 ? IEEE80211_STYPE_DEAUTH : IEEE80211_STYPE_BEACON, 100, now_us);
+    }
+    CHECK_EQ(w.slots[3].state, TRIGGER_COLLECTING);
+    CHECK_EQ(trigger_window_poll(&w, now_us + TRIGGER_POST_TIMEOUT_MS * 1000 - 1), 0);
+    CHECK_EQ(trigger_window_poll(&w, now_us + TRIGGER_POST_TIMEOUT_MS * 1000), 0x08);
+    CHECK_EQ(w.slots[3].state, TRIGGER_READY);
+    CHECK_EQ(w.slots[3].first_seq, 2);
+    CHECK_EQ(w.slots[3].end_seq, 10);
+    CHECK(!trigger_window_active(&w));
+}
+
+int main(void) {
+    check_wrap();
+    check_burst();
+    check_retention();
+    check_post_timeout();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,88 @@
+// Host test: floods spread over random sources and the broadcast BSSID are caught channel-wide
+#include "host_test.h"
+#include "wids.h"
+#include <string.h>
+
+static uint32_t rng = 33;
+
+static uint32_t next_random(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static const uint8_t broadcast[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+// One management frame from a fresh locally administered address
+static void send_random(wids_t *wids, uint8_t subtype, const uint8_t *bssid, uint8_t channel, uint64_t now_us) {
+    uint8_t source[6];
+    for (int i = 0; i < 6; i++) {
+        source[i] = next_random();
+    }
+    source[0] = (source[0] & 0xFC) | 0x02;
+
+    frame_info_t info;
+    memset(&info, 0, sizeof(info));
+    info.type = IEEE80211_TYPE_MGMT;
+    info.subtype = subtype;
+    info.addr1 = broadcast;
+    info.addr2 = source;
+    info.addr3 = bssid;
+    info.bssid = bssid;
+    info.channel = channel;
+    info.timestamp_us = now_us;
+    wids_update(wids, &info);
+}
+
+int main(void) {
+    static wids_t wids;
+    wids_init(&wids, NULL);
+    uint64_t now_us = 1000000;
+
+    // Background: a probe request every 100 ms on channel 1 stays quiet
+    for (int i = 0; i < 200; i++, now_us += 100000) {
+        send_random(&wids, IEEE80211_STYPE_PROBE_REQ, broadcast, 1, now_us);
+    }
+    CHECK_EQ(wids.next_alert_id, 0);
+
+    // Probe flood from random sources at the broadcast BSSID on channel 6
+    uint32_t threshold = WIDS_DEFAULT_PROBE * WIDS_CHANNEL_SCALE;
+    for (uint32_t i = 0; i < threshold; i++, now_us += 1000) {
+        send_random(&wids, IEEE80211_STYPE_PROBE_REQ, broadcast, 6, now_us);
+    }
+    wids_alert_t alerts[WIDS_ALERT_RING];
+    int count = wids_get_alerts(&wids, 0, alerts, WIDS_ALERT_RING);
+    CHECK_EQ(count, 1);
+    CHECK_EQ(alerts[0].scope, WIDS_SCOPE_CHANNEL);
+    CHECK_EQ(alerts[0].category, WIDS_CAT_PROBE);
+    CHECK_EQ(alerts[0].channel, 6);
+    CHECK_EQ(alerts[0].count, threshold);
+    CHECK_EQ(alerts[0].threshold, threshold);
+    static const uint8_t zero[6];
+    CHECK(memcmp(alerts[0].mac, zero, 6) == 0);
+    CHECK(strcmp(wids_scope_name(alerts[0].scope), "channel") == 0);
+
+    // Deauths from random sources at one AP: caught per BSSID before the channel
+    static const uint8_t ap[6] = {0x24, 0x0A, 0xC4, 0x00, 0x00, 0x33};
+    for (int i = 0; i < WIDS_DEFAULT_DEAUTH * WIDS_CHANNEL_SCALE; i++, now_us += 1000) {
+        send_random(&wids, IEEE80211_STYPE_DEAUTH, ap, 11, now_us);
+    }
+    count = wids_get_alerts(&wids, alerts[0].id, alerts, WIDS_ALERT_RING);
+    CHECK_EQ(count, 2);
+    CHECK_EQ(alerts[0].scope, WIDS_SCOPE_BSSID);
+    CHECK(memcmp(alerts[0].mac, ap, 6) == 0);
+    CHECK_EQ(alerts[0].count, WIDS_DEFAULT_DEAUTH);
+    CHECK_EQ(alerts[1].scope, WIDS_SCOPE_CHANNEL);
+    CHECK_EQ(alerts[1].channel, 11);
+
+    // The channel re-arms once the flood has drained from the window
+    now_us += (WIDS_BUCKETS + 1) * 1000000ull;
+    for (uint32_t i = 0; i < threshold; i++, now_us += 1000) {
+        send_random(&wids, IEEE80211_STYPE_PROBE_REQ, broadcast, 6, now_us);
+    }
+    CHECK_EQ(wids.next_alert_id, 4);
+    CHECK_EQ(wids.frames[WIDS_CAT_PROBE], 200 + 2 * threshold);
+
+    return HOST_TEST_RESULT();
+}
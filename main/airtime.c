@@ -0,0 +1,214 @@
+#include "airtime.h"
+#include <string.h>
+
+// SERVICE field and convolutional code tail bits around the PSDU
+#define OFDM_SERVICE_TAIL_BITS   22
+
+// Legacy rate codes, in 500 kbps units (0 = unused code)
+static const uint8_t legacy_rates[16] = {
+    2, 4, 11, 22,                // 0x00-0x03: 1, 2, 5.5, 11 Mbps, long preamble
+    0, 4, 11, 22,                // 0x05-0x07: 2, 5.5, 11 Mbps, short preamble
+    96, 48, 24, 12,              // 0x08-0x0B: 48, 24, 12, 6 Mbps
+    108, 72, 36, 18,             // 0x0C-0x0F: 54, 36, 18, 9 Mbps
+};
+
+// Modulation and coding of HT (per stream), VHT and HE MCS indexes
+static const struct {
+    uint8_t bits;                // Coded bits per subcarrier
+    uint8_t num, den;            // Coding rate
+} mcs_table[12] = {
+    {1, 1, 2}, {2, 1, 2}, {2, 3, 4}, {4, 1, 2}, {4, 3, 4}, {6, 2, 3},
+    {6, 3, 4}, {6, 5, 6}, {8, 3, 4}, {8, 5, 6}, {10, 3, 4}, {10, 5, 6},
+};
+
+// Data subcarriers for 20/40/80 MHz
+static const uint16_t ht_subcarriers[3] = {52, 108, 234};
+static const uint16_t he_subcarriers[3] = {234, 468, 980};
+
+// Index into the subcarrier tables, -1 for unsupported widths
+static int bandwidth_index(uint8_t bandwidth) {
+    switch (bandwidth) {
+        case 20: return 0;
+        case 40: return 1;
+        case 80: return 2;
+        default: return -1;
+    }
+}
+
+// Duration in ns of a PPDU carrying psdu_len bytes with the given symbol layout
+static uint32_t ofdm_duration_ns(uint16_t psdu_len, uint32_t bits_per_symbol, uint32_t symbol_ns,
+                                 uint32_t preamble_ns) {
+    uint32_t bits = OFDM_SERVICE_TAIL_BITS + 8 * (uint32_t)psdu_len;
+    uint32_t symbols = (bits + bits_per_symbol - 1) / bits_per_symbol;
+    return preamble_ns + symbols * symbol_ns;
+}
+
+// Map an ESP legacy rate code to PHY parameters
+bool airtime_phy_from_legacy_code(uint8_t code, airtime_phy_t *phy) {
+    if (code >= 16 || legacy_rates[code] == 0) {
+        return false;
+    }
+
+    memset(phy, 0, sizeof(*phy));
+    phy->format = code < 0x08 ? AIRTIME_PHY_DSSS : AIRTIME_PHY_OFDM;
+    phy->rate = legacy_rates[code];
+    phy->nss = 1;
+    phy->bandwidth = 20;
+    phy->short_preamble = code >= 0x05 && code <= 0x07;
+    return true;
+}
+
+// Map a legacy rate in 500 kbps units to its ESP rate code
+int airtime_legacy_code(uint8_t rate) {
+    for (int code = 0; code < 16; code++) {
+        if (rate != 0 && legacy_rates[code] == rate) {
+            return code;
+        }
+    }
+    return -1;
+}
+
+// Estimate the on-air duration of a frame, preamble included
+uint32_t airtime_duration_us(const airtime_phy_t *phy, uint16_t psdu_len) {
+    int bw = bandwidth_index(phy->bandwidth);
+    uint8_t mcs = phy->rate;
+    uint8_t nss = phy->nss ? phy->nss : 1;
+    uint32_t ns;
+
+    switch (phy->format) {
+        case AIRTIME_PHY_DSSS:
+            if (phy->rate == 0) return 0;
+            // PLCP preamble + header, then 2 * bits / (rate in 500 kbps) microseconds
+            return (phy->short_preamble ? 96 : 192) + (16 * (uint32_t)psdu_len + phy->rate - 1) / phy->rate;
+
+        case AIRTIME_PHY_OFDM:
+            if (phy->rate == 0) return 0;
+            // 4 us symbols carrying 2 bits per 500 kbps; 20 us preamble and SIGNAL
+            ns = ofdm_duration_ns(psdu_len, phy->rate * 2, 4000, 20000);
+            break;
+
+        case AIRTIME_PHY_HT:
+            if (mcs > 31 || bw < 0 || bw > 1) return 0;
+            nss = mcs / 8 + 1;
+            mcs %= 8;
+            // L-STF/L-LTF/L-SIG (20), HT-SIG (8), HT-STF (4), one HT-LTF per stream
+            ns = ofdm_duration_ns(psdu_len,
+                                  ht_subcarriers[bw] * mcs_table[mcs].bits * mcs_table[mcs].num / mcs_table[mcs].den * nss,
+                                  phy->gi_ns == 400 ? 3600 : 4000, (32 + 4 * nss) * 1000);
+            break;
+
+        case AIRTIME_PHY_VHT:
+            if (mcs > 9 || bw < 0) return 0;
+            // As HT plus VHT-SIG-B (4)
+            ns = ofdm_duration_ns(psdu_len,
+                                  ht_subcarriers[bw] * mcs_table[mcs].bits * mcs_table[mcs].num / mcs_table[mcs].den * nss,
+                                  phy->gi_ns == 400 ? 3600 : 4000, (36 + 4 * nss) * 1000);
+            break;
+
+        case AIRTIME_PHY_HE: {
+            if (mcs > 11 || bw < 0) return 0;
+            uint32_t gi_ns = phy->gi_ns ? phy->gi_ns : 800;
+            // 12.8 us symbols; L-STF/L-LTF/L-SIG/RL-SIG/HE-SIG-A/HE-STF (36 us),
+            // then one 2x HE-LTF (6.4 us + GI) per stream
+            ns = ofdm_duration_ns(psdu_len,
+                                  he_subcarriers[bw] * mcs_table[mcs].bits * mcs_table[mcs].num / mcs_table[mcs].den * nss,
+                                  12800 + gi_ns, 36000 + nss * (6400 + gi_ns));
+            break;
+        }
+
+        default:
+            return 0;
+    }
+
+    return (ns + 999) / 1000;
+}
+
+// Find or allocate the slot of a channel, evicting the least recently dwelt on
+static int channel_slot(airtime_t *at, uint8_t channel) {
+    int free_slot = -1, oldest = 0;
+    for (int i = 0; i < AIRTIME_MAX_CHANNELS; i++) {
+        const airtime_channel_t *ch = &at->channels[i];
+        if (ch->channel == channel) return i;
+        if (ch->channel == 0) {
+            if (free_slot < 0) free_slot = i;
+        } else if (ch->last_dwell_us < at->channels[oldest].last_dwell_us) {
+            oldest = i;
+        }
+    }
+
+    int slot = free_slot >= 0 ? free_slot : oldest;
+    airtime_channel_t *ch = &at->channels[slot];
+    if (ch->channel != 0) {
+        at->evictions++;
+    }
+    memset(ch, 0, sizeof(*ch));
+    ch->channel = channel;
+    return slot;
+}
+
+// Reset the accumulator
+void airtime_init(airtime_t *at, uint64_t now_us) {
+    memset(at, 0, sizeof(*at));
+    at->session_start_us = now_us;
+    at->dwell_slot = -1;
+}
+
+// Close the current dwell and record its busy percentage
+void airtime_dwell_end(airtime_t *at, uint64_t now_us) {
+    if (at->dwell_slot < 0) {
+        return;
+    }
+
+    airtime_channel_t *ch = &at->channels[at->dwell_slot];
+    uint64_t dwell_us = now_us - at->dwell_start_us;
+    at->dwell_slot = -1;
+
+    // Ignore dwells too short to say anything (e.g. a failed hop)
+    if (dwell_us < 1000) {
+        return;
+    }
+
+    // Estimates can exceed the dwell when frames overlap or straddle a hop
+    uint32_t busy_us = at->dwell_busy_us < dwell_us ? at->dwell_busy_us : (uint32_t)dwell_us;
+    ch->busy_us += busy_us;
+    ch->dwell_us += dwell_us;
+    ch->frames += at->dwell_frames;
+
+    if (ch->count == AIRTIME_HISTORY) {
+        ch->head = (ch->head + 1) % AIRTIME_HISTORY;
+        ch->count--;
+    }
+    airtime_sample_t *sample = &ch->history[(ch->head + ch->count) % AIRTIME_HISTORY];
+    ch->count++;
+    sample->end_ms = (uint32_t)((now_us - at->session_start_us) / 1000);
+    sample->dwell_ms = dwell_us / 1000 > UINT16_MAX ? UINT16_MAX : dwell_us / 1000;
+    sample->busy_permille = (uint16_t)((uint64_t)busy_us * 1000 / dwell_us);
+}
+
+// Close the current dwell (if any) and start one on a channel
+void airtime_dwell_begin(airtime_t *at, uint8_t channel, uint64_t now_us) {
+    airtime_dwell_end(at, now_us);
+
+    at->dwell_slot = channel_slot(at, channel);
+    at->channels[at->dwell_slot].last_dwell_us = now_us;
+    at->dwell_start_us = now_us;
+    at->dwell_busy_us = 0;
+    at->dwell_frames = 0;
+}
+
+// Account the airtime of one received frame
+void airtime_update(airtime_t *at, uint8_t channel, uint32_t duration_us, uint64_t now_us) {
+    // Without a hopper nobody closes dwells, so roll them over here
+    if (at->dwell_slot < 0 || now_us - at->dwell_start_us >= AIRTIME_MAX_DWELL_US) {
+        airtime_dwell_begin(at, channel, now_us);
+    }
+
+    // Frames reported on another channel straddled a hop; drop them
+    if (at->channels[at->dwell_slot].channel != channel) {
+        at->dropped_frames++;
+        return;
+    }
+
+    at->dwell_busy_us += duration_us;
+    at->dwell_frames++;
+}
@@ -0,0 +1,124 @@
+#ifndef AIRTIME_H
+#define AIRTIME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Channels tracked at once (the least recently dwelt on is evicted beyond this)
+// and dwell samples kept per channel
+#define AIRTIME_MAX_CHANNELS         16
+#define AIRTIME_HISTORY              32
+// A dwell on a fixed channel is closed and restarted after this long
+#define AIRTIME_MAX_DWELL_US         1000000
+
+/**
+ * @brief PHY formats with distinct timing
+ */
+typedef enum {
+    AIRTIME_PHY_DSSS = 0,        // 802.11b
+    AIRTIME_PHY_OFDM,            // 802.11a/g
+    AIRTIME_PHY_HT,              // 802.11n mixed format
+    AIRTIME_PHY_VHT,             // 802.11ac
+    AIRTIME_PHY_HE,              // 802.11ax SU
+} airtime_format_t;
+
+/**
+ * @brief PHY parameters of a received frame
+ */
+typedef struct {
+    uint8_t format;              // airtime_format_t
+    uint8_t rate;                // DSSS/OFDM: rate in 500 kbps units; HT: MCS 0-31; VHT/HE: MCS
+    uint8_t nss;                 // Spatial streams (VHT/HE; HT derives it from the MCS)
+    uint8_t bandwidth;           // 20, 40 or 80 MHz
+    uint16_t gi_ns;              // Guard interval: 400/800 (HT/VHT) or 800/1600/3200 (HE)
+    bool short_preamble;         // DSSS only
+} airtime_phy_t;
+
+/**
+ * @brief Busy time measured during one dwell
+ */
+typedef struct {
+    uint32_t end_ms;             // Dwell end, relative to the session start
+    uint16_t dwell_ms;
+    uint16_t busy_permille;
+} airtime_sample_t;
+
+/**
+ * @brief Airtime counters of one channel
+ */
+typedef struct {
+    uint8_t channel;             // 0 if the slot is unused
+    uint8_t head;                // Oldest sample
+    uint8_t count;
+    uint32_t frames;
+    uint64_t busy_us;            // Totals over all completed dwells
+    uint64_t dwell_us;
+    uint64_t last_dwell_us;      // Start of the latest dwell, for eviction
+    airtime_sample_t history[AIRTIME_HISTORY];
+} airtime_channel_t;
+
+/**
+ * @brief Per-channel airtime accumulator
+ */
+typedef struct {
+    airtime_channel_t channels[AIRTIME_MAX_CHANNELS];
+    uint64_t session_start_us;
+    int8_t dwell_slot;           // Channel slot being dwelt on, -1 if none
+    uint64_t dwell_start_us;
+    uint32_t dwell_busy_us;
+    uint32_t dwell_frames;
+    uint32_t evictions;          // Channels whose counters were dropped to make room
+    uint32_t dropped_frames;     // Frames reported on a channel other than the dwell's
+} airtime_t;
+
+/**
+ * @brief Map an ESP legacy rate code (rx_ctrl.rate, 0x00-0x0F) to PHY parameters
+ *
+ * @return false if the code is not a legacy rate
+ */
+bool airtime_phy_from_legacy_code(uint8_t code, airtime_phy_t *phy);
+
+/**
+ * @brief Map a legacy rate in 500 kbps units to its ESP rate code (long preamble for DSSS)
+ *
+ * @return The code, or -1 if the rate is not a legacy rate
+ */
+int airtime_legacy_code(uint8_t rate);
+
+/**
+ * @brief Estimate the on-air duration of a frame, preamble included
+ *
+ * @param phy PHY parameters
+ * @param psdu_len Frame length including the FCS
+ * @return Duration in microseconds, rounded up (0 if the PHY is invalid)
+ */
+uint32_t airtime_duration_us(const airtime_phy_t *phy, uint16_t psdu_len);
+
+/**
+ * @brief Reset the accumulator
+ */
+void airtime_init(airtime_t *at, uint64_t now_us);
+
+/**
+ * @brief Close the current dwell (if any) and start one on a channel
+ */
+void airtime_dwell_begin(airtime_t *at, uint8_t channel, uint64_t now_us);
+
+/**
+ * @brief Close the current dwell and record its busy percentage
+ */
+void airtime_dwell_end(airtime_t *at, uint64_t now_us);
+
+/**
+ * @brief Account the airtime of one received frame
+ */
+void airtime_update(airtime_t *at, uint8_t channel, uint32_t duration_us, uint64_t now_us);
+
+/**
+ * @brief Get a dwell sample of a channel, oldest first
+ */
+static inline const airtime_sample_t *airtime_sample(const airtime_channel_t *ch, int i) {
+    return &ch->history[(ch->head + i) % AIRTIME_HISTORY];
+}
+
+#endif /* AIRTIME_H */
@@ -0,0 +1,116 @@
+#include "api_json.h"
+#include "frame_format.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Name of a scan record's security mode
+static const char *auth_mode_name(wifi_auth_mode_t mode) {
+    switch (mode) {
+        case WIFI_AUTH_OPEN: return "Open";
+        case WIFI_AUTH_WEP: return "WEP";
+        case WIFI_AUTH_WPA_PSK: return "WPA PSK";
+        case WIFI_AUTH_WPA2_PSK: return "WPA2 PSK";
+        case WIFI_AUTH_WPA_WPA2_PSK: return "WPA/WPA2 PSK";
+        case WIFI_AUTH_WPA3_PSK: return "WPA3 PSK";
+        case WIFI_AUTH_WPA2_WPA3_PSK: return "WPA2/WPA3 PSK";
+        default: return "Unknown";
+    }
+}
+
+// Build the /api/scan/result response from scan records
+cJSON *api_json_scan_results(const wifi_ap_record_t *records, uint16_t count) {
+    cJSON *root = cJSON_CreateObject();
+    cJSON *networks = root ? cJSON_AddArrayToObject(root, "networks") : NULL;
+    if (!networks) {
+        cJSON_Delete(root);
+        return NULL;
+    }
+    cJSON_AddStringToObject(root, "status", "success");
+    
+    for (int i = 0; i < count; i++) {
+        const wifi_ap_record_t *ap = &records[i];
+        cJSON *network = cJSON_CreateObject();
+        if (!network) {
+            continue;
+        }
+        
+        cJSON_AddStringToObject(network, "ssid", (const char *)ap->ssid);
+        
+        char bssid_str[18];
+        format_mac_addr(bssid_str, ap->bssid);
+        cJSON_AddStringToObject(network, "bssid", bssid_str);
+        
+        cJSON_AddNumberToObject(network, "rssi", ap->rssi);
+        cJSON_AddNumberToObject(network, "channel", ap->primary);
+        
+        // Determine WiFi band (2.4GHz or 5GHz) based on channel
+        bool is_5ghz = ap->primary > 14;
+        cJSON_AddStringToObject(network, "band", is_5ghz ? "5 GHz" : "2.4 GHz");
+        
+        // Add second channel if using 40MHz bandwidth
+        if (ap->second) {
+            cJSON_AddNumberToObject(network, "second_channel", ap->second);
+        }
+        
+        const char *phy_mode = ap->phy_11n ? "802.11n" : is_5ghz ? "802.11a" : "802.11b/g";
+        cJSON_AddStringToObject(network, "phy_mode", phy_mode);
+        cJSON_AddStringToObject(network, "security", auth_mode_name(ap->authmode));
+        cJSON_AddBoolToObject(network, "is_hidden", ap->ssid[0] == 0);
+        
+        cJSON_AddItemToArray(networks, network);
+    }
+    
+    return root;
+}
+
+// Build the /api/sniff/packets response from captured frames
+cJSON *api_json_packets(packet_info_t *const *packets, int count) {
+    cJSON *root = cJSON_CreateObject();
+    cJSON *packets_array = root ? cJSON_AddArrayToObject(root, "packets") : NULL;
+    if (!packets_array) {
+        cJSON_Delete(root);
+        return NULL;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        const packet_info_t *pkt = packets[i];
+        cJSON *packet = cJSON_CreateObject();
+        if (!packet) {
+            continue;
+        }
+        
+        // Extract header info
+        uint16_t frame_ctrl = pkt->data[0] | (pkt->data[1] << 8);
+        const uint8_t *addr1 = pkt->data + 4;  // dst
+        const uint8_t *addr2 = pkt->data + 10; // src
+        
+        char src_mac[18], dst_mac[18];
+        format_mac_addr(dst_mac, addr1);
+        format_mac_addr(src_mac, addr2);
+        
+        cJSON_AddStringToObject(packet, "type", get_frame_type_str(frame_ctrl));
+        cJSON_AddStringToObject(packet, "src", src_mac);
+        cJSON_AddStringToObject(packet, "dst", dst_mac);
+        cJSON_AddNumberToObject(packet, "channel", pkt->channel);
+        cJSON_AddNumberToObject(packet, "rssi", pkt->rssi);
+        
+        // Leading bytes as hex, with an ellipsis if the frame is longer
+        if (pkt->length > 0) {
+            char hex_data[API_JSON_HEX_BYTES * 3 + 4];
+            int pos = 0;
+            for (int j = 0; j < pkt->length && j < API_JSON_HEX_BYTES; j++) {
+                pos += snprintf(hex_data + pos, 4, "%02x ", pkt->data[j]);
+            }
+            if (pkt->length > API_JSON_HEX_BYTES) {
+                strcpy(hex_data + pos, "...");
+            }
+            cJSON_AddStringToObject(packet, "data", hex_data);
+        }
+        
+        cJSON_AddItemToArray(packets_array, packet);
+    }
+    
+    return root;
+}
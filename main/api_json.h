@@ -0,0 +1,28 @@
+#ifndef API_JSON_H
+#define API_JSON_H
+
+#include <stdint.h>
+#include "cJSON.h"
+#include "esp_wifi_types.h"
+#include "wifi_sniffer.h"
+
+// Leading bytes of each frame shown as hex in the packet list
+#define API_JSON_HEX_BYTES           64
+
+/**
+ * @brief Build the /api/scan/result response from scan records
+ *
+ * @return The response object (free with cJSON_Delete), or NULL if out of memory
+ */
+cJSON *api_json_scan_results(const wifi_ap_record_t *records, uint16_t count);
+
+/**
+ * @brief Build the /api/sniff/packets response from captured frames
+ *
+ * @param packets Frames to list; ownership stays with the caller
+ * @param count Number of frames
+ * @return The response object (free with cJSON_Delete), or NULL if out of memory
+ */
+cJSON *api_json_packets(packet_info_t *const *packets, int count);
+
+#endif /* API_JSON_H */
@@ -0,0 +1,147 @@
+#include "assoc_graph.h"
+#include <string.h>
+
+// Look up or create the edge for a (BSSID, station) pair
+static assoc_edge_t *touch_edge(assoc_graph_t *graph, const uint8_t *bssid, const uint8_t *station,
+                                const frame_info_t *info) {
+    uint8_t key[12];
+    memcpy(key, bssid, 6);
+    memcpy(key + 6, station, 6);
+
+    bool is_new;
+    int slot = mac_table_touch(&graph->table, key, &is_new);
+    assoc_edge_t *edge = &graph->edges[slot];
+
+    if (is_new) {
+        memset(edge, 0, sizeof(*edge));
+        memcpy(edge->bssid, bssid, 6);
+        memcpy(edge->station, station, 6);
+        edge->first_seen_us = info->timestamp_us;
+    }
+    edge->frames++;
+    edge->last_seen_us = info->timestamp_us;
+    edge->channel = info->channel;
+    return edge;
+}
+
+// Reset the graph
+void assoc_graph_init(assoc_graph_t *graph) {
+    mac_table_init(&graph->table, graph->nodes, graph->buckets,
+                   ASSOC_GRAPH_MAX_EDGES, ASSOC_GRAPH_HASH_BUCKETS, 12);
+}
+
+// Update the graph from one received frame
+void assoc_graph_update(assoc_graph_t *graph, const frame_info_t *info) {
+    if (!info->addr2) {
+        return;
+    }
+
+    if (info->type == IEEE80211_TYPE_DATA) {
+        bool to_ds = info->flags & IEEE80211_FCTL_TODS;
+        bool from_ds = info->flags & IEEE80211_FCTL_FROMDS;
+
+        // Only infrastructure traffic with exactly one DS bit identifies a client
+        if (to_ds == from_ds) {
+            return;
+        }
+
+        const uint8_t *station = to_ds ? info->addr2 : info->addr1;
+        if (ieee80211_is_group_addr(station)) {
+            return; // Group-addressed downlink
+        }
+
+        assoc_edge_t *edge = touch_edge(graph, info->bssid, station, info);
+        edge->sources |= ASSOC_EDGE_FROM_DATA;
+        edge->associated = true;
+        return;
+    }
+
+    if (info->type != IEEE80211_TYPE_MGMT || !info->bssid) {
+        return;
+    }
+
+    switch (info->subtype) {
+        case IEEE80211_STYPE_ASSOC_RESP:
+        case IEEE80211_STYPE_REASSOC_RESP: {
+            // Body: capability (2), status code (2), AID (2)
+            if (info->body_len < 6 || ieee80211_is_group_addr(info->addr1)) {
+                return;
+            }
+            uint16_t status = info->body[2] | (info->body[3] << 8);
+            if (status != 0) {
+                return;
+            }
+
+            assoc_edge_t *edge = touch_edge(graph, info->bssid, info->addr1, info);
+            edge->aid = (info->body[4] | (info->body[5] << 8)) & 0x3FFF;
+            edge->sources |= ASSOC_EDGE_FROM_ASSOC;
+            edge->associated = true;
+            break;
+        }
+
+        case IEEE80211_STYPE_DEAUTH:
+        case IEEE80211_STYPE_DISASSOC: {
+            // Mark an existing edge as gone without creating new ones
+            const uint8_t *station = memcmp(info->addr2, info->bssid, 6) == 0 ? info->addr1 : info->addr2;
+            uint8_t key[12];
+            memcpy(key, info->bssid, 6);
+            memcpy(key + 6, station, 6);
+
+            int slot = mac_table_find(&graph->table, key);
+            if (slot >= 0) {
+                graph->edges[slot].associated = false;
+                graph->edges[slot].last_seen_us = info->timestamp_us;
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+// Merge the edges of src into dst
+void assoc_graph_merge(assoc_graph_t *dst, const assoc_graph_t *src) {
+    for (uint16_t slot = src->table.lru_tail; slot != MAC_TABLE_NONE; slot = src->nodes[slot].lru_prev) {
+        const assoc_edge_t *from = &src->edges[slot];
+
+        bool is_new;
+        int dst_slot = mac_table_touch(&dst->table, mac_table_key(&src->table, slot), &is_new);
+        assoc_edge_t *to = &dst->edges[dst_slot];
+
+        if (is_new) {
+            *to = *from;
+            continue;
+        }
+
+        to->frames += from->frames;
+        to->sources |= from->sources;
+        if (from->first_seen_us < to->first_seen_us) {
+            to->first_seen_us = from->first_seen_us;
+        }
+        if (from->last_seen_us > to->last_seen_us) {
+            to->last_seen_us = from->last_seen_us;
+            to->channel = from->channel;
+            to->associated = from->associated;
+        }
+        if (from->aid) {
+            to->aid = from->aid;
+        }
+    }
+    dst->table.evictions += src->table.evictions;
+}
+
+// Copy edges, optionally only those of one BSSID
+int assoc_graph_get_edges(const assoc_graph_t *graph, const uint8_t *bssid, assoc_edge_t *out, int max_edges) {
+    int count = 0;
+
+    for (uint16_t slot = graph->table.lru_head; slot != MAC_TABLE_NONE && count < max_edges;
+         slot = graph->nodes[slot].lru_next) {
+        if (bssid && memcmp(graph->edges[slot].bssid, bssid, 6) != 0) {
+            continue;
+        }
+        out[count++] = graph->edges[slot];
+    }
+
+    return count;
+}
@@ -0,0 +1,72 @@
+#ifndef ASSOC_GRAPH_H
+#define ASSOC_GRAPH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ieee80211.h"
+#include "mac_table.h"
+
+// Maximum number of (BSSID, station) edges; least recently active are evicted
+#ifndef ASSOC_GRAPH_MAX_EDGES
+#define ASSOC_GRAPH_MAX_EDGES        256
+#endif
+#ifndef ASSOC_GRAPH_HASH_BUCKETS
+#define ASSOC_GRAPH_HASH_BUCKETS     128
+#endif
+
+// How an edge was learned
+#define ASSOC_EDGE_FROM_DATA         0x01  // ToDS/FromDS data frames
+#define ASSOC_EDGE_FROM_ASSOC        0x02  // Successful (re)association response
+
+/**
+ * @brief One client-to-AP edge
+ */
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t station[6];
+    uint32_t frames;             // Frames exchanged over this edge
+    uint64_t first_seen_us;
+    uint64_t last_seen_us;       // Last activity
+    uint16_t aid;                // Association ID, 0 if not observed
+    uint8_t sources;             // ASSOC_EDGE_FROM_* bits
+    uint8_t channel;
+    bool associated;             // Cleared by deauth/disassoc
+} assoc_edge_t;
+
+/**
+ * @brief Association graph state
+ */
+typedef struct {
+    mac_table_t table;
+    mac_table_node_t nodes[ASSOC_GRAPH_MAX_EDGES];
+    uint16_t buckets[ASSOC_GRAPH_HASH_BUCKETS];
+    assoc_edge_t edges[ASSOC_GRAPH_MAX_EDGES];
+} assoc_graph_t;
+
+/**
+ * @brief Reset the graph
+ */
+void assoc_graph_init(assoc_graph_t *graph);
+
+/**
+ * @brief Update the graph from one received frame (O(1))
+ */
+void assoc_graph_update(assoc_graph_t *graph, const frame_info_t *info);
+
+/**
+ * @brief Merge the edges of src into dst
+ */
+void assoc_graph_merge(assoc_graph_t *dst, const assoc_graph_t *src);
+
+/**
+ * @brief Copy edges, optionally only those of one BSSID
+ *
+ * @param graph Graph
+ * @param bssid Only copy this BSSID's clients (NULL for the whole graph)
+ * @param out Output array
+ * @param max_edges Size of the output array
+ * @return Number of edges copied, most recently active first
+ */
+int assoc_graph_get_edges(const assoc_graph_t *graph, const uint8_t *bssid, assoc_edge_t *out, int max_edges);
+
+#endif /* ASSOC_GRAPH_H */
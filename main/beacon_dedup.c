@@ -0,0 +1,138 @@
+#include "beacon_dedup.h"
+#include <string.h>
+
+// 1 TU = 1024 us
+#define TU_TO_US(tu) ((uint64_t)(tu) * 1024)
+
+// Hash the tagged parameters of a beacon, skipping elements that change on
+// every beacon (TIM carries the DTIM count, BSS Load the channel utilization)
+static uint32_t hash_beacon_ies(const uint8_t *ies, uint16_t len) {
+    uint32_t hash = 2166136261u; // FNV-1a offset basis
+    uint16_t pos = 0;
+
+    while (pos + 2 <= len) {
+        uint8_t id = ies[pos];
+        uint8_t ie_len = ies[pos + 1];
+
+        if (pos + 2 + ie_len > len) {
+            break;
+        }
+        if (id != IEEE80211_IE_TIM && id != IEEE80211_IE_BSS_LOAD) {
+            for (uint16_t i = 0; i < ie_len + 2; i++) {
+                hash ^= ies[pos + i];
+                hash *= 16777619u;
+            }
+        }
+        pos += 2 + ie_len;
+    }
+
+    return hash;
+}
+
+// Find the entry for a BSSID, or recycle the least recently heard one
+static beacon_dedup_entry_t *find_or_alloc_entry(beacon_dedup_t *dedup, const uint8_t *bssid, bool *is_new) {
+    beacon_dedup_entry_t *free_entry = NULL;
+    beacon_dedup_entry_t *oldest = NULL;
+
+    for (int i = 0; i < BEACON_DEDUP_MAX_ENTRIES; i++) {
+        beacon_dedup_entry_t *entry = &dedup->entries[i];
+
+        if (!entry->in_use) {
+            if (!free_entry) free_entry = entry;
+        } else if (memcmp(entry->bssid, bssid, 6) == 0) {
+            *is_new = false;
+            return entry;
+        } else if (!oldest || entry->last_seen_us < oldest->last_seen_us) {
+            oldest = entry;
+        }
+    }
+
+    beacon_dedup_entry_t *entry = free_entry ? free_entry : oldest;
+    memset(entry, 0, sizeof(*entry));
+    memcpy(entry->bssid, bssid, 6);
+    entry->in_use = true;
+    *is_new = true;
+    return entry;
+}
+
+// Reset the dedup state
+void beacon_dedup_init(beacon_dedup_t *dedup, uint32_t keepalive_ms) {
+    memset(dedup, 0, sizeof(*dedup));
+    dedup->keepalive_ms = keepalive_ms ? keepalive_ms : BEACON_DEDUP_KEEPALIVE_MS;
+}
+
+// Account a beacon and decide whether it should be captured
+bool beacon_dedup_check(beacon_dedup_t *dedup, const frame_info_t *info) {
+    if (!info->bssid || info->body_len < IEEE80211_BEACON_FIXED_LEN) {
+        return true; // Can't key it, let it through
+    }
+
+    dedup->total_seen++;
+
+    const uint8_t *ies = info->body + IEEE80211_BEACON_FIXED_LEN;
+    uint16_t ies_len = info->body_len - IEEE80211_BEACON_FIXED_LEN;
+
+    // Extract the SSID
+    char ssid[33] = {0};
+    uint8_t ssid_len = 0;
+    const uint8_t *ssid_ie = ieee80211_find_ie(ies, ies_len, IEEE80211_IE_SSID, &ssid_len);
+    if (ssid_ie) {
+        if (ssid_len > 32) ssid_len = 32;
+        memcpy(ssid, ssid_ie, ssid_len);
+    }
+
+    uint32_t ie_hash = hash_beacon_ies(ies, ies_len);
+    uint16_t interval_tu = info->body[8] | (info->body[9] << 8);
+
+    bool is_new;
+    beacon_dedup_entry_t *entry = find_or_alloc_entry(dedup, info->bssid, &is_new);
+
+    if (is_new) {
+        entry->first_seen_us = info->timestamp_us;
+        entry->rssi_min = info->rssi;
+        entry->rssi_max = info->rssi;
+    } else {
+        // Beacon interval jitter: deviation of the inter-arrival time from the
+        // nearest multiple of the advertised interval (beacons missed while
+        // hopping show up as multiples, not as jitter)
+        uint64_t nominal_us = TU_TO_US(interval_tu);
+        if (nominal_us > 0 && info->timestamp_us > entry->last_seen_us) {
+            uint64_t delta_us = info->timestamp_us - entry->last_seen_us;
+            uint64_t periods = (delta_us + nominal_us / 2) / nominal_us;
+            if (periods > 0) {
+                uint64_t expected_us = periods * nominal_us;
+                uint32_t deviation = (uint32_t)(delta_us > expected_us ? delta_us - expected_us : expected_us - delta_us);
+                entry->jitter_samples++;
+                entry->jitter_sum_us += deviation;
+                if (deviation > entry->jitter_max_us) entry->jitter_max_us = deviation;
+            }
+        }
+        if (info->rssi < entry->rssi_min) entry->rssi_min = info->rssi;
+        if (info->rssi > entry->rssi_max) entry->rssi_max = info->rssi;
+    }
+
+    entry->beacons++;
+    entry->rssi_sum += info->rssi;
+    entry->last_seen_us = info->timestamp_us;
+    entry->channel = info->channel;
+    entry->interval_tu = interval_tu;
+
+    // Forward when the beacon is new, has changed, or the keepalive expired
+    bool changed = !is_new && (entry->ie_hash != ie_hash || strcmp(entry->ssid, ssid) != 0);
+    bool keepalive = info->timestamp_us - entry->last_forward_us >= (uint64_t)dedup->keepalive_ms * 1000;
+
+    if (changed) {
+        entry->changes++;
+    }
+    entry->ie_hash = ie_hash;
+    memcpy(entry->ssid, ssid, sizeof(entry->ssid));
+
+    if (is_new || changed || keepalive) {
+        entry->last_forward_us = info->timestamp_us;
+        entry->forwarded++;
+        dedup->total_forwarded++;
+        return true;
+    }
+
+    return false;
+}
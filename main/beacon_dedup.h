@@ -0,0 +1,78 @@
+#ifndef BEACON_DEDUP_H
+#define BEACON_DEDUP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ieee80211.h"
+
+// Number of BSSIDs tracked at once; least recently heard entries are recycled
+#define BEACON_DEDUP_MAX_ENTRIES     64
+// Default interval after which an unchanged beacon is forwarded again
+#define BEACON_DEDUP_KEEPALIVE_MS    5000
+
+/**
+ * @brief Per-BSSID beacon counters kept by the dedup stage
+ */
+typedef struct {
+    uint8_t bssid[6];
+    char ssid[33];
+    uint32_t ie_hash;            // Hash over the IEs that identify the BSS
+    uint8_t channel;
+    uint16_t interval_tu;        // Advertised beacon interval
+    uint64_t first_seen_us;
+    uint64_t last_seen_us;
+    uint64_t last_forward_us;
+    uint32_t beacons;            // Beacons seen
+    uint32_t forwarded;          // Beacons passed on to the capture buffer
+    uint32_t changes;            // Times the SSID or IE hash changed
+    int8_t rssi_min;
+    int8_t rssi_max;
+    int64_t rssi_sum;
+    uint32_t jitter_samples;     // Inter-arrival samples used for jitter
+    uint64_t jitter_sum_us;      // Sum of deviations from the nominal interval
+    uint32_t jitter_max_us;
+    bool in_use;
+} beacon_dedup_entry_t;
+
+/**
+ * @brief Beacon dedup state
+ */
+typedef struct {
+    beacon_dedup_entry_t entries[BEACON_DEDUP_MAX_ENTRIES];
+    uint32_t keepalive_ms;
+    uint32_t total_seen;
+    uint32_t total_forwarded;
+} beacon_dedup_t;
+
+/**
+ * @brief Reset the dedup state
+ *
+ * @param dedup Dedup state
+ * @param keepalive_ms Interval after which an unchanged beacon is forwarded again
+ */
+void beacon_dedup_init(beacon_dedup_t *dedup, uint32_t keepalive_ms);
+
+/**
+ * @brief Account a beacon and decide whether it should be captured
+ *
+ * @param dedup Dedup state
+ * @param info Parsed beacon frame
+ * @return true if the beacon is new, changed or due for a keepalive
+ */
+bool beacon_dedup_check(beacon_dedup_t *dedup, const frame_info_t *info);
+
+/**
+ * @brief Get the average RSSI of an entry
+ */
+static inline int8_t beacon_dedup_rssi_avg(const beacon_dedup_entry_t *entry) {
+    return entry->beacons ? (int8_t)(entry->rssi_sum / (int64_t)entry->beacons) : 0;
+}
+
+/**
+ * @brief Get the average beacon interval jitter of an entry in microseconds
+ */
+static inline uint32_t beacon_dedup_jitter_avg(const beacon_dedup_entry_t *entry) {
+    return entry->jitter_samples ? (uint32_t)(entry->jitter_sum_us / entry->jitter_samples) : 0;
+}
+
+#endif /* BEACON_DEDUP_H */
@@ -0,0 +1,142 @@
+#include "capture_buffer.h"
+#include <string.h>
+
+// Reserved slots per class; whatever is left over is shared by all classes
+static const uint16_t class_reserved[CAPTURE_CLASS_COUNT] = {
+    [CAPTURE_CLASS_HANDSHAKE] = 8,
+    [CAPTURE_CLASS_DEAUTH]    = 4,
+    [CAPTURE_CLASS_PROBE]     = 4,
+    [CAPTURE_CLASS_BEACON]    = 4,
+    [CAPTURE_CLASS_OTHER]     = 4,
+};
+
+static const char *class_names[CAPTURE_CLASS_COUNT] = {
+    [CAPTURE_CLASS_HANDSHAKE] = "handshake",
+    [CAPTURE_CLASS_DEAUTH]    = "deauth",
+    [CAPTURE_CLASS_PROBE]     = "probe",
+    [CAPTURE_CLASS_BEACON]    = "beacon",
+    [CAPTURE_CLASS_OTHER]     = "other",
+};
+
+// Remove the oldest frame of a class
+static void *pop_class(capture_buffer_t *cb, int cls) {
+    capture_class_stats_t *stats = &cb->stats[cls];
+    if (stats->stored == 0) {
+        return NULL;
+    }
+
+    void *item = cb->slots[cls][cb->head[cls]].item;
+    cb->head[cls] = (cb->head[cls] + 1) % CAPTURE_BUFFER_CAPACITY;
+    stats->stored--;
+    cb->total--;
+    return item;
+}
+
+// Initialize an empty capture buffer with the default class quotas
+void capture_buffer_init(capture_buffer_t *cb) {
+    memset(cb, 0, sizeof(*cb));
+    for (int i = 0; i < CAPTURE_CLASS_COUNT; i++) {
+        cb->stats[i].reserved = class_reserved[i];
+    }
+}
+
+// Classify a frame into a retention class
+capture_class_t capture_buffer_classify(const frame_info_t *info) {
+    if (info->type == IEEE80211_TYPE_MGMT) {
+        switch (info->subtype) {
+            case IEEE80211_STYPE_ASSOC_REQ:
+            case IEEE80211_STYPE_ASSOC_RESP:
+            case IEEE80211_STYPE_REASSOC_REQ:
+            case IEEE80211_STYPE_REASSOC_RESP:
+            case IEEE80211_STYPE_AUTH:
+                return CAPTURE_CLASS_HANDSHAKE;
+            case IEEE80211_STYPE_DEAUTH:
+            case IEEE80211_STYPE_DISASSOC:
+                return CAPTURE_CLASS_DEAUTH;
+            case IEEE80211_STYPE_PROBE_REQ:
+            case IEEE80211_STYPE_PROBE_RESP:
+                return CAPTURE_CLASS_PROBE;
+            case IEEE80211_STYPE_BEACON:
+                return CAPTURE_CLASS_BEACON;
+            default:
+                return CAPTURE_CLASS_OTHER;
+        }
+    }
+
+    if (ieee80211_is_eapol(info)) {
+        return CAPTURE_CLASS_HANDSHAKE;
+    }
+
+    return CAPTURE_CLASS_OTHER;
+}
+
+// Add a frame to the buffer
+bool capture_buffer_push(capture_buffer_t *cb, capture_class_t cls, void *item, void **evicted) {
+    *evicted = NULL;
+
+    if (cb->total >= CAPTURE_BUFFER_CAPACITY) {
+        // A class within its reservation may evict from any class using shared
+        // slots; otherwise it may only evict from itself or lower priorities
+        bool within_quota = cb->stats[cls].stored < cb->stats[cls].reserved;
+        int victim = -1;
+
+        for (int i = CAPTURE_CLASS_COUNT - 1; i >= (within_quota ? 0 : (int)cls); i--) {
+            if (cb->stats[i].stored > cb->stats[i].reserved ||
+                (!within_quota && i == (int)cls)) {
+                victim = i;
+                break;
+            }
+        }
+
+        if (victim < 0) {
+            cb->stats[cls].dropped++;
+            return false;
+        }
+
+        *evicted = pop_class(cb, victim);
+        cb->stats[victim].evicted++;
+    }
+
+    capture_class_stats_t *stats = &cb->stats[cls];
+    int tail = (cb->head[cls] + stats->stored) % CAPTURE_BUFFER_CAPACITY;
+    cb->slots[cls][tail].item = item;
+    cb->slots[cls][tail].seq = cb->next_seq++;
+    stats->stored++;
+    stats->captured++;
+    cb->total++;
+    if (stats->stored > stats->peak) stats->peak = stats->stored;
+    if (cb->total > cb->peak) cb->peak = cb->total;
+    return true;
+}
+
+// Remove the oldest frame across all classes
+void *capture_buffer_pop(capture_buffer_t *cb) {
+    int oldest = -1;
+    uint32_t oldest_age = 0;
+
+    for (int i = 0; i < CAPTURE_CLASS_COUNT; i++) {
+        if (cb->stats[i].stored == 0) continue;
+
+        // Compare ages rather than raw sequence numbers so wraparound is harmless
+        uint32_t age = cb->next_seq - cb->slots[i][cb->head[i]].seq;
+        if (oldest < 0 || age > oldest_age) {
+            oldest = i;
+            oldest_age = age;
+        }
+    }
+
+    return oldest < 0 ? NULL : pop_class(cb, oldest);
+}
+
+// Restart the high-water marks from the current fill level
+void capture_buffer_reset_peaks(capture_buffer_t *cb) {
+    for (int i = 0; i < CAPTURE_CLASS_COUNT; i++) {
+        cb->stats[i].peak = cb->stats[i].stored;
+    }
+    cb->peak = cb->total;
+}
+
+// Get the name of a retention class
+const char *capture_buffer_class_name(capture_class_t cls) {
+    return cls < CAPTURE_CLASS_COUNT ? class_names[cls] : "unknown";
+}
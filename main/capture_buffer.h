@@ -0,0 +1,93 @@
+#ifndef CAPTURE_BUFFER_H
+#define CAPTURE_BUFFER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ieee80211.h"
+
+// Total number of frames held in capture memory
+#define CAPTURE_BUFFER_CAPACITY      32
+
+/**
+ * @brief Retention classes, highest priority first
+ */
+typedef enum {
+    CAPTURE_CLASS_HANDSHAKE = 0,   // EAPOL, authentication, (re)association
+    CAPTURE_CLASS_DEAUTH,          // Deauthentication, disassociation
+    CAPTURE_CLASS_PROBE,           // Probe requests/responses
+    CAPTURE_CLASS_BEACON,          // Beacons
+    CAPTURE_CLASS_OTHER,           // Data, control and remaining management frames
+    CAPTURE_CLASS_COUNT
+} capture_class_t;
+
+/**
+ * @brief Per-class counters
+ */
+typedef struct {
+    uint16_t stored;               // Frames currently held
+    uint16_t reserved;             // Slots reserved for this class
+    uint16_t peak;                 // Most frames held at once
+    uint32_t captured;             // Frames accepted into the buffer
+    uint32_t evicted;              // Frames pushed out by newer or higher priority frames
+    uint32_t dropped;              // Frames rejected because the buffer was full
+} capture_class_stats_t;
+
+/**
+ * @brief Class-aware capture buffer
+ *
+ * Each class has a reserved quota; the remaining slots are shared. When the
+ * buffer is full, frames are evicted from the lowest priority class that is
+ * using shared slots, oldest first. Frames are returned in arrival order.
+ */
+typedef struct {
+    struct {
+        void *item;
+        uint32_t seq;
+    } slots[CAPTURE_CLASS_COUNT][CAPTURE_BUFFER_CAPACITY];
+    uint8_t head[CAPTURE_CLASS_COUNT];
+    capture_class_stats_t stats[CAPTURE_CLASS_COUNT];
+    uint16_t total;
+    uint16_t peak;                 // Most frames held at once, all classes
+    uint32_t next_seq;
+} capture_buffer_t;
+
+/**
+ * @brief Initialize an empty capture buffer with the default class quotas
+ */
+void capture_buffer_init(capture_buffer_t *cb);
+
+/**
+ * @brief Classify a frame into a retention class
+ */
+capture_class_t capture_buffer_classify(const frame_info_t *info);
+
+/**
+ * @brief Add a frame to the buffer
+ *
+ * @param cb Capture buffer
+ * @param cls Retention class of the frame
+ * @param item Frame to store
+ * @param evicted Set to the frame that was evicted to make room, or NULL
+ * @return true if the frame was stored; false if it was rejected (the
+ *         caller keeps ownership of item)
+ */
+bool capture_buffer_push(capture_buffer_t *cb, capture_class_t cls, void *item, void **evicted);
+
+/**
+ * @brief Remove the oldest frame across all classes
+ *
+ * @return The frame, or NULL if the buffer is empty
+ */
+void *capture_buffer_pop(capture_buffer_t *cb);
+
+/**
+ * @brief Restart the high-water marks from the current fill level
+ */
+void capture_buffer_reset_peaks(capture_buffer_t *cb);
+
+/**
+ * @brief Get the name of a retention class
+ */
+const char *capture_buffer_class_name(capture_class_t cls);
+
+#endif /* CAPTURE_BUFFER_H */
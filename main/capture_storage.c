@@ -0,0 +1,342 @@
+#include "capture_storage.h"
+#include "pcap.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_vfs_fat.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+static const char *TAG = "capture_storage";
+
+// Writer task settings; below the sniffer and web server so flash I/O
+// only uses otherwise idle time
+#define WRITER_TASK_STACK       4096
+#define WRITER_TASK_PRIORITY    2
+#define WRITER_POLL_MS          500
+
+// Ring between the RX callback and the writer task
+static portMUX_TYPE ring_lock = portMUX_INITIALIZER_UNLOCKED;
+static pcap_ring_t ring;
+static uint8_t *ring_memory = NULL;
+
+// Segment writer, owned by the writer task while recording
+static SemaphoreHandle_t store_mutex = NULL;
+static pcap_store_t store;
+static bool store_open = false;
+
+// Compression scratch, allocated the first time compression is used
+typedef struct {
+    lz4_state_t state;
+    uint8_t block[LZ4_FRAME_BLOCK_BOUND(PCAP_STORE_BUFFER_SIZE)];
+} compress_scratch_t;
+static compress_scratch_t *compress_scratch = NULL;
+static uint64_t raw_bytes = 0;
+static uint64_t compressed_bytes = 0;
+static uint64_t compress_us = 0;
+
+static wl_handle_t wl_handle = WL_INVALID_HANDLE;
+static bool is_mounted = false;
+static volatile bool is_recording = false;
+static volatile bool stop_requested = false;
+static TaskHandle_t writer_task_handle = NULL;
+
+// Offset from esp_timer time to wall clock time, taken at start
+static int64_t wall_offset_us = 0;
+
+// Mount the FAT partition with wear levelling (once)
+static bool mount_storage(void) {
+    if (is_mounted) {
+        return true;
+    }
+
+    const esp_vfs_fat_mount_config_t mount_config = {
+        .format_if_mount_failed = true,
+        .max_files = 4,
+        .allocation_unit_size = CONFIG_WL_SECTOR_SIZE,
+    };
+    esp_err_t err = esp_vfs_fat_spiflash_mount_rw_wl(CAPTURE_STORAGE_BASE_PATH, CAPTURE_STORAGE_PARTITION,
+                                                      &mount_config, &wl_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to mount storage partition: %s", esp_err_to_name(err));
+        return false;
+    }
+
+    is_mounted = true;
+    ESP_LOGI(TAG, "Storage mounted at %s", CAPTURE_STORAGE_BASE_PATH);
+    return true;
+}
+
+// Mount the storage partition without recording
+bool capture_storage_mount(void) {
+    return mount_storage();
+}
+
+// Write every sealed buffer to the current segment
+static bool drain_ring(void) {
+    bool wrote = false;
+    const uint8_t *data;
+    size_t len;
+
+    for (;;) {
+        portENTER_CRITICAL(&ring_lock);
+        bool ready = pcap_ring_peek(&ring, &data, &len);
+        portEXIT_CRITICAL(&ring_lock);
+        if (!ready) {
+            break;
+        }
+
+        // The producer never touches sealed buffers, so write without the lock
+        xSemaphoreTake(store_mutex, portMAX_DELAY);
+        if (store.config.compress) {
+            uint64_t start = esp_timer_get_time();
+            size_t block_len = lz4_frame_block(&compress_scratch->state, data, len, compress_scratch->block);
+            compress_us += esp_timer_get_time() - start;
+            raw_bytes += len;
+            compressed_bytes += block_len;
+            data = compress_scratch->block;
+            len = block_len;
+        }
+        if (!pcap_store_write(&store, data, len, esp_timer_get_time())) {
+            ESP_LOGW(TAG, "Failed to write %u bytes to storage", (unsigned)len);
+        }
+        xSemaphoreGive(store_mutex);
+
+        portENTER_CRITICAL(&ring_lock);
+        pcap_ring_release(&ring);
+        portEXIT_CRITICAL(&ring_lock);
+        wrote = true;
+    }
+
+    return wrote;
+}
+
+// Writer task: drains full buffers, flushes stale partial ones, syncs when idle
+static void storage_writer_task(void *pvParameters) {
+    bool dirty = false;
+
+    ESP_LOGI(TAG, "Storage writer task started");
+
+    while (!stop_requested) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(WRITER_POLL_MS));
+
+        // Bound how long a frame can sit in RAM when traffic is light
+        uint64_t now = esp_timer_get_time();
+        portENTER_CRITICAL(&ring_lock);
+        pcap_ring_seal(&ring, now - (uint64_t)CAPTURE_STORAGE_FLUSH_MS * 1000);
+        portEXIT_CRITICAL(&ring_lock);
+
+        if (drain_ring()) {
+            dirty = true;
+        } else if (dirty) {
+            // Nothing new: commit the FAT and directory entry of the segment
+            xSemaphoreTake(store_mutex, portMAX_DELAY);
+            pcap_store_sync(&store);
+            xSemaphoreGive(store_mutex);
+            dirty = false;
+        }
+    }
+
+    // Write out whatever is still buffered
+    portENTER_CRITICAL(&ring_lock);
+    pcap_ring_seal(&ring, UINT64_MAX);
+    portEXIT_CRITICAL(&ring_lock);
+    drain_ring();
+
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    pcap_store_close(&store);
+    xSemaphoreGive(store_mutex);
+
+    ESP_LOGI(TAG, "Storage writer task stopped");
+    writer_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+// Mount the storage partition and start recording captured frames
+bool capture_storage_start(uint32_t max_segment_bytes, uint32_t max_segment_ms, uint16_t max_files, bool compress) {
+    if (is_recording) {
+        ESP_LOGW(TAG, "Recording already running, stopping first");
+        capture_storage_stop();
+    }
+
+    if (!mount_storage()) {
+        return false;
+    }
+
+    if (!store_mutex) {
+        store_mutex = xSemaphoreCreateMutex();
+        if (!store_mutex) {
+            ESP_LOGE(TAG, "Failed to create storage mutex");
+            return false;
+        }
+    }
+    if (!ring_memory) {
+        ring_memory = malloc(PCAP_STORE_BUFFERS * PCAP_STORE_BUFFER_SIZE);
+        if (!ring_memory) {
+            ESP_LOGE(TAG, "Failed to allocate write-behind buffers");
+            return false;
+        }
+    }
+    if (compress && !compress_scratch) {
+        compress_scratch = malloc(sizeof(compress_scratch_t));
+        if (!compress_scratch) {
+            ESP_LOGE(TAG, "Failed to allocate compression state");
+            return false;
+        }
+    }
+
+    pcap_store_config_t config = {
+        .dir = CAPTURE_STORAGE_BASE_PATH,
+        .prefix = CAPTURE_STORAGE_PREFIX,
+        .max_segment_bytes = max_segment_bytes ? max_segment_bytes : CAPTURE_STORAGE_SEGMENT_KB * 1024,
+        .max_segment_ms = max_segment_ms,
+        .max_files = max_files ? max_files : CAPTURE_STORAGE_MAX_FILES,
+        .compress = compress,
+    };
+
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    store_open = pcap_store_open(&store, &config);
+    raw_bytes = 0;
+    compressed_bytes = 0;
+    compress_us = 0;
+    xSemaphoreGive(store_mutex);
+    if (!store_open) {
+        ESP_LOGE(TAG, "Failed to open %s", CAPTURE_STORAGE_BASE_PATH);
+        return false;
+    }
+
+    portENTER_CRITICAL(&ring_lock);
+    pcap_ring_init(&ring, ring_memory);
+    portEXIT_CRITICAL(&ring_lock);
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    wall_offset_us = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec - esp_timer_get_time();
+
+    stop_requested = false;
+    if (xTaskCreate(storage_writer_task, "storage_writer", WRITER_TASK_STACK, NULL,
+                    WRITER_TASK_PRIORITY, &writer_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create storage writer task");
+        writer_task_handle = NULL;
+        return false;
+    }
+    is_recording = true;
+
+    ESP_LOGI(TAG, "Recording to %s/%s_%05lu.pcap%s (%lu KB segments, %u files)", config.dir, config.prefix,
+             (unsigned long)store.next_index, compress ? ".lz4" : "",
+             (unsigned long)(config.max_segment_bytes / 1024), config.max_files);
+    return true;
+}
+
+// Stop recording, writing out everything still buffered
+void capture_storage_stop(void) {
+    if (!is_recording) {
+        return;
+    }
+
+    is_recording = false;
+    stop_requested = true;
+    if (writer_task_handle) {
+        xTaskNotifyGive(writer_task_handle);
+    }
+
+    // Wait for the writer to drain the ring and close the segment
+    for (int i = 0; i < 100 && writer_task_handle; i++) {
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    if (writer_task_handle) {
+        ESP_LOGW(TAG, "Storage writer did not stop in time");
+    }
+    ESP_LOGI(TAG, "Recording stopped: %lu frames, %lu dropped", (unsigned long)ring.frames,
+             (unsigned long)ring.dropped_frames);
+}
+
+// Queue a captured frame for writing
+void capture_storage_push(const uint8_t *frame, uint16_t caplen, uint16_t len, int8_t rssi, uint8_t channel,
+                          uint8_t rate, uint64_t timestamp_us) {
+    if (!is_recording) {
+        return;
+    }
+
+    if (caplen > PCAP_SNAPLEN) {
+        caplen = PCAP_SNAPLEN;
+    }
+    uint8_t prefix[PCAP_RECORD_PREFIX_LEN];
+    pcap_record_prefix(prefix, timestamp_us + wall_offset_us, caplen, len, rssi, channel, rate);
+
+    portENTER_CRITICAL(&ring_lock);
+    pcap_ring_result_t result = pcap_ring_append(&ring, prefix, sizeof(prefix), frame, caplen, timestamp_us);
+    portEXIT_CRITICAL(&ring_lock);
+
+    if (result == PCAP_RING_SEALED && writer_task_handle) {
+        xTaskNotifyGive(writer_task_handle);
+    }
+}
+
+// Get the recording state and counters
+void capture_storage_get_status(capture_storage_status_t *status) {
+    memset(status, 0, sizeof(*status));
+    status->mounted = is_mounted;
+    status->running = is_recording;
+
+    portENTER_CRITICAL(&ring_lock);
+    status->frames = ring.frames;
+    status->dropped_frames = ring.dropped_frames;
+    status->dropped_bytes = ring.dropped_bytes;
+    status->buffers_pending = ring.full;
+    portEXIT_CRITICAL(&ring_lock);
+
+    if (store_open) {
+        xSemaphoreTake(store_mutex, portMAX_DELAY);
+        status->config = store.config;
+        status->segments = store.segments;
+        status->removed = store.removed;
+        status->bytes = store.bytes;
+        status->raw_bytes = raw_bytes;
+        status->compressed_bytes = compressed_bytes;
+        status->compress_us = compress_us;
+        status->write_errors = store.write_errors;
+        xSemaphoreGive(store_mutex);
+    }
+
+    if (is_mounted) {
+        esp_vfs_fat_info(CAPTURE_STORAGE_BASE_PATH, &status->total_bytes, &status->free_bytes);
+    }
+}
+
+// List the stored segments, oldest first
+int capture_storage_list(pcap_segment_t *segments, int max_segments) {
+    if (!store_open) {
+        return 0;
+    }
+
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    int count = pcap_store_list(&store, segments, max_segments);
+    xSemaphoreGive(store_mutex);
+    return count;
+}
+
+// Open a stored segment for reading
+FILE *capture_storage_open_segment(const char *name, bool *compressed) {
+    char path[PCAP_STORE_MAX_PATH];
+    FILE *file = NULL;
+
+    if (!store_open) {
+        return NULL;
+    }
+
+    xSemaphoreTake(store_mutex, portMAX_DELAY);
+    uint32_t index;
+    bool valid = pcap_store_path(&store, name, path, sizeof(path), &index);
+    bool active = store.file && index == store.next_index - 1;
+    if (valid && !active) {
+        file = fopen(path, "rb");
+        *compressed = strstr(path, ".lz4") != NULL;
+    }
+    xSemaphoreGive(store_mutex);
+
+    return file;
+}
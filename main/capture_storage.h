@@ -0,0 +1,104 @@
+#ifndef CAPTURE_STORAGE_H
+#define CAPTURE_STORAGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "pcap_store.h"
+#include "lz4_frame.h"
+
+// FAT partition (label in partitions.csv) and where it is mounted
+#define CAPTURE_STORAGE_PARTITION    "storage"
+#define CAPTURE_STORAGE_BASE_PATH    "/storage"
+#define CAPTURE_STORAGE_PREFIX       "cap"
+// Defaults for segment rotation and retention
+#define CAPTURE_STORAGE_SEGMENT_KB   256
+#define CAPTURE_STORAGE_SEGMENT_S    300
+#define CAPTURE_STORAGE_MAX_FILES    6
+// A partially filled buffer is written out once its oldest record is this old
+#define CAPTURE_STORAGE_FLUSH_MS     2000
+
+/**
+ * @brief Recording state and counters
+ */
+typedef struct {
+    bool mounted;
+    bool running;
+    pcap_store_config_t config;
+    uint32_t frames;             // Records queued for writing
+    uint32_t dropped_frames;     // Records lost because the writer fell behind
+    uint64_t dropped_bytes;
+    uint8_t buffers_pending;     // Sealed buffers waiting for the writer
+    uint32_t segments;
+    uint32_t removed;
+    uint64_t bytes;              // Bytes written to flash
+    uint64_t raw_bytes;          // Bytes handed to the compressor
+    uint64_t compressed_bytes;   // What they compressed to, block headers included
+    uint64_t compress_us;        // CPU time spent compressing
+    uint32_t write_errors;
+    uint64_t total_bytes;        // Filesystem size and free space
+    uint64_t free_bytes;
+} capture_storage_status_t;
+
+/**
+ * @brief Mount the storage partition (once) without recording
+ *
+ * @return true if the partition is mounted
+ */
+bool capture_storage_mount(void);
+
+/**
+ * @brief Mount the storage partition and start recording captured frames
+ *
+ * Frames are buffered in RAM and written to rotating pcap segments by a
+ * low-priority task, so the RX path never waits for flash.
+ *
+ * @param max_segment_bytes Rotate once a segment reaches this size (0 = default)
+ * @param max_segment_ms Rotate once a segment is this old (0 = no time limit)
+ * @param max_files Segments kept before the oldest is deleted (0 = default)
+ * @param compress Write LZ4-compressed segments (.pcap.lz4)
+ * @return true if recording started
+ */
+bool capture_storage_start(uint32_t max_segment_bytes, uint32_t max_segment_ms, uint16_t max_files, bool compress);
+
+/**
+ * @brief Stop recording, writing out everything still buffered
+ */
+void capture_storage_stop(void);
+
+/**
+ * @brief Queue a captured frame for writing (called from the RX callback)
+ *
+ * @param frame 802.11 frame without the FCS
+ * @param caplen Bytes to record, as the overload governor allows
+ * @param len Frame length on air
+ * @param rssi Signal strength
+ * @param channel Channel the frame was received on
+ * @param rate Legacy rate in 500 kbps units, 0 if unknown
+ * @param timestamp_us esp_timer time of reception
+ */
+void capture_storage_push(const uint8_t *frame, uint16_t caplen, uint16_t len, int8_t rssi, uint8_t channel,
+                          uint8_t rate, uint64_t timestamp_us);
+
+/**
+ * @brief Get the recording state and counters
+ */
+void capture_storage_get_status(capture_storage_status_t *status);
+
+/**
+ * @brief List the stored segments, oldest first
+ *
+ * @return Number of segments written to segments
+ */
+int capture_storage_list(pcap_segment_t *segments, int max_segments);
+
+/**
+ * @brief Open a stored segment for reading
+ *
+ * @param name Segment name as returned by capture_storage_list()
+ * @param compressed Set if the segment is an LZ4 frame
+ * @return The open file, or NULL if the name is invalid or the segment is being written
+ */
+FILE *capture_storage_open_segment(const char *name, bool *compressed);
+
+#endif /* CAPTURE_STORAGE_H */
@@ -0,0 +1,54 @@
+#include "export_batch.h"
+#include "pcap.h"
+#include <string.h>
+
+static void put_le16(uint8_t *p, uint16_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+// Empty a batch
+void export_batch_reset(export_batch_t *batch) {
+    batch->len = EXPORT_BATCH_HEADER_LEN;
+    batch->count = 0;
+    batch->opened_us = 0;
+}
+
+// Append one frame as a pcap record
+bool export_batch_add(export_batch_t *batch, const uint8_t *frame, uint16_t len, uint16_t orig_len,
+                      int8_t rssi, uint8_t channel, uint8_t rate, uint64_t timestamp_us) {
+    const size_t max_frame = EXPORT_BATCH_MAX_LEN - EXPORT_BATCH_HEADER_LEN - PCAP_RECORD_PREFIX_LEN;
+    if (len > max_frame) {
+        len = max_frame;
+    }
+    if (batch->len + PCAP_RECORD_PREFIX_LEN + len > EXPORT_BATCH_MAX_LEN) {
+        return false;
+    }
+
+    if (batch->count == 0) {
+        batch->opened_us = timestamp_us;
+    }
+    batch->len += pcap_record_prefix(batch->data + batch->len, timestamp_us, len, orig_len, rssi, channel, rate);
+    memcpy(batch->data + batch->len, frame, len);
+    batch->len += len;
+    batch->count++;
+    return true;
+}
+
+// Write the batch header
+size_t export_batch_finish(export_batch_t *batch, uint32_t seq, uint32_t dropped) {
+    put_le32(batch->data, EXPORT_BATCH_MAGIC);
+    batch->data[4] = EXPORT_BATCH_VERSION;
+    batch->data[5] = 0;
+    put_le16(batch->data + 6, batch->count);
+    put_le32(batch->data + 8, seq);
+    put_le32(batch->data + 12, dropped);
+    return batch->len;
+}
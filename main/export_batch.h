@@ -0,0 +1,62 @@
+#ifndef EXPORT_BATCH_H
+#define EXPORT_BATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Largest datagram: 1500 byte MTU minus IPv4 and UDP headers
+#define EXPORT_BATCH_MAX_LEN         1472
+#define EXPORT_BATCH_HEADER_LEN      16
+#define EXPORT_BATCH_MAGIC           0x4B43344A    // "J4CK"
+#define EXPORT_BATCH_VERSION         1
+
+/**
+ * @brief One datagram of pcap records
+ *
+ * Layout (little endian): magic u32, version u8, flags u8, record count
+ * u16, batch sequence u32, frames dropped on the device so far u32, then
+ * the records exactly as in a pcap file (record header, radiotap, frame).
+ * A collector appends the records to a file after a pcap_global_header()
+ * and uses the sequence numbers to count lost datagrams.
+ */
+typedef struct {
+    uint8_t data[EXPORT_BATCH_MAX_LEN];
+    size_t len;
+    uint16_t count;
+    uint64_t opened_us;          // Time of the first record
+} export_batch_t;
+
+/**
+ * @brief Empty a batch
+ */
+void export_batch_reset(export_batch_t *batch);
+
+/**
+ * @brief Append one frame as a pcap record
+ *
+ * Frames too large for an empty batch are truncated to fit.
+ *
+ * @param batch Batch
+ * @param frame Frame without the FCS
+ * @param len Bytes available in frame
+ * @param orig_len Frame length on air
+ * @param rssi Signal strength
+ * @param channel Channel
+ * @param rate Legacy rate in 500 kbps units, 0 if unknown
+ * @param timestamp_us Wall clock time of reception
+ * @return false if the record does not fit (the batch is unchanged)
+ */
+bool export_batch_add(export_batch_t *batch, const uint8_t *frame, uint16_t len, uint16_t orig_len,
+                      int8_t rssi, uint8_t channel, uint8_t rate, uint64_t timestamp_us);
+
+/**
+ * @brief Write the batch header
+ *
+ * @param seq Batch sequence number
+ * @param dropped Frames dropped on the device so far
+ * @return Datagram length
+ */
+size_t export_batch_finish(export_batch_t *batch, uint32_t seq, uint32_t dropped);
+
+#endif /* EXPORT_BATCH_H */
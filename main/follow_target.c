@@ -0,0 +1,184 @@
+#include "follow_target.h"
+#include <string.h>
+
+static const char *state_names[] = {
+    [FOLLOW_IDLE]      = "idle",
+    [FOLLOW_LOCKED]    = "locked",
+    [FOLLOW_SEARCHING] = "searching",
+};
+
+// Append a channel to the sweep unless it is already in it
+static void add_candidate(follow_target_t *ft, uint8_t channel) {
+    if (channel == 0) return;
+    for (int i = 0; i < ft->candidate_count; i++) {
+        if (ft->candidates[i] == channel) return;
+    }
+    ft->candidates[ft->candidate_count++] = channel;
+}
+
+// Start sweeping, the announced channel first; the channel the target
+// went quiet on was just watched and comes in its normal order
+static void start_search(follow_target_t *ft, uint64_t now_us) {
+    ft->candidate_count = 0;
+    if (ft->csa_pending) {
+        add_candidate(ft, ft->csa_channel);
+    }
+    for (int i = 0; i < ft->plan_count; i++) {
+        add_candidate(ft, ft->plan[i]);
+    }
+    if (ft->candidate_count == 0) {
+        add_candidate(ft, ft->channel);
+    }
+
+    ft->csa_pending = false;
+    ft->state = FOLLOW_SEARCHING;
+    ft->lost_us = now_us;
+    ft->candidate_index = 0;
+    ft->channel = ft->candidates[0];
+    ft->dwell_end_us = now_us + FOLLOW_SEARCH_DWELL_MS * 1000;
+}
+
+static uint64_t lost_timeout_us(const follow_target_t *ft) {
+    uint64_t timeout = ft->interval_us * FOLLOW_LOST_BEACONS;
+    return timeout > FOLLOW_MIN_LOST_MS * 1000 ? timeout : FOLLOW_MIN_LOST_MS * 1000;
+}
+
+// Start following a BSS
+void follow_target_init(follow_target_t *ft, const uint8_t *bssid, uint8_t channel,
+                        const uint8_t *plan, uint8_t plan_count, uint64_t now_us) {
+    memset(ft, 0, sizeof(*ft));
+    memcpy(ft->bssid, bssid, 6);
+    ft->interval_us = FOLLOW_DEFAULT_INTERVAL_US;
+    ft->last_poll_us = now_us;
+    ft->plan_count = plan_count < FOLLOW_MAX_CANDIDATES ? plan_count : FOLLOW_MAX_CANDIDATES;
+    memcpy(ft->plan, plan, ft->plan_count);
+
+    if (channel) {
+        ft->state = FOLLOW_LOCKED;
+        ft->channel = channel;
+        ft->last_heard_us = now_us;
+    } else {
+        start_search(ft, now_us);
+    }
+}
+
+// Account one received frame
+bool follow_target_observe(follow_target_t *ft, const frame_info_t *info) {
+    if (ft->state == FOLLOW_IDLE) {
+        return false;
+    }
+
+    if (!ieee80211_is_beacon_like(info)) {
+        // Traffic of the BSS leaks onto neighbouring channels, so it only
+        // confirms the lock and never moves it
+        if (!info->bssid || memcmp(info->bssid, ft->bssid, 6) != 0) {
+            return false;
+        }
+        if (ft->state == FOLLOW_LOCKED && info->channel == ft->channel) {
+            ft->last_heard_us = info->timestamp_us;
+        }
+        return true;
+    }
+    if (!info->addr3 || memcmp(info->addr3, ft->bssid, 6) != 0 ||
+        info->body_len < IEEE80211_BEACON_FIXED_LEN) {
+        return false;
+    }
+
+    const uint8_t *ies = info->body + IEEE80211_BEACON_FIXED_LEN;
+    uint16_t ies_len = info->body_len - IEEE80211_BEACON_FIXED_LEN;
+    uint64_t now_us = info->timestamp_us;
+    ft->beacons++;
+
+    uint16_t interval_tu = info->body[8] | (info->body[9] << 8);
+    if (interval_tu) {
+        ft->interval_us = (uint64_t)interval_tu * 1024;
+    }
+
+    // The channel the BSS operates on: DS element on 2.4 GHz, HT operation
+    // on 5 GHz, else where it was heard
+    uint8_t channel = info->channel;
+    uint8_t len = 0;
+    const uint8_t *ie = ieee80211_find_ie(ies, ies_len, IEEE80211_IE_DS_PARAMS, &len);
+    if (ie && len >= 1 && ie[0]) {
+        channel = ie[0];
+    } else if ((ie = ieee80211_find_ie(ies, ies_len, IEEE80211_IE_HT_OPERATION, &len)) && len >= 1 && ie[0]) {
+        channel = ie[0];
+    }
+
+    if (ft->state == FOLLOW_SEARCHING) {
+        uint64_t took = now_us > ft->lost_us ? now_us - ft->lost_us : 0;
+        ft->reacquisitions++;
+        ft->reacquire_total_us += took;
+        if (took > ft->reacquire_max_us) {
+            ft->reacquire_max_us = took;
+        }
+        ft->state = FOLLOW_LOCKED;
+        ft->channel = channel;
+        ft->csa_pending = false;
+    } else if (channel != ft->channel) {
+        ft->moves++;
+        ft->channel = channel;
+        ft->csa_pending = false;
+    }
+    ft->last_heard_us = now_us;
+
+    // Channel switch announcement: the switch happens after count beacon intervals
+    uint8_t new_channel = 0, count = 0;
+    if ((ie = ieee80211_find_ie(ies, ies_len, IEEE80211_IE_CSA, &len)) && len >= 3) {
+        new_channel = ie[1];
+        count = ie[2];
+    } else if ((ie = ieee80211_find_ie(ies, ies_len, IEEE80211_IE_EXT_CSA, &len)) && len >= 4) {
+        new_channel = ie[2];
+        count = ie[3];
+    }
+    if (new_channel && new_channel != ft->channel) {
+        if (!ft->csa_pending || ft->csa_channel != new_channel) {
+            ft->announcements++;
+        }
+        ft->csa_pending = true;
+        ft->csa_channel = new_channel;
+        ft->csa_deadline_us = now_us + count * ft->interval_us;
+    }
+    return true;
+}
+
+// Advance timers
+uint8_t follow_target_poll(follow_target_t *ft, uint64_t now_us) {
+    uint64_t elapsed = now_us > ft->last_poll_us ? now_us - ft->last_poll_us : 0;
+    ft->last_poll_us = now_us;
+
+    switch (ft->state) {
+        case FOLLOW_LOCKED:
+            ft->locked_us += elapsed;
+            if (ft->csa_pending && now_us >= ft->csa_deadline_us) {
+                // Give the target a full lost timeout on its new channel
+                ft->channel = ft->csa_channel;
+                ft->csa_pending = false;
+                ft->csa_switches++;
+                ft->last_heard_us = now_us;
+            } else if (now_us > ft->last_heard_us && now_us - ft->last_heard_us > lost_timeout_us(ft)) {
+                ft->losses++;
+                start_search(ft, now_us);
+            }
+            break;
+        case FOLLOW_SEARCHING:
+            ft->searching_us += elapsed;
+            if (now_us >= ft->dwell_end_us) {
+                if (++ft->candidate_index >= ft->candidate_count) {
+                    ft->candidate_index = 0;
+                    ft->sweeps++;
+                }
+                ft->channel = ft->candidates[ft->candidate_index];
+                ft->dwell_end_us = now_us + FOLLOW_SEARCH_DWELL_MS * 1000;
+            }
+            break;
+        default:
+            break;
+    }
+    return ft->channel;
+}
+
+// Get the name of a state
+const char *follow_target_state_name(follow_state_t state) {
+    return state <= FOLLOW_SEARCHING ? state_names[state] : "unknown";
+}
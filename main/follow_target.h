@@ -0,0 +1,103 @@
+#ifndef FOLLOW_TARGET_H
+#define FOLLOW_TARGET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ieee80211.h"
+
+// The target is lost after this many beacon intervals without a beacon
+#define FOLLOW_LOST_BEACONS          8
+#define FOLLOW_MIN_LOST_MS           500
+// Dwell per channel while searching: one beacon interval plus margin
+#define FOLLOW_SEARCH_DWELL_MS       150
+// Beacon interval assumed until the target's own is known (100 TU)
+#define FOLLOW_DEFAULT_INTERVAL_US   102400
+#define FOLLOW_MAX_CANDIDATES        48
+
+typedef enum {
+    FOLLOW_IDLE = 0,
+    FOLLOW_LOCKED,               // Dwelling on the target's channel
+    FOLLOW_SEARCHING,            // Target lost, sweeping the candidate channels
+} follow_state_t;
+
+/**
+ * @brief State of a follow-target session
+ *
+ * Locks onto the channel a BSS beacons on. A channel switch announcement
+ * moves the lock when the countdown expires; if the beacons stop without
+ * one, the candidate channels are swept until the BSS is heard again,
+ * starting with the announced and the last known channel.
+ */
+typedef struct {
+    uint8_t bssid[6];
+    follow_state_t state;
+    uint8_t channel;             // Channel the radio should be on
+    uint64_t interval_us;        // Target's beacon interval
+    uint64_t last_heard_us;
+    uint64_t last_poll_us;
+
+    // Pending channel switch announcement
+    bool csa_pending;
+    uint8_t csa_channel;
+    uint64_t csa_deadline_us;
+
+    // Search
+    uint8_t plan[FOLLOW_MAX_CANDIDATES];     // Channels to sweep, in order
+    uint8_t plan_count;
+    uint8_t candidates[FOLLOW_MAX_CANDIDATES + 1];  // Announced channel, then the plan
+    uint8_t candidate_count;
+    uint8_t candidate_index;
+    uint64_t dwell_end_us;
+    uint64_t lost_us;            // When the current search started
+
+    // Counters
+    uint32_t beacons;            // Beacons and probe responses of the target
+    uint32_t announcements;      // Channel switch announcements heard
+    uint32_t csa_switches;       // Moves made on an announcement
+    uint32_t moves;              // Target heard on another channel while locked
+    uint32_t losses;
+    uint32_t reacquisitions;
+    uint32_t sweeps;             // Full passes over the candidates without a hit
+    uint64_t reacquire_total_us;
+    uint64_t reacquire_max_us;
+    uint64_t locked_us;          // Time spent on the target's channel
+    uint64_t searching_us;
+} follow_target_t;
+
+/**
+ * @brief Start following a BSS
+ *
+ * @param ft Session state
+ * @param bssid Target BSS
+ * @param channel Channel the target is believed to be on, 0 to search right away
+ * @param plan Channels to sweep when the target is lost
+ * @param plan_count Number of channels in plan (at most FOLLOW_MAX_CANDIDATES)
+ * @param now_us Current time
+ */
+void follow_target_init(follow_target_t *ft, const uint8_t *bssid, uint8_t channel,
+                        const uint8_t *plan, uint8_t plan_count, uint64_t now_us);
+
+/**
+ * @brief Account one received frame
+ *
+ * Beacons and probe responses of the target lock the channel they announce
+ * and carry channel switch announcements; other frames of the BSS only
+ * count as signs of life when heard on the locked channel.
+ *
+ * @return true if the frame belonged to the target
+ */
+bool follow_target_observe(follow_target_t *ft, const frame_info_t *info);
+
+/**
+ * @brief Advance timers
+ *
+ * @return Channel the radio should be on now
+ */
+uint8_t follow_target_poll(follow_target_t *ft, uint64_t now_us);
+
+/**
+ * @brief Get the name of a state
+ */
+const char *follow_target_state_name(follow_state_t state);
+
+#endif /* FOLLOW_TARGET_H */
@@ -0,0 +1,49 @@
+#include "frame_format.h"
+#include <stdio.h>
+
+// Format a MAC address as xx:xx:xx:xx:xx:xx
+void format_mac_addr(char *dest, const uint8_t *addr) {
+    snprintf(dest, 18, "%02x:%02x:%02x:%02x:%02x:%02x",
+             addr[0], addr[1], addr[2],
+             addr[3], addr[4], addr[5]);
+}
+
+// Get the name of a frame type/subtype from its frame control field
+const char *get_frame_type_str(uint16_t frame_ctrl) {
+    uint8_t type = (frame_ctrl & 0x000C) >> 2;
+    uint8_t subtype = (frame_ctrl & 0x00F0) >> 4;
+    
+    switch (type) {
+        case 0: // Management
+            switch (subtype) {
+                case 0: return "ASSOC_REQ";
+                case 1: return "ASSOC_RES";
+                case 2: return "REASSOC_REQ";
+                case 3: return "REASSOC_RES";
+                case 4: return "PROBE_REQ";
+                case 5: return "PROBE_RES";
+                case 8: return "BEACON";
+                case 9: return "ATIM";
+                case 10: return "DISASSOC";
+                case 11: return "AUTH";
+                case 12: return "DEAUTH";
+                case 13: return "ACTION";
+                default: return "MGMT";
+            }
+        case 1: // Control
+            switch (subtype) {
+                case 8: return "BLOCK_ACK_REQ";
+                case 9: return "BLOCK_ACK";
+                case 10: return "PS_POLL";
+                case 11: return "RTS";
+                case 12: return "CTS";
+                case 13: return "ACK";
+                case 14: return "CF_END";
+                default: return "CTRL";
+            }
+        case 2: // Data
+            return "DATA";
+        default:
+            return "UNKNOWN";
+    }
+}
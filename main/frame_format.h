@@ -0,0 +1,19 @@
+#ifndef FRAME_FORMAT_H
+#define FRAME_FORMAT_H
+
+#include <stdint.h>
+
+/**
+ * @brief Format a MAC address as xx:xx:xx:xx:xx:xx
+ *
+ * @param dest Buffer of at least 18 bytes
+ * @param addr Address
+ */
+void format_mac_addr(char *dest, const uint8_t *addr);
+
+/**
+ * @brief Get the name of a frame type/subtype from its frame control field
+ */
+const char *get_frame_type_str(uint16_t frame_ctrl);
+
+#endif /* FRAME_FORMAT_H */
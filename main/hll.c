@@ -0,0 +1,189 @@
+#include "hll.h"
+#include <math.h>
+#include <string.h>
+
+// Clear a sketch
+void hll_clear(hll_t *hll) {
+    memset(hll->registers, 0, sizeof(hll->registers));
+}
+
+// Add an item to a sketch
+void hll_add(hll_t *hll, const uint8_t *data, uint8_t len) {
+    uint32_t hash = mac_table_hash(data, len);
+
+    // Top bits select the register, the rest give the rank
+    uint32_t index = hash >> (32 - HLL_PRECISION);
+    uint32_t rest = hash << HLL_PRECISION;
+    uint8_t rank = rest ? (uint8_t)(__builtin_clz(rest) + 1) : (32 - HLL_PRECISION + 1);
+
+    if (rank > hll->registers[index]) {
+        hll->registers[index] = rank;
+    }
+}
+
+// Merge src into dst
+void hll_merge(hll_t *dst, const hll_t *src) {
+    for (int i = 0; i < HLL_REGISTERS; i++) {
+        if (src->registers[i] > dst->registers[i]) {
+            dst->registers[i] = src->registers[i];
+        }
+    }
+}
+
+// Estimate the number of distinct items added to a sketch
+uint32_t hll_estimate(const hll_t *hll) {
+    const double m = HLL_REGISTERS;
+    const double alpha = 0.7213 / (1.0 + 1.079 / m);
+
+    double sum = 0;
+    int zeros = 0;
+    for (int i = 0; i < HLL_REGISTERS; i++) {
+        sum += ldexp(1.0, -hll->registers[i]);
+        if (hll->registers[i] == 0) zeros++;
+    }
+
+    double estimate = alpha * m * m / sum;
+
+    // Small range correction: linear counting while registers are still empty
+    if (estimate <= 2.5 * m && zeros > 0) {
+        estimate = m * log(m / zeros);
+    }
+
+    return (uint32_t)(estimate + 0.5);
+}
+
+// Get the union of the current and previous window of a key
+void hll_pair_union(const hll_pair_t *pair, hll_t *out) {
+    *out = pair->window[0];
+    hll_merge(out, &pair->window[1]);
+}
+
+// Start a new window: the previous window is dropped, the current becomes previous
+static void rotate_window(hll_stats_t *stats) {
+    stats->current ^= 1;
+    for (int i = 0; i < HLL_MAX_CHANNELS; i++) {
+        hll_clear(&stats->channel_sketches[i].window[stats->current]);
+    }
+    for (int i = 0; i < HLL_MAX_BSSIDS; i++) {
+        hll_clear(&stats->bssid_sketches[i].window[stats->current]);
+    }
+}
+
+// Find or allocate the slot of a channel (-1 once all slots are taken)
+static int channel_slot(hll_stats_t *stats, uint8_t channel) {
+    for (int i = 0; i < HLL_MAX_CHANNELS; i++) {
+        if (stats->channels[i] == channel) return i;
+    }
+    for (int i = 0; i < HLL_MAX_CHANNELS; i++) {
+        if (stats->channels[i] == 0) {
+            stats->channels[i] = channel;
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Reset the per-channel and per-BSSID counters
+void hll_stats_init(hll_stats_t *stats) {
+    memset(stats->channels, 0, sizeof(stats->channels));
+    memset(stats->channel_sketches, 0, sizeof(stats->channel_sketches));
+    memset(stats->bssid_sketches, 0, sizeof(stats->bssid_sketches));
+    mac_table_init(&stats->bssid_table, stats->bssid_nodes, stats->bssid_buckets,
+                   HLL_MAX_BSSIDS, HLL_BSSID_HASH_BUCKETS, 6);
+    stats->current = 0;
+    stats->window_start_us = 0;
+}
+
+// Account the devices seen in one frame
+void hll_stats_update(hll_stats_t *stats, const frame_info_t *info) {
+    if (!info->addr2 || info->channel == 0) {
+        return;
+    }
+
+    // Advance the window (dropping both if we were idle for two windows)
+    uint64_t window_us = (uint64_t)HLL_WINDOW_S * 1000000;
+    if (stats->window_start_us == 0) {
+        stats->window_start_us = info->timestamp_us;
+    } else if (info->timestamp_us - stats->window_start_us >= window_us) {
+        uint64_t elapsed = (info->timestamp_us - stats->window_start_us) / window_us;
+        rotate_window(stats);
+        if (elapsed > 1) {
+            rotate_window(stats);
+        }
+        stats->window_start_us += elapsed * window_us;
+    }
+
+    // Every transmitter counts towards its channel
+    int slot = channel_slot(stats, info->channel);
+    if (slot >= 0) {
+        hll_add(&stats->channel_sketches[slot].window[stats->current], info->addr2, 6);
+    }
+
+    // Stations count towards the BSS they talk to
+    const uint8_t *station = ieee80211_station_addr(info);
+    if (station && !ieee80211_is_group_addr(info->bssid)) {
+        bool is_new;
+        slot = mac_table_touch(&stats->bssid_table, info->bssid, &is_new);
+        if (is_new) {
+            memset(&stats->bssid_sketches[slot], 0, sizeof(hll_pair_t));
+        }
+        hll_add(&stats->bssid_sketches[slot].window[stats->current], station, 6);
+    }
+}
+
+// Merge all counters of src into dst
+void hll_stats_merge(hll_stats_t *dst, const hll_stats_t *src) {
+    hll_t merged;
+
+    for (int i = 0; i < HLL_MAX_CHANNELS; i++) {
+        if (src->channels[i] == 0) continue;
+        int slot = channel_slot(dst, src->channels[i]);
+        if (slot < 0) continue;
+
+        hll_pair_union(&src->channel_sketches[i], &merged);
+        hll_merge(&dst->channel_sketches[slot].window[dst->current], &merged);
+    }
+
+    for (uint16_t i = src->bssid_table.lru_tail; i != MAC_TABLE_NONE; i = src->bssid_nodes[i].lru_prev) {
+        bool is_new;
+        int slot = mac_table_touch(&dst->bssid_table, mac_table_key(&src->bssid_table, i), &is_new);
+        if (is_new) {
+            memset(&dst->bssid_sketches[slot], 0, sizeof(hll_pair_t));
+        }
+
+        hll_pair_union(&src->bssid_sketches[i], &merged);
+        hll_merge(&dst->bssid_sketches[slot].window[dst->current], &merged);
+    }
+}
+
+// Estimate distinct devices for every tracked key
+void hll_stats_counts(const hll_stats_t *stats, hll_counts_t *counts) {
+    hll_t merged, total;
+    hll_clear(&total);
+
+    // Walk the storage arrays directly so this also works on a plain copy
+    counts->channel_count = 0;
+    for (int i = 0; i < HLL_MAX_CHANNELS; i++) {
+        if (stats->channels[i] == 0) continue;
+
+        hll_pair_union(&stats->channel_sketches[i], &merged);
+        hll_merge(&total, &merged);
+
+        counts->channels[counts->channel_count].channel = stats->channels[i];
+        counts->channels[counts->channel_count].devices = hll_estimate(&merged);
+        counts->channel_count++;
+    }
+
+    counts->bssid_count = 0;
+    for (int i = 0; i < HLL_MAX_BSSIDS; i++) {
+        if (!stats->bssid_nodes[i].in_use) continue;
+
+        hll_pair_union(&stats->bssid_sketches[i], &merged);
+
+        memcpy(counts->bssids[counts->bssid_count].bssid, stats->bssid_nodes[i].key, 6);
+        counts->bssids[counts->bssid_count].devices = hll_estimate(&merged);
+        counts->bssid_count++;
+    }
+
+    counts->total_devices = hll_estimate(&total);
+}
@@ -0,0 +1,116 @@
+#ifndef HLL_H
+#define HLL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ieee80211.h"
+#include "mac_table.h"
+
+// 2^HLL_PRECISION registers of one byte each; standard error is 1.04/sqrt(2^p) (6.5% at p=8)
+#define HLL_PRECISION                8
+#define HLL_REGISTERS                (1 << HLL_PRECISION)
+
+// Tracked keys; each keeps a current and a previous window sketch
+#define HLL_MAX_CHANNELS             16
+#define HLL_MAX_BSSIDS               16
+#define HLL_BSSID_HASH_BUCKETS       16
+#define HLL_WINDOW_S                 60
+
+/**
+ * @brief HyperLogLog sketch
+ */
+typedef struct {
+    uint8_t registers[HLL_REGISTERS];
+} hll_t;
+
+/**
+ * @brief Sketches of one key over the current and previous window
+ */
+typedef struct {
+    hll_t window[2];
+} hll_pair_t;
+
+/**
+ * @brief Distinct-device counters per channel and per BSSID
+ *
+ * Counts cover the current window plus the previous one, so a query always
+ * reflects between one and two window lengths of traffic.
+ */
+typedef struct {
+    uint8_t channels[HLL_MAX_CHANNELS];   // Channel number per slot, 0 if free
+    hll_pair_t channel_sketches[HLL_MAX_CHANNELS];
+
+    mac_table_t bssid_table;
+    mac_table_node_t bssid_nodes[HLL_MAX_BSSIDS];
+    uint16_t bssid_buckets[HLL_BSSID_HASH_BUCKETS];
+    hll_pair_t bssid_sketches[HLL_MAX_BSSIDS];
+
+    uint8_t current;                      // Index of the current window
+    uint64_t window_start_us;
+} hll_stats_t;
+
+/**
+ * @brief Distinct-device estimates for all tracked keys
+ */
+typedef struct {
+    struct {
+        uint8_t channel;
+        uint32_t devices;
+    } channels[HLL_MAX_CHANNELS];
+    struct {
+        uint8_t bssid[6];
+        uint32_t devices;
+    } bssids[HLL_MAX_BSSIDS];
+    int channel_count;
+    int bssid_count;
+    uint32_t total_devices;      // Union over all channels
+} hll_counts_t;
+
+/**
+ * @brief Clear a sketch
+ */
+void hll_clear(hll_t *hll);
+
+/**
+ * @brief Add an item to a sketch
+ */
+void hll_add(hll_t *hll, const uint8_t *data, uint8_t len);
+
+/**
+ * @brief Merge src into dst (union of the counted sets)
+ */
+void hll_merge(hll_t *dst, const hll_t *src);
+
+/**
+ * @brief Estimate the number of distinct items added to a sketch
+ */
+uint32_t hll_estimate(const hll_t *hll);
+
+/**
+ * @brief Reset the per-channel and per-BSSID counters
+ */
+void hll_stats_init(hll_stats_t *stats);
+
+/**
+ * @brief Account the devices seen in one frame
+ */
+void hll_stats_update(hll_stats_t *stats, const frame_info_t *info);
+
+/**
+ * @brief Merge all counters of src into dst
+ */
+void hll_stats_merge(hll_stats_t *dst, const hll_stats_t *src);
+
+/**
+ * @brief Estimate distinct devices for every tracked key
+ *
+ * Only reads the storage arrays, so it may be called on a copy of the state.
+ */
+void hll_stats_counts(const hll_stats_t *stats, hll_counts_t *counts);
+
+/**
+ * @brief Get the union of the current and previous window of a key
+ */
+void hll_pair_union(const hll_pair_t *pair, hll_t *out);
+
+#endif /* HLL_H */
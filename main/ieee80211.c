@@ -0,0 +1,147 @@
+#include "ieee80211.h"
+#include <stddef.h>
+#include <string.h>
+
+// Control frame subtypes that carry a transmitter address
+#define CTRL_STYPE_BLOCK_ACK_REQ 8
+#define CTRL_STYPE_BLOCK_ACK     9
+#define CTRL_STYPE_PS_POLL       10
+#define CTRL_STYPE_RTS           11
+#define CTRL_STYPE_CTS           12
+#define CTRL_STYPE_ACK           13
+#define CTRL_STYPE_CF_END        14
+
+// Parse the MAC header of a raw 802.11 frame
+bool ieee80211_parse_frame(const uint8_t *frame, uint16_t length, frame_info_t *info) {
+    if (!frame || !info || length < 10) {
+        return false;
+    }
+
+    uint16_t frame_ctrl = frame[0] | (frame[1] << 8);
+    info->type = (frame_ctrl & 0x000C) >> 2;
+    info->subtype = (frame_ctrl & 0x00F0) >> 4;
+    info->flags = frame[1];
+    info->length = length;
+    info->addr1 = frame + 4;
+    info->addr2 = NULL;
+    info->addr3 = NULL;
+    info->bssid = NULL;
+    info->body = NULL;
+    info->body_len = 0;
+    info->seq = 0;
+    info->frag = 0;
+    info->has_seq = false;
+
+    uint16_t header_len;
+
+    switch (info->type) {
+        case IEEE80211_TYPE_MGMT:
+            header_len = 24;
+            if (length < header_len) return false;
+            info->addr2 = frame + 10;
+            info->addr3 = frame + 16;
+            info->bssid = info->addr3;
+            break;
+
+        case IEEE80211_TYPE_CTRL:
+            // CTS and ACK only carry the receiver address
+            if (info->subtype == CTRL_STYPE_CTS || info->subtype == CTRL_STYPE_ACK) {
+                return true;
+            }
+            if (length < 16) return false;
+            if (info->subtype == CTRL_STYPE_RTS || info->subtype == CTRL_STYPE_PS_POLL ||
+                info->subtype == CTRL_STYPE_BLOCK_ACK_REQ || info->subtype == CTRL_STYPE_BLOCK_ACK ||
+                info->subtype == CTRL_STYPE_CF_END) {
+                info->addr2 = frame + 10;
+            }
+            if (info->subtype == CTRL_STYPE_PS_POLL) {
+                info->bssid = info->addr1;
+            } else if (info->subtype == CTRL_STYPE_CF_END) {
+                info->bssid = info->addr2;
+            }
+            return true;
+
+        case IEEE80211_TYPE_DATA: {
+            bool to_ds = info->flags & IEEE80211_FCTL_TODS;
+            bool from_ds = info->flags & IEEE80211_FCTL_FROMDS;
+
+            header_len = (to_ds && from_ds) ? 30 : 24;
+            if (info->subtype & 0x08) {
+                header_len += 2; // QoS control
+            }
+            if (length < header_len) return false;
+
+            info->addr2 = frame + 10;
+            info->addr3 = frame + 16;
+            if (!to_ds && !from_ds) {
+                info->bssid = info->addr3;
+            } else if (to_ds && !from_ds) {
+                info->bssid = info->addr1;
+            } else if (!to_ds && from_ds) {
+                info->bssid = info->addr2;
+            }
+            break;
+        }
+
+        default:
+            // Extension frames: nothing beyond the receiver address is decoded
+            return true;
+    }
+
+    uint16_t seq_ctrl = frame[22] | (frame[23] << 8);
+    info->frag = seq_ctrl & 0x000F;
+    info->seq = seq_ctrl >> 4;
+    info->has_seq = true;
+
+    info->body = frame + header_len;
+    info->body_len = length - header_len;
+    return true;
+}
+
+// Check whether a data frame carries an unprotected EAPOL payload
+bool ieee80211_is_eapol(const frame_info_t *info) {
+    // LLC/SNAP header followed by the 802.1X ethertype
+    static const uint8_t eapol_snap[8] = {0xAA, 0xAA, 0x03, 0x00, 0x00, 0x00, 0x88, 0x8E};
+
+    if (info->type != IEEE80211_TYPE_DATA || (info->flags & IEEE80211_FCTL_PROTECTED)) {
+        return false;
+    }
+    if (!info->body || info->body_len < sizeof(eapol_snap)) {
+        return false;
+    }
+    return memcmp(info->body, eapol_snap, sizeof(eapol_snap)) == 0;
+}
+
+// Get the station side of a frame exchanged with a BSS
+const uint8_t *ieee80211_station_addr(const frame_info_t *info) {
+    if (!info->bssid || !info->addr2) {
+        return NULL;
+    }
+
+    const uint8_t *station = memcmp(info->addr2, info->bssid, 6) == 0 ? info->addr1 : info->addr2;
+    if (memcmp(station, info->bssid, 6) == 0 || ieee80211_is_group_addr(station)) {
+        return NULL;
+    }
+    return station;
+}
+
+// Find an information element in a tagged parameter list
+const uint8_t *ieee80211_find_ie(const uint8_t *ies, uint16_t len, uint8_t id, uint8_t *out_len) {
+    uint16_t pos = 0;
+
+    while (pos + 2 <= len) {
+        uint8_t ie_id = ies[pos];
+        uint8_t ie_len = ies[pos + 1];
+
+        if (pos + 2 + ie_len > len) {
+            break; // Truncated element
+        }
+        if (ie_id == id) {
+            if (out_len) *out_len = ie_len;
+            return ies + pos + 2;
+        }
+        pos += 2 + ie_len;
+    }
+
+    return NULL;
+}
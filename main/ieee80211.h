@@ -0,0 +1,135 @@
+#ifndef IEEE80211_H
+#define IEEE80211_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Frame types (frame control bits 2-3)
+#define IEEE80211_TYPE_MGMT          0
+#define IEEE80211_TYPE_CTRL          1
+#define IEEE80211_TYPE_DATA          2
+
+// Management subtypes
+#define IEEE80211_STYPE_ASSOC_REQ    0
+#define IEEE80211_STYPE_ASSOC_RESP   1
+#define IEEE80211_STYPE_REASSOC_REQ  2
+#define IEEE80211_STYPE_REASSOC_RESP 3
+#define IEEE80211_STYPE_PROBE_REQ    4
+#define IEEE80211_STYPE_PROBE_RESP   5
+#define IEEE80211_STYPE_BEACON       8
+#define IEEE80211_STYPE_ATIM         9
+#define IEEE80211_STYPE_DISASSOC     10
+#define IEEE80211_STYPE_AUTH         11
+#define IEEE80211_STYPE_DEAUTH       12
+#define IEEE80211_STYPE_ACTION       13
+
+// Frame control flags (second byte of frame control)
+#define IEEE80211_FCTL_TODS          0x01
+#define IEEE80211_FCTL_FROMDS        0x02
+#define IEEE80211_FCTL_MOREFRAGS     0x04
+#define IEEE80211_FCTL_RETRY         0x08
+#define IEEE80211_FCTL_PROTECTED     0x40
+
+// Information element IDs
+#define IEEE80211_IE_SSID            0
+#define IEEE80211_IE_DS_PARAMS       3
+#define IEEE80211_IE_TIM             5
+#define IEEE80211_IE_BSS_LOAD        11
+#define IEEE80211_IE_CSA             37
+#define IEEE80211_IE_QUIET           40
+#define IEEE80211_IE_RSN             48
+#define IEEE80211_IE_EXT_CSA         60
+#define IEEE80211_IE_HT_OPERATION    61
+#define IEEE80211_IE_VENDOR          221
+
+// Fixed fields in beacon/probe response bodies: timestamp, interval, capabilities
+#define IEEE80211_BEACON_FIXED_LEN   12
+
+/**
+ * @brief Decoded view of an 802.11 MAC header plus the radio metadata
+ *
+ * Address pointers point into the original frame buffer and are only valid
+ * for as long as that buffer is. Fields that do not apply to a frame type
+ * (e.g. addr2 on CTS/ACK) are NULL.
+ */
+typedef struct {
+    uint8_t type;              // IEEE80211_TYPE_*
+    uint8_t subtype;           // IEEE80211_STYPE_* for management frames
+    uint8_t flags;             // IEEE80211_FCTL_* bits
+    uint16_t length;           // Frame length without FCS
+    const uint8_t *addr1;      // Receiver address
+    const uint8_t *addr2;      // Transmitter address
+    const uint8_t *addr3;
+    const uint8_t *bssid;      // BSSID, when derivable from ToDS/FromDS
+    const uint8_t *body;       // Frame body after the MAC header
+    uint16_t body_len;
+    uint16_t seq;              // 12-bit sequence number
+    uint8_t frag;              // 4-bit fragment number
+    bool has_seq;
+    int8_t rssi;
+    uint8_t channel;
+    uint64_t timestamp_us;     // Receive time
+} frame_info_t;
+
+/**
+ * @brief Parse the MAC header of a raw 802.11 frame
+ *
+ * @param frame Frame buffer starting at the frame control field
+ * @param length Frame length in bytes, excluding FCS
+ * @param info Output structure (radio metadata fields are left untouched)
+ * @return true if the frame was long enough to contain a valid header
+ */
+bool ieee80211_parse_frame(const uint8_t *frame, uint16_t length, frame_info_t *info);
+
+/**
+ * @brief Find an information element in a tagged parameter list
+ *
+ * @param ies Start of the tagged parameters
+ * @param len Length of the tagged parameters
+ * @param id Element ID to look for
+ * @param out_len Length of the element payload (may be NULL)
+ * @return Pointer to the element payload, or NULL if not present
+ */
+const uint8_t *ieee80211_find_ie(const uint8_t *ies, uint16_t len, uint8_t id, uint8_t *out_len);
+
+/**
+ * @brief Check whether a data frame carries an unprotected EAPOL payload
+ */
+bool ieee80211_is_eapol(const frame_info_t *info);
+
+/**
+ * @brief Get the station side of a frame exchanged with a BSS
+ *
+ * @return Whichever of transmitter/receiver is not the BSSID, or NULL if the
+ *         frame has no BSSID or the station address is a group address
+ */
+const uint8_t *ieee80211_station_addr(const frame_info_t *info);
+
+/**
+ * @brief Check whether an address is a group (broadcast/multicast) address
+ */
+static inline bool ieee80211_is_group_addr(const uint8_t *addr) {
+    return addr[0] & 0x01;
+}
+
+/**
+ * @brief Check whether a frame is a beacon or probe response
+ */
+static inline bool ieee80211_is_beacon_like(const frame_info_t *info) {
+    return info->type == IEEE80211_TYPE_MGMT &&
+           (info->subtype == IEEE80211_STYPE_BEACON || info->subtype == IEEE80211_STYPE_PROBE_RESP);
+}
+
+/**
+ * @brief Get the traffic identifier of a QoS data frame
+ *
+ * @return TID 0-15, or -1 if the frame has no QoS control field
+ */
+static inline int ieee80211_qos_tid(const frame_info_t *info) {
+    if (info->type != IEEE80211_TYPE_DATA || !(info->subtype & 0x08) || !info->body) {
+        return -1;
+    }
+    return info->body[-2] & 0x0F; // QoS control ends the MAC header
+}
+
+#endif /* IEEE80211_H */
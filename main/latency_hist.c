@@ -0,0 +1,62 @@
+#include "latency_hist.h"
+#include <string.h>
+
+// Bucket of a value: exact below 16, then 16 sub-buckets per power of two
+static int bucket_index(uint32_t value) {
+    if (value < LATENCY_HIST_SUB_BUCKETS) {
+        return value;
+    }
+    int msb = 31 - __builtin_clz(value);
+    int shift = msb - LATENCY_HIST_SUB_BITS;
+    return (shift + 1) * LATENCY_HIST_SUB_BUCKETS + ((value >> shift) & (LATENCY_HIST_SUB_BUCKETS - 1));
+}
+
+// Smallest value that falls in a bucket
+static uint32_t bucket_floor(int index) {
+    if (index < LATENCY_HIST_SUB_BUCKETS) {
+        return index;
+    }
+    int shift = index / LATENCY_HIST_SUB_BUCKETS - 1;
+    uint32_t sub = index % LATENCY_HIST_SUB_BUCKETS;
+    return (LATENCY_HIST_SUB_BUCKETS + sub) << shift;
+}
+
+// Reset the histogram
+void latency_hist_init(latency_hist_t *hist) {
+    memset(hist, 0, sizeof(*hist));
+}
+
+// Account one sample
+void latency_hist_add(latency_hist_t *hist, uint32_t value) {
+    hist->buckets[bucket_index(value)]++;
+    hist->count++;
+    hist->sum += value;
+    if (value > hist->max) {
+        hist->max = value;
+    }
+}
+
+// Get a percentile, as the lower bound of its bucket
+uint32_t latency_hist_percentile(const latency_hist_t *hist, uint16_t permille) {
+    if (hist->count == 0) {
+        return 0;
+    }
+    if (permille >= 1000) {
+        return hist->max;
+    }
+
+    // Rank of the sample wanted, 1-based
+    uint32_t rank = (uint32_t)(((uint64_t)hist->count * permille + 999) / 1000);
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint32_t seen = 0;
+    for (int i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            uint32_t floor = bucket_floor(i);
+            return floor < hist->max ? floor : hist->max;
+        }
+    }
+    return hist->max;
+}
@@ -0,0 +1,47 @@
+#ifndef LATENCY_HIST_H
+#define LATENCY_HIST_H
+
+#include <stdint.h>
+
+// Log-linear buckets: 16 per power of two, so any value is within 1/16 of its bucket
+#define LATENCY_HIST_SUB_BITS        4
+#define LATENCY_HIST_SUB_BUCKETS     (1 << LATENCY_HIST_SUB_BITS)
+#define LATENCY_HIST_BUCKETS         ((32 - LATENCY_HIST_SUB_BITS + 1) * LATENCY_HIST_SUB_BUCKETS)
+
+/**
+ * @brief Fixed-size latency histogram (the unit is up to the caller)
+ */
+typedef struct {
+    uint32_t buckets[LATENCY_HIST_BUCKETS];
+    uint32_t count;
+    uint32_t max;
+    uint64_t sum;
+} latency_hist_t;
+
+/**
+ * @brief Reset the histogram
+ */
+void latency_hist_init(latency_hist_t *hist);
+
+/**
+ * @brief Account one sample
+ */
+void latency_hist_add(latency_hist_t *hist, uint32_t value);
+
+/**
+ * @brief Get a percentile
+ *
+ * @param permille Percentile in tenths of a percent (500 = median, 999 = p99.9)
+ * @return Lower bound of the bucket holding the percentile (the maximum for 1000,
+ *         0 if the histogram is empty)
+ */
+uint32_t latency_hist_percentile(const latency_hist_t *hist, uint16_t permille);
+
+/**
+ * @brief Get the mean of all samples
+ */
+static inline uint32_t latency_hist_mean(const latency_hist_t *hist) {
+    return hist->count ? (uint32_t)(hist->sum / hist->count) : 0;
+}
+
+#endif /* LATENCY_HIST_H */
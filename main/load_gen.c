@@ -0,0 +1,198 @@
+#include "load_gen.h"
+#include "latency_hist.h"
+#include "wifi_sniffer.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "load_gen";
+
+// Generator task settings; below the sender tasks so readers keep draining
+#define GEN_TASK_STACK          4096
+#define GEN_TASK_PRIORITY       3
+// Longest stretch of injection before yielding a tick to lower priority tasks
+#define GEN_SLICE_US            50000
+
+static portMUX_TYPE gen_lock = portMUX_INITIALIZER_UNLOCKED;
+static load_gen_status_t gen_status;
+static volatile bool stop_requested = false;
+static TaskHandle_t gen_task_handle = NULL;
+
+// Owned by the task while it runs
+static traffic_gen_t *generator = NULL;
+static latency_hist_t handler_hist;
+static capture_class_stats_t start_stats[CAPTURE_CLASS_COUNT];
+
+// Publish counters and percentiles to the status readers
+static void publish(uint32_t elapsed_ms, uint32_t injected, uint32_t rejected) {
+    capture_class_stats_t stats[CAPTURE_CLASS_COUNT];
+    uint32_t captured = 0, evicted = 0, dropped = 0;
+
+    wifi_sniffer_get_class_stats(stats);
+    for (int i = 0; i < CAPTURE_CLASS_COUNT; i++) {
+        captured += stats[i].captured - start_stats[i].captured;
+        evicted += stats[i].evicted - start_stats[i].evicted;
+        dropped += stats[i].dropped - start_stats[i].dropped;
+    }
+    uint16_t peak = wifi_sniffer_get_buffer_peak(false);
+    uint32_t p50 = latency_hist_percentile(&handler_hist, 500);
+    uint32_t p99 = latency_hist_percentile(&handler_hist, 990);
+    uint32_t p999 = latency_hist_percentile(&handler_hist, 999);
+
+    portENTER_CRITICAL(&gen_lock);
+    gen_status.elapsed_ms = elapsed_ms;
+    gen_status.injected = injected;
+    gen_status.rejected = rejected;
+    memcpy(gen_status.kinds, generator->generated, sizeof(gen_status.kinds));
+    gen_status.captured = captured;
+    gen_status.evicted = evicted;
+    gen_status.dropped = dropped;
+    gen_status.buffer_peak = peak;
+    gen_status.handler_mean_ns = latency_hist_mean(&handler_hist);
+    gen_status.handler_p50_ns = p50;
+    gen_status.handler_p99_ns = p99;
+    gen_status.handler_p999_ns = p999;
+    gen_status.handler_max_ns = handler_hist.max;
+    portEXIT_CRITICAL(&gen_lock);
+}
+
+// Generator task: paces synthetic frames into the packet handler
+static void load_gen_task(void *pvParameters) {
+    (void)pvParameters;
+    wifi_promiscuous_pkt_t *pkt = malloc(sizeof(wifi_promiscuous_pkt_t) + LOAD_GEN_FRAME_MAX + 4);
+    uint32_t ticks_per_us = esp_rom_get_cpu_ticks_per_us();
+    uint32_t target_fps = gen_status.target_fps;
+    uint64_t duration_us = (uint64_t)gen_status.duration_ms * 1000;
+    uint32_t injected = 0, rejected = 0;
+
+    ESP_LOGI(TAG, "Load generator started: %lu frames/s for %lu ms",
+             (unsigned long)target_fps, (unsigned long)gen_status.duration_ms);
+
+    int64_t start_us = esp_timer_get_time();
+    int64_t elapsed_us = 0;
+    while (pkt && !stop_requested && (uint64_t)elapsed_us < duration_us) {
+        int64_t slice_start_us = esp_timer_get_time();
+
+        for (;;) {
+            int64_t now_us = esp_timer_get_time();
+            elapsed_us = now_us - start_us;
+            if ((uint64_t)elapsed_us >= duration_us || now_us - slice_start_us >= GEN_SLICE_US) {
+                break;
+            }
+            // Paced runs inject whatever is due; falling behind shows as a lower achieved rate
+            if (target_fps && (uint64_t)injected + rejected >= (uint64_t)target_fps * elapsed_us / 1000000) {
+                break;
+            }
+
+            traffic_gen_frame_t frame;
+            uint16_t len = traffic_gen_next(generator, pkt->payload, LOAD_GEN_FRAME_MAX, &frame);
+            esp_cpu_cycle_count_t c0 = esp_cpu_get_cycle_count();
+            bool ok = wifi_sniffer_inject(pkt, len, frame.rssi, frame.channel, frame.rate);
+            esp_cpu_cycle_count_t c1 = esp_cpu_get_cycle_count();
+            if (ok) {
+                latency_hist_add(&handler_hist, (uint32_t)((uint64_t)(c1 - c0) * 1000 / ticks_per_us));
+                injected++;
+            } else {
+                rejected++;
+            }
+        }
+
+        publish(elapsed_us / 1000, injected, rejected);
+        // Sniffer stopped under us; nothing more will get through
+        if (rejected && !wifi_sniffer_is_running()) {
+            break;
+        }
+        vTaskDelay(1);
+    }
+
+    publish(elapsed_us / 1000, injected, rejected);
+    ESP_LOGI(TAG, "Load generator finished: %lu frames in %lu ms, %lu dropped, %lu evicted",
+             (unsigned long)injected, (unsigned long)(elapsed_us / 1000),
+             (unsigned long)gen_status.dropped, (unsigned long)gen_status.evicted);
+
+    free(pkt);
+    free(generator);
+    generator = NULL;
+    portENTER_CRITICAL(&gen_lock);
+    gen_status.running = false;
+    portEXIT_CRITICAL(&gen_lock);
+    gen_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+// Start feeding synthetic frames to the running sniffer
+bool load_gen_start(const traffic_gen_config_t *config, uint32_t target_fps, uint32_t duration_ms) {
+    if (gen_task_handle) {
+        ESP_LOGW(TAG, "Load generator already running, stopping first");
+        load_gen_stop();
+        if (gen_task_handle) {
+            return false;
+        }
+    }
+    if (!wifi_sniffer_is_running()) {
+        ESP_LOGE(TAG, "Sniffer is not running");
+        return false;
+    }
+
+    generator = malloc(sizeof(traffic_gen_t));
+    if (!generator) {
+        ESP_LOGE(TAG, "Failed to allocate the traffic generator");
+        return false;
+    }
+    if (!traffic_gen_init(generator, config)) {
+        ESP_LOGE(TAG, "Invalid traffic configuration");
+        free(generator);
+        generator = NULL;
+        return false;
+    }
+
+    latency_hist_init(&handler_hist);
+    wifi_sniffer_get_class_stats(start_stats);
+    wifi_sniffer_get_buffer_peak(true);
+
+    portENTER_CRITICAL(&gen_lock);
+    memset(&gen_status, 0, sizeof(gen_status));
+    gen_status.running = true;
+    gen_status.target_fps = target_fps;
+    gen_status.duration_ms = duration_ms < LOAD_GEN_MAX_DURATION_MS ? duration_ms : LOAD_GEN_MAX_DURATION_MS;
+    portEXIT_CRITICAL(&gen_lock);
+
+    stop_requested = false;
+    if (xTaskCreate(load_gen_task, "load_gen", GEN_TASK_STACK, NULL, GEN_TASK_PRIORITY,
+                    &gen_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create load generator task");
+        gen_task_handle = NULL;
+        gen_status.running = false;
+        free(generator);
+        generator = NULL;
+        return false;
+    }
+    return true;
+}
+
+// Stop a run early
+void load_gen_stop(void) {
+    if (!gen_task_handle) {
+        return;
+    }
+
+    stop_requested = true;
+    for (int i = 0; i < 100 && gen_task_handle; i++) {
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+    if (gen_task_handle) {
+        ESP_LOGW(TAG, "Load generator did not stop in time");
+    }
+}
+
+// Get the state and results of the current or last run
+void load_gen_get_status(load_gen_status_t *status) {
+    portENTER_CRITICAL(&gen_lock);
+    *status = gen_status;
+    portEXIT_CRITICAL(&gen_lock);
+}
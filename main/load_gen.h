@@ -0,0 +1,61 @@
+#ifndef LOAD_GEN_H
+#define LOAD_GEN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "traffic_gen.h"
+
+// Longest run accepted
+#define LOAD_GEN_MAX_DURATION_MS     600000
+// Largest synthesized frame
+#define LOAD_GEN_FRAME_MAX           1600
+
+/**
+ * @brief Load test state and results
+ *
+ * Capture buffer counters are deltas over the run and include anything the
+ * radio delivered at the same time.
+ */
+typedef struct {
+    bool running;
+    uint32_t target_fps;         // 0 = as fast as possible
+    uint32_t duration_ms;
+    uint32_t elapsed_ms;
+    uint32_t injected;           // Frames handed to the packet handler
+    uint32_t rejected;           // Frames refused because the sniffer was not running
+    uint32_t kinds[TRAFFIC_GEN_KIND_COUNT];
+    uint32_t captured;           // Frames accepted into the capture buffer
+    uint32_t evicted;            // Frames pushed out before a reader took them
+    uint32_t dropped;            // Frames rejected by a full capture buffer
+    uint16_t buffer_peak;        // Capture buffer high-water mark
+    uint32_t handler_mean_ns;    // Time per packet handler call
+    uint32_t handler_p50_ns;
+    uint32_t handler_p99_ns;
+    uint32_t handler_p999_ns;
+    uint32_t handler_max_ns;
+} load_gen_status_t;
+
+/**
+ * @brief Start feeding synthetic frames to the running sniffer
+ *
+ * Frames go through wifi_sniffer_inject(), so every handler stage runs as
+ * for received frames.
+ *
+ * @param config Traffic mix and population
+ * @param target_fps Frames per second, 0 for as fast as possible
+ * @param duration_ms Run length
+ * @return false if the sniffer is not running or the task could not start
+ */
+bool load_gen_start(const traffic_gen_config_t *config, uint32_t target_fps, uint32_t duration_ms);
+
+/**
+ * @brief Stop a run early (results are kept)
+ */
+void load_gen_stop(void);
+
+/**
+ * @brief Get the state and results of the current or last run
+ */
+void load_gen_get_status(load_gen_status_t *status);
+
+#endif /* LOAD_GEN_H */
@@ -0,0 +1,156 @@
+#include "load_governor.h"
+#include <string.h>
+
+static const char *level_names[] = {
+    [LOAD_LEVEL_FULL]     = "full",
+    [LOAD_LEVEL_SNAPLEN]  = "snaplen",
+    [LOAD_LEVEL_HEADERS]  = "headers",
+    [LOAD_LEVEL_SAMPLED]  = "sampled",
+    [LOAD_LEVEL_COUNTERS] = "counters",
+};
+
+#define WINDOW_US ((uint64_t)LOAD_GOVERNOR_WINDOW_MS * 1000)
+
+// Fill in the default thresholds
+void load_governor_default_config(load_governor_config_t *config) {
+    config->enabled = true;
+    config->busy_high_pct = 50;
+    config->busy_low_pct = 25;
+    config->churn_high_fps = 2000;
+    config->churn_low_fps = 500;
+    config->heap_low_bytes = 24 * 1024;
+    config->heap_high_bytes = 40 * 1024;
+    config->raise_windows = 1;
+    config->recover_windows = 8;
+}
+
+// Initialize the governor at full fidelity
+void load_governor_init(load_governor_t *gov, const load_governor_config_t *config, uint64_t now_us) {
+    memset(gov, 0, sizeof(*gov));
+    gov->config = *config;
+    gov->level = LOAD_LEVEL_FULL;
+    gov->level_since_us = now_us;
+    gov->window_start_us = now_us;
+    gov->hold_windows = config->recover_windows;
+}
+
+// Decide how much of a frame to capture
+uint16_t load_governor_admit(load_governor_t *gov, uint16_t length, uint16_t header_len, bool important) {
+    uint16_t caplen;
+
+    gov->frames[gov->level]++;
+    switch (gov->level) {
+        case LOAD_LEVEL_FULL:
+            return length;
+        case LOAD_LEVEL_SNAPLEN:
+            caplen = length > LOAD_GOVERNOR_SNAPLEN ? LOAD_GOVERNOR_SNAPLEN : length;
+            break;
+        case LOAD_LEVEL_HEADERS:
+            caplen = header_len;
+            break;
+        case LOAD_LEVEL_SAMPLED:
+            if (!important && ++gov->sample_count % LOAD_GOVERNOR_SAMPLE_N != 0) {
+                gov->skipped++;
+                return 0;
+            }
+            caplen = header_len;
+            break;
+        default:
+            gov->skipped++;
+            return 0;
+    }
+
+    if (caplen < length) {
+        gov->truncated++;
+    }
+    return caplen;
+}
+
+// Charge time spent in the RX callback
+bool load_governor_account(load_governor_t *gov, uint32_t busy_us, uint64_t now_us) {
+    gov->busy_us += busy_us;
+    return now_us - gov->window_start_us >= WINDOW_US;
+}
+
+// Move to a new level
+static void set_level(load_governor_t *gov, load_level_t level, uint64_t now_us) {
+    gov->level = level;
+    gov->level_since_us = now_us;
+    gov->hot_windows = 0;
+    gov->calm_windows = 0;
+    gov->sample_count = 0;
+}
+
+// Close the current window and step the level if needed
+bool load_governor_evaluate(load_governor_t *gov, uint64_t now_us, uint32_t churn_total, uint32_t free_heap) {
+    uint64_t elapsed = now_us - gov->window_start_us;
+    if (now_us < gov->window_start_us || elapsed < WINDOW_US) {
+        return false;
+    }
+
+    // A long quiet gap counts as that many calm windows
+    uint32_t windows = elapsed / WINDOW_US ? elapsed / WINDOW_US : 1;
+    uint64_t busy_pct = gov->busy_us * 100 / elapsed;
+    gov->busy_pct = busy_pct > 100 ? 100 : busy_pct;
+    gov->churn_fps = (uint64_t)(churn_total - gov->churn_total) * 1000000 / elapsed;
+    gov->churn_total = churn_total;
+    gov->free_heap = free_heap;
+    gov->level_us[gov->level] += elapsed;
+    gov->window_start_us = now_us;
+    gov->busy_us = 0;
+
+    const load_governor_config_t *c = &gov->config;
+    if (!c->enabled) {
+        if (gov->level != LOAD_LEVEL_FULL) {
+            set_level(gov, LOAD_LEVEL_FULL, now_us);
+            return true;
+        }
+        return false;
+    }
+
+    // A level that held for the longest hold has settled; forget the backoff
+    if (now_us - gov->level_since_us >= LOAD_GOVERNOR_MAX_HOLD * WINDOW_US) {
+        gov->hold_windows = c->recover_windows;
+    }
+
+    bool hot = gov->busy_pct >= c->busy_high_pct || gov->churn_fps >= c->churn_high_fps ||
+               free_heap < c->heap_low_bytes;
+    bool calm = gov->busy_pct < c->busy_low_pct && gov->churn_fps < c->churn_low_fps &&
+                free_heap >= c->heap_high_bytes;
+
+    if (hot) {
+        gov->calm_windows = 0;
+        if (++gov->hot_windows < c->raise_windows || gov->level == LOAD_LEVEL_COUNTERS) {
+            return false;
+        }
+        // The level just stepped up to was too much: wait longer next time
+        if (gov->steps_up && now_us - gov->raised_us < gov->hold_windows * WINDOW_US) {
+            gov->hold_windows = gov->hold_windows * 2 < LOAD_GOVERNOR_MAX_HOLD ? gov->hold_windows * 2
+                                                                               : LOAD_GOVERNOR_MAX_HOLD;
+        }
+        gov->steps_down++;
+        set_level(gov, gov->level + 1, now_us);
+        return true;
+    }
+
+    if (calm) {
+        gov->hot_windows = 0;
+        gov->calm_windows = gov->calm_windows + windows < UINT16_MAX ? gov->calm_windows + windows : UINT16_MAX;
+        if (gov->calm_windows < gov->hold_windows || gov->level == LOAD_LEVEL_FULL) {
+            return false;
+        }
+        gov->steps_up++;
+        gov->raised_us = now_us;
+        set_level(gov, gov->level - 1, now_us);
+        return true;
+    }
+
+    gov->hot_windows = 0;
+    gov->calm_windows = 0;
+    return false;
+}
+
+// Get the name of a level
+const char *load_governor_level_name(load_level_t level) {
+    return level < LOAD_LEVEL_COUNT ? level_names[level] : "unknown";
+}
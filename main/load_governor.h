@@ -0,0 +1,127 @@
+#ifndef LOAD_GOVERNOR_H
+#define LOAD_GOVERNOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Load is measured over windows of this length
+#define LOAD_GOVERNOR_WINDOW_MS      250
+// Bytes kept per frame at the snaplen level
+#define LOAD_GOVERNOR_SNAPLEN        128
+// One frame in this many is kept at the sampling level
+#define LOAD_GOVERNOR_SAMPLE_N       8
+// Longest hold before trying a higher level again, in windows
+#define LOAD_GOVERNOR_MAX_HOLD       64
+
+/**
+ * @brief Capture fidelity levels, highest first
+ */
+typedef enum {
+    LOAD_LEVEL_FULL = 0,         // Whole frames
+    LOAD_LEVEL_SNAPLEN,          // First LOAD_GOVERNOR_SNAPLEN bytes
+    LOAD_LEVEL_HEADERS,          // MAC header only
+    LOAD_LEVEL_SAMPLED,          // MAC header of one frame in LOAD_GOVERNOR_SAMPLE_N
+    LOAD_LEVEL_COUNTERS,         // Nothing captured; analytics only
+    LOAD_LEVEL_COUNT
+} load_level_t;
+
+/**
+ * @brief Thresholds and hysteresis
+ *
+ * A window is overloaded when any signal is above its high threshold and
+ * calm when all are below their low ones; in between the level holds.
+ */
+typedef struct {
+    bool enabled;
+    uint8_t busy_high_pct;       // Share of time spent in the RX callback
+    uint8_t busy_low_pct;
+    uint32_t churn_high_fps;     // Frames/s pushed into a full capture buffer (evicting or dropped)
+    uint32_t churn_low_fps;
+    uint32_t heap_low_bytes;     // Free heap
+    uint32_t heap_high_bytes;
+    uint8_t raise_windows;       // Overloaded windows in a row before stepping down
+    uint8_t recover_windows;     // Calm windows in a row before stepping back up
+} load_governor_config_t;
+
+/**
+ * @brief Overload governor state
+ *
+ * Steps capture fidelity down one level per overloaded stretch and back up
+ * one level per calm stretch. Falling back within a hold of stepping up
+ * doubles the hold, so a load that sits right at the edge does not make
+ * the level flap; once a level has lasted LOAD_GOVERNOR_MAX_HOLD windows
+ * the hold is back to recover_windows.
+ */
+typedef struct {
+    load_governor_config_t config;
+    load_level_t level;
+    uint64_t level_since_us;
+
+    // Current window
+    uint64_t window_start_us;
+    uint64_t busy_us;
+    uint32_t sample_count;
+
+    // Hysteresis
+    uint8_t hot_windows;
+    uint16_t calm_windows;
+    uint16_t hold_windows;       // Calm windows needed to step up now
+    uint64_t raised_us;          // When the level was last stepped up
+
+    // Last window's signals
+    uint8_t busy_pct;
+    uint32_t churn_fps;
+    uint32_t free_heap;
+    uint32_t churn_total;        // Cumulative count the churn is derived from
+
+    // Counters
+    uint32_t steps_down;
+    uint32_t steps_up;
+    uint32_t frames[LOAD_LEVEL_COUNT];  // Frames offered at each level
+    uint32_t truncated;          // Frames captured shorter than they were
+    uint32_t skipped;            // Frames not captured at all
+    uint64_t level_us[LOAD_LEVEL_COUNT];  // Time spent at each level
+} load_governor_t;
+
+/**
+ * @brief Fill in the default thresholds
+ */
+void load_governor_default_config(load_governor_config_t *config);
+
+/**
+ * @brief Initialize the governor at full fidelity
+ */
+void load_governor_init(load_governor_t *gov, const load_governor_config_t *config, uint64_t now_us);
+
+/**
+ * @brief Decide how much of a frame to capture
+ *
+ * @param length Frame length
+ * @param header_len Length of its MAC header
+ * @param important Handshake or deauthentication frame; not sampled out
+ * @return Bytes to capture, 0 to capture nothing
+ */
+uint16_t load_governor_admit(load_governor_t *gov, uint16_t length, uint16_t header_len, bool important);
+
+/**
+ * @brief Charge time spent in the RX callback
+ *
+ * @return true once the current window is over and load_governor_evaluate() is due
+ */
+bool load_governor_account(load_governor_t *gov, uint32_t busy_us, uint64_t now_us);
+
+/**
+ * @brief Close the current window and step the level if needed
+ *
+ * @param churn_total Cumulative frames pushed into a full capture buffer
+ * @param free_heap Free heap in bytes
+ * @return true if the level changed
+ */
+bool load_governor_evaluate(load_governor_t *gov, uint64_t now_us, uint32_t churn_total, uint32_t free_heap);
+
+/**
+ * @brief Get the name of a level
+ */
+const char *load_governor_level_name(load_level_t level);
+
+#endif /* LOAD_GOVERNOR_H */
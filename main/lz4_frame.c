@@ -0,0 +1,157 @@
+#include "lz4_frame.h"
+#include <string.h>
+
+// Block format limits: the last 5 bytes are always literals and the last
+// match starts at least 12 bytes before the end of the block
+#define MIN_MATCH               4
+#define LAST_LITERALS           5
+#define MF_LIMIT                12
+#define MAX_OFFSET              65535
+// Skip ahead faster through data that does not compress
+#define SKIP_TRIGGER            6
+
+static uint32_t read32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint32_t hash4(uint32_t v) {
+    return (v * 2654435761u) >> (32 - LZ4_HASH_BITS);
+}
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+// Write the 255-run continuation of a length whose nibble saturated at 15
+static uint8_t *put_length(uint8_t *op, size_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+// Emit literals then (if match_len) a match; NULL if the output would overflow
+static uint8_t *put_sequence(uint8_t *op, const uint8_t *op_end, const uint8_t *literals, size_t lit_len,
+                             size_t offset, size_t match_len) {
+    size_t need = 1 + lit_len + lit_len / 255 + 1 + (match_len ? 2 + match_len / 255 + 1 : 0);
+    if (need > (size_t)(op_end - op)) {
+        return NULL;
+    }
+
+    uint8_t *token = op++;
+    *token = (lit_len >= 15 ? 15 : lit_len) << 4;
+    if (lit_len >= 15) {
+        op = put_length(op, lit_len - 15);
+    }
+    memcpy(op, literals, lit_len);
+    op += lit_len;
+
+    if (match_len) {
+        size_t code = match_len - MIN_MATCH;
+        *op++ = offset;
+        *op++ = offset >> 8;
+        *token |= code >= 15 ? 15 : code;
+        if (code >= 15) {
+            op = put_length(op, code - 15);
+        }
+    }
+    return op;
+}
+
+// Compress one independent block in LZ4 block format
+size_t lz4_compress_block(lz4_state_t *state, const uint8_t *src, size_t len, uint8_t *dst, size_t dst_cap) {
+    const uint8_t *op_end = dst + dst_cap;
+    uint8_t *op = dst;
+    size_t anchor = 0;
+
+    if (len > LZ4_MAX_BLOCK) {
+        return 0;
+    }
+
+    if (len > MF_LIMIT) {
+        size_t match_limit = len - MF_LIMIT;
+        size_t match_end = len - LAST_LITERALS;
+        size_t ip = 1;
+
+        memset(state->table, 0, sizeof(state->table));
+        state->table[hash4(read32(src))] = 0;
+
+        while (ip < match_limit) {
+            uint32_t seq = read32(src + ip);
+            uint32_t h = hash4(seq);
+            size_t ref = state->table[h];
+            state->table[h] = (uint16_t)ip;
+
+            // Candidates are only hints; confirm the bytes before using one
+            if (ref >= ip || ip - ref > MAX_OFFSET || read32(src + ref) != seq) {
+                ip += 1 + ((ip - anchor) >> SKIP_TRIGGER);
+                continue;
+            }
+
+            // Extend backwards into pending literals, then forwards
+            while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+                ip--;
+                ref--;
+            }
+            size_t match_len = MIN_MATCH;
+            while (ip + match_len < match_end && src[ip + match_len] == src[ref + match_len]) {
+                match_len++;
+            }
+
+            op = put_sequence(op, op_end, src + anchor, ip - anchor, ip - ref, match_len);
+            if (!op) {
+                return 0;
+            }
+            ip += match_len;
+            anchor = ip;
+
+            // Index a position inside the match so runs keep chaining
+            if (ip < match_limit) {
+                state->table[hash4(read32(src + ip - 2))] = (uint16_t)(ip - 2);
+            }
+        }
+    }
+
+    op = put_sequence(op, op_end, src + anchor, len - anchor, 0, 0);
+    return op ? (size_t)(op - dst) : 0;
+}
+
+// Write the LZ4 frame header
+size_t lz4_frame_header(uint8_t out[LZ4_FRAME_HEADER_LEN]) {
+    put_le32(out, 0x184D2204);        // Magic
+    out[4] = 0x60;                    // FLG: version 01, independent blocks
+    out[5] = 0x40;                    // BD: 64 KB maximum block size
+    out[6] = 0x82;                    // Header checksum: (XXH32(FLG, BD) >> 8) & 0xFF
+    return LZ4_FRAME_HEADER_LEN;
+}
+
+// Write one frame block holding the input as is
+size_t lz4_frame_stored(const uint8_t *src, size_t len, uint8_t *dst) {
+    // High bit of the size marks a stored block
+    put_le32(dst, 0x80000000u | (uint32_t)len);
+    memcpy(dst + LZ4_BLOCK_HEADER_LEN, src, len);
+    return LZ4_BLOCK_HEADER_LEN + len;
+}
+
+// Write one frame block: compressed, or stored if that is not smaller
+size_t lz4_frame_block(lz4_state_t *state, const uint8_t *src, size_t len, uint8_t *dst) {
+    size_t compressed = len ? lz4_compress_block(state, src, len, dst + LZ4_BLOCK_HEADER_LEN, len - 1) : 0;
+    if (compressed == 0) {
+        return lz4_frame_stored(src, len, dst);
+    }
+    put_le32(dst, (uint32_t)compressed);
+    return LZ4_BLOCK_HEADER_LEN + compressed;
+}
+
+// Write the end mark that closes a frame
+size_t lz4_frame_end(uint8_t out[LZ4_FRAME_END_LEN]) {
+    put_le32(out, 0);
+    return LZ4_FRAME_END_LEN;
+}
@@ -0,0 +1,66 @@
+#ifndef LZ4_FRAME_H
+#define LZ4_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Match finder: 4096 entries of 16-bit positions (8 KB, no allocation)
+#define LZ4_HASH_BITS                12
+// Largest block the frame header announces (and 16-bit positions allow)
+#define LZ4_MAX_BLOCK                65536
+#define LZ4_FRAME_HEADER_LEN         7
+#define LZ4_BLOCK_HEADER_LEN         4
+#define LZ4_FRAME_END_LEN            4
+// Worst case size of a framed block of n input bytes
+#define LZ4_FRAME_BLOCK_BOUND(n)     (LZ4_BLOCK_HEADER_LEN + (n))
+
+/**
+ * @brief Compressor state, reused across blocks
+ */
+typedef struct {
+    uint16_t table[1 << LZ4_HASH_BITS];
+} lz4_state_t;
+
+/**
+ * @brief Compress one independent block in LZ4 block format
+ *
+ * @param state Scratch state
+ * @param src Input, at most LZ4_MAX_BLOCK bytes
+ * @param len Input length
+ * @param dst Output buffer
+ * @param dst_cap Output capacity
+ * @return Compressed length, or 0 if it does not fit in dst_cap
+ */
+size_t lz4_compress_block(lz4_state_t *state, const uint8_t *src, size_t len, uint8_t *dst, size_t dst_cap);
+
+/**
+ * @brief Write the LZ4 frame header (independent 64 KB blocks, no checksums)
+ *
+ * @return LZ4_FRAME_HEADER_LEN
+ */
+size_t lz4_frame_header(uint8_t out[LZ4_FRAME_HEADER_LEN]);
+
+/**
+ * @brief Write one frame block: compressed, or stored if that is not smaller
+ *
+ * @param dst Output of at least LZ4_FRAME_BLOCK_BOUND(len) bytes
+ * @return Bytes written to dst
+ */
+size_t lz4_frame_block(lz4_state_t *state, const uint8_t *src, size_t len, uint8_t *dst);
+
+/**
+ * @brief Write one frame block holding the input as is
+ *
+ * @param dst Output of at least LZ4_FRAME_BLOCK_BOUND(len) bytes
+ * @return Bytes written to dst
+ */
+size_t lz4_frame_stored(const uint8_t *src, size_t len, uint8_t *dst);
+
+/**
+ * @brief Write the end mark that closes a frame
+ *
+ * @return LZ4_FRAME_END_LEN
+ */
+size_t lz4_frame_end(uint8_t out[LZ4_FRAME_END_LEN]);
+
+#endif /* LZ4_FRAME_H */
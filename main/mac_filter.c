@@ -0,0 +1,228 @@
+#include "mac_filter.h"
+#include "mac_table.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Second hash for double hashing, derived from the first
+static inline uint32_t second_hash(uint32_t h1) {
+    uint32_t h = h1 ^ 0x9e3779b9u;
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    return h | 1; // Odd so that all probes differ
+}
+
+static int compare_macs(const void *a, const void *b) {
+    return memcmp(a, b, 6);
+}
+
+// Allocate an empty list
+mac_filter_t *mac_filter_create(mac_filter_mode_t mode, uint32_t capacity) {
+    if (capacity > MAC_FILTER_MAX_ENTRIES) {
+        capacity = MAC_FILTER_MAX_ENTRIES;
+    }
+
+    mac_filter_t *filter = calloc(1, sizeof(mac_filter_t));
+    if (!filter) {
+        return NULL;
+    }
+
+    filter->mode = mode;
+    filter->capacity = capacity;
+    if (capacity > 0) {
+        filter->entries = malloc((size_t)capacity * 6);
+        if (!filter->entries) {
+            free(filter);
+            return NULL;
+        }
+    }
+    return filter;
+}
+
+// Free a list
+void mac_filter_destroy(mac_filter_t *filter) {
+    if (!filter) return;
+    free(filter->entries);
+    free(filter->bloom);
+    free(filter);
+}
+
+// Add an address to a list that has not been finalized yet
+bool mac_filter_add(mac_filter_t *filter, const uint8_t *mac) {
+    if (filter->count >= filter->capacity) {
+        return false;
+    }
+    memcpy(filter->entries[filter->count++], mac, 6);
+    return true;
+}
+
+// Sort and deduplicate the list and build its Bloom filter
+void mac_filter_finalize(mac_filter_t *filter) {
+    if (filter->count == 0) {
+        return;
+    }
+
+    qsort(filter->entries, filter->count, 6, compare_macs);
+
+    uint32_t unique = 1;
+    for (uint32_t i = 1; i < filter->count; i++) {
+        if (memcmp(filter->entries[i], filter->entries[unique - 1], 6) != 0) {
+            memcpy(filter->entries[unique++], filter->entries[i], 6);
+        }
+    }
+    filter->count = unique;
+
+    // Round the Bloom filter up to a power of two so probes can be masked
+    uint32_t bits = 1024;
+    while (bits < filter->count * MAC_FILTER_BITS_PER_ENTRY) {
+        bits <<= 1;
+    }
+
+    filter->bloom = calloc(bits / 32, sizeof(uint32_t));
+    if (!filter->bloom) {
+        return; // Lookups fall back to binary search only
+    }
+    filter->bloom_bits = bits;
+
+    for (uint32_t i = 0; i < filter->count; i++) {
+        uint32_t h1 = mac_table_hash(filter->entries[i], 6);
+        uint32_t h2 = second_hash(h1);
+        for (int k = 0; k < MAC_FILTER_HASHES; k++) {
+            uint32_t bit = (h1 + k * h2) & (bits - 1);
+            filter->bloom[bit / 32] |= 1u << (bit % 32);
+        }
+    }
+}
+
+// Check whether an address is in a finalized list
+bool mac_filter_contains(mac_filter_t *filter, const uint8_t *mac) {
+    if (filter->count == 0) {
+        return false;
+    }
+
+    // Fast reject: constant cost regardless of list size
+    if (filter->bloom) {
+        uint32_t h1 = mac_table_hash(mac, 6);
+        uint32_t h2 = second_hash(h1);
+        for (int k = 0; k < MAC_FILTER_HASHES; k++) {
+            uint32_t bit = (h1 + k * h2) & (filter->bloom_bits - 1);
+            if (!(filter->bloom[bit / 32] & (1u << (bit % 32)))) {
+                filter->bloom_rejects++;
+                return false;
+            }
+        }
+    }
+
+    // Exact confirm
+    if (bsearch(mac, filter->entries, filter->count, 6, compare_macs)) {
+        filter->exact_hits++;
+        return true;
+    }
+    filter->false_positives++;
+    return false;
+}
+
+// Decide whether a frame passes the filter
+bool mac_filter_accept(mac_filter_t *filter, const frame_info_t *info) {
+    if (!filter || filter->mode == MAC_FILTER_OFF) {
+        return true;
+    }
+
+    bool listed = (info->addr2 && mac_filter_contains(filter, info->addr2)) ||
+                  (!ieee80211_is_group_addr(info->addr1) && mac_filter_contains(filter, info->addr1)) ||
+                  (info->bssid && info->bssid != info->addr1 && info->bssid != info->addr2 &&
+                   mac_filter_contains(filter, info->bssid));
+
+    return filter->mode == MAC_FILTER_WATCH ? listed : !listed;
+}
+
+// Reset a list parser
+void mac_list_parser_init(mac_list_parser_t *parser) {
+    memset(parser, 0, sizeof(*parser));
+}
+
+// Convert a hex digit, -1 if it is not one
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Digits between separators of a kind
+static uint8_t group_digits(char separator) {
+    return separator == '.' ? 4 : 2;
+}
+
+// End the current token, adding it if it was a complete MAC address
+static uint32_t end_token(mac_list_parser_t *parser, mac_filter_t *filter) {
+    uint32_t overflow = 0;
+
+    if (parser->length > 0) {
+        // A trailing separator leaves the last group empty
+        bool valid = !parser->invalid && parser->digits == 12 &&
+                     (parser->separators == 0 ||
+                      parser->separators == 12 / group_digits(parser->separator) - 1);
+        if (valid) {
+            if (!mac_filter_add(filter, parser->mac)) {
+                overflow = 1;
+            }
+        } else if (parser->digits > 0 && (parser->separators > 0 || parser->length >= 12)) {
+            parser->rejected++;
+        }
+    }
+    parser->digits = 0;
+    parser->length = 0;
+    parser->separators = 0;
+    parser->separator = 0;
+    parser->invalid = false;
+    return overflow;
+}
+
+// Feed a chunk of uploaded text into a list
+uint32_t mac_list_parse(mac_list_parser_t *parser, const char *text, size_t len, mac_filter_t *filter) {
+    if (len == 0) {
+        return end_token(parser, filter);
+    }
+
+    uint32_t overflow = 0;
+    for (size_t i = 0; i < len; i++) {
+        char c = text[i];
+        int value = hex_value(c);
+
+        if (value >= 0) {
+            if (parser->digits < 12) {
+                parser->mac[parser->digits / 2] = (parser->mac[parser->digits / 2] << 4) | value;
+                parser->digits++;
+            } else {
+                parser->invalid = true;
+            }
+        } else if (c == ':' || c == '-' || c == '.') {
+            // One kind of separator per address, each closing a full group
+            if (parser->separator == 0) {
+                parser->separator = c;
+            }
+            if (c != parser->separator ||
+                parser->digits != (parser->separators + 1) * group_digits(c)) {
+                parser->invalid = true;
+            }
+            if (parser->separators < UINT8_MAX) parser->separators++;
+        } else {
+            // Any other character ends the current token
+            overflow += end_token(parser, filter);
+            continue;
+        }
+        if (parser->length < UINT8_MAX) parser->length++;
+    }
+
+    return overflow;
+}
+
+// Get the name of a filter mode
+const char *mac_filter_mode_name(mac_filter_mode_t mode) {
+    switch (mode) {
+        case MAC_FILTER_IGNORE: return "ignore";
+        case MAC_FILTER_WATCH: return "watch";
+        default: return "off";
+    }
+}
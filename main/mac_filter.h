@@ -0,0 +1,117 @@
+#ifndef MAC_FILTER_H
+#define MAC_FILTER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "ieee80211.h"
+
+// Largest list accepted by mac_filter_create()
+#define MAC_FILTER_MAX_ENTRIES       10000
+// Bloom filter size per entry and number of probes (about 1% false positives)
+#define MAC_FILTER_BITS_PER_ENTRY    10
+#define MAC_FILTER_HASHES            4
+
+typedef enum {
+    MAC_FILTER_OFF = 0,          // Capture everything
+    MAC_FILTER_IGNORE,           // Drop frames involving a listed address
+    MAC_FILTER_WATCH,            // Only keep frames involving a listed address
+} mac_filter_mode_t;
+
+/**
+ * @brief MAC list with a Bloom filter for fast rejects and a sorted array
+ *        for exact confirmation
+ */
+typedef struct {
+    mac_filter_mode_t mode;
+    uint8_t (*entries)[6];       // Sorted, unique after mac_filter_finalize()
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t *bloom;
+    uint32_t bloom_bits;         // Power of two
+    uint32_t bloom_rejects;      // Lookups answered by the Bloom filter alone
+    uint32_t exact_hits;         // Lookups confirmed by the sorted array
+    uint32_t false_positives;    // Bloom filter hits not confirmed
+} mac_filter_t;
+
+/**
+ * @brief Incremental parser for uploaded MAC lists
+ *
+ * Accepts any text where addresses are written as aa:bb:cc:dd:ee:ff,
+ * aa-bb-cc-dd-ee-ff, aabb.ccdd.eeff or 12 plain hex digits, e.g. one per line
+ * or a JSON array of strings. A token of hex digits and separators ends at any
+ * other character; one with hex digits and either a separator or at least 12
+ * characters that is none of these forms is counted as rejected.
+ */
+typedef struct {
+    uint8_t mac[6];
+    uint8_t digits;
+    uint8_t length;              // Characters in the current token, saturating
+    uint8_t separators;          // Separators in the current token
+    char separator;              // The first one, 0 if none yet
+    bool invalid;                // Current token is not a MAC address
+    uint32_t rejected;           // Malformed addresses skipped so far
+} mac_list_parser_t;
+
+/**
+ * @brief Allocate an empty list
+ *
+ * @param mode Filter mode
+ * @param capacity Maximum number of addresses (at most MAC_FILTER_MAX_ENTRIES)
+ * @return New list, or NULL if out of memory
+ */
+mac_filter_t *mac_filter_create(mac_filter_mode_t mode, uint32_t capacity);
+
+/**
+ * @brief Free a list
+ */
+void mac_filter_destroy(mac_filter_t *filter);
+
+/**
+ * @brief Add an address to a list that has not been finalized yet
+ *
+ * @return false if the list is full
+ */
+bool mac_filter_add(mac_filter_t *filter, const uint8_t *mac);
+
+/**
+ * @brief Sort and deduplicate the list and build its Bloom filter
+ */
+void mac_filter_finalize(mac_filter_t *filter);
+
+/**
+ * @brief Check whether an address is in a finalized list
+ */
+bool mac_filter_contains(mac_filter_t *filter, const uint8_t *mac);
+
+/**
+ * @brief Decide whether a frame passes the filter
+ *
+ * The transmitter, receiver and BSSID are checked against the list.
+ */
+bool mac_filter_accept(mac_filter_t *filter, const frame_info_t *info);
+
+/**
+ * @brief Reset a list parser
+ */
+void mac_list_parser_init(mac_list_parser_t *parser);
+
+/**
+ * @brief Feed a chunk of uploaded text into a list
+ *
+ * Call once more with len 0 after the last chunk to flush the final token.
+ *
+ * @param parser Parser state carried across chunks
+ * @param text Chunk of text
+ * @param len Chunk length
+ * @param filter List to add parsed addresses to
+ * @return Number of addresses that did not fit into the list
+ */
+uint32_t mac_list_parse(mac_list_parser_t *parser, const char *text, size_t len, mac_filter_t *filter);
+
+/**
+ * @brief Get the name of a filter mode
+ */
+const char *mac_filter_mode_name(mac_filter_mode_t mode);
+
+#endif /* MAC_FILTER_H */
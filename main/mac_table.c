@@ -0,0 +1,151 @@
+#include "mac_table.h"
+#include <string.h>
+
+// Hash a MAC address (also used by the probabilistic counters)
+uint32_t mac_table_hash(const uint8_t *key, uint8_t len) {
+    uint32_t hash = 2166136261u; // FNV-1a offset basis
+    for (uint8_t i = 0; i < len; i++) {
+        hash ^= key[i];
+        hash *= 16777619u;
+    }
+
+    // Murmur3 finalizer so that low bits are usable as a bucket index
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+// Unlink a slot from the LRU list
+static void lru_unlink(mac_table_t *table, uint16_t slot) {
+    mac_table_node_t *node = &table->nodes[slot];
+
+    if (node->lru_prev != MAC_TABLE_NONE) {
+        table->nodes[node->lru_prev].lru_next = node->lru_next;
+    } else {
+        table->lru_head = node->lru_next;
+    }
+    if (node->lru_next != MAC_TABLE_NONE) {
+        table->nodes[node->lru_next].lru_prev = node->lru_prev;
+    } else {
+        table->lru_tail = node->lru_prev;
+    }
+}
+
+// Link a slot at the most recently used end of the LRU list
+static void lru_push_front(mac_table_t *table, uint16_t slot) {
+    mac_table_node_t *node = &table->nodes[slot];
+
+    node->lru_prev = MAC_TABLE_NONE;
+    node->lru_next = table->lru_head;
+    if (table->lru_head != MAC_TABLE_NONE) {
+        table->nodes[table->lru_head].lru_prev = slot;
+    } else {
+        table->lru_tail = slot;
+    }
+    table->lru_head = slot;
+}
+
+// Initialize a table over caller-provided storage
+void mac_table_init(mac_table_t *table, mac_table_node_t *nodes, uint16_t *buckets,
+                    uint16_t capacity, uint16_t bucket_count, uint8_t key_len) {
+    table->nodes = nodes;
+    table->buckets = buckets;
+    table->capacity = capacity;
+    table->bucket_count = bucket_count;
+    table->key_len = key_len > MAC_TABLE_KEY_MAX ? MAC_TABLE_KEY_MAX : key_len;
+    table->count = 0;
+    table->lru_head = MAC_TABLE_NONE;
+    table->lru_tail = MAC_TABLE_NONE;
+    table->evictions = 0;
+
+    for (uint16_t i = 0; i < bucket_count; i++) {
+        buckets[i] = MAC_TABLE_NONE;
+    }
+
+    // Chain all slots into the free list
+    memset(nodes, 0, sizeof(mac_table_node_t) * capacity);
+    for (uint16_t i = 0; i < capacity; i++) {
+        nodes[i].hash_next = (i + 1 < capacity) ? i + 1 : MAC_TABLE_NONE;
+        nodes[i].lru_prev = MAC_TABLE_NONE;
+        nodes[i].lru_next = MAC_TABLE_NONE;
+    }
+    table->free_head = capacity > 0 ? 0 : MAC_TABLE_NONE;
+}
+
+// Find the slot of a key without changing its LRU position
+int mac_table_find(const mac_table_t *table, const uint8_t *key) {
+    uint32_t bucket = mac_table_hash(key, table->key_len) & (table->bucket_count - 1);
+
+    for (uint16_t slot = table->buckets[bucket]; slot != MAC_TABLE_NONE; slot = table->nodes[slot].hash_next) {
+        if (memcmp(table->nodes[slot].key, key, table->key_len) == 0) {
+            return slot;
+        }
+    }
+
+    return -1;
+}
+
+// Remove a key from the table
+void mac_table_remove(mac_table_t *table, int slot) {
+    mac_table_node_t *node = &table->nodes[slot];
+    if (!node->in_use) {
+        return;
+    }
+
+    // Unlink from its hash chain
+    uint32_t bucket = mac_table_hash(node->key, table->key_len) & (table->bucket_count - 1);
+    uint16_t *link = &table->buckets[bucket];
+    while (*link != MAC_TABLE_NONE && *link != slot) {
+        link = &table->nodes[*link].hash_next;
+    }
+    if (*link == slot) {
+        *link = node->hash_next;
+    }
+
+    lru_unlink(table, slot);
+
+    node->in_use = false;
+    node->hash_next = table->free_head;
+    table->free_head = slot;
+    table->count--;
+}
+
+// Find or insert a key and mark it most recently used
+int mac_table_touch(mac_table_t *table, const uint8_t *key, bool *inserted) {
+    int slot = mac_table_find(table, key);
+
+    if (slot >= 0) {
+        *inserted = false;
+        if (table->lru_head != slot) {
+            lru_unlink(table, slot);
+            lru_push_front(table, slot);
+        }
+        return slot;
+    }
+
+    // Recycle the least recently used slot when full
+    if (table->free_head == MAC_TABLE_NONE) {
+        mac_table_remove(table, table->lru_tail);
+        table->evictions++;
+    }
+
+    slot = table->free_head;
+    mac_table_node_t *node = &table->nodes[slot];
+    table->free_head = node->hash_next;
+
+    memcpy(node->key, key, table->key_len);
+    node->in_use = true;
+
+    uint32_t bucket = mac_table_hash(key, table->key_len) & (table->bucket_count - 1);
+    node->hash_next = table->buckets[bucket];
+    table->buckets[bucket] = slot;
+
+    lru_push_front(table, slot);
+    table->count++;
+
+    *inserted = true;
+    return slot;
+}
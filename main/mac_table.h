@@ -0,0 +1,99 @@
+#ifndef MAC_TABLE_H
+#define MAC_TABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Longest supported key: a pair of MAC addresses
+#define MAC_TABLE_KEY_MAX    12
+#define MAC_TABLE_NONE       0xFFFF
+
+/**
+ * @brief Table node; the slot index doubles as the index into the caller's value array
+ */
+typedef struct {
+    uint8_t key[MAC_TABLE_KEY_MAX];
+    uint16_t hash_next;
+    uint16_t lru_prev;
+    uint16_t lru_next;
+    bool in_use;
+} mac_table_node_t;
+
+/**
+ * @brief Fixed-capacity hash table keyed by MAC addresses, with LRU eviction
+ *
+ * The table only manages keys and slot indexes; callers keep their values in
+ * a parallel array of the same capacity. Storage is supplied by the caller so
+ * no memory is allocated at runtime.
+ */
+typedef struct {
+    mac_table_node_t *nodes;
+    uint16_t *buckets;
+    uint16_t capacity;
+    uint16_t bucket_count;       // Must be a power of two
+    uint16_t count;
+    uint16_t lru_head;           // Most recently used
+    uint16_t lru_tail;           // Least recently used
+    uint16_t free_head;          // Chain of unused slots (through hash_next)
+    uint8_t key_len;
+    uint32_t evictions;          // Keys recycled to make room (merges add the source's)
+} mac_table_t;
+
+/**
+ * @brief Initialize a table over caller-provided storage
+ *
+ * @param table Table to initialize
+ * @param nodes Array of capacity nodes
+ * @param buckets Array of bucket_count bucket heads (power of two)
+ * @param capacity Number of slots
+ * @param bucket_count Number of hash buckets
+ * @param key_len Key length in bytes (6 for a MAC, 12 for a MAC pair)
+ */
+void mac_table_init(mac_table_t *table, mac_table_node_t *nodes, uint16_t *buckets,
+                    uint16_t capacity, uint16_t bucket_count, uint8_t key_len);
+
+/**
+ * @brief Find the slot of a key without changing its LRU position
+ *
+ * @return Slot index, or -1 if the key is not present
+ */
+int mac_table_find(const mac_table_t *table, const uint8_t *key);
+
+/**
+ * @brief Find or insert a key and mark it most recently used
+ *
+ * When the table is full, the least recently used slot is recycled and
+ * counted in evictions.
+ *
+ * @param table Table
+ * @param key Key to look up
+ * @param inserted Set to true if the slot is new (the caller must reset its value)
+ * @return Slot index
+ */
+int mac_table_touch(mac_table_t *table, const uint8_t *key, bool *inserted);
+
+/**
+ * @brief Remove a key from the table
+ */
+void mac_table_remove(mac_table_t *table, int slot);
+
+/**
+ * @brief Get the key stored in a slot
+ */
+static inline const uint8_t *mac_table_key(const mac_table_t *table, int slot) {
+    return table->nodes[slot].key;
+}
+
+/**
+ * @brief Check whether a slot holds a key
+ */
+static inline bool mac_table_in_use(const mac_table_t *table, int slot) {
+    return table->nodes[slot].in_use;
+}
+
+/**
+ * @brief Hash a MAC address (also used by the probabilistic counters)
+ */
+uint32_t mac_table_hash(const uint8_t *key, uint8_t len);
+
+#endif /* MAC_TABLE_H */
@@ -0,0 +1,69 @@
+#include "pcap.h"
+
+// Radiotap fields present: flags, rate, channel, antenna signal
+#define RADIOTAP_PRESENT        ((1 << 1) | (1 << 2) | (1 << 3) | (1 << 5))
+#define RADIOTAP_CHAN_CCK       0x0020
+#define RADIOTAP_CHAN_OFDM      0x0040
+#define RADIOTAP_CHAN_2GHZ      0x0080
+#define RADIOTAP_CHAN_5GHZ      0x0100
+
+static void put_le16(uint8_t *p, uint16_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+// Get the center frequency of a channel in MHz
+uint16_t pcap_channel_freq(uint8_t channel) {
+    if (channel == 14) {
+        return 2484;
+    }
+    if (channel < 14) {
+        return 2407 + 5 * channel;
+    }
+    return 5000 + 5 * channel;
+}
+
+// Write the pcap file header
+void pcap_global_header(uint8_t out[PCAP_GLOBAL_HEADER_LEN]) {
+    put_le32(out, 0xA1B2C3D4);        // Magic, microsecond resolution
+    put_le16(out + 4, 2);             // Version 2.4
+    put_le16(out + 6, 4);
+    put_le32(out + 8, 0);             // GMT offset
+    put_le32(out + 12, 0);            // Timestamp accuracy
+    put_le32(out + 16, PCAP_SNAPLEN);
+    put_le32(out + 20, PCAP_LINKTYPE_RADIOTAP);
+}
+
+// Write the record and radiotap headers that precede a captured frame
+size_t pcap_record_prefix(uint8_t *out, uint64_t timestamp_us, uint16_t frame_len, uint16_t orig_len,
+                          int8_t rssi, uint8_t channel, uint8_t rate) {
+    put_le32(out, (uint32_t)(timestamp_us / 1000000));
+    put_le32(out + 4, (uint32_t)(timestamp_us % 1000000));
+    put_le32(out + 8, PCAP_RADIOTAP_LEN + frame_len);
+    put_le32(out + 12, PCAP_RADIOTAP_LEN + orig_len);
+
+    uint8_t *rt = out + PCAP_RECORD_HEADER_LEN;
+    uint16_t chan_flags = channel > 14 ? RADIOTAP_CHAN_5GHZ : RADIOTAP_CHAN_2GHZ;
+    if (rate) {
+        chan_flags |= (rate == 2 || rate == 4 || rate == 11 || rate == 22) ? RADIOTAP_CHAN_CCK : RADIOTAP_CHAN_OFDM;
+    }
+
+    rt[0] = 0;                        // Version
+    rt[1] = 0;                        // Padding
+    put_le16(rt + 2, PCAP_RADIOTAP_LEN);
+    put_le32(rt + 4, RADIOTAP_PRESENT);
+    rt[8] = 0;                        // Flags: no FCS at the end
+    rt[9] = rate;
+    put_le16(rt + 10, pcap_channel_freq(channel));
+    put_le16(rt + 12, chan_flags);
+    rt[14] = (uint8_t)rssi;
+
+    return PCAP_RECORD_PREFIX_LEN;
+}
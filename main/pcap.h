@@ -0,0 +1,41 @@
+#ifndef PCAP_H
+#define PCAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Classic pcap with a minimal radiotap header in front of every frame
+#define PCAP_LINKTYPE_RADIOTAP       127
+#define PCAP_SNAPLEN                 4096
+#define PCAP_GLOBAL_HEADER_LEN       24
+#define PCAP_RECORD_HEADER_LEN       16
+#define PCAP_RADIOTAP_LEN            15
+// Record header plus radiotap header, as written by pcap_record_prefix()
+#define PCAP_RECORD_PREFIX_LEN       (PCAP_RECORD_HEADER_LEN + PCAP_RADIOTAP_LEN)
+
+/**
+ * @brief Write the pcap file header (little endian, microsecond timestamps)
+ */
+void pcap_global_header(uint8_t out[PCAP_GLOBAL_HEADER_LEN]);
+
+/**
+ * @brief Write the record and radiotap headers that precede a captured frame
+ *
+ * @param out Output buffer of PCAP_RECORD_PREFIX_LEN bytes
+ * @param timestamp_us Receive time
+ * @param frame_len Bytes of the frame that follow the prefix
+ * @param orig_len Frame length on air (without FCS)
+ * @param rssi Signal strength in dBm
+ * @param channel Channel the frame was received on
+ * @param rate Legacy rate in 500 kbps units, 0 if unknown
+ * @return PCAP_RECORD_PREFIX_LEN
+ */
+size_t pcap_record_prefix(uint8_t *out, uint64_t timestamp_us, uint16_t frame_len, uint16_t orig_len,
+                          int8_t rssi, uint8_t channel, uint8_t rate);
+
+/**
+ * @brief Get the center frequency of a channel in MHz
+ */
+uint16_t pcap_channel_freq(uint8_t channel);
+
+#endif /* PCAP_H */
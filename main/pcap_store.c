@@ -0,0 +1,295 @@
+#include "pcap_store.h"
+#include "pcap.h"
+#include "lz4_frame.h"
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Reset the ring over caller-provided memory
+void pcap_ring_init(pcap_ring_t *ring, uint8_t *memory) {
+    memset(ring, 0, sizeof(*ring));
+    ring->memory = memory;
+}
+
+// Append one record to the buffer being filled
+pcap_ring_result_t pcap_ring_append(pcap_ring_t *ring, const uint8_t *prefix, size_t prefix_len,
+                                    const uint8_t *data, size_t len, uint64_t now_us) {
+    size_t record_len = prefix_len + len;
+    pcap_ring_result_t result = PCAP_RING_APPENDED;
+
+    if (ring->full == PCAP_STORE_BUFFERS || record_len > PCAP_STORE_BUFFER_SIZE) {
+        ring->dropped_frames++;
+        ring->dropped_bytes += record_len;
+        return PCAP_RING_DROPPED;
+    }
+
+    int cur = (ring->head + ring->full) % PCAP_STORE_BUFFERS;
+    if (ring->fill[cur] + record_len > PCAP_STORE_BUFFER_SIZE) {
+        ring->full++;
+        result = PCAP_RING_SEALED;
+        if (ring->full == PCAP_STORE_BUFFERS) {
+            ring->dropped_frames++;
+            ring->dropped_bytes += record_len;
+            return PCAP_RING_DROPPED;
+        }
+        cur = (cur + 1) % PCAP_STORE_BUFFERS;
+    }
+
+    if (ring->fill[cur] == 0) {
+        ring->opened_us = now_us;
+    }
+    uint8_t *dst = ring->memory + cur * PCAP_STORE_BUFFER_SIZE + ring->fill[cur];
+    memcpy(dst, prefix, prefix_len);
+    memcpy(dst + prefix_len, data, len);
+    ring->fill[cur] += record_len;
+    ring->frames++;
+
+    return result;
+}
+
+// Seal the buffer being filled if it holds data older than a cutoff
+bool pcap_ring_seal(pcap_ring_t *ring, uint64_t older_than_us) {
+    if (ring->full == PCAP_STORE_BUFFERS) {
+        return false;
+    }
+
+    int cur = (ring->head + ring->full) % PCAP_STORE_BUFFERS;
+    if (ring->fill[cur] == 0 || ring->opened_us > older_than_us) {
+        return false;
+    }
+    ring->full++;
+    return true;
+}
+
+// Get the oldest sealed buffer
+bool pcap_ring_peek(const pcap_ring_t *ring, const uint8_t **data, size_t *len) {
+    if (ring->full == 0) {
+        return false;
+    }
+    *data = ring->memory + ring->head * PCAP_STORE_BUFFER_SIZE;
+    *len = ring->fill[ring->head];
+    return true;
+}
+
+// Return the oldest sealed buffer to the producer
+void pcap_ring_release(pcap_ring_t *ring) {
+    if (ring->full == 0) {
+        return;
+    }
+    ring->fill[ring->head] = 0;
+    ring->head = (ring->head + 1) % PCAP_STORE_BUFFERS;
+    ring->full--;
+}
+
+// Parse <prefix>_<index>.pcap[.lz4] (case-insensitive, FAT may change case)
+static bool parse_segment_name(const char *prefix, const char *name, uint32_t *index, bool *compressed) {
+    size_t prefix_len = strlen(prefix);
+    if (strncasecmp(name, prefix, prefix_len) != 0 || name[prefix_len] != '_') {
+        return false;
+    }
+
+    const char *digits = name + prefix_len + 1;
+    char *end;
+    if (*digits < '0' || *digits > '9') {
+        return false;
+    }
+    unsigned long value = strtoul(digits, &end, 10);
+    if (strcasecmp(end, ".pcap") == 0) {
+        *compressed = false;
+    } else if (strcasecmp(end, ".pcap.lz4") == 0) {
+        *compressed = true;
+    } else {
+        return false;
+    }
+    *index = (uint32_t)value;
+    return true;
+}
+
+static void segment_name(const pcap_store_t *store, uint32_t index, bool compressed, char *name, size_t len) {
+    snprintf(name, len, "%s_%05lu.pcap%s", store->config.prefix, (unsigned long)index, compressed ? ".lz4" : "");
+}
+
+static void segment_path(const pcap_store_t *store, uint32_t index, bool compressed, char *path, size_t len) {
+    char name[PCAP_STORE_MAX_NAME];
+    segment_name(store, index, compressed, name, sizeof(name));
+    snprintf(path, len, "%s/%s", store->config.dir, name);
+}
+
+// Start a store, continuing the numbering of segments already in the directory
+bool pcap_store_open(pcap_store_t *store, const pcap_store_config_t *config) {
+    memset(store, 0, sizeof(*store));
+    store->config = *config;
+    if (store->config.max_files < 2) {
+        store->config.max_files = 2;
+    }
+
+    DIR *dir = opendir(store->config.dir);
+    if (!dir) {
+        return false;
+    }
+
+    bool found = false;
+    uint32_t lowest = 0, highest = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        uint32_t index;
+        bool compressed;
+        if (!parse_segment_name(store->config.prefix, entry->d_name, &index, &compressed)) {
+            continue;
+        }
+        if (!found || index < lowest) lowest = index;
+        if (!found || index > highest) highest = index;
+        found = true;
+    }
+    closedir(dir);
+
+    if (found) {
+        store->first_index = lowest;
+        store->next_index = highest + 1;
+    }
+    return true;
+}
+
+// Close the current segment
+void pcap_store_close(pcap_store_t *store) {
+    if (store->file) {
+        if (store->config.compress) {
+            uint8_t end[LZ4_FRAME_END_LEN];
+            if (fwrite(end, 1, lz4_frame_end(end), store->file) != sizeof(end)) {
+                store->write_errors++;
+            }
+        }
+        fclose(store->file);
+        store->file = NULL;
+    }
+}
+
+// Open the next segment, deleting the oldest ones beyond the retention limit
+static bool open_segment(pcap_store_t *store, uint64_t now_us) {
+    char path[PCAP_STORE_MAX_PATH];
+
+    while (store->next_index - store->first_index >= store->config.max_files) {
+        // The compression setting may have changed since it was written
+        uint32_t index = store->first_index++;
+        segment_path(store, index, false, path, sizeof(path));
+        int result = remove(path);
+        segment_path(store, index, true, path, sizeof(path));
+        if (result == 0 || remove(path) == 0) {
+            store->removed++;
+        }
+    }
+
+    segment_path(store, store->next_index, store->config.compress, path, sizeof(path));
+    store->file = fopen(path, "wb");
+    if (!store->file) {
+        store->write_errors++;
+        return false;
+    }
+    store->next_index++;
+    store->segments++;
+
+    // Whole buffers are written at once; stdio buffering would only add a copy
+    setvbuf(store->file, NULL, _IONBF, 0);
+
+    // The pcap header goes in a stored block of its own in compressed segments
+    uint8_t header[LZ4_FRAME_HEADER_LEN + LZ4_FRAME_BLOCK_BOUND(PCAP_GLOBAL_HEADER_LEN)];
+    size_t header_len = 0;
+    uint8_t pcap_header[PCAP_GLOBAL_HEADER_LEN];
+    pcap_global_header(pcap_header);
+    if (store->config.compress) {
+        header_len = lz4_frame_header(header);
+        header_len += lz4_frame_stored(pcap_header, sizeof(pcap_header), header + header_len);
+    } else {
+        memcpy(header, pcap_header, sizeof(pcap_header));
+        header_len = sizeof(pcap_header);
+    }
+
+    if (fwrite(header, 1, header_len, store->file) != header_len) {
+        store->write_errors++;
+        fclose(store->file);
+        store->file = NULL;
+        return false;
+    }
+    store->segment_header_bytes = header_len;
+    store->segment_bytes = header_len;
+    store->segment_start_us = now_us;
+    store->bytes += header_len;
+    return true;
+}
+
+// Write whole records, rotating segments first if a limit is reached
+bool pcap_store_write(pcap_store_t *store, const uint8_t *data, size_t len, uint64_t now_us) {
+    if (store->file) {
+        bool full = store->segment_bytes + len > store->config.max_segment_bytes &&
+                    store->segment_bytes > store->segment_header_bytes;
+        bool old = store->config.max_segment_ms &&
+                   now_us - store->segment_start_us >= (uint64_t)store->config.max_segment_ms * 1000;
+        if (full || old) {
+            pcap_store_close(store);
+        }
+    }
+
+    if (!store->file && !open_segment(store, now_us)) {
+        return false;
+    }
+
+    if (fwrite(data, 1, len, store->file) != len) {
+        store->write_errors++;
+        pcap_store_close(store);
+        return false;
+    }
+    store->segment_bytes += len;
+    store->bytes += len;
+    return true;
+}
+
+// Flush the current segment to the medium
+void pcap_store_sync(pcap_store_t *store) {
+    if (store->file) {
+        fflush(store->file);
+        fsync(fileno(store->file));
+    }
+}
+
+// List the retained segments, oldest first
+int pcap_store_list(const pcap_store_t *store, pcap_segment_t *out, int max_segments) {
+    int count = 0;
+    char path[PCAP_STORE_MAX_PATH];
+
+    for (uint32_t index = store->first_index; index != store->next_index && count < max_segments; index++) {
+        // Look for the current format first, then the other one
+        for (int i = 0; i < 2; i++) {
+            bool compressed = store->config.compress != (i == 1);
+            struct stat st;
+            segment_path(store, index, compressed, path, sizeof(path));
+            if (stat(path, &st) != 0) {
+                continue;
+            }
+
+            pcap_segment_t *segment = &out[count++];
+            segment_name(store, index, compressed, segment->name, sizeof(segment->name));
+            segment->index = index;
+            segment->size = (uint32_t)st.st_size;
+            segment->compressed = compressed;
+            segment->active = store->file && index == store->next_index - 1;
+            break;
+        }
+    }
+
+    return count;
+}
+
+// Build the path of a segment from its name
+bool pcap_store_path(const pcap_store_t *store, const char *name, char *path, size_t path_len, uint32_t *index) {
+    bool compressed;
+
+    // Only names of this store's own segments, so no path can escape the directory
+    if (strchr(name, '/') || !parse_segment_name(store->config.prefix, name, index, &compressed)) {
+        return false;
+    }
+    segment_path(store, *index, compressed, path, path_len);
+    return true;
+}
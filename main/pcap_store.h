@@ -0,0 +1,163 @@
+#ifndef PCAP_STORE_H
+#define PCAP_STORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Write-behind buffers; a multiple of the 4 KB flash sector so every
+// flush writes whole sectors
+#define PCAP_STORE_BUFFER_SIZE       8192
+#define PCAP_STORE_BUFFERS           4
+// Segment names are <prefix>_<index>.pcap, or .pcap.lz4 when compressed
+#define PCAP_STORE_MAX_DIR           32
+#define PCAP_STORE_MAX_PREFIX        16
+#define PCAP_STORE_MAX_NAME          (PCAP_STORE_MAX_PREFIX + 24)
+#define PCAP_STORE_MAX_PATH          (PCAP_STORE_MAX_DIR + PCAP_STORE_MAX_NAME + 2)
+
+/**
+ * @brief Result of appending a record to the ring
+ */
+typedef enum {
+    PCAP_RING_APPENDED = 0,
+    PCAP_RING_SEALED,            // Appended, and a buffer is now ready to be written
+    PCAP_RING_DROPPED,           // Every buffer is waiting for the writer
+} pcap_ring_result_t;
+
+/**
+ * @brief Ring of fixed-size buffers between the RX path and the flash writer
+ *
+ * The producer fills buffer (head + full) while the writer drains buffer
+ * head; sealed buffers are never touched by the producer, so only the
+ * index updates need the caller's lock.
+ */
+typedef struct {
+    uint8_t *memory;             // PCAP_STORE_BUFFERS * PCAP_STORE_BUFFER_SIZE bytes
+    uint16_t fill[PCAP_STORE_BUFFERS];
+    uint64_t opened_us;          // When the buffer being filled got its first record
+    uint8_t head;                // Oldest sealed buffer
+    uint8_t full;                // Sealed buffers waiting for the writer
+    uint32_t frames;
+    uint32_t dropped_frames;
+    uint64_t dropped_bytes;
+} pcap_ring_t;
+
+/**
+ * @brief Segment rotation and retention
+ */
+typedef struct {
+    char dir[PCAP_STORE_MAX_DIR];
+    char prefix[PCAP_STORE_MAX_PREFIX];
+    uint32_t max_segment_bytes;  // Rotate once a segment reaches this size
+    uint32_t max_segment_ms;     // Rotate once a segment is this old (0 = never)
+    uint16_t max_files;          // Oldest segments are deleted beyond this count
+    bool compress;               // Segments are LZ4 frames; writes are lz4_frame_block() output
+} pcap_store_config_t;
+
+/**
+ * @brief Rotating pcap segment writer
+ */
+typedef struct {
+    pcap_store_config_t config;
+    FILE *file;                  // Segment being written, NULL between segments
+    uint32_t first_index;        // Oldest retained segment
+    uint32_t next_index;         // Index of the next segment to open
+    uint32_t segment_bytes;
+    uint32_t segment_header_bytes;
+    uint64_t segment_start_us;
+    uint32_t segments;           // Segments opened since pcap_store_open()
+    uint32_t removed;            // Segments deleted by retention
+    uint64_t bytes;
+    uint32_t write_errors;
+} pcap_store_t;
+
+/**
+ * @brief Size and name of a stored segment
+ */
+typedef struct {
+    char name[PCAP_STORE_MAX_NAME];
+    uint32_t index;
+    uint32_t size;
+    bool compressed;
+    bool active;                 // Currently being written
+} pcap_segment_t;
+
+/**
+ * @brief Reset the ring over caller-provided memory
+ *
+ * @param memory PCAP_STORE_BUFFERS * PCAP_STORE_BUFFER_SIZE bytes
+ */
+void pcap_ring_init(pcap_ring_t *ring, uint8_t *memory);
+
+/**
+ * @brief Append one record (prefix and frame) to the buffer being filled
+ *
+ * Records never straddle buffers; a record that does not fit seals the
+ * current buffer and goes into the next one.
+ */
+pcap_ring_result_t pcap_ring_append(pcap_ring_t *ring, const uint8_t *prefix, size_t prefix_len,
+                                    const uint8_t *data, size_t len, uint64_t now_us);
+
+/**
+ * @brief Seal the buffer being filled if it holds data older than a cutoff
+ *
+ * @return true if a buffer was sealed
+ */
+bool pcap_ring_seal(pcap_ring_t *ring, uint64_t older_than_us);
+
+/**
+ * @brief Get the oldest sealed buffer
+ *
+ * @return false if no buffer is waiting
+ */
+bool pcap_ring_peek(const pcap_ring_t *ring, const uint8_t **data, size_t *len);
+
+/**
+ * @brief Return the oldest sealed buffer to the producer
+ */
+void pcap_ring_release(pcap_ring_t *ring);
+
+/**
+ * @brief Start a store, continuing the numbering of segments already in the directory
+ *
+ * @return false if the directory cannot be read
+ */
+bool pcap_store_open(pcap_store_t *store, const pcap_store_config_t *config);
+
+/**
+ * @brief Write whole records, rotating segments first if a limit is reached
+ *
+ * With compression enabled, data must be whole blocks from lz4_frame_block()
+ * and the size limit applies to the compressed size.
+ *
+ * @return false on a write error (counted; the segment is closed)
+ */
+bool pcap_store_write(pcap_store_t *store, const uint8_t *data, size_t len, uint64_t now_us);
+
+/**
+ * @brief Flush the current segment to the medium
+ */
+void pcap_store_sync(pcap_store_t *store);
+
+/**
+ * @brief Close the current segment
+ */
+void pcap_store_close(pcap_store_t *store);
+
+/**
+ * @brief List the retained segments, oldest first
+ *
+ * @return Number of segments written to out
+ */
+int pcap_store_list(const pcap_store_t *store, pcap_segment_t *out, int max_segments);
+
+/**
+ * @brief Build the path of a segment from its name
+ *
+ * @param index Receives the segment index
+ * @return false if the name is not one of this store's segments
+ */
+bool pcap_store_path(const pcap_store_t *store, const char *name, char *path, size_t path_len, uint32_t *index);
+
+#endif /* PCAP_STORE_H */
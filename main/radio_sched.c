@@ -0,0 +1,529 @@
+#include "radio_sched.h"
+#include "wifi_sniffer.h"
+#include "board_config.h"
+#include "sdkconfig.h"
+#include "esp_wifi.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "radio_sched";
+
+// Scheduler task settings; above the exporters so slices start on time
+#define SCHED_TASK_STACK        4096
+#define SCHED_TASK_PRIORITY     6
+// How often a parked radio rechecks the softAP stations
+#define SCHED_PARK_POLL_MS      250
+// Dwell per scanned channel; slices scan as many channels as fit
+#define SCAN_CHANNEL_MIN_MS     50
+#define SCAN_CHANNEL_MAX_MS     100
+
+static const uint8_t hop_channels[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13};
+static const uint8_t scan_channels[] = {
+    1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13,
+#if CONFIG_SOC_WIFI_SUPPORT_5G
+    36, 40, 44, 48, 52, 56, 60, 64, 100, 104, 108, 112, 116, 120, 124, 128,
+    132, 136, 140, 144, 149, 153, 157, 161, 165,
+#endif
+};
+#define HOP_CHANNEL_COUNT   (sizeof(hop_channels) / sizeof(hop_channels[0]))
+#define SCAN_CHANNEL_COUNT  (sizeof(scan_channels) / sizeof(scan_channels[0]))
+
+static const char *client_names[RADIO_CLIENT_COUNT] = {
+    [RADIO_CLIENT_AP]      = "ap",
+    [RADIO_CLIENT_SCAN]    = "scan",
+    [RADIO_CLIENT_SNIFFER] = "sniffer",
+};
+
+static portMUX_TYPE sched_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t sched_task_handle = NULL;
+// Set while one caller creates the task, so no other caller creates a second
+static bool sched_starting = false;
+static radio_sched_config_t sched_config = {
+    .share_pct = {
+        [RADIO_CLIENT_AP]      = RADIO_SCHED_DEFAULT_AP_PCT,
+        [RADIO_CLIENT_SCAN]    = RADIO_SCHED_DEFAULT_SCAN_PCT,
+        [RADIO_CLIENT_SNIFFER] = RADIO_SCHED_DEFAULT_SNIFF_PCT,
+    },
+    .period_ms = RADIO_SCHED_DEFAULT_PERIOD_MS,
+};
+static radio_sched_status_t sched_status = {
+    .current = RADIO_CLIENT_COUNT,
+};
+
+// Sniffer registration; hop state restarts with every registration
+static bool sniffing = false;
+static uint8_t sniffer_channel = 0;
+static bool sniffer_changed = false;
+
+// Scan job, under sched_lock; the task fills the records while it is pending,
+// then they stay for the caller until the next job starts
+static struct {
+    uint32_t id;
+    bool pending;
+    bool done;
+    esp_err_t result;
+    uint8_t next;                // Next index into scan_channels
+    uint16_t count;
+} scan_job;
+// Allocated with the first job and reused by every later one
+static wifi_ap_record_t *scan_records = NULL;
+
+// Owned by the task
+static uint8_t tuned_channel = 0;
+static uint8_t hop_index = 0;
+static uint32_t hop_left_ms = 0;
+
+// Hold the radio for a while; returns true if the schedule changed meanwhile
+static bool hold(uint32_t ms) {
+    TickType_t ticks = pdMS_TO_TICKS(ms);
+    return ulTaskNotifyTake(pdTRUE, ticks ? ticks : 1) != 0;
+}
+
+// Wake the task so it re-plans the current period
+static void notify_task(void) {
+    portENTER_CRITICAL(&sched_lock);
+    TaskHandle_t task = sched_task_handle;
+    portEXIT_CRITICAL(&sched_lock);
+    if (task) {
+        xTaskNotifyGive(task);
+    }
+}
+
+// Move the radio, telling the sniffer where it now listens
+static bool tune(uint8_t channel) {
+    if (channel == tuned_channel) {
+        return true;
+    }
+
+    esp_err_t err = esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
+    if (err != ESP_OK) {
+        ESP_LOGD(TAG, "Failed to tune to channel %d: %s", channel, esp_err_to_name(err));
+        portENTER_CRITICAL(&sched_lock);
+        sched_status.switch_failures++;
+        portEXIT_CRITICAL(&sched_lock);
+        return false;
+    }
+
+    tuned_channel = channel;
+    portENTER_CRITICAL(&sched_lock);
+    sched_status.switches++;
+    sched_status.channel = channel;
+    portEXIT_CRITICAL(&sched_lock);
+    wifi_sniffer_radio_tuned(channel);
+    return true;
+}
+
+// Count the stations on the softAP; the AP only needs air time while it serves someone
+static uint8_t ap_station_count(void) {
+    wifi_sta_list_t list;
+    if (esp_wifi_ap_get_sta_list(&list) != ESP_OK) {
+        return 0;
+    }
+    return list.num;
+}
+
+// Add the driver's scan results to the first count records, keeping one per
+// BSSID; returns the new count
+static uint16_t collect_scan_results(uint16_t count) {
+    uint16_t found = 0;
+    esp_wifi_scan_get_ap_num(&found);
+
+    uint16_t room = RADIO_SCAN_MAX_APS - count;
+    if (found == 0 || room == 0) {
+        esp_wifi_clear_ap_list();
+        return count;
+    }
+    uint16_t n = found < room ? found : room;
+    wifi_ap_record_t *fresh = &scan_records[count];
+    if (esp_wifi_scan_get_ap_records(&n, fresh) != ESP_OK) {
+        return count;
+    }
+
+    // Adjacent 2.4 GHz channels often report the same BSS twice
+    for (uint16_t i = 0; i < n; i++) {
+        bool duplicate = false;
+        for (uint16_t j = 0; j < count; j++) {
+            if (memcmp(scan_records[j].bssid, fresh[i].bssid, 6) == 0) {
+                if (fresh[i].rssi > scan_records[j].rssi) {
+                    scan_records[j] = fresh[i];
+                }
+                duplicate = true;
+                break;
+            }
+        }
+        if (!duplicate) {
+            scan_records[count++] = fresh[i];
+        }
+    }
+    return count;
+}
+
+// Scan as many channels as fit in the slice (at least one)
+static void scan_slice(uint32_t slice_ms) {
+    int64_t end_us = esp_timer_get_time() + (int64_t)slice_ms * 1000;
+    esp_err_t err = ESP_OK;
+    uint32_t scanned = 0;
+
+    // The driver moves the radio itself; the sniffer's dwell ends here
+    wifi_sniffer_radio_tuned(0);
+    tuned_channel = 0;
+    portENTER_CRITICAL(&sched_lock);
+    sched_status.channel = 0;
+    uint8_t next = scan_job.next;
+    uint16_t count = scan_job.count;
+    portEXIT_CRITICAL(&sched_lock);
+
+    do {
+        wifi_scan_config_t scan_config = {
+            .ssid = NULL,
+            .bssid = NULL,
+            .channel = scan_channels[next],
+            .show_hidden = true,
+            .scan_type = WIFI_SCAN_TYPE_ACTIVE,
+            .scan_time.active.min = SCAN_CHANNEL_MIN_MS,
+            .scan_time.active.max = SCAN_CHANNEL_MAX_MS,
+            .scan_time.passive = SCAN_CHANNEL_MAX_MS,
+        };
+        err = esp_wifi_scan_start(&scan_config, true);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Scan of channel %d failed: %s", scan_config.channel, esp_err_to_name(err));
+            break;
+        }
+        count = collect_scan_results(count);
+        next++;
+        scanned++;
+
+        // Progress is visible to callers polling the job
+        portENTER_CRITICAL(&sched_lock);
+        scan_job.next = next;
+        scan_job.count = count;
+        portEXIT_CRITICAL(&sched_lock);
+    } while (next < SCAN_CHANNEL_COUNT &&
+             esp_timer_get_time() + SCAN_CHANNEL_MAX_MS * 1000 <= end_us);
+
+    bool finished = err != ESP_OK || next >= SCAN_CHANNEL_COUNT;
+    if (finished && err == ESP_OK) {
+        // Keep the evil-twin index current with every scan
+        wifi_sniffer_observe_scan(scan_records, count);
+    }
+
+    portENTER_CRITICAL(&sched_lock);
+    sched_status.scan_channels += scanned;
+    if (finished) {
+        scan_job.result = err;
+        scan_job.pending = false;
+        scan_job.done = true;
+        sched_status.scans++;
+        sched_status.scan_pending = false;
+    }
+    portEXIT_CRITICAL(&sched_lock);
+}
+
+// Dwell on the sniffer's channel, or hop, carrying partial dwells over to the next slice
+static void sniff_slice(uint8_t channel, uint32_t slice_ms) {
+    if (channel) {
+        tune(channel);
+        hold(slice_ms);
+        return;
+    }
+
+    int64_t end_us = esp_timer_get_time() + (int64_t)slice_ms * 1000;
+    for (;;) {
+        if (hop_left_ms == 0) {
+            hop_index = (hop_index + 1) % HOP_CHANNEL_COUNT;
+            hop_left_ms = RADIO_SCHED_HOP_DWELL_MS;
+        }
+        tune(hop_channels[hop_index]);
+
+        int64_t now_us = esp_timer_get_time();
+        uint32_t remaining_ms = now_us < end_us ? (end_us - now_us) / 1000 : 0;
+        if (remaining_ms == 0) {
+            break;
+        }
+        uint32_t dwell_ms = hop_left_ms < remaining_ms ? hop_left_ms : remaining_ms;
+        bool changed = hold(dwell_ms);
+        uint32_t used_ms = (esp_timer_get_time() - now_us) / 1000;
+        hop_left_ms = used_ms < hop_left_ms ? hop_left_ms - used_ms : 0;
+        if (changed) {
+            break;
+        }
+    }
+}
+
+// Charge a slice to a client
+static void account(radio_client_t client, int64_t start_us) {
+    uint64_t ms = (esp_timer_get_time() - start_us) / 1000;
+    portENTER_CRITICAL(&sched_lock);
+    if (client < RADIO_CLIENT_COUNT) {
+        sched_status.granted_ms[client] += ms;
+        sched_status.slices[client]++;
+    } else {
+        sched_status.parked_ms += ms;
+    }
+    portEXIT_CRITICAL(&sched_lock);
+}
+
+static void set_current(radio_client_t client) {
+    portENTER_CRITICAL(&sched_lock);
+    sched_status.current = client;
+    portEXIT_CRITICAL(&sched_lock);
+}
+
+// Scheduler task: the only place that moves the radio
+static void radio_sched_task(void *pvParameters) {
+    (void)pvParameters;
+    ESP_LOGI(TAG, "Radio scheduler started, home channel %d", DEFAULT_WIFI_CHANNEL);
+
+    for (;;) {
+        uint8_t stations = ap_station_count();
+
+        portENTER_CRITICAL(&sched_lock);
+        radio_sched_config_t config = sched_config;
+        if (scan_job.pending && config.share_pct[RADIO_CLIENT_SCAN] == 0) {
+            // The scan share was taken away: end the job rather than leave it queued
+            scan_job.result = ESP_ERR_INVALID_STATE;
+            scan_job.pending = false;
+            scan_job.done = true;
+            sched_status.scan_pending = false;
+        }
+        bool want[RADIO_CLIENT_COUNT] = {
+            [RADIO_CLIENT_AP]      = stations > 0,
+            [RADIO_CLIENT_SCAN]    = scan_job.pending,
+            [RADIO_CLIENT_SNIFFER] = sniffing,
+        };
+        uint8_t channel = sniffer_channel;
+        if (sniffer_changed) {
+            // A new capture needs its first dwell even if the radio is already there
+            hop_index = HOP_CHANNEL_COUNT - 1;
+            hop_left_ms = 0;
+            tuned_channel = 0;
+            sniffer_changed = false;
+        }
+        sched_status.ap_stations = stations;
+        portEXIT_CRITICAL(&sched_lock);
+
+        uint32_t total = 0;
+        for (int c = 0; c < RADIO_CLIENT_COUNT; c++) {
+            if (!want[c] || config.share_pct[c] == 0) {
+                want[c] = false;
+                continue;
+            }
+            total += config.share_pct[c];
+        }
+
+        // Nobody but the AP wants the radio: park on the home channel
+        if (!want[RADIO_CLIENT_SCAN] && !want[RADIO_CLIENT_SNIFFER]) {
+            int64_t start_us = esp_timer_get_time();
+            set_current(RADIO_CLIENT_COUNT);
+            tune(DEFAULT_WIFI_CHANNEL);
+            hold(SCHED_PARK_POLL_MS);
+            account(RADIO_CLIENT_COUNT, start_us);
+            continue;
+        }
+
+        for (int c = 0; c < RADIO_CLIENT_COUNT; c++) {
+            if (!want[c]) continue;
+            uint32_t slice_ms = (uint32_t)config.period_ms * config.share_pct[c] / total;
+            int64_t start_us = esp_timer_get_time();
+
+            set_current(c);
+            switch (c) {
+                case RADIO_CLIENT_AP:
+                    tune(DEFAULT_WIFI_CHANNEL);
+                    hold(slice_ms);
+                    break;
+                case RADIO_CLIENT_SCAN:
+                    scan_slice(slice_ms);
+                    break;
+                case RADIO_CLIENT_SNIFFER:
+                    sniff_slice(channel, slice_ms);
+                    break;
+            }
+            account(c, start_us);
+        }
+    }
+}
+
+// Switch to APSTA and create the task; only the caller that claimed the start runs this
+static bool start_task(void) {
+    // Scans need the station interface and the softAP must stay up
+    wifi_mode_t mode;
+    if (esp_wifi_get_mode(&mode) == ESP_OK && mode != WIFI_MODE_APSTA) {
+        esp_err_t err = esp_wifi_set_mode(WIFI_MODE_APSTA);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to set APSTA mode: %s", esp_err_to_name(err));
+            return false;
+        }
+    }
+
+    TaskHandle_t task = NULL;
+    if (xTaskCreate(radio_sched_task, "radio_sched", SCHED_TASK_STACK, NULL, SCHED_TASK_PRIORITY,
+                    &task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create radio scheduler task");
+        return false;
+    }
+    portENTER_CRITICAL(&sched_lock);
+    sched_task_handle = task;
+    portEXIT_CRITICAL(&sched_lock);
+    return true;
+}
+
+// Start the scheduler task on first use; callers racing the first one wait for it
+static bool ensure_started(void) {
+    for (;;) {
+        portENTER_CRITICAL(&sched_lock);
+        bool running = sched_task_handle != NULL;
+        bool claimed = !running && !sched_starting;
+        if (claimed) {
+            sched_starting = true;
+        }
+        portEXIT_CRITICAL(&sched_lock);
+        if (running) {
+            return true;
+        }
+        if (claimed) {
+            break;
+        }
+        vTaskDelay(1);
+    }
+
+    bool started = start_task();
+    portENTER_CRITICAL(&sched_lock);
+    sched_starting = false;
+    portEXIT_CRITICAL(&sched_lock);
+    return started;
+}
+
+// Get the duty ratios
+void radio_sched_get_config(radio_sched_config_t *config) {
+    portENTER_CRITICAL(&sched_lock);
+    *config = sched_config;
+    portEXIT_CRITICAL(&sched_lock);
+}
+
+// Set the duty ratios
+bool radio_sched_set_config(const radio_sched_config_t *config) {
+    uint32_t sum = 0;
+    for (int c = 0; c < RADIO_CLIENT_COUNT; c++) {
+        sum += config->share_pct[c];
+    }
+    if (sum != 100 || config->period_ms < RADIO_SCHED_MIN_PERIOD_MS ||
+        config->period_ms > RADIO_SCHED_MAX_PERIOD_MS) {
+        return false;
+    }
+
+    portENTER_CRITICAL(&sched_lock);
+    sched_config = *config;
+    portEXIT_CRITICAL(&sched_lock);
+    notify_task();
+    return true;
+}
+
+// Give the sniffer its share of the radio
+bool radio_sched_set_sniffer(uint8_t channel) {
+    if (!ensure_started()) {
+        return false;
+    }
+
+    portENTER_CRITICAL(&sched_lock);
+    sniffing = true;
+    sniffer_channel = channel;
+    sniffer_changed = true;
+    sched_status.sniffing = true;
+    sched_status.sniffer_channel = channel;
+    portEXIT_CRITICAL(&sched_lock);
+    notify_task();
+    return true;
+}
+
+// Withdraw the sniffer from the schedule
+void radio_sched_release_sniffer(void) {
+    portENTER_CRITICAL(&sched_lock);
+    sniffing = false;
+    sched_status.sniffing = false;
+    portEXIT_CRITICAL(&sched_lock);
+    notify_task();
+}
+
+// Queue a scan of all channels without waiting for it
+esp_err_t radio_sched_scan_start(uint32_t *job) {
+    if (!ensure_started()) {
+        return ESP_FAIL;
+    }
+    portENTER_CRITICAL(&sched_lock);
+    bool allocated = scan_records != NULL;
+    portEXIT_CRITICAL(&sched_lock);
+    if (!allocated) {
+        // Two first jobs may both allocate; the loser frees its copy
+        wifi_ap_record_t *records = malloc(sizeof(wifi_ap_record_t) * RADIO_SCAN_MAX_APS);
+        if (!records) {
+            return ESP_ERR_NO_MEM;
+        }
+        portENTER_CRITICAL(&sched_lock);
+        if (!scan_records) {
+            scan_records = records;
+            records = NULL;
+        }
+        portEXIT_CRITICAL(&sched_lock);
+        free(records);
+    }
+
+    esp_err_t err = ESP_OK;
+    portENTER_CRITICAL(&sched_lock);
+    if (sched_config.share_pct[RADIO_CLIENT_SCAN] == 0) {
+        err = ESP_ERR_INVALID_STATE;
+    } else if (!scan_job.pending) {
+        uint32_t id = scan_job.id + 1;
+        memset(&scan_job, 0, sizeof(scan_job));
+        scan_job.id = id;
+        scan_job.pending = true;
+        sched_status.scan_pending = true;
+    }
+    *job = scan_job.id;
+    portEXIT_CRITICAL(&sched_lock);
+
+    if (err == ESP_OK) {
+        notify_task();
+    }
+    return err;
+}
+
+// Get the progress of a scan job, and its results once it is done
+bool radio_sched_scan_get(uint32_t job, radio_scan_status_t *status, wifi_ap_record_t *records) {
+    portENTER_CRITICAL(&sched_lock);
+    bool known = job != 0 && job == scan_job.id;
+    if (known) {
+        status->job = job;
+        status->done = scan_job.done;
+        status->result = scan_job.result;
+        status->channels_scanned = scan_job.next;
+        status->channels_total = SCAN_CHANNEL_COUNT;
+        status->count = scan_job.count;
+    }
+    portEXIT_CRITICAL(&sched_lock);
+
+    if (!known) {
+        return false;
+    }
+    // Once done the task no longer writes the records
+    if (status->done && records) {
+        memcpy(records, scan_records, sizeof(wifi_ap_record_t) * status->count);
+    }
+    return true;
+}
+
+// Get the time split and the current state
+void radio_sched_get_status(radio_sched_status_t *status) {
+    portENTER_CRITICAL(&sched_lock);
+    *status = sched_status;
+    portEXIT_CRITICAL(&sched_lock);
+}
+
+// Get the name of a client
+const char *radio_sched_client_name(radio_client_t client) {
+    return client < RADIO_CLIENT_COUNT ? client_names[client] : "parked";
+}
@@ -0,0 +1,143 @@
+#ifndef RADIO_SCHED_H
+#define RADIO_SCHED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+
+// Default split of each scheduling period, in percent
+#define RADIO_SCHED_DEFAULT_AP_PCT       20
+#define RADIO_SCHED_DEFAULT_SCAN_PCT     30
+#define RADIO_SCHED_DEFAULT_SNIFF_PCT    50
+#define RADIO_SCHED_DEFAULT_PERIOD_MS    500
+#define RADIO_SCHED_MIN_PERIOD_MS        100
+#define RADIO_SCHED_MAX_PERIOD_MS        5000
+// Dwell per channel while the sniffer hops
+#define RADIO_SCHED_HOP_DWELL_MS         200
+// Most APs one scan collects
+#define RADIO_SCAN_MAX_APS               64
+
+/**
+ * @brief Users of the radio
+ */
+typedef enum {
+    RADIO_CLIENT_AP = 0,         // SoftAP service on its home channel
+    RADIO_CLIENT_SCAN,           // Scan jobs
+    RADIO_CLIENT_SNIFFER,        // Sniffer dwell
+    RADIO_CLIENT_COUNT
+} radio_client_t;
+
+/**
+ * @brief Duty ratios of the radio
+ *
+ * Each period is split between the clients that currently want the radio,
+ * in proportion to their shares. The AP only competes while stations are
+ * associated; with nobody else asking the radio parks on the home channel.
+ */
+typedef struct {
+    uint8_t share_pct[RADIO_CLIENT_COUNT];   // Sums to 100
+    uint16_t period_ms;
+} radio_sched_config_t;
+
+/**
+ * @brief How the radio's time was split since boot
+ */
+typedef struct {
+    uint64_t granted_ms[RADIO_CLIENT_COUNT];
+    uint32_t slices[RADIO_CLIENT_COUNT];
+    uint64_t parked_ms;          // On the home channel with nobody competing
+    uint32_t switches;           // Channel changes
+    uint32_t switch_failures;
+    uint32_t scans;              // Scan jobs completed
+    uint32_t scan_channels;      // Channels scanned
+    radio_client_t current;      // Client holding the radio (RADIO_CLIENT_COUNT when parked)
+    uint8_t channel;             // Channel the radio is tuned to, 0 while scanning
+    uint8_t sniffer_channel;     // Sniffer channel, 0 when hopping
+    bool sniffing;
+    bool scan_pending;
+    uint8_t ap_stations;         // Stations on the softAP at the last check
+} radio_sched_status_t;
+
+/**
+ * @brief Progress of a scan job
+ */
+typedef struct {
+    uint32_t job;                // Job id, counting from 1 since boot
+    bool done;
+    esp_err_t result;            // Valid once done
+    uint8_t channels_scanned;
+    uint8_t channels_total;
+    uint16_t count;              // APs found so far
+} radio_scan_status_t;
+
+/**
+ * @brief Get the duty ratios
+ */
+void radio_sched_get_config(radio_sched_config_t *config);
+
+/**
+ * @brief Set the duty ratios
+ *
+ * @return false if the shares do not sum to 100 or the period is out of range
+ */
+bool radio_sched_set_config(const radio_sched_config_t *config);
+
+/**
+ * @brief Give the sniffer its share of the radio
+ *
+ * Hopping covers channels 1-13 only, while scans also cover the 5 GHz
+ * channels where the chip supports them: the per-channel analytics (air
+ * time, unique counts, sequence gaps) keep 16 channels each, fewer than
+ * the 2.4 and 5 GHz channels together. A 5 GHz channel can still be
+ * sniffed as a fixed channel.
+ *
+ * @param channel Channel to dwell on, 0 to hop over channels 1-13
+ * @return false if the scheduler could not be started
+ */
+bool radio_sched_set_sniffer(uint8_t channel);
+
+/**
+ * @brief Withdraw the sniffer from the schedule
+ */
+void radio_sched_release_sniffer(void);
+
+/**
+ * @brief Queue a scan of all channels without waiting for it
+ *
+ * The scheduler scans a few channels per slice, so a scan takes several
+ * periods. If a scan is already running its id is returned instead of
+ * starting another. The results of the last job are kept until the next
+ * one starts.
+ *
+ * @param job Set to the id of the queued or running job
+ * @return ESP_OK, ESP_ERR_INVALID_STATE if the scan share is 0,
+ *         ESP_ERR_NO_MEM, or ESP_FAIL if the scheduler could not be started
+ */
+esp_err_t radio_sched_scan_start(uint32_t *job);
+
+/**
+ * @brief Get the progress of a scan job, and its results once it is done
+ *
+ * Call from one task at a time: a job started meanwhile reuses the buffer
+ * the results are copied from.
+ *
+ * @param job Job id from radio_sched_scan_start()
+ * @param status Filled with the job's progress
+ * @param records Output array of RADIO_SCAN_MAX_APS records, filled once
+ *        the job is done; may be NULL
+ * @return false if the job is unknown or was superseded by a newer one
+ */
+bool radio_sched_scan_get(uint32_t job, radio_scan_status_t *status, wifi_ap_record_t *records);
+
+/**
+ * @brief Get the time split and the current state
+ */
+void radio_sched_get_status(radio_sched_status_t *status);
+
+/**
+ * @brief Get the name of a client
+ */
+const char *radio_sched_client_name(radio_client_t client);
+
+#endif /* RADIO_SCHED_H */
@@ -0,0 +1,131 @@
+#include "rate_stats.h"
+#include <string.h>
+
+// Legacy rates in 500 kbps units, in bin order
+static const uint8_t legacy_rates[RATE_LEGACY_BINS] = {
+    2, 4, 11, 22, 12, 18, 24, 36, 48, 72, 96, 108,
+};
+
+static const char *bin_names[RATE_BINS] = {
+    "1M", "2M", "5.5M", "11M", "6M", "9M", "12M", "18M", "24M", "36M", "48M", "54M",
+    "MCS0", "MCS1", "MCS2", "MCS3", "MCS4", "MCS5",
+    "MCS6", "MCS7", "MCS8", "MCS9", "MCS10", "MCS11",
+};
+
+// Get the histogram bin of a PHY rate
+int rate_stats_bin(const airtime_phy_t *phy) {
+    switch (phy->format) {
+        case AIRTIME_PHY_DSSS:
+        case AIRTIME_PHY_OFDM:
+            for (int i = 0; i < RATE_LEGACY_BINS; i++) {
+                if (legacy_rates[i] == phy->rate) return i;
+            }
+            return -1;
+        case AIRTIME_PHY_HT:
+            return phy->rate < 32 ? RATE_LEGACY_BINS + phy->rate % 8 : -1;
+        default:
+            return phy->rate < 12 ? RATE_LEGACY_BINS + phy->rate : -1;
+    }
+}
+
+// Add one frame to a histogram
+static void account_frame(rate_hist_t *hist, bool is_new, const frame_info_t *info,
+                          const airtime_phy_t *phy, int bin) {
+    if (is_new) {
+        memset(hist, 0, sizeof(*hist));
+    }
+
+    hist->frames++;
+    if (info->flags & IEEE80211_FCTL_RETRY) {
+        hist->retries++;
+    }
+    if (bin >= 0) {
+        hist->bins[bin]++;
+    }
+    if (phy) {
+        uint8_t nss = phy->format == AIRTIME_PHY_HT ? phy->rate / 8 + 1 : phy->nss;
+        if (nss > hist->max_nss) hist->max_nss = nss;
+        if (phy->bandwidth > hist->max_bandwidth) hist->max_bandwidth = phy->bandwidth;
+    }
+}
+
+// Combine two histograms for the same key
+static void merge_hist(rate_hist_t *dst, bool is_new, const rate_hist_t *src) {
+    if (is_new) {
+        *dst = *src;
+        return;
+    }
+
+    for (int i = 0; i < RATE_BINS; i++) {
+        dst->bins[i] += src->bins[i];
+    }
+    dst->frames += src->frames;
+    dst->retries += src->retries;
+    if (src->max_nss > dst->max_nss) dst->max_nss = src->max_nss;
+    if (src->max_bandwidth > dst->max_bandwidth) dst->max_bandwidth = src->max_bandwidth;
+}
+
+// Reset the rate analytics
+void rate_stats_init(rate_stats_t *stats) {
+    mac_table_init(&stats->tx_table, stats->tx_nodes, stats->tx_buckets,
+                   RATE_MAX_TRANSMITTERS, RATE_HASH_BUCKETS, 6);
+    mac_table_init(&stats->bss_table, stats->bss_nodes, stats->bss_buckets,
+                   RATE_MAX_BSSIDS, RATE_HASH_BUCKETS, 6);
+}
+
+// Account one received frame
+void rate_stats_update(rate_stats_t *stats, const frame_info_t *info, const airtime_phy_t *phy) {
+    if (info->type != IEEE80211_TYPE_DATA || !info->addr2) {
+        return;
+    }
+
+    int bin = phy ? rate_stats_bin(phy) : -1;
+    bool is_new;
+
+    int slot = mac_table_touch(&stats->tx_table, info->addr2, &is_new);
+    account_frame(&stats->tx[slot], is_new, info, phy, bin);
+
+    // Both directions of a BSS count towards its BSSID
+    if (info->bssid && !ieee80211_is_group_addr(info->bssid)) {
+        slot = mac_table_touch(&stats->bss_table, info->bssid, &is_new);
+        account_frame(&stats->bss[slot], is_new, info, phy, bin);
+    }
+}
+
+// Merge the counters of src into dst
+void rate_stats_merge(rate_stats_t *dst, const rate_stats_t *src) {
+    bool is_new;
+
+    // Walk from least to most recently used so the merged LRU order follows src
+    for (uint16_t slot = src->tx_table.lru_tail; slot != MAC_TABLE_NONE; slot = src->tx_nodes[slot].lru_prev) {
+        int dst_slot = mac_table_touch(&dst->tx_table, mac_table_key(&src->tx_table, slot), &is_new);
+        merge_hist(&dst->tx[dst_slot], is_new, &src->tx[slot]);
+    }
+    for (uint16_t slot = src->bss_table.lru_tail; slot != MAC_TABLE_NONE; slot = src->bss_nodes[slot].lru_prev) {
+        int dst_slot = mac_table_touch(&dst->bss_table, mac_table_key(&src->bss_table, slot), &is_new);
+        merge_hist(&dst->bss[dst_slot], is_new, &src->bss[slot]);
+    }
+    dst->tx_table.evictions += src->tx_table.evictions;
+    dst->bss_table.evictions += src->bss_table.evictions;
+}
+
+// Copy the per-transmitter or per-BSSID histograms, most recently heard first
+int rate_stats_export(const rate_stats_t *stats, bool bssids, rate_entry_t *out, int max_entries) {
+    const mac_table_t *table = bssids ? &stats->bss_table : &stats->tx_table;
+    const rate_hist_t *values = bssids ? stats->bss : stats->tx;
+    int count = 0;
+
+    for (uint16_t slot = table->lru_head; slot != MAC_TABLE_NONE && count < max_entries;
+         slot = table->nodes[slot].lru_next) {
+        memcpy(out[count].addr, mac_table_key(table, slot), 6);
+        out[count].hist = values[slot];
+        count++;
+    }
+
+    return count;
+}
+
+// Get the label of a histogram bin
+const char *rate_stats_bin_name(int bin) {
+    return bin >= 0 && bin < RATE_BINS ? bin_names[bin] : "unknown";
+}
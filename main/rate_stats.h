@@ -0,0 +1,97 @@
+#ifndef RATE_STATS_H
+#define RATE_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ieee80211.h"
+#include "mac_table.h"
+#include "airtime.h"
+
+// Histogram bins: 12 legacy rates, then MCS 0-11 (per stream for HT)
+#define RATE_LEGACY_BINS             12
+#define RATE_BINS                    (RATE_LEGACY_BINS + 12)
+// Tracked transmitters and BSSIDs; least recently heard are evicted
+#ifndef RATE_MAX_TRANSMITTERS
+#define RATE_MAX_TRANSMITTERS        64
+#endif
+#ifndef RATE_MAX_BSSIDS
+#define RATE_MAX_BSSIDS              32
+#endif
+#ifndef RATE_HASH_BUCKETS
+#define RATE_HASH_BUCKETS            32
+#endif
+
+/**
+ * @brief Rate histogram and retry counters of a transmitter or BSS
+ *
+ * Only data frames are counted: management frames go out at the lowest
+ * basic rate and would hide the rates actually used for traffic.
+ */
+typedef struct {
+    uint32_t bins[RATE_BINS];
+    uint32_t frames;
+    uint32_t retries;            // Frames with the Retry bit set
+    uint8_t max_nss;             // Most spatial streams seen
+    uint8_t max_bandwidth;       // Widest channel seen, in MHz
+} rate_hist_t;
+
+/**
+ * @brief Flattened entry for exports
+ */
+typedef struct {
+    uint8_t addr[6];
+    rate_hist_t hist;
+} rate_entry_t;
+
+/**
+ * @brief Rate analytics state
+ */
+typedef struct {
+    mac_table_t tx_table;
+    mac_table_node_t tx_nodes[RATE_MAX_TRANSMITTERS];
+    uint16_t tx_buckets[RATE_HASH_BUCKETS];
+    rate_hist_t tx[RATE_MAX_TRANSMITTERS];
+
+    mac_table_t bss_table;
+    mac_table_node_t bss_nodes[RATE_MAX_BSSIDS];
+    uint16_t bss_buckets[RATE_HASH_BUCKETS];
+    rate_hist_t bss[RATE_MAX_BSSIDS];
+} rate_stats_t;
+
+/**
+ * @brief Reset the rate analytics
+ */
+void rate_stats_init(rate_stats_t *stats);
+
+/**
+ * @brief Account one received frame
+ *
+ * @param stats Rate analytics
+ * @param info Parsed frame
+ * @param phy PHY the frame was received with (NULL if unknown)
+ */
+void rate_stats_update(rate_stats_t *stats, const frame_info_t *info, const airtime_phy_t *phy);
+
+/**
+ * @brief Merge the counters of src into dst
+ */
+void rate_stats_merge(rate_stats_t *dst, const rate_stats_t *src);
+
+/**
+ * @brief Copy the per-transmitter or per-BSSID histograms, most recently heard first
+ *
+ * @return Number of entries copied
+ */
+int rate_stats_export(const rate_stats_t *stats, bool bssids, rate_entry_t *out, int max_entries);
+
+/**
+ * @brief Get the histogram bin of a PHY rate (-1 if it has none)
+ */
+int rate_stats_bin(const airtime_phy_t *phy);
+
+/**
+ * @brief Get the label of a histogram bin ("54M", "MCS7", ...)
+ */
+const char *rate_stats_bin_name(int bin);
+
+#endif /* RATE_STATS_H */
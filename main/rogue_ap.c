@@ -0,0 +1,455 @@
+#include "rogue_ap.h"
+#include <string.h>
+
+// Capability bit advertising WEP/privacy
+#define CAPABILITY_PRIVACY   0x0010
+// RSN AKM suite types (OUI 00-0F-AC)
+#define RSN_AKM_SAE          8
+#define RSN_AKM_FT_SAE       9
+
+static const char *auth_names[ROGUE_AUTH_COUNT] = {
+    [ROGUE_AUTH_OPEN] = "open",
+    [ROGUE_AUTH_WEP]  = "wep",
+    [ROGUE_AUTH_WPA]  = "wpa",
+    [ROGUE_AUTH_WPA2] = "wpa2",
+    [ROGUE_AUTH_WPA3] = "wpa3",
+};
+
+// Build the table key of an SSID from two independent hashes
+static void ssid_key(const char *ssid, uint8_t key[8]) {
+    uint8_t len = strlen(ssid);
+    uint32_t h1 = mac_table_hash((const uint8_t *)ssid, len);
+    uint32_t h2 = 5381; // djb2
+    for (uint8_t i = 0; i < len; i++) {
+        h2 = h2 * 33 + (uint8_t)ssid[i];
+    }
+    memcpy(key, &h1, 4);
+    memcpy(key + 4, &h2, 4);
+}
+
+// Check whether an RSN element only offers SAE key management
+static bool rsn_is_sae_only(const uint8_t *rsn, uint8_t len) {
+    // Version (2), group cipher (4), pairwise count (2) + suites
+    if (len < 8) {
+        return false;
+    }
+    uint16_t pairwise = rsn[6] | (rsn[7] << 8);
+    uint16_t pos = 8 + pairwise * 4;
+    if (pos + 2 > len) {
+        return false;
+    }
+
+    uint16_t akm_count = rsn[pos] | (rsn[pos + 1] << 8);
+    pos += 2;
+    if (akm_count == 0 || pos + akm_count * 4 > len) {
+        return false;
+    }
+    for (uint16_t i = 0; i < akm_count; i++, pos += 4) {
+        uint8_t type = rsn[pos + 3];
+        if (type != RSN_AKM_SAE && type != RSN_AKM_FT_SAE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Find a WPA (vendor 00-50-F2 type 1) element
+static bool has_wpa_ie(const uint8_t *ies, uint16_t len) {
+    uint16_t pos = 0;
+
+    while (pos + 2 <= len) {
+        uint8_t ie_len = ies[pos + 1];
+        if (pos + 2 + ie_len > len) {
+            break;
+        }
+        const uint8_t *ie = &ies[pos + 2];
+        if (ies[pos] == IEEE80211_IE_VENDOR && ie_len >= 4 &&
+            ie[0] == 0x00 && ie[1] == 0x50 && ie[2] == 0xF2 && ie[3] == 0x01) {
+            return true;
+        }
+        pos += 2 + ie_len;
+    }
+    return false;
+}
+
+// Elements a BSS adds, drops or changes from one beacon to the next
+static bool is_volatile_ie(uint8_t id) {
+    return id == IEEE80211_IE_TIM || id == IEEE80211_IE_BSS_LOAD || id == IEEE80211_IE_CSA ||
+           id == IEEE80211_IE_QUIET || id == IEEE80211_IE_EXT_CSA;
+}
+
+// Hash the element IDs in order, the RSN element and the capabilities; a
+// clone on different hardware rarely reproduces all three
+static uint32_t beacon_fingerprint(const uint8_t *ies, uint16_t len, uint16_t capability) {
+    uint32_t hash = 2166136261u; // FNV-1a offset basis
+    uint16_t pos = 0;
+
+    hash = (hash ^ (capability & 0xFF)) * 16777619u;
+    hash = (hash ^ (capability >> 8)) * 16777619u;
+    while (pos + 2 <= len) {
+        uint8_t id = ies[pos];
+        uint8_t ie_len = ies[pos + 1];
+        if (pos + 2 + ie_len > len) {
+            break;
+        }
+        if (is_volatile_ie(id)) {
+            pos += 2 + ie_len;
+            continue;
+        }
+        hash = (hash ^ id) * 16777619u;
+        if (id == IEEE80211_IE_RSN) {
+            for (uint16_t i = 0; i < ie_len; i++) {
+                hash = (hash ^ ies[pos + 2 + i]) * 16777619u;
+            }
+        }
+        pos += 2 + ie_len;
+    }
+
+    return hash ? hash : 1; // 0 means "unknown"
+}
+
+// Re-evaluate the baseline-derived flags of a BSS
+static uint8_t evaluate_bss(const rogue_ap_t *index, const rogue_ssid_t *entry, const rogue_bss_t *bss) {
+    uint8_t flags = bss->flags & ROGUE_FLAG_FINGERPRINT;
+    uint8_t key[8];
+
+    ssid_key(entry->ssid, key);
+    int slot = mac_table_find(&index->baseline_table, key);
+    if (slot < 0) {
+        // Without a baseline the strongest BSS of the SSID is the reference
+        if (bss->auth < entry->best_auth) {
+            flags |= ROGUE_FLAG_DOWNGRADE;
+        }
+        return flags;
+    }
+
+    const rogue_baseline_entry_t *expected = NULL;
+    uint8_t weakest = ROGUE_AUTH_WPA3;
+    for (int i = 0; i < index->baseline[slot].count; i++) {
+        const rogue_baseline_entry_t *b = &index->baseline[slot].bss[i];
+        if (memcmp(b->bssid, bss->bssid, 6) == 0) {
+            expected = b;
+        }
+        if (b->auth < weakest) {
+            weakest = b->auth;
+        }
+    }
+
+    if (!expected) {
+        flags |= ROGUE_FLAG_UNKNOWN_BSSID;
+        if (bss->auth < weakest) {
+            flags |= ROGUE_FLAG_DOWNGRADE;
+        }
+    } else {
+        if (expected->channel && expected->channel != bss->channel) {
+            flags |= ROGUE_FLAG_CHANNEL;
+        }
+        if (bss->auth < expected->auth) {
+            flags |= ROGUE_FLAG_DOWNGRADE;
+        }
+    }
+    return flags;
+}
+
+// Re-evaluate every observed BSS, e.g. after the baseline changed
+static void evaluate_all(rogue_ap_t *index) {
+    for (int i = 0; i < ROGUE_MAX_SSIDS; i++) {
+        if (!mac_table_in_use(&index->ssid_table, i)) continue;
+
+        rogue_ssid_t *entry = &index->ssids[i];
+        for (int j = 0; j < entry->bss_count; j++) {
+            entry->bss[j].flags = evaluate_bss(index, entry, &entry->bss[j]);
+        }
+    }
+}
+
+// Add one entry to the baseline
+static bool add_baseline_entry(rogue_ap_t *index, const rogue_baseline_entry_t *entry) {
+    uint8_t key[8];
+    bool is_new;
+
+    if (entry->ssid[0] == '\0') {
+        return false;
+    }
+
+    ssid_key(entry->ssid, key);
+    int slot = mac_table_find(&index->baseline_table, key);
+    if (slot < 0) {
+        // Never recycle baseline SSIDs
+        if (index->baseline_table.count >= ROGUE_MAX_BASELINE_SSIDS) {
+            return false;
+        }
+        slot = mac_table_touch(&index->baseline_table, key, &is_new);
+        index->baseline[slot].count = 0;
+    }
+
+    if (index->baseline[slot].count >= ROGUE_MAX_BSS_PER_SSID) {
+        return false;
+    }
+    index->baseline[slot].bss[index->baseline[slot].count++] = *entry;
+    index->baseline_count++;
+    return true;
+}
+
+// Reset the index and its baseline
+void rogue_ap_init(rogue_ap_t *index) {
+    mac_table_init(&index->ssid_table, index->ssid_nodes, index->ssid_buckets,
+                   ROGUE_MAX_SSIDS, ROGUE_HASH_BUCKETS, 8);
+    mac_table_init(&index->baseline_table, index->baseline_nodes, index->baseline_buckets,
+                   ROGUE_MAX_BASELINE_SSIDS, ROGUE_BASELINE_BUCKETS, 8);
+    index->baseline_count = 0;
+    index->alerts = 0;
+}
+
+// Account one observed BSS and re-evaluate its flags
+uint8_t rogue_ap_observe(rogue_ap_t *index, const char *ssid, const uint8_t *bssid, uint8_t channel,
+                         rogue_auth_t auth, uint32_t fingerprint, int8_t rssi, uint8_t source, uint64_t now_us) {
+    uint8_t key[8];
+    bool is_new;
+
+    if (ssid[0] == '\0') {
+        return 0;
+    }
+
+    ssid_key(ssid, key);
+    int slot = mac_table_touch(&index->ssid_table, key, &is_new);
+    rogue_ssid_t *entry = &index->ssids[slot];
+    if (is_new || strcmp(entry->ssid, ssid) != 0) {
+        memset(entry, 0, sizeof(*entry));
+        strncpy(entry->ssid, ssid, sizeof(entry->ssid) - 1);
+    }
+
+    // Find the BSS, or recycle the least recently heard one
+    rogue_bss_t *bss = NULL;
+    rogue_bss_t *oldest = NULL;
+    for (int i = 0; i < entry->bss_count; i++) {
+        if (memcmp(entry->bss[i].bssid, bssid, 6) == 0) {
+            bss = &entry->bss[i];
+            break;
+        }
+        if (!oldest || entry->bss[i].last_seen_us < oldest->last_seen_us) {
+            oldest = &entry->bss[i];
+        }
+    }
+    if (!bss) {
+        bss = entry->bss_count < ROGUE_MAX_BSS_PER_SSID ? &entry->bss[entry->bss_count++] : oldest;
+        memset(bss, 0, sizeof(*bss));
+        memcpy(bss->bssid, bssid, 6);
+        bss->first_seen_us = now_us;
+    }
+
+    uint8_t old_flags = bss->flags;
+    if (fingerprint) {
+        if (bss->fingerprint && bss->fingerprint != fingerprint) {
+            bss->flags |= ROGUE_FLAG_FINGERPRINT;
+        }
+        if (!bss->fingerprint) {
+            bss->fingerprint = fingerprint;
+        }
+    }
+    bss->channel = channel;
+    bss->auth = auth;
+    bss->rssi = rssi;
+    bss->sources |= source;
+    bss->seen++;
+    bss->last_seen_us = now_us;
+    if (auth > entry->best_auth) {
+        entry->best_auth = auth;
+    }
+
+    bss->flags = evaluate_bss(index, entry, bss);
+    if (bss->flags & ~old_flags) {
+        index->alerts++;
+    }
+    return bss->flags;
+}
+
+// Account a captured beacon or probe response
+void rogue_ap_update(rogue_ap_t *index, const frame_info_t *info) {
+    if (!ieee80211_is_beacon_like(info) || !info->addr3 || info->body_len < IEEE80211_BEACON_FIXED_LEN) {
+        return;
+    }
+
+    const uint8_t *ies = info->body + IEEE80211_BEACON_FIXED_LEN;
+    uint16_t ies_len = info->body_len - IEEE80211_BEACON_FIXED_LEN;
+    uint16_t capability = info->body[10] | (info->body[11] << 8);
+
+    uint8_t ssid_len = 0;
+    const uint8_t *ssid_ie = ieee80211_find_ie(ies, ies_len, IEEE80211_IE_SSID, &ssid_len);
+    if (!ssid_ie || ssid_len == 0 || ssid_len > 32 || ssid_ie[0] == '\0') {
+        return;
+    }
+    char ssid[33];
+    memcpy(ssid, ssid_ie, ssid_len);
+    ssid[ssid_len] = '\0';
+
+    // Report the weakest security the BSS accepts
+    rogue_auth_t auth = ROGUE_AUTH_OPEN;
+    uint8_t rsn_len = 0;
+    const uint8_t *rsn = ieee80211_find_ie(ies, ies_len, IEEE80211_IE_RSN, &rsn_len);
+    if (has_wpa_ie(ies, ies_len)) {
+        auth = ROGUE_AUTH_WPA;
+    } else if (rsn) {
+        auth = rsn_is_sae_only(rsn, rsn_len) ? ROGUE_AUTH_WPA3 : ROGUE_AUTH_WPA2;
+    } else if (capability & CAPABILITY_PRIVACY) {
+        auth = ROGUE_AUTH_WEP;
+    }
+
+    // The DS element holds the channel the BSS operates on
+    uint8_t channel = info->channel;
+    uint8_t ds_len = 0;
+    const uint8_t *ds = ieee80211_find_ie(ies, ies_len, IEEE80211_IE_DS_PARAMS, &ds_len);
+    if (ds && ds_len >= 1) {
+        channel = ds[0];
+    }
+
+    // Probe responses carry a different element set, so only beacons are fingerprinted
+    uint32_t fingerprint = 0;
+    if (info->subtype == IEEE80211_STYPE_BEACON) {
+        fingerprint = beacon_fingerprint(ies, ies_len, capability);
+    }
+    rogue_ap_observe(index, ssid, info->addr3, channel, auth, fingerprint,
+                     info->rssi, ROGUE_SOURCE_BEACON, info->timestamp_us);
+}
+
+// Merge the observations of src into dst
+void rogue_ap_merge(rogue_ap_t *dst, const rogue_ap_t *src) {
+    bool is_new;
+
+    // Walk from least to most recently used so the merged LRU order follows src
+    for (uint16_t slot = src->ssid_table.lru_tail; slot != MAC_TABLE_NONE; slot = src->ssid_nodes[slot].lru_prev) {
+        const rogue_ssid_t *from = &src->ssids[slot];
+        int dst_slot = mac_table_touch(&dst->ssid_table, mac_table_key(&src->ssid_table, slot), &is_new);
+        rogue_ssid_t *entry = &dst->ssids[dst_slot];
+        if (is_new || strcmp(entry->ssid, from->ssid) != 0) {
+            *entry = *from;
+        } else {
+            for (int i = 0; i < from->bss_count; i++) {
+                const rogue_bss_t *in = &from->bss[i];
+
+                // Find the BSS, or recycle the least recently heard one
+                rogue_bss_t *bss = NULL;
+                rogue_bss_t *oldest = NULL;
+                for (int j = 0; j < entry->bss_count; j++) {
+                    if (memcmp(entry->bss[j].bssid, in->bssid, 6) == 0) {
+                        bss = &entry->bss[j];
+                        break;
+                    }
+                    if (!oldest || entry->bss[j].last_seen_us < oldest->last_seen_us) {
+                        oldest = &entry->bss[j];
+                    }
+                }
+                if (!bss) {
+                    if (entry->bss_count < ROGUE_MAX_BSS_PER_SSID) {
+                        entry->bss[entry->bss_count++] = *in;
+                    } else if (in->last_seen_us > oldest->last_seen_us) {
+                        *oldest = *in;
+                    }
+                    continue;
+                }
+
+                if (in->fingerprint && bss->fingerprint && in->fingerprint != bss->fingerprint) {
+                    bss->flags |= ROGUE_FLAG_FINGERPRINT;
+                }
+                if (!bss->fingerprint) {
+                    bss->fingerprint = in->fingerprint;
+                }
+                bss->flags |= in->flags & ROGUE_FLAG_FINGERPRINT;
+                bss->sources |= in->sources;
+                bss->seen += in->seen;
+                if (in->first_seen_us < bss->first_seen_us) {
+                    bss->first_seen_us = in->first_seen_us;
+                }
+                if (in->last_seen_us > bss->last_seen_us) {
+                    bss->last_seen_us = in->last_seen_us;
+                    bss->channel = in->channel;
+                    bss->auth = in->auth;
+                    bss->rssi = in->rssi;
+                }
+            }
+            if (from->best_auth > entry->best_auth) {
+                entry->best_auth = from->best_auth;
+            }
+        }
+
+        for (int i = 0; i < entry->bss_count; i++) {
+            entry->bss[i].flags = evaluate_bss(dst, entry, &entry->bss[i]);
+        }
+    }
+
+    dst->ssid_table.evictions += src->ssid_table.evictions;
+    dst->alerts += src->alerts;
+}
+
+// Replace the baseline and clear flags derived from the old one
+int rogue_ap_set_baseline(rogue_ap_t *index, const rogue_baseline_entry_t *entries, int count) {
+    mac_table_init(&index->baseline_table, index->baseline_nodes, index->baseline_buckets,
+                   ROGUE_MAX_BASELINE_SSIDS, ROGUE_BASELINE_BUCKETS, 8);
+    index->baseline_count = 0;
+
+    int installed = 0;
+    for (int i = 0; i < count; i++) {
+        if (add_baseline_entry(index, &entries[i])) {
+            installed++;
+        }
+    }
+
+    evaluate_all(index);
+    return installed;
+}
+
+// Install everything currently observed as the baseline
+int rogue_ap_learn_baseline(rogue_ap_t *index) {
+    mac_table_init(&index->baseline_table, index->baseline_nodes, index->baseline_buckets,
+                   ROGUE_MAX_BASELINE_SSIDS, ROGUE_BASELINE_BUCKETS, 8);
+    index->baseline_count = 0;
+
+    // Most recently heard SSIDs first, in case they do not all fit
+    int installed = 0;
+    for (uint16_t slot = index->ssid_table.lru_head; slot != MAC_TABLE_NONE;
+         slot = index->ssid_nodes[slot].lru_next) {
+        const rogue_ssid_t *entry = &index->ssids[slot];
+
+        for (int i = 0; i < entry->bss_count; i++) {
+            rogue_baseline_entry_t b;
+            memcpy(b.ssid, entry->ssid, sizeof(b.ssid));
+            memcpy(b.bssid, entry->bss[i].bssid, 6);
+            b.channel = entry->bss[i].channel;
+            b.auth = entry->bss[i].auth;
+            if (add_baseline_entry(index, &b)) {
+                installed++;
+            }
+        }
+    }
+
+    // Learning accepts the current state, fingerprint changes included
+    for (int i = 0; i < ROGUE_MAX_SSIDS; i++) {
+        for (int j = 0; j < index->ssids[i].bss_count; j++) {
+            index->ssids[i].bss[j].flags = 0;
+        }
+    }
+    evaluate_all(index);
+    return installed;
+}
+
+// Check whether an SSID has baseline entries
+bool rogue_ap_is_baselined(const rogue_ap_t *index, const char *ssid) {
+    uint8_t key[8];
+    ssid_key(ssid, key);
+    return mac_table_find(&index->baseline_table, key) >= 0;
+}
+
+// Get the name of a security level
+const char *rogue_ap_auth_name(rogue_auth_t auth) {
+    return auth < ROGUE_AUTH_COUNT ? auth_names[auth] : "unknown";
+}
+
+// Parse a security level name
+rogue_auth_t rogue_ap_auth_from_name(const char *name) {
+    for (int i = 0; i < ROGUE_AUTH_COUNT; i++) {
+        if (strcmp(name, auth_names[i]) == 0) {
+            return i;
+        }
+    }
+    return ROGUE_AUTH_COUNT;
+}
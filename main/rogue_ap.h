@@ -0,0 +1,165 @@
+#ifndef ROGUE_AP_H
+#define ROGUE_AP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ieee80211.h"
+#include "mac_table.h"
+
+// Tracked SSIDs and BSSs per SSID; least recently heard are recycled
+#ifndef ROGUE_MAX_SSIDS
+#define ROGUE_MAX_SSIDS              32
+#endif
+#define ROGUE_MAX_BSS_PER_SSID       8
+#ifndef ROGUE_HASH_BUCKETS
+#define ROGUE_HASH_BUCKETS           32
+#endif
+// Baseline capacity (the baseline is never evicted)
+#define ROGUE_MAX_BASELINE_SSIDS     16
+#define ROGUE_BASELINE_BUCKETS       16
+
+/**
+ * @brief Weakest security a BSS accepts, in increasing strength
+ */
+typedef enum {
+    ROGUE_AUTH_OPEN = 0,
+    ROGUE_AUTH_WEP,
+    ROGUE_AUTH_WPA,
+    ROGUE_AUTH_WPA2,
+    ROGUE_AUTH_WPA3,
+    ROGUE_AUTH_COUNT
+} rogue_auth_t;
+
+// Divergence flags of an observed BSS
+#define ROGUE_FLAG_UNKNOWN_BSSID     0x01    // SSID is baselined but this BSSID is not
+#define ROGUE_FLAG_CHANNEL           0x02    // Known BSSID on a different channel than baselined
+#define ROGUE_FLAG_DOWNGRADE         0x04    // Weaker security than the baseline or other BSSs
+#define ROGUE_FLAG_FINGERPRINT       0x08    // IE fingerprint changed since first seen
+
+// Where an observation came from
+#define ROGUE_SOURCE_SCAN            0x01
+#define ROGUE_SOURCE_BEACON          0x02
+
+/**
+ * @brief One BSS advertising an SSID
+ */
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t auth;                // rogue_auth_t
+    uint32_t fingerprint;        // Hash of the beacon IE layout, 0 if no beacon was heard
+    uint8_t flags;               // ROGUE_FLAG_*
+    uint8_t sources;             // ROGUE_SOURCE_*
+    int8_t rssi;
+    uint32_t seen;
+    uint64_t first_seen_us;
+    uint64_t last_seen_us;
+} rogue_bss_t;
+
+/**
+ * @brief Everything seen for one SSID
+ */
+typedef struct {
+    char ssid[33];
+    uint8_t bss_count;
+    uint8_t best_auth;           // Strongest security seen for this SSID
+    rogue_bss_t bss[ROGUE_MAX_BSS_PER_SSID];
+} rogue_ssid_t;
+
+/**
+ * @brief Expected BSS of an SSID (channel 0 matches any channel)
+ */
+typedef struct {
+    char ssid[33];
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t auth;
+} rogue_baseline_entry_t;
+
+/**
+ * @brief Evil-twin index state
+ */
+typedef struct {
+    mac_table_t ssid_table;
+    mac_table_node_t ssid_nodes[ROGUE_MAX_SSIDS];
+    uint16_t ssid_buckets[ROGUE_HASH_BUCKETS];
+    rogue_ssid_t ssids[ROGUE_MAX_SSIDS];
+
+    mac_table_t baseline_table;
+    mac_table_node_t baseline_nodes[ROGUE_MAX_BASELINE_SSIDS];
+    uint16_t baseline_buckets[ROGUE_BASELINE_BUCKETS];
+    struct {
+        uint8_t count;
+        rogue_baseline_entry_t bss[ROGUE_MAX_BSS_PER_SSID];
+    } baseline[ROGUE_MAX_BASELINE_SSIDS];
+    uint16_t baseline_count;     // Baseline entries installed
+
+    uint32_t alerts;             // Times an observation gained a new flag
+} rogue_ap_t;
+
+/**
+ * @brief Reset the index and its baseline
+ */
+void rogue_ap_init(rogue_ap_t *index);
+
+/**
+ * @brief Account one observed BSS and re-evaluate its flags
+ *
+ * @param index Index
+ * @param ssid NUL-terminated SSID (hidden SSIDs are ignored)
+ * @param bssid BSSID
+ * @param channel Channel the BSS was heard on
+ * @param auth Weakest security the BSS accepts
+ * @param fingerprint IE fingerprint, 0 if not known
+ * @param rssi Signal strength
+ * @param source ROGUE_SOURCE_*
+ * @param now_us Current time
+ * @return Divergence flags of the BSS
+ */
+uint8_t rogue_ap_observe(rogue_ap_t *index, const char *ssid, const uint8_t *bssid, uint8_t channel,
+                         rogue_auth_t auth, uint32_t fingerprint, int8_t rssi, uint8_t source, uint64_t now_us);
+
+/**
+ * @brief Account a captured beacon or probe response
+ */
+void rogue_ap_update(rogue_ap_t *index, const frame_info_t *info);
+
+/**
+ * @brief Merge the observations of src into dst
+ *
+ * The baseline of dst is kept and the merged BSSs are re-evaluated against it.
+ */
+void rogue_ap_merge(rogue_ap_t *dst, const rogue_ap_t *src);
+
+/**
+ * @brief Replace the baseline and clear flags derived from the old one
+ *
+ * @return Number of entries installed (entries beyond capacity are skipped)
+ */
+int rogue_ap_set_baseline(rogue_ap_t *index, const rogue_baseline_entry_t *entries, int count);
+
+/**
+ * @brief Install everything currently observed as the baseline
+ *
+ * @return Number of entries installed
+ */
+int rogue_ap_learn_baseline(rogue_ap_t *index);
+
+/**
+ * @brief Check whether an SSID has baseline entries
+ */
+bool rogue_ap_is_baselined(const rogue_ap_t *index, const char *ssid);
+
+/**
+ * @brief Get the name of a security level
+ */
+const char *rogue_ap_auth_name(rogue_auth_t auth);
+
+/**
+ * @brief Parse a security level name
+ *
+ * @return The level, or ROGUE_AUTH_COUNT if the name is unknown
+ */
+rogue_auth_t rogue_ap_auth_from_name(const char *name);
+
+#endif /* ROGUE_AP_H */
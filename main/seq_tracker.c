@@ -0,0 +1,130 @@
+#include "seq_tracker.h"
+#include <string.h>
+
+// Find or allocate the slot of a channel (-1 once all slots are taken)
+static int channel_slot(seq_tracker_t *tracker, uint8_t channel) {
+    for (int i = 0; i < SEQ_MAX_CHANNELS; i++) {
+        if (tracker->channels[i] == channel) return i;
+    }
+    for (int i = 0; i < SEQ_MAX_CHANNELS; i++) {
+        if (tracker->channels[i] == 0) {
+            tracker->channels[i] = channel;
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Add one set of counters to another
+static void add_counters(seq_counters_t *dst, const seq_counters_t *src) {
+    dst->received += src->received;
+    dst->duplicates += src->duplicates;
+    dst->missed_on_channel += src->missed_on_channel;
+    dst->missed_off_channel += src->missed_off_channel;
+}
+
+// Reset the tracker
+void seq_tracker_init(seq_tracker_t *tracker) {
+    mac_table_init(&tracker->table, tracker->nodes, tracker->buckets,
+                   SEQ_MAX_TRANSMITTERS, SEQ_HASH_BUCKETS, 6);
+    memset(tracker->channels, 0, sizeof(tracker->channels));
+    memset(tracker->channel_counters, 0, sizeof(tracker->channel_counters));
+    memset(&tracker->total, 0, sizeof(tracker->total));
+}
+
+// Account one frame
+bool seq_tracker_update(seq_tracker_t *tracker, const frame_info_t *info, uint64_t dwell_start_us) {
+    if (!info->has_seq || !info->addr2 || ieee80211_is_group_addr(info->addr2)) {
+        return false;
+    }
+
+    // QoS data frames are numbered per TID; everything else shares one counter
+    int tid = ieee80211_qos_tid(info);
+    int space = (tid >= 0 && tid < 8) ? tid : 8;
+    uint16_t bit = 1 << space;
+
+    bool is_new;
+    int slot = mac_table_touch(&tracker->table, info->addr2, &is_new);
+    seq_stream_t *stream = &tracker->streams[slot];
+    if (is_new) {
+        memset(stream, 0, sizeof(*stream));
+    }
+
+    seq_counters_t delta = {0};
+    if (stream->valid & bit) {
+        uint16_t advance = (info->seq - stream->last_seq[space]) & 0x0FFF;
+
+        if (advance == 0 && info->frag == stream->last_frag[space] && (info->flags & IEEE80211_FCTL_RETRY)) {
+            // Retransmission we already have (the original was received)
+            delta.duplicates = 1;
+        } else if (advance > 0 && advance <= SEQ_MAX_GAP) {
+            // Frames between the two were sent but not heard; if the previous
+            // one in this space predates this dwell, we were listening elsewhere
+            // meanwhile (other spaces heard this dwell say nothing about it)
+            if (stream->last_seen_us[space] < dwell_start_us) {
+                delta.missed_off_channel = advance - 1;
+            } else {
+                delta.missed_on_channel = advance - 1;
+            }
+        }
+        // Larger jumps and steps backwards are resets or reordering: resync silently
+    }
+    if (!delta.duplicates) {
+        delta.received = 1;
+    }
+
+    stream->last_seq[space] = info->seq;
+    stream->last_frag[space] = info->frag;
+    stream->valid |= bit;
+    stream->last_seen_us[space] = info->timestamp_us;
+    stream->channel = info->channel;
+
+    add_counters(&stream->counters, &delta);
+    add_counters(&tracker->total, &delta);
+    int ch = channel_slot(tracker, info->channel);
+    if (ch >= 0) {
+        add_counters(&tracker->channel_counters[ch], &delta);
+    }
+
+    return delta.duplicates != 0;
+}
+
+// Merge the counters of src into dst
+void seq_tracker_merge(seq_tracker_t *dst, const seq_tracker_t *src) {
+    bool is_new;
+
+    // Walk from least to most recently used so the merged LRU order follows src
+    for (uint16_t slot = src->table.lru_tail; slot != MAC_TABLE_NONE; slot = src->nodes[slot].lru_prev) {
+        int dst_slot = mac_table_touch(&dst->table, mac_table_key(&src->table, slot), &is_new);
+        if (is_new) {
+            dst->streams[dst_slot] = src->streams[slot];
+        } else {
+            add_counters(&dst->streams[dst_slot].counters, &src->streams[slot].counters);
+        }
+    }
+
+    for (int i = 0; i < SEQ_MAX_CHANNELS; i++) {
+        if (src->channels[i] == 0) continue;
+        int ch = channel_slot(dst, src->channels[i]);
+        if (ch >= 0) {
+            add_counters(&dst->channel_counters[ch], &src->channel_counters[i]);
+        }
+    }
+    add_counters(&dst->total, &src->total);
+    dst->table.evictions += src->table.evictions;
+}
+
+// Copy the per-transmitter counters, most recently heard first
+int seq_tracker_export(const seq_tracker_t *tracker, seq_entry_t *out, int max_entries) {
+    int count = 0;
+
+    for (uint16_t slot = tracker->table.lru_head; slot != MAC_TABLE_NONE && count < max_entries;
+         slot = tracker->nodes[slot].lru_next) {
+        memcpy(out[count].addr, mac_table_key(&tracker->table, slot), 6);
+        out[count].channel = tracker->streams[slot].channel;
+        out[count].counters = tracker->streams[slot].counters;
+        count++;
+    }
+
+    return count;
+}
@@ -0,0 +1,106 @@
+#ifndef SEQ_TRACKER_H
+#define SEQ_TRACKER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ieee80211.h"
+#include "mac_table.h"
+
+// Tracked transmitters; least recently heard are evicted
+#ifndef SEQ_MAX_TRANSMITTERS
+#define SEQ_MAX_TRANSMITTERS         128
+#endif
+#ifndef SEQ_HASH_BUCKETS
+#define SEQ_HASH_BUCKETS             64
+#endif
+#define SEQ_MAX_CHANNELS             16
+// Sequence spaces per transmitter: QoS TIDs 0-7, then everything else
+#define SEQ_SPACES                   9
+// Larger forward jumps are treated as a counter reset rather than losses
+#define SEQ_MAX_GAP                  512
+
+/**
+ * @brief Capture completeness counters
+ *
+ * Frames missed while the transmitter's previous frame was heard in an
+ * earlier dwell are attributed to time spent on other channels; the rest
+ * were lost while listening (weak signal, collisions, RX overload).
+ */
+typedef struct {
+    uint32_t received;           // Unique frames
+    uint32_t duplicates;         // Retransmissions of a frame already received
+    uint32_t missed_on_channel;
+    uint32_t missed_off_channel;
+} seq_counters_t;
+
+/**
+ * @brief Sequence state of one transmitter
+ */
+typedef struct {
+    seq_counters_t counters;
+    uint64_t last_seen_us[SEQ_SPACES];
+    uint16_t last_seq[SEQ_SPACES];
+    uint8_t last_frag[SEQ_SPACES];
+    uint16_t valid;              // Bit per sequence space with a previous frame
+    uint8_t channel;
+} seq_stream_t;
+
+/**
+ * @brief Flattened entry for exports
+ */
+typedef struct {
+    uint8_t addr[6];
+    uint8_t channel;
+    seq_counters_t counters;
+} seq_entry_t;
+
+/**
+ * @brief Sequence gap tracker state
+ */
+typedef struct {
+    mac_table_t table;
+    mac_table_node_t nodes[SEQ_MAX_TRANSMITTERS];
+    uint16_t buckets[SEQ_HASH_BUCKETS];
+    seq_stream_t streams[SEQ_MAX_TRANSMITTERS];
+
+    uint8_t channels[SEQ_MAX_CHANNELS];
+    seq_counters_t channel_counters[SEQ_MAX_CHANNELS];
+    seq_counters_t total;
+} seq_tracker_t;
+
+/**
+ * @brief Reset the tracker
+ */
+void seq_tracker_init(seq_tracker_t *tracker);
+
+/**
+ * @brief Account one frame
+ *
+ * @param tracker Tracker
+ * @param info Parsed frame
+ * @param dwell_start_us Start of the current dwell on this channel
+ * @return true if the frame is a retransmission of one already received
+ */
+bool seq_tracker_update(seq_tracker_t *tracker, const frame_info_t *info, uint64_t dwell_start_us);
+
+/**
+ * @brief Merge the counters of src into dst (sequence state is not merged)
+ */
+void seq_tracker_merge(seq_tracker_t *dst, const seq_tracker_t *src);
+
+/**
+ * @brief Copy the per-transmitter counters, most recently heard first
+ *
+ * @return Number of entries copied
+ */
+int seq_tracker_export(const seq_tracker_t *tracker, seq_entry_t *out, int max_entries);
+
+/**
+ * @brief Get the fraction of frames captured, in permille (1000 if nothing is known)
+ */
+static inline uint16_t seq_coverage_permille(const seq_counters_t *c) {
+    uint64_t expected = (uint64_t)c->received + c->missed_on_channel + c->missed_off_channel;
+    return expected ? (uint16_t)(c->received * 1000ULL / expected) : 1000;
+}
+
+#endif /* SEQ_TRACKER_H */
@@ -0,0 +1,58 @@
+#include "slip_frame.h"
+#include <stdbool.h>
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+uint16_t slip_crc16(const uint8_t *data, size_t len, uint16_t crc) {
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+// Append escaped bytes; false if dst would overflow (keeping room for the END marker)
+static bool put_escaped(uint8_t *dst, size_t *pos, size_t cap, const uint8_t *src, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (*pos + 3 > cap) {
+            return false;
+        }
+        if (src[i] == SLIP_END) {
+            dst[(*pos)++] = SLIP_ESC;
+            dst[(*pos)++] = SLIP_ESC_END;
+        } else if (src[i] == SLIP_ESC) {
+            dst[(*pos)++] = SLIP_ESC;
+            dst[(*pos)++] = SLIP_ESC_ESC;
+        } else {
+            dst[(*pos)++] = src[i];
+        }
+    }
+    return true;
+}
+
+// Encode one SLIP frame
+size_t slip_frame_encode(uint8_t type, uint16_t seq, const uint8_t *head, size_t head_len,
+                         const uint8_t *data, size_t len, uint8_t *dst, size_t dst_cap) {
+    size_t content_len = head_len + len;
+    if (content_len > UINT16_MAX || dst_cap < 2) {
+        return 0;
+    }
+
+    uint8_t prefix[5] = {type, seq, seq >> 8, content_len, content_len >> 8};
+    uint16_t crc = slip_crc16(prefix, sizeof(prefix), 0xFFFF);
+    crc = slip_crc16(head, head_len, crc);
+    crc = slip_crc16(data, len, crc);
+    uint8_t suffix[2] = {crc, crc >> 8};
+
+    size_t pos = 0;
+    dst[pos++] = SLIP_END;
+    if (!put_escaped(dst, &pos, dst_cap, prefix, sizeof(prefix)) ||
+        !put_escaped(dst, &pos, dst_cap, head, head_len) ||
+        !put_escaped(dst, &pos, dst_cap, data, len) ||
+        !put_escaped(dst, &pos, dst_cap, suffix, sizeof(suffix))) {
+        return 0;
+    }
+    dst[pos++] = SLIP_END;
+    return pos;
+}
@@ -0,0 +1,49 @@
+#ifndef SLIP_FRAME_H
+#define SLIP_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// RFC 1055 special bytes
+#define SLIP_END                     0xC0
+#define SLIP_ESC                     0xDB
+#define SLIP_ESC_END                 0xDC
+#define SLIP_ESC_ESC                 0xDD
+
+// Frame types
+#define SLIP_FRAME_PCAP_HEADER       0x01    // pcap_global_header()
+#define SLIP_FRAME_PCAP_RECORD       0x02    // One pcap record (record header, radiotap, frame)
+#define SLIP_FRAME_STATS             0x03    // Stream counters, see uart_stream.h
+
+// Type, sequence and length before the content, CRC after it
+#define SLIP_FRAME_OVERHEAD          7
+// Worst case encoded size: every byte escaped, plus both END markers
+#define SLIP_FRAME_BOUND(n)          (2 * ((n) + SLIP_FRAME_OVERHEAD) + 2)
+
+/**
+ * @brief CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+ */
+uint16_t slip_crc16(const uint8_t *data, size_t len, uint16_t crc);
+
+/**
+ * @brief Encode one SLIP frame
+ *
+ * The unescaped frame is: type u8, sequence u16, content length u16,
+ * content (head then data), CRC-16 of everything before it; all little
+ * endian. Frames start and end with SLIP_END so a receiver can resync
+ * after line noise or stray console output, which fails the CRC.
+ *
+ * @param type SLIP_FRAME_*
+ * @param seq Frame sequence number, for loss detection
+ * @param head First part of the content (may be NULL)
+ * @param head_len Length of head
+ * @param data Second part of the content (may be NULL)
+ * @param len Length of data
+ * @param dst Output buffer
+ * @param dst_cap Output capacity (SLIP_FRAME_BOUND(head_len + len) always fits)
+ * @return Encoded length, or 0 if it does not fit
+ */
+size_t slip_frame_encode(uint8_t type, uint16_t seq, const uint8_t *head, size_t head_len,
+                         const uint8_t *data, size_t len, uint8_t *dst, size_t dst_cap);
+
+#endif /* SLIP_FRAME_H */
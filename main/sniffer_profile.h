@@ -0,0 +1,33 @@
+#ifndef SNIFFER_PROFILE_H
+#define SNIFFER_PROFILE_H
+
+/**
+ * @brief Stages of the promiscuous packet handler, in order
+ */
+typedef enum {
+    SNIFFER_STAGE_PARSE = 0,     // MAC header parse and PHY decode
+    SNIFFER_STAGE_SECURITY,      // Retransmission check, flood detector and evil-twin index
+    SNIFFER_STAGE_FILTER,        // MAC watch/ignore list
+    SNIFFER_STAGE_ANALYTICS,     // Statistics, sketches and detectors
+    SNIFFER_STAGE_DEDUP,         // Capture filter and beacon dedup
+    SNIFFER_STAGE_STORE,         // Flash recording, copy and capture buffer
+    SNIFFER_STAGE_COUNT
+} sniffer_stage_t;
+
+#ifdef SNIFFER_PROFILE
+/**
+ * @brief Start timing a frame through the handler
+ */
+void sniffer_profile_begin(void);
+
+/**
+ * @brief Charge the time since the previous mark to a stage
+ */
+void sniffer_profile_mark(sniffer_stage_t stage);
+#else
+// Compiled out on the device
+#define sniffer_profile_begin()      do { } while (0)
+#define sniffer_profile_mark(stage)  do { (void)(stage); } while (0)
+#endif
+
+#endif /* SNIFFER_PROFILE_H */
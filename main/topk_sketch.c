@@ -0,0 +1,197 @@
+#include "topk_sketch.h"
+#include <string.h>
+#include <stdlib.h>
+
+// Window layout: each window keeps one more epoch than it spans so a full
+// window length is always covered
+static const struct {
+    uint16_t window_s;
+    uint16_t epoch_s;
+} window_layout[TOPK_WINDOW_COUNT] = {
+    { 10,  5 },
+    { 60,  10 },
+    { 300, 60 },
+};
+
+// Add weight to a Space-Saving summary
+static void summary_add(topk_summary_t *summary, const uint8_t *mac, uint32_t weight) {
+    summary->total += weight;
+
+    int min_idx = 0;
+    for (int i = 0; i < summary->used; i++) {
+        topk_counter_t *c = &summary->counters[i];
+        if (memcmp(c->mac, mac, 6) == 0) {
+            c->count += weight;
+            return;
+        }
+        if (c->count < summary->counters[min_idx].count) {
+            min_idx = i;
+        }
+    }
+
+    if (summary->used < TOPK_CAPACITY) {
+        topk_counter_t *c = &summary->counters[summary->used++];
+        memcpy(c->mac, mac, 6);
+        c->count = weight;
+        c->error = 0;
+        return;
+    }
+
+    // Replace the smallest counter; its count becomes the new key's error
+    topk_counter_t *c = &summary->counters[min_idx];
+    memcpy(c->mac, mac, 6);
+    c->error = c->count;
+    c->count += weight;
+}
+
+// Smallest count of a full summary (an upper bound for any key it does not hold)
+static uint32_t summary_floor(const topk_summary_t *summary) {
+    if (summary->used < TOPK_CAPACITY) {
+        return 0;
+    }
+    uint32_t min = summary->counters[0].count;
+    for (int i = 1; i < summary->used; i++) {
+        if (summary->counters[i].count < min) min = summary->counters[i].count;
+    }
+    return min;
+}
+
+// Move a window forward to the epoch containing now_us
+static void window_rotate(topk_window_t *window, uint64_t now_us) {
+    if (now_us < window->current_start_us + window->epoch_us) {
+        return;
+    }
+
+    uint64_t elapsed = (now_us - window->current_start_us) / window->epoch_us;
+    int steps = elapsed > window->epoch_count ? window->epoch_count : (int)elapsed;
+
+    for (int i = 0; i < steps; i++) {
+        window->current = (window->current + 1) % window->epoch_count;
+        for (int m = 0; m < TOPK_METRIC_COUNT; m++) {
+            memset(&window->epochs[m][window->current], 0, sizeof(topk_summary_t));
+        }
+    }
+    window->current_start_us += elapsed * window->epoch_us;
+}
+
+// Reset the sketch
+void topk_sketch_init(topk_sketch_t *sketch) {
+    memset(sketch, 0, sizeof(*sketch));
+    for (int i = 0; i < TOPK_WINDOW_COUNT; i++) {
+        topk_window_t *window = &sketch->windows[i];
+        window->window_s = window_layout[i].window_s;
+        window->epoch_us = (uint32_t)window_layout[i].epoch_s * 1000000;
+        window->epoch_count = window_layout[i].window_s / window_layout[i].epoch_s + 1;
+    }
+}
+
+// Account one frame for its transmitter
+void topk_sketch_update(topk_sketch_t *sketch, const frame_info_t *info) {
+    if (!info->addr2) {
+        return;
+    }
+
+    for (int i = 0; i < TOPK_WINDOW_COUNT; i++) {
+        topk_window_t *window = &sketch->windows[i];
+        if (window->current_start_us == 0) {
+            window->current_start_us = info->timestamp_us;
+        }
+        window_rotate(window, info->timestamp_us);
+
+        summary_add(&window->epochs[TOPK_METRIC_FRAMES][window->current], info->addr2, 1);
+        summary_add(&window->epochs[TOPK_METRIC_BYTES][window->current], info->addr2, info->length);
+    }
+}
+
+// Find the window matching a length in seconds
+const topk_window_t *topk_sketch_window(const topk_sketch_t *sketch, uint16_t window_s) {
+    for (int i = 0; i < TOPK_WINDOW_COUNT; i++) {
+        if (sketch->windows[i].window_s == window_s) {
+            return &sketch->windows[i];
+        }
+    }
+    return NULL;
+}
+
+// Order results by estimate, heaviest first
+static int compare_results(const void *a, const void *b) {
+    const topk_result_t *ra = a, *rb = b;
+    return (rb->estimate > ra->estimate) - (rb->estimate < ra->estimate);
+}
+
+// Get the heaviest transmitters of a window
+int topk_window_query(const topk_window_t *window, topk_metric_t metric, uint64_t now_us,
+                      topk_result_t *out, int max_results, uint32_t *max_error, uint32_t *total) {
+    // Union of all keys held by live epochs
+    static const int max_keys = TOPK_CAPACITY * TOPK_MAX_EPOCHS;
+    topk_result_t *merged = malloc(sizeof(topk_result_t) * max_keys);
+    if (!merged) {
+        return TOPK_ERR_NO_MEMORY;
+    }
+
+    // Epochs older than the window (no frame arrived to rotate them) are skipped
+    int live_epochs = window->epoch_count;
+    if (window->current_start_us && now_us > window->current_start_us) {
+        uint64_t idle = (now_us - window->current_start_us) / window->epoch_us;
+        live_epochs = idle >= window->epoch_count ? 0 : window->epoch_count - (int)idle;
+    }
+
+    int key_count = 0;
+    uint32_t floor_sum = 0;
+    uint32_t bound = 0;
+    uint32_t weight = 0;
+
+    for (int e = 0; e < live_epochs; e++) {
+        int idx = (window->current - e + window->epoch_count) % window->epoch_count;
+        const topk_summary_t *summary = &window->epochs[metric][idx];
+        uint32_t floor = summary_floor(summary);
+
+        // Space-Saving guarantees error <= total / capacity per epoch
+        bound += summary->total / TOPK_CAPACITY;
+        weight += summary->total;
+
+        // Keys seen before but absent from this epoch may have up to floor weight in it
+        for (int k = 0; k < key_count; k++) {
+            bool present = false;
+            for (int i = 0; i < summary->used; i++) {
+                if (memcmp(summary->counters[i].mac, merged[k].mac, 6) == 0) {
+                    present = true;
+                    break;
+                }
+            }
+            if (!present) {
+                merged[k].estimate += floor;
+                merged[k].error += floor;
+            }
+        }
+
+        for (int i = 0; i < summary->used; i++) {
+            const topk_counter_t *c = &summary->counters[i];
+            int k;
+            for (k = 0; k < key_count; k++) {
+                if (memcmp(merged[k].mac, c->mac, 6) == 0) break;
+            }
+            if (k == key_count) {
+                // New key: earlier epochs may have held up to their floors
+                memcpy(merged[k].mac, c->mac, 6);
+                merged[k].estimate = floor_sum;
+                merged[k].error = floor_sum;
+                key_count++;
+            }
+            merged[k].estimate += c->count;
+            merged[k].error += c->error;
+        }
+
+        floor_sum += floor;
+    }
+
+    qsort(merged, key_count, sizeof(topk_result_t), compare_results);
+
+    int count = key_count < max_results ? key_count : max_results;
+    memcpy(out, merged, sizeof(topk_result_t) * count);
+    free(merged);
+
+    if (max_error) *max_error = bound;
+    if (total) *total = weight;
+    return count;
+}
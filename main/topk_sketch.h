@@ -0,0 +1,111 @@
+#ifndef TOPK_SKETCH_H
+#define TOPK_SKETCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ieee80211.h"
+
+// Counters per Space-Saving summary; the sketch takes roughly
+// 16 bytes * TOPK_CAPACITY * 2 metrics * 21 epoch slots (about 16 KB at 24)
+#ifndef TOPK_CAPACITY
+#define TOPK_CAPACITY                24
+#endif
+
+// Sliding windows reported by the sketch
+#define TOPK_WINDOW_COUNT            3
+#define TOPK_MAX_EPOCHS              7
+
+// Query failures, as negative result counts
+#define TOPK_ERR_NO_WINDOW           (-1)    // Window length is not tracked
+#define TOPK_ERR_NO_MEMORY           (-2)    // Scratch space for the merge could not be allocated
+
+typedef enum {
+    TOPK_METRIC_FRAMES = 0,
+    TOPK_METRIC_BYTES,
+    TOPK_METRIC_COUNT
+} topk_metric_t;
+
+/**
+ * @brief Space-Saving counter
+ *
+ * count overestimates the true weight by at most error.
+ */
+typedef struct {
+    uint8_t mac[6];
+    uint32_t count;
+    uint32_t error;
+} topk_counter_t;
+
+/**
+ * @brief Space-Saving summary of one epoch
+ */
+typedef struct {
+    topk_counter_t counters[TOPK_CAPACITY];
+    uint16_t used;
+    uint32_t total;              // Total weight seen in the epoch
+} topk_summary_t;
+
+/**
+ * @brief Sliding window made of a ring of epoch summaries
+ *
+ * A query merges all epochs in the ring, so a window reports between
+ * window_s and window_s + epoch length worth of traffic.
+ */
+typedef struct {
+    uint16_t window_s;
+    uint32_t epoch_us;
+    uint8_t epoch_count;
+    uint8_t current;
+    uint64_t current_start_us;
+    topk_summary_t epochs[TOPK_METRIC_COUNT][TOPK_MAX_EPOCHS];
+} topk_window_t;
+
+/**
+ * @brief Top-K talker sketch over 10 s, 60 s and 5 min windows
+ */
+typedef struct {
+    topk_window_t windows[TOPK_WINDOW_COUNT];
+} topk_sketch_t;
+
+/**
+ * @brief Query result entry
+ */
+typedef struct {
+    uint8_t mac[6];
+    uint32_t estimate;           // Upper bound of the true weight
+    uint32_t error;              // estimate - error is a lower bound
+} topk_result_t;
+
+/**
+ * @brief Reset the sketch
+ */
+void topk_sketch_init(topk_sketch_t *sketch);
+
+/**
+ * @brief Account one frame for its transmitter
+ */
+void topk_sketch_update(topk_sketch_t *sketch, const frame_info_t *info);
+
+/**
+ * @brief Find the window matching a length in seconds
+ *
+ * @return Window, or NULL if window_s is not one of the tracked windows
+ */
+const topk_window_t *topk_sketch_window(const topk_sketch_t *sketch, uint16_t window_s);
+
+/**
+ * @brief Get the heaviest transmitters of a window
+ *
+ * @param window Window (may be a copy taken under a lock)
+ * @param metric Frames or bytes
+ * @param now_us Current time, used to expire epochs that have not rotated yet
+ * @param out Results, heaviest first
+ * @param max_results Number of results wanted
+ * @param max_error Set to the guaranteed bound on any estimate's error (may be NULL)
+ * @param total Set to the total weight seen in the window (may be NULL)
+ * @return Number of results, or TOPK_ERR_NO_MEMORY
+ */
+int topk_window_query(const topk_window_t *window, topk_metric_t metric, uint64_t now_us,
+                      topk_result_t *out, int max_results, uint32_t *max_error, uint32_t *total);
+
+#endif /* TOPK_SKETCH_H */
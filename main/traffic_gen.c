@@ -0,0 +1,395 @@
+#include "traffic_gen.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 802.11 header sizes
+#define MGMT_HEADER_LEN              24
+#define QOS_DATA_HEADER_LEN          26
+
+// Vendor OUIs the population is drawn from (APs, then client devices)
+static const uint8_t ap_ouis[][3] = {
+    {0x00, 0x1A, 0x1E}, {0xF4, 0xF2, 0x6D}, {0x3C, 0x84, 0x6A}, {0x00, 0x0C, 0x43},
+    {0xB4, 0xFB, 0xE4}, {0x70, 0x3A, 0xCB}, {0x00, 0x24, 0x6C}, {0x10, 0x27, 0xF5},
+};
+static const uint8_t sta_ouis[][3] = {
+    {0xF0, 0x18, 0x98}, {0xAC, 0xBC, 0x32}, {0x8C, 0x85, 0x90}, {0x34, 0x14, 0x5F},
+    {0x24, 0x0A, 0xC4}, {0xDC, 0xA6, 0x32}, {0x3C, 0x22, 0xFB}, {0x60, 0x45, 0xCB},
+};
+
+// OFDM rates in 500 kbps units, and the ones used for control responses
+static const uint8_t ofdm_rates[] = {12, 18, 24, 36, 48, 72, 96, 108};
+static const uint8_t control_rates[] = {12, 24};
+
+static const char *kind_names[TRAFFIC_GEN_KIND_COUNT] = {
+    [TRAFFIC_GEN_BEACON]  = "beacon",
+    [TRAFFIC_GEN_PROBE]   = "probe",
+    [TRAFFIC_GEN_DATA]    = "data",
+    [TRAFFIC_GEN_CONTROL] = "control",
+};
+
+static const uint8_t broadcast[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+// xorshift32
+static uint32_t next_random(traffic_gen_t *gen) {
+    uint32_t x = gen->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    gen->rng = x;
+    return x;
+}
+
+// Uniform value in [0, n)
+static uint32_t random_below(traffic_gen_t *gen, uint32_t n) {
+    return n ? (uint32_t)(((uint64_t)next_random(gen) * n) >> 32) : 0;
+}
+
+// Index in [0, n) skewed towards 0, so a few devices carry most of the traffic
+static uint32_t random_skewed(traffic_gen_t *gen, uint32_t n) {
+    uint64_t a = next_random(gen), b = next_random(gen);
+    return (uint32_t)((((a * b) >> 32) * n) >> 32);
+}
+
+// Roughly normal RSSI (sum of four uniforms), clamped to what radios report
+static int8_t random_rssi(traffic_gen_t *gen, int mean, int stddev) {
+    int sum = 0;
+    for (int i = 0; i < 4; i++) {
+        sum += (int)random_below(gen, 2001) - 1000;
+    }
+    // The sum has a standard deviation of about 1155
+    int rssi = mean + sum * stddev / 1155;
+    if (rssi < -95) rssi = -95;
+    if (rssi > -20) rssi = -20;
+    return rssi;
+}
+
+static void random_mac(traffic_gen_t *gen, const uint8_t oui[3], uint8_t *mac) {
+    uint32_t r = next_random(gen);
+    memcpy(mac, oui, 3);
+    mac[3] = r >> 16;
+    mac[4] = r >> 8;
+    mac[5] = r;
+}
+
+// Locally administered unicast MAC, as used by MAC randomization
+static void randomized_mac(traffic_gen_t *gen, uint8_t *mac) {
+    uint32_t hi = next_random(gen), lo = next_random(gen);
+    mac[0] = ((hi >> 24) & 0xFC) | 0x02;
+    mac[1] = hi >> 16;
+    mac[2] = hi >> 8;
+    mac[3] = lo >> 16;
+    mac[4] = lo >> 8;
+    mac[5] = lo;
+}
+
+// Fill a configuration with a busy office-like default mix
+void traffic_gen_default_config(traffic_gen_config_t *config) {
+    memset(config, 0, sizeof(*config));
+    config->seed = 1;
+    config->aps = 16;
+    config->stations = 128;
+    config->mix[TRAFFIC_GEN_BEACON] = 20;
+    config->mix[TRAFFIC_GEN_PROBE] = 10;
+    config->mix[TRAFFIC_GEN_DATA] = 55;
+    config->mix[TRAFFIC_GEN_CONTROL] = 15;
+    config->rssi_mean = -65;
+    config->rssi_stddev = 10;
+    config->channels[0] = 1;
+    config->channels[1] = 6;
+    config->channels[2] = 11;
+    config->channel_count = 3;
+    config->data_len_max = 1500;
+    config->retry_permille = 50;
+    config->random_mac_permille = 300;
+}
+
+// Set up the population
+bool traffic_gen_init(traffic_gen_t *gen, const traffic_gen_config_t *config) {
+    memset(gen, 0, sizeof(*gen));
+    gen->config = *config;
+    traffic_gen_config_t *c = &gen->config;
+
+    if (c->aps > TRAFFIC_GEN_MAX_APS) c->aps = TRAFFIC_GEN_MAX_APS;
+    if (c->stations > TRAFFIC_GEN_MAX_STATIONS) c->stations = TRAFFIC_GEN_MAX_STATIONS;
+    if (c->channel_count > TRAFFIC_GEN_MAX_CHANNELS) c->channel_count = TRAFFIC_GEN_MAX_CHANNELS;
+    for (int i = 0; i < TRAFFIC_GEN_KIND_COUNT; i++) {
+        gen->mix_total += c->mix[i];
+    }
+    if (c->aps == 0 || c->channel_count == 0 || gen->mix_total == 0) {
+        return false;
+    }
+    // Data and probe responses need someone to talk to
+    if (c->stations == 0) {
+        gen->mix_total -= c->mix[TRAFFIC_GEN_DATA];
+        c->mix[TRAFFIC_GEN_DATA] = 0;
+        if (gen->mix_total == 0) {
+            return false;
+        }
+    }
+
+    gen->rng = c->seed ? c->seed : 1;
+    for (int i = 0; i < c->aps; i++) {
+        traffic_gen_device_t *ap = &gen->aps[i];
+        random_mac(gen, ap_ouis[random_below(gen, sizeof(ap_ouis) / 3)], ap->mac);
+        ap->channel = c->channels[random_below(gen, c->channel_count)];
+        ap->rssi = random_rssi(gen, c->rssi_mean, c->rssi_stddev);
+        ap->seq = random_below(gen, 4096);
+    }
+    for (int i = 0; i < c->stations; i++) {
+        traffic_gen_device_t *sta = &gen->stations[i];
+        // About half of the clients use a randomized address
+        if (random_below(gen, 2)) {
+            randomized_mac(gen, sta->mac);
+        } else {
+            random_mac(gen, sta_ouis[random_below(gen, sizeof(sta_ouis) / 3)], sta->mac);
+        }
+        sta->ap = random_skewed(gen, c->aps);
+        sta->channel = gen->aps[sta->ap].channel;
+        sta->rssi = random_rssi(gen, c->rssi_mean, c->rssi_stddev);
+        sta->seq = random_below(gen, 4096);
+    }
+    return true;
+}
+
+// Frame control, duration and up to three addresses
+static size_t put_header(uint8_t *buf, uint8_t fc0, uint8_t fc1, const uint8_t *a1, const uint8_t *a2,
+                         const uint8_t *a3) {
+    buf[0] = fc0;
+    buf[1] = fc1;
+    buf[2] = 0x2C;
+    buf[3] = 0x00;
+    memcpy(buf + 4, a1, 6);
+    if (!a2) return 10;
+    memcpy(buf + 10, a2, 6);
+    if (!a3) return 16;
+    memcpy(buf + 16, a3, 6);
+    return 22;
+}
+
+static size_t put_seq(uint8_t *buf, uint16_t seq) {
+    buf[0] = (seq << 4) & 0xF0;
+    buf[1] = seq >> 4;
+    return 2;
+}
+
+static size_t put_ie(uint8_t *buf, uint8_t id, const void *data, uint8_t len) {
+    buf[0] = id;
+    buf[1] = len;
+    memcpy(buf + 2, data, len);
+    return 2 + len;
+}
+
+// Beacon/probe response body: fixed fields, SSID, rates, DS parameter and RSN
+static size_t put_ap_body(traffic_gen_t *gen, uint8_t *buf, int ap_index) {
+    static const uint8_t rates_24[] = {0x82, 0x84, 0x8B, 0x96, 0x0C, 0x12, 0x18, 0x24};
+    static const uint8_t rates_5[] = {0x8C, 0x12, 0x98, 0x24, 0xB0, 0x48, 0x60, 0x6C};
+    static const uint8_t rsn[] = {
+        0x01, 0x00, 0x00, 0x0F, 0xAC, 0x04, 0x01, 0x00, 0x00, 0x0F, 0xAC, 0x04,
+        0x01, 0x00, 0x00, 0x0F, 0xAC, 0x02, 0x00, 0x00,
+    };
+    const traffic_gen_device_t *ap = &gen->aps[ap_index];
+    // Every eighth AP is open; pairs of APs share an SSID like a small ESS
+    bool open = ap_index % 8 == 7;
+    char ssid[33];
+    int ssid_len = snprintf(ssid, sizeof(ssid), "gen-%02d", ap_index / 2);
+
+    size_t off = 0;
+    uint32_t tsf = next_random(gen);
+    memset(buf, 0, 8);
+    memcpy(buf, &tsf, sizeof(tsf));
+    off += 8;
+    buf[off++] = 0x64;                       // Beacon interval: 100 TU
+    buf[off++] = 0x00;
+    buf[off++] = open ? 0x01 : 0x11;         // ESS, privacy
+    buf[off++] = 0x04;                       // Short slot time
+    off += put_ie(buf + off, 0, ssid, ssid_len);
+    off += put_ie(buf + off, 1, ap->channel > 14 ? rates_5 : rates_24, 8);
+    off += put_ie(buf + off, 3, &ap->channel, 1);
+    if (!open) {
+        off += put_ie(buf + off, 48, rsn, sizeof(rsn));
+    }
+    return off;
+}
+
+// Frame rate for a device: management at the basic rate, data anywhere in the OFDM set
+static uint8_t basic_rate(uint8_t channel) {
+    return channel > 14 ? 12 : 2;
+}
+
+static uint16_t build_beacon(traffic_gen_t *gen, uint8_t *buf, traffic_gen_frame_t *frame) {
+    int index = random_below(gen, gen->config.aps);
+    traffic_gen_device_t *ap = &gen->aps[index];
+
+    size_t off = put_header(buf, 0x80, 0x00, broadcast, ap->mac, ap->mac);
+    buf[2] = buf[3] = 0;
+    off += put_seq(buf + off, ap->seq++);
+    off += put_ap_body(gen, buf + off, index);
+
+    frame->channel = ap->channel;
+    frame->rssi = ap->rssi + (int8_t)random_below(gen, 5) - 2;
+    frame->rate = basic_rate(ap->channel);
+    return off;
+}
+
+static uint16_t build_probe(traffic_gen_t *gen, uint8_t *buf, traffic_gen_frame_t *frame) {
+    static const uint8_t rates_24[] = {0x02, 0x04, 0x0B, 0x16, 0x0C, 0x12, 0x18, 0x24};
+    const traffic_gen_config_t *c = &gen->config;
+    size_t off;
+
+    if (c->stations == 0 || random_below(gen, 2)) {
+        // Wildcard probe request, often from a one-off randomized address
+        uint8_t mac[6];
+        uint16_t seq;
+        uint8_t channel = c->channels[random_below(gen, c->channel_count)];
+        int8_t rssi;
+        if (c->stations == 0 || random_below(gen, 1000) < c->random_mac_permille) {
+            randomized_mac(gen, mac);
+            seq = random_below(gen, 4096);
+            rssi = random_rssi(gen, c->rssi_mean - 10, c->rssi_stddev);
+        } else {
+            traffic_gen_device_t *sta = &gen->stations[random_below(gen, c->stations)];
+            memcpy(mac, sta->mac, 6);
+            seq = sta->seq++;
+            rssi = sta->rssi;
+        }
+        off = put_header(buf, 0x40, 0x00, broadcast, mac, broadcast);
+        buf[2] = buf[3] = 0;
+        off += put_seq(buf + off, seq);
+        off += put_ie(buf + off, 0, "", 0);
+        off += put_ie(buf + off, 1, rates_24, sizeof(rates_24));
+        frame->channel = channel;
+        frame->rssi = rssi;
+        frame->rate = basic_rate(channel);
+    } else {
+        // Probe response from a station's AP
+        traffic_gen_device_t *sta = &gen->stations[random_below(gen, c->stations)];
+        traffic_gen_device_t *ap = &gen->aps[sta->ap];
+        off = put_header(buf, 0x50, 0x00, sta->mac, ap->mac, ap->mac);
+        off += put_seq(buf + off, ap->seq++);
+        off += put_ap_body(gen, buf + off, sta->ap);
+        frame->channel = ap->channel;
+        frame->rssi = ap->rssi;
+        frame->rate = basic_rate(ap->channel);
+    }
+    return off;
+}
+
+static uint16_t build_data(traffic_gen_t *gen, uint8_t *buf, size_t size, traffic_gen_frame_t *frame) {
+    static const uint8_t llc_ipv4[] = {0xAA, 0xAA, 0x03, 0x00, 0x00, 0x00, 0x08, 0x00};
+    const traffic_gen_config_t *c = &gen->config;
+    traffic_gen_device_t *sta = &gen->stations[random_skewed(gen, c->stations)];
+    traffic_gen_device_t *ap = &gen->aps[sta->ap];
+    bool uplink = random_below(gen, 2);
+    traffic_gen_device_t *tx = uplink ? sta : ap;
+
+    // Retries repeat the sequence number of the previous frame
+    bool retry = random_below(gen, 1000) < c->retry_permille;
+    uint16_t seq = retry ? (uint16_t)(tx->seq - 1) : tx->seq++;
+
+    size_t off;
+    if (uplink) {
+        off = put_header(buf, 0x88, 0x01 | (retry ? 0x08 : 0), ap->mac, sta->mac, ap->mac);
+    } else {
+        off = put_header(buf, 0x88, 0x02 | (retry ? 0x08 : 0), sta->mac, ap->mac, ap->mac);
+    }
+    off += put_seq(buf + off, seq);
+    buf[off++] = 0x00;                       // QoS control: best effort
+    buf[off++] = 0x00;
+
+    // Bimodal sizes: TCP ACK-sized frames, and full-ish payloads
+    uint16_t body = random_below(gen, 10) < 4 ? 40 + random_below(gen, 40)
+                                              : 64 + random_below(gen, c->data_len_max > 64 ? c->data_len_max - 63 : 1);
+    if (body > c->data_len_max) body = c->data_len_max;
+    if (off + sizeof(llc_ipv4) + body > size) {
+        body = size > off + sizeof(llc_ipv4) ? size - off - sizeof(llc_ipv4) : 0;
+    }
+    memcpy(buf + off, llc_ipv4, sizeof(llc_ipv4));
+    off += sizeof(llc_ipv4);
+    for (uint16_t i = 0; i < body; i++) {
+        buf[off + i] = (uint8_t)(seq + i);
+    }
+    off += body;
+
+    frame->channel = tx->channel;
+    frame->rssi = tx->rssi + (int8_t)random_below(gen, 7) - 3;
+    frame->rate = tx->channel > 14 || random_below(gen, 8) ? ofdm_rates[random_below(gen, sizeof(ofdm_rates))]
+                                                          : 22;
+    return off;
+}
+
+static uint16_t build_control(traffic_gen_t *gen, uint8_t *buf, traffic_gen_frame_t *frame) {
+    const traffic_gen_config_t *c = &gen->config;
+    traffic_gen_device_t *ap = &gen->aps[random_below(gen, c->aps)];
+    traffic_gen_device_t *peer = c->stations ? &gen->stations[random_skewed(gen, c->stations)] : ap;
+    size_t off;
+
+    switch (random_below(gen, 3)) {
+        case 0:  // ACK
+            off = put_header(buf, 0xD4, 0x00, peer->mac, NULL, NULL);
+            break;
+        case 1:  // RTS
+            off = put_header(buf, 0xB4, 0x00, ap->mac, peer->mac, NULL);
+            break;
+        default: // CTS
+            off = put_header(buf, 0xC4, 0x00, peer->mac, NULL, NULL);
+            break;
+    }
+    frame->channel = peer->channel;
+    frame->rssi = peer->rssi;
+    frame->rate = control_rates[random_below(gen, sizeof(control_rates))];
+    return off;
+}
+
+// Synthesize the next frame
+uint16_t traffic_gen_next(traffic_gen_t *gen, uint8_t *buf, size_t size, traffic_gen_frame_t *frame) {
+    // Largest management frame: header, fixed fields and IEs
+    if (size < 128) {
+        return 0;
+    }
+
+    uint32_t pick = random_below(gen, gen->mix_total);
+    int kind = 0;
+    while (pick >= gen->config.mix[kind]) {
+        pick -= gen->config.mix[kind];
+        kind++;
+    }
+
+    uint16_t len;
+    switch (kind) {
+        case TRAFFIC_GEN_BEACON: len = build_beacon(gen, buf, frame); break;
+        case TRAFFIC_GEN_PROBE:  len = build_probe(gen, buf, frame); break;
+        case TRAFFIC_GEN_DATA:   len = build_data(gen, buf, size, frame); break;
+        default:                 len = build_control(gen, buf, frame); break;
+    }
+    frame->kind = kind;
+    gen->generated[kind]++;
+    return len;
+}
+
+// Parse a comma-separated list of small numbers
+int traffic_gen_parse_list(const char *text, uint8_t *values, int max_values) {
+    int count = 0;
+    const char *p = text;
+
+    while (*p) {
+        char *end;
+        long value = strtol(p, &end, 10);
+        if (end == p || value < 0 || value > 255 || count == max_values) {
+            return -1;
+        }
+        values[count++] = value;
+        if (*end == ',') {
+            end++;
+        } else if (*end) {
+            return -1;
+        }
+        p = end;
+    }
+    return count;
+}
+
+// Get the name of a frame kind
+const char *traffic_gen_kind_name(traffic_gen_kind_t kind) {
+    return kind < TRAFFIC_GEN_KIND_COUNT ? kind_names[kind] : "unknown";
+}
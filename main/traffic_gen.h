@@ -0,0 +1,109 @@
+#ifndef TRAFFIC_GEN_H
+#define TRAFFIC_GEN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Population and channel list limits
+#define TRAFFIC_GEN_MAX_APS          64
+#define TRAFFIC_GEN_MAX_STATIONS     512
+#define TRAFFIC_GEN_MAX_CHANNELS     16
+
+/**
+ * @brief Kinds of synthesized frames
+ */
+typedef enum {
+    TRAFFIC_GEN_BEACON = 0,
+    TRAFFIC_GEN_PROBE,           // Probe requests and responses
+    TRAFFIC_GEN_DATA,            // QoS data to and from stations
+    TRAFFIC_GEN_CONTROL,         // ACK, RTS and CTS
+    TRAFFIC_GEN_KIND_COUNT
+} traffic_gen_kind_t;
+
+/**
+ * @brief Traffic mix and population
+ */
+typedef struct {
+    uint32_t seed;               // Same seed, same frame sequence
+    uint16_t aps;
+    uint16_t stations;           // Spread over the APs, a few of them busy
+    uint8_t mix[TRAFFIC_GEN_KIND_COUNT];   // Relative weight of each kind
+    int8_t rssi_mean;            // Per-device RSSI is drawn around this
+    uint8_t rssi_stddev;
+    uint8_t channels[TRAFFIC_GEN_MAX_CHANNELS];
+    uint8_t channel_count;
+    uint16_t data_len_max;       // Largest data frame body
+    uint16_t retry_permille;     // Data frames sent again as retries
+    uint16_t random_mac_permille;  // Probe requests from one-off randomized MACs
+} traffic_gen_config_t;
+
+/**
+ * @brief One synthesized device
+ */
+typedef struct {
+    uint8_t mac[6];
+    uint8_t channel;
+    int8_t rssi;
+    uint16_t seq;
+    uint16_t ap;                 // Stations: index of their AP
+} traffic_gen_device_t;
+
+/**
+ * @brief Generator state
+ */
+typedef struct {
+    traffic_gen_config_t config;
+    uint32_t rng;
+    uint16_t mix_total;
+    traffic_gen_device_t aps[TRAFFIC_GEN_MAX_APS];
+    traffic_gen_device_t stations[TRAFFIC_GEN_MAX_STATIONS];
+    uint32_t generated[TRAFFIC_GEN_KIND_COUNT];
+} traffic_gen_t;
+
+/**
+ * @brief Metadata of a synthesized frame, as the radio would report it
+ */
+typedef struct {
+    uint8_t kind;                // traffic_gen_kind_t
+    int8_t rssi;
+    uint8_t channel;
+    uint8_t rate;                // Legacy rate in 500 kbps units
+} traffic_gen_frame_t;
+
+/**
+ * @brief Fill a configuration with a busy office-like default mix on channels 1, 6 and 11
+ */
+void traffic_gen_default_config(traffic_gen_config_t *config);
+
+/**
+ * @brief Set up the population
+ *
+ * @return false if the configuration has no APs, channels or mix weights
+ */
+bool traffic_gen_init(traffic_gen_t *gen, const traffic_gen_config_t *config);
+
+/**
+ * @brief Synthesize the next frame
+ *
+ * @param gen Generator
+ * @param buf Frame buffer (frames are at most 64 bytes larger than data_len_max)
+ * @param size Buffer size; data frames are shortened to fit
+ * @param frame Filled with the frame metadata
+ * @return Frame length without the FCS
+ */
+uint16_t traffic_gen_next(traffic_gen_t *gen, uint8_t *buf, size_t size, traffic_gen_frame_t *frame);
+
+/**
+ * @brief Parse a comma-separated list of small numbers ("1,6,11")
+ *
+ * @return Number of values, or -1 if the list is malformed, too long or has values above 255
+ */
+int traffic_gen_parse_list(const char *text, uint8_t *values, int max_values);
+
+/**
+ * @brief Get the name of a frame kind
+ */
+const char *traffic_gen_kind_name(traffic_gen_kind_t kind);
+
+#endif /* TRAFFIC_GEN_H */
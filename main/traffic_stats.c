@@ -0,0 +1,157 @@
+#include "traffic_stats.h"
+#include <string.h>
+
+// EWMA weight of a new RSSI sample is 1/2^RSSI_EWMA_SHIFT
+#define RSSI_EWMA_SHIFT 3
+
+// Update a counter block with one frame
+static void account_frame(traffic_counters_t *c, bool is_new, const frame_info_t *info) {
+    if (is_new) {
+        memset(c, 0, sizeof(*c));
+        c->first_seen_us = info->timestamp_us;
+        c->rssi_ewma = info->rssi * 16;
+    } else {
+        c->rssi_ewma += (info->rssi * 16 - c->rssi_ewma) >> RSSI_EWMA_SHIFT;
+    }
+
+    if (info->type <= IEEE80211_TYPE_DATA) {
+        c->frames[info->type]++;
+    }
+    c->bytes += info->length;
+    c->channel = info->channel;
+    c->last_seen_us = info->timestamp_us;
+}
+
+// Combine two counter blocks for the same key
+static void merge_counters(traffic_counters_t *dst, bool is_new, const traffic_counters_t *src) {
+    if (is_new) {
+        *dst = *src;
+        return;
+    }
+
+    for (int i = 0; i < 3; i++) {
+        dst->frames[i] += src->frames[i];
+    }
+    dst->bytes += src->bytes;
+    if (src->first_seen_us < dst->first_seen_us) {
+        dst->first_seen_us = src->first_seen_us;
+    }
+    if (src->last_seen_us > dst->last_seen_us) {
+        dst->last_seen_us = src->last_seen_us;
+        dst->channel = src->channel;
+        dst->rssi_ewma = src->rssi_ewma;
+    }
+}
+
+// Copy a table in LRU order
+static int export_table(const mac_table_t *table, const traffic_counters_t *values, bool is_link,
+                        traffic_entry_t *out, int max_entries) {
+    int count = 0;
+
+    for (uint16_t slot = table->lru_head; slot != MAC_TABLE_NONE && count < max_entries;
+         slot = table->nodes[slot].lru_next) {
+        const uint8_t *key = mac_table_key(table, slot);
+        traffic_entry_t *entry = &out[count++];
+
+        memcpy(entry->addr, key, 6);
+        if (is_link) {
+            memcpy(entry->station, key + 6, 6);
+        } else {
+            memset(entry->station, 0, 6);
+        }
+        entry->counters = values[slot];
+    }
+
+    return count;
+}
+
+// Reset the aggregation state
+void traffic_stats_init(traffic_stats_t *stats) {
+    mac_table_init(&stats->tx_table, stats->tx_nodes, stats->tx_buckets,
+                   TRAFFIC_MAX_TRANSMITTERS, TRAFFIC_HASH_BUCKETS, 6);
+    mac_table_init(&stats->link_table, stats->link_nodes, stats->link_buckets,
+                   TRAFFIC_MAX_LINKS, TRAFFIC_HASH_BUCKETS, 12);
+    stats->total_frames = 0;
+    stats->total_bytes = 0;
+}
+
+// Account one received frame
+void traffic_stats_update(traffic_stats_t *stats, const frame_info_t *info) {
+    bool is_new;
+
+    stats->total_frames++;
+    stats->total_bytes += info->length;
+
+    // Per transmitter
+    if (info->addr2) {
+        int slot = mac_table_touch(&stats->tx_table, info->addr2, &is_new);
+        account_frame(&stats->tx[slot], is_new, info);
+    }
+
+    // Per (BSSID, station), counting both directions
+    const uint8_t *station = ieee80211_station_addr(info);
+    if (station) {
+        uint8_t key[12];
+        memcpy(key, info->bssid, 6);
+        memcpy(key + 6, station, 6);
+
+        int slot = mac_table_touch(&stats->link_table, key, &is_new);
+        account_frame(&stats->links[slot], is_new, info);
+    }
+}
+
+// Merge the counters of src into dst
+void traffic_stats_merge(traffic_stats_t *dst, const traffic_stats_t *src) {
+    bool is_new;
+
+    // Walk from least to most recently used so the merged LRU order follows src
+    for (uint16_t slot = src->tx_table.lru_tail; slot != MAC_TABLE_NONE; slot = src->tx_nodes[slot].lru_prev) {
+        int dst_slot = mac_table_touch(&dst->tx_table, mac_table_key(&src->tx_table, slot), &is_new);
+        merge_counters(&dst->tx[dst_slot], is_new, &src->tx[slot]);
+    }
+    for (uint16_t slot = src->link_table.lru_tail; slot != MAC_TABLE_NONE; slot = src->link_nodes[slot].lru_prev) {
+        int dst_slot = mac_table_touch(&dst->link_table, mac_table_key(&src->link_table, slot), &is_new);
+        merge_counters(&dst->links[dst_slot], is_new, &src->links[slot]);
+    }
+
+    dst->tx_table.evictions += src->tx_table.evictions;
+    dst->link_table.evictions += src->link_table.evictions;
+    dst->total_frames += src->total_frames;
+    dst->total_bytes += src->total_bytes;
+}
+
+// Copy both tables into a snapshot
+void traffic_stats_snapshot(const traffic_stats_t *stats, traffic_snapshot_t *snapshot) {
+    snapshot->transmitter_count = export_table(&stats->tx_table, stats->tx, false,
+                                               snapshot->transmitters, TRAFFIC_MAX_TRANSMITTERS);
+    snapshot->link_count = export_table(&stats->link_table, stats->links, true,
+                                        snapshot->links, TRAFFIC_MAX_LINKS);
+    snapshot->total_frames = stats->total_frames;
+    snapshot->total_bytes = stats->total_bytes;
+}
+
+// Copy a batch of entries of one table, in slot order
+int traffic_stats_export(const traffic_stats_t *stats, bool links, int *cursor, traffic_entry_t *out,
+                         int max_entries) {
+    const mac_table_t *table = links ? &stats->link_table : &stats->tx_table;
+    const traffic_counters_t *values = links ? stats->links : stats->tx;
+    int count = 0;
+
+    for (; *cursor < table->capacity && count < max_entries; (*cursor)++) {
+        if (!mac_table_in_use(table, *cursor)) {
+            continue;
+        }
+        const uint8_t *key = mac_table_key(table, *cursor);
+        traffic_entry_t *entry = &out[count++];
+
+        memcpy(entry->addr, key, 6);
+        if (links) {
+            memcpy(entry->station, key + 6, 6);
+        } else {
+            memset(entry->station, 0, 6);
+        }
+        entry->counters = values[*cursor];
+    }
+
+    return count;
+}
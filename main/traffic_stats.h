@@ -0,0 +1,110 @@
+#ifndef TRAFFIC_STATS_H
+#define TRAFFIC_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ieee80211.h"
+#include "mac_table.h"
+
+// Tracked transmitters and (BSSID, station) pairs; least recently heard are evicted
+#ifndef TRAFFIC_MAX_TRANSMITTERS
+#define TRAFFIC_MAX_TRANSMITTERS     128
+#endif
+#ifndef TRAFFIC_MAX_LINKS
+#define TRAFFIC_MAX_LINKS            128
+#endif
+#ifndef TRAFFIC_HASH_BUCKETS
+#define TRAFFIC_HASH_BUCKETS         64
+#endif
+
+/**
+ * @brief Counters kept per transmitter and per (BSSID, station) pair
+ */
+typedef struct {
+    uint32_t frames[3];          // Indexed by IEEE80211_TYPE_MGMT/CTRL/DATA
+    uint64_t bytes;
+    int16_t rssi_ewma;           // RSSI EWMA in 1/16 dBm
+    uint8_t channel;             // Channel the entry was last heard on
+    uint64_t first_seen_us;
+    uint64_t last_seen_us;
+} traffic_counters_t;
+
+/**
+ * @brief Flattened entry for snapshots
+ *
+ * For transmitters only addr is set; for links addr is the BSSID and
+ * station the client address.
+ */
+typedef struct {
+    uint8_t addr[6];
+    uint8_t station[6];
+    traffic_counters_t counters;
+} traffic_entry_t;
+
+/**
+ * @brief Consistent copy of both tables, most recently heard first
+ */
+typedef struct {
+    traffic_entry_t transmitters[TRAFFIC_MAX_TRANSMITTERS];
+    traffic_entry_t links[TRAFFIC_MAX_LINKS];
+    int transmitter_count;
+    int link_count;
+    uint32_t total_frames;
+    uint64_t total_bytes;
+} traffic_snapshot_t;
+
+/**
+ * @brief Traffic aggregation state
+ */
+typedef struct {
+    mac_table_t tx_table;
+    mac_table_node_t tx_nodes[TRAFFIC_MAX_TRANSMITTERS];
+    uint16_t tx_buckets[TRAFFIC_HASH_BUCKETS];
+    traffic_counters_t tx[TRAFFIC_MAX_TRANSMITTERS];
+
+    mac_table_t link_table;
+    mac_table_node_t link_nodes[TRAFFIC_MAX_LINKS];
+    uint16_t link_buckets[TRAFFIC_HASH_BUCKETS];
+    traffic_counters_t links[TRAFFIC_MAX_LINKS];
+
+    uint32_t total_frames;
+    uint64_t total_bytes;
+} traffic_stats_t;
+
+/**
+ * @brief Reset the aggregation state
+ */
+void traffic_stats_init(traffic_stats_t *stats);
+
+/**
+ * @brief Account one received frame
+ */
+void traffic_stats_update(traffic_stats_t *stats, const frame_info_t *info);
+
+/**
+ * @brief Merge the counters of src into dst (e.g. per-thread partial results)
+ */
+void traffic_stats_merge(traffic_stats_t *dst, const traffic_stats_t *src);
+
+/**
+ * @brief Copy both tables into a snapshot
+ */
+void traffic_stats_snapshot(const traffic_stats_t *stats, traffic_snapshot_t *snapshot);
+
+/**
+ * @brief Copy a batch of entries of one table, in slot order
+ *
+ * Slots do not move as frames arrive, so a table can be read batch by batch
+ * with updates allowed in between; an entry evicted or added meanwhile may
+ * be missed.
+ *
+ * @param links Read the (BSSID, station) table instead of the transmitters
+ * @param cursor Slot to start at, 0 for the first batch; moved past the last slot read
+ * @param out Array for the entries
+ * @param max_entries Size of the out array
+ * @return Number of entries copied, 0 once the table is exhausted
+ */
+int traffic_stats_export(const traffic_stats_t *stats, bool links, int *cursor, traffic_entry_t *out,
+                         int max_entries);
+
+#endif /* TRAFFIC_STATS_H */
@@ -0,0 +1,259 @@
+#include "trigger_capture.h"
+#include "capture_storage.h"
+#include "pcap.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+static const char *TAG = "trigger_capture";
+
+// Writer task settings; flash I/O below the sniffer and web server
+#define WRITER_TASK_STACK       4096
+#define WRITER_TASK_PRIORITY    3
+#define WRITER_POLL_MS          500
+// Records are copied out of the window into this much RAM between writes
+#define WRITER_CHUNK_SIZE       8192
+#define MAX_RECORD_LEN          (PCAP_RECORD_PREFIX_LEN + TRIGGER_SNAPLEN)
+
+// Window shared between the RX callback and the writer task
+static portMUX_TYPE window_lock = portMUX_INITIALIZER_UNLOCKED;
+static trigger_window_t *window = NULL;
+static uint8_t *window_memory = NULL;
+static volatile bool window_active = false;
+
+static TaskHandle_t writer_task_handle = NULL;
+static uint8_t *chunk = NULL;
+static char files[TRIGGER_SLOTS][TRIGGER_CAPTURE_MAX_NAME];
+static uint32_t write_errors = 0;
+
+// Offset from esp_timer time to wall clock time, taken when a slot is armed
+static int64_t wall_offset_us = 0;
+
+// Write a ready capture to the storage partition and hand the slot back
+static void save_capture(int slot) {
+    portENTER_CRITICAL(&window_lock);
+    trigger_slot_t copy = window->slots[slot];
+    portEXIT_CRITICAL(&window_lock);
+    if (copy.state != TRIGGER_READY) {
+        return;
+    }
+
+    char name[TRIGGER_CAPTURE_MAX_NAME];
+    char path[sizeof(CAPTURE_STORAGE_BASE_PATH) + TRIGGER_CAPTURE_MAX_NAME + 1];
+    snprintf(name, sizeof(name), "%s%d_%lu.pcap", TRIGGER_CAPTURE_PREFIX, slot,
+             (unsigned long)(copy.saved % TRIGGER_CAPTURE_KEEP));
+    snprintf(path, sizeof(path), "%s/%s", CAPTURE_STORAGE_BASE_PATH, name);
+
+    FILE *file = capture_storage_mount() ? fopen(path, "wb") : NULL;
+    bool ok = file != NULL;
+    size_t used = 0;
+    if (ok) {
+        pcap_global_header(chunk);
+        used = PCAP_GLOBAL_HEADER_LEN;
+    }
+
+    // Copy record by record so the RX callback is only held up briefly;
+    // records overwritten meanwhile are counted as lost
+    uint32_t lost = 0;
+    uint32_t frames = 0;
+    for (uint32_t seq = copy.first_seq; seq != copy.end_seq; seq++) {
+        if (ok && used > WRITER_CHUNK_SIZE - MAX_RECORD_LEN) {
+            ok = fwrite(chunk, 1, used, file) == used;
+            used = 0;
+        }
+
+        uint16_t len = 0;
+        portENTER_CRITICAL(&window_lock);
+        const uint8_t *record = trigger_window_record(window, seq, &len);
+        if (record) {
+            memcpy(chunk + used, record, len);
+        }
+        portEXIT_CRITICAL(&window_lock);
+
+        if (record) {
+            used += len;
+            frames++;
+        } else {
+            lost++;
+        }
+    }
+    if (ok && used) {
+        ok = fwrite(chunk, 1, used, file) == used;
+    }
+    if (file && fclose(file) != 0) {
+        ok = false;
+    }
+
+    portENTER_CRITICAL(&window_lock);
+    trigger_window_saved(window, slot, copy.fired, lost);
+    window_active = trigger_window_active(window);
+    if (ok) {
+        strcpy(files[slot], name);
+    } else {
+        write_errors++;
+    }
+    portEXIT_CRITICAL(&window_lock);
+
+    if (ok) {
+        ESP_LOGI(TAG, "Slot %d: saved %lu frames to %s (%lu lost)", slot, (unsigned long)frames, name,
+                 (unsigned long)lost);
+    } else {
+        ESP_LOGW(TAG, "Slot %d: failed to write %s", slot, path);
+    }
+}
+
+// Writer task: closes overdue captures and saves ready ones
+static void trigger_writer_task(void *pvParameters) {
+    ESP_LOGI(TAG, "Trigger writer task started");
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(WRITER_POLL_MS));
+
+        portENTER_CRITICAL(&window_lock);
+        uint8_t ready = trigger_window_poll(window, esp_timer_get_time());
+        window_active = trigger_window_active(window);
+        portEXIT_CRITICAL(&window_lock);
+
+        for (int i = 0; i < TRIGGER_SLOTS; i++) {
+            if (ready & (1 << i)) {
+                save_capture(i);
+            }
+        }
+    }
+}
+
+// Allocate the window and start the writer on first use
+static bool ensure_started(void) {
+    if (writer_task_handle) {
+        return true;
+    }
+
+    if (!window) {
+        window = malloc(sizeof(trigger_window_t));
+        window_memory = malloc(TRIGGER_WINDOW_BYTES);
+        chunk = malloc(WRITER_CHUNK_SIZE);
+        if (!window || !window_memory || !chunk) {
+            ESP_LOGE(TAG, "Failed to allocate the pre-trigger window");
+            free(window);
+            free(window_memory);
+            free(chunk);
+            window = NULL;
+            window_memory = NULL;
+            chunk = NULL;
+            return false;
+        }
+        trigger_window_init(window, window_memory, TRIGGER_WINDOW_BYTES);
+    }
+
+    if (xTaskCreate(trigger_writer_task, "trigger_writer", WRITER_TASK_STACK, NULL, WRITER_TASK_PRIORITY,
+                    &writer_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create trigger writer task");
+        writer_task_handle = NULL;
+        return false;
+    }
+    return true;
+}
+
+// Arm a trigger slot
+bool trigger_capture_arm(uint8_t slot, const trigger_config_t *config) {
+    if (!ensure_started()) {
+        return false;
+    }
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    int64_t offset = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec - esp_timer_get_time();
+
+    portENTER_CRITICAL(&window_lock);
+    wall_offset_us = offset;
+    bool armed = trigger_window_arm(window, slot, config);
+    window_active = trigger_window_active(window);
+    portEXIT_CRITICAL(&window_lock);
+
+    if (armed) {
+        ESP_LOGI(TAG, "Slot %u armed: %u frames before, %u after", slot, config->pre, config->post);
+    }
+    return armed;
+}
+
+// Disarm a trigger slot
+bool trigger_capture_disarm(uint8_t slot) {
+    if (slot >= TRIGGER_SLOTS) {
+        return false;
+    }
+    if (!window) {
+        return true;
+    }
+
+    portENTER_CRITICAL(&window_lock);
+    trigger_window_disarm(window, slot);
+    window_active = trigger_window_active(window);
+    portEXIT_CRITICAL(&window_lock);
+    return true;
+}
+
+// Offer a captured frame to the trigger slots
+void trigger_capture_push(const frame_info_t *info, const uint8_t *frame, uint16_t caplen, uint8_t rate) {
+    if (!window_active) {
+        return;
+    }
+
+    if (caplen > TRIGGER_SNAPLEN) {
+        caplen = TRIGGER_SNAPLEN;
+    }
+    uint8_t prefix[PCAP_RECORD_PREFIX_LEN];
+    pcap_record_prefix(prefix, info->timestamp_us + wall_offset_us, caplen, info->length, info->rssi,
+                       info->channel, rate);
+
+    portENTER_CRITICAL(&window_lock);
+    uint8_t ready = trigger_window_push(window, info, prefix, sizeof(prefix), frame, caplen);
+    window_active = trigger_window_active(window);
+    portEXIT_CRITICAL(&window_lock);
+
+    if (ready && writer_task_handle) {
+        xTaskNotifyGive(writer_task_handle);
+    }
+}
+
+// Get the slots and counters
+void trigger_capture_get_status(trigger_capture_status_t *status) {
+    memset(status, 0, sizeof(*status));
+    if (!window) {
+        return;
+    }
+
+    portENTER_CRITICAL(&window_lock);
+    status->active = trigger_window_active(window);
+    status->window_frames = window->next_seq - window->first_seq;
+    status->frames = window->frames;
+    status->bytes = window->bytes;
+    status->dropped = window->dropped;
+    status->write_errors = write_errors;
+    memcpy(status->slots, window->slots, sizeof(status->slots));
+    memcpy(status->files, files, sizeof(status->files));
+    portEXIT_CRITICAL(&window_lock);
+}
+
+// Open a saved capture for reading
+FILE *trigger_capture_open(const char *name) {
+    unsigned slot, index;
+    char expected[TRIGGER_CAPTURE_MAX_NAME];
+    char path[sizeof(CAPTURE_STORAGE_BASE_PATH) + TRIGGER_CAPTURE_MAX_NAME + 1];
+
+    // Only names this module writes, so nothing else on the partition is reachable
+    if (sscanf(name, TRIGGER_CAPTURE_PREFIX "%u_%u.pcap", &slot, &index) != 2 ||
+        slot >= TRIGGER_SLOTS || index >= TRIGGER_CAPTURE_KEEP) {
+        return NULL;
+    }
+    snprintf(expected, sizeof(expected), "%s%u_%u.pcap", TRIGGER_CAPTURE_PREFIX, slot, index);
+    if (strcmp(name, expected) != 0 || !capture_storage_mount()) {
+        return NULL;
+    }
+
+    snprintf(path, sizeof(path), "%s/%s", CAPTURE_STORAGE_BASE_PATH, name);
+    return fopen(path, "rb");
+}
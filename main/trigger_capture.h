@@ -0,0 +1,72 @@
+#ifndef TRIGGER_CAPTURE_H
+#define TRIGGER_CAPTURE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "trigger_window.h"
+
+// Saved captures are <prefix><slot>_<n>.pcap on the storage partition
+#define TRIGGER_CAPTURE_PREFIX       "trig"
+// Captures kept per slot; the oldest is overwritten
+#define TRIGGER_CAPTURE_KEEP         4
+#define TRIGGER_CAPTURE_MAX_NAME     24
+
+/**
+ * @brief Trigger slots and counters
+ */
+typedef struct {
+    bool active;                 // A slot is armed or collecting
+    uint32_t window_frames;      // Frames held in the pre-trigger window
+    uint64_t frames;             // Frames appended to the window
+    uint64_t bytes;
+    uint32_t dropped;            // Frames left out while fired captures filled the window
+    uint32_t write_errors;
+    trigger_slot_t slots[TRIGGER_SLOTS];
+    char files[TRIGGER_SLOTS][TRIGGER_CAPTURE_MAX_NAME];  // Last capture saved per slot ("" if none)
+} trigger_capture_status_t;
+
+/**
+ * @brief Arm a trigger slot
+ *
+ * While any slot is armed the sniffer keeps a rolling window of recent
+ * frames. When the slot's condition matches, the frames around the
+ * trigger are written to the storage partition by a low-priority task.
+ *
+ * @param slot Slot number, below TRIGGER_SLOTS
+ * @param config Condition and capture size
+ * @return false if the configuration is invalid or out of memory
+ */
+bool trigger_capture_arm(uint8_t slot, const trigger_config_t *config);
+
+/**
+ * @brief Disarm a trigger slot, dropping a capture it has not saved yet
+ *
+ * @return false if the slot number is invalid
+ */
+bool trigger_capture_disarm(uint8_t slot);
+
+/**
+ * @brief Offer a captured frame to the trigger slots (called from the RX callback)
+ *
+ * @param info Parsed frame, with its radio metadata
+ * @param frame 802.11 frame without the FCS
+ * @param caplen Bytes of the frame to keep, as the overload governor allows
+ * @param rate Legacy rate in 500 kbps units, 0 if unknown
+ */
+void trigger_capture_push(const frame_info_t *info, const uint8_t *frame, uint16_t caplen, uint8_t rate);
+
+/**
+ * @brief Get the slots and counters
+ */
+void trigger_capture_get_status(trigger_capture_status_t *status);
+
+/**
+ * @brief Open a saved capture for reading
+ *
+ * @param name File name as reported by trigger_capture_get_status()
+ * @return The open file, or NULL if the name is invalid or the capture is missing
+ */
+FILE *trigger_capture_open(const char *name);
+
+#endif /* TRIGGER_CAPTURE_H */
@@ -0,0 +1,366 @@
+#include "trigger_window.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *state_names[] = {
+    [TRIGGER_IDLE]       = "idle",
+    [TRIGGER_ARMED]      = "armed",
+    [TRIGGER_COLLECTING] = "collecting",
+    [TRIGGER_READY]      = "ready",
+};
+
+// Frame kind names; groups come first so formatting prefers them
+static const struct {
+    const char *name;
+    uint64_t frames;
+} frame_names[] = {
+    { "any",          TRIGGER_FRAMES_ANY },
+    { "mgmt",         TRIGGER_FRAMES_MGMT },
+    { "ctrl",         TRIGGER_FRAMES_CTRL },
+    { "data",         TRIGGER_FRAMES_DATA },
+    { "assoc_req",    TRIGGER_FRAME_BIT(IEEE80211_TYPE_MGMT, IEEE80211_STYPE_ASSOC_REQ) },
+    { "assoc_resp",   TRIGGER_FRAME_BIT(IEEE80211_TYPE_MGMT, IEEE80211_STYPE_ASSOC_RESP) },
+    { "reassoc_req",  TRIGGER_FRAME_BIT(IEEE80211_TYPE_MGMT, IEEE80211_STYPE_REASSOC_REQ) },
+    { "reassoc_resp", TRIGGER_FRAME_BIT(IEEE80211_TYPE_MGMT, IEEE80211_STYPE_REASSOC_RESP) },
+    { "probe_req",    TRIGGER_FRAME_BIT(IEEE80211_TYPE_MGMT, IEEE80211_STYPE_PROBE_REQ) },
+    { "probe_resp",   TRIGGER_FRAME_BIT(IEEE80211_TYPE_MGMT, IEEE80211_STYPE_PROBE_RESP) },
+    { "beacon",       TRIGGER_FRAME_BIT(IEEE80211_TYPE_MGMT, IEEE80211_STYPE_BEACON) },
+    { "disassoc",     TRIGGER_FRAME_BIT(IEEE80211_TYPE_MGMT, IEEE80211_STYPE_DISASSOC) },
+    { "auth",         TRIGGER_FRAME_BIT(IEEE80211_TYPE_MGMT, IEEE80211_STYPE_AUTH) },
+    { "deauth",       TRIGGER_FRAME_BIT(IEEE80211_TYPE_MGMT, IEEE80211_STYPE_DEAUTH) },
+    { "action",       TRIGGER_FRAME_BIT(IEEE80211_TYPE_MGMT, IEEE80211_STYPE_ACTION) },
+    { "block_ack_req", TRIGGER_FRAME_BIT(IEEE80211_TYPE_CTRL, 8) },
+    { "block_ack",    TRIGGER_FRAME_BIT(IEEE80211_TYPE_CTRL, 9) },
+    { "ps_poll",      TRIGGER_FRAME_BIT(IEEE80211_TYPE_CTRL, 10) },
+    { "rts",          TRIGGER_FRAME_BIT(IEEE80211_TYPE_CTRL, 11) },
+    { "cts",          TRIGGER_FRAME_BIT(IEEE80211_TYPE_CTRL, 12) },
+    { "ack",          TRIGGER_FRAME_BIT(IEEE80211_TYPE_CTRL, 13) },
+    { "null",         TRIGGER_FRAME_BIT(IEEE80211_TYPE_DATA, 4) | TRIGGER_FRAME_BIT(IEEE80211_TYPE_DATA, 12) },
+    { "eapol",        TRIGGER_FRAME_EAPOL },
+};
+
+#define FRAME_NAME_COUNT (sizeof(frame_names) / sizeof(frame_names[0]))
+
+// Recompute the armed and collecting sets and the union of the armed masks
+static void update_masks(trigger_window_t *w) {
+    w->frames_mask = 0;
+    w->armed = 0;
+    w->collecting = 0;
+    for (int i = 0; i < TRIGGER_SLOTS; i++) {
+        const trigger_slot_t *slot = &w->slots[i];
+        if (slot->state == TRIGGER_ARMED) {
+            w->armed |= 1 << i;
+            w->frames_mask |= slot->config.frames;
+        } else if (slot->state == TRIGGER_COLLECTING) {
+            w->collecting |= 1 << i;
+        }
+    }
+}
+
+// Oldest record a fired slot still needs; false if no capture is pending
+static bool pinned_seq(const trigger_window_t *w, uint32_t *seq) {
+    bool pinned = false;
+    for (int i = 0; i < TRIGGER_SLOTS; i++) {
+        const trigger_slot_t *slot = &w->slots[i];
+        if (slot->state != TRIGGER_COLLECTING && slot->state != TRIGGER_READY) {
+            continue;
+        }
+        if (!pinned || (int32_t)(slot->first_seq - *seq) < 0) {
+            *seq = slot->first_seq;
+        }
+        pinned = true;
+    }
+    return pinned;
+}
+
+// Copy a record in at the head, evicting the oldest records it overlaps;
+// false if that would evict a record a fired slot keeps
+static bool append_record(trigger_window_t *w, const uint8_t *prefix, uint16_t prefix_len,
+                          const uint8_t *data, uint16_t data_len) {
+    uint32_t len = prefix_len + data_len;
+    if (len > w->size) {
+        return false;
+    }
+    uint32_t head = w->head;
+    uint32_t first_seq = w->first_seq;
+    if (head + len > w->size) {
+        // Skip the tail; records still in it are older than any at the start
+        while (first_seq != w->next_seq && w->records[first_seq % TRIGGER_WINDOW_RECORDS].offset >= head) {
+            first_seq++;
+        }
+        head = 0;
+    }
+
+    // Records follow the head in age order, so only the oldest can be in the way
+    while (first_seq != w->next_seq) {
+        const trigger_record_t *oldest = &w->records[first_seq % TRIGGER_WINDOW_RECORDS];
+        bool overlaps = oldest->offset < head + len && oldest->offset + oldest->len > head;
+        if (!overlaps && w->next_seq - first_seq < TRIGGER_WINDOW_RECORDS) {
+            break;
+        }
+        first_seq++;
+    }
+
+    uint32_t pinned = 0;
+    if (pinned_seq(w, &pinned) && (int32_t)(first_seq - pinned) > 0) {
+        w->dropped++;
+        return false;
+    }
+    w->head = head;
+    w->first_seq = first_seq;
+
+    trigger_record_t *record = &w->records[w->next_seq % TRIGGER_WINDOW_RECORDS];
+    record->offset = w->head;
+    record->len = len;
+    memcpy(w->memory + w->head, prefix, prefix_len);
+    memcpy(w->memory + w->head + prefix_len, data, data_len);
+    w->head += len;
+    w->next_seq++;
+    w->frames++;
+    w->bytes += len;
+    return true;
+}
+
+// Frame kind bits of a frame; EAPOL is only looked for when a slot wants it
+static uint64_t frame_bits(const trigger_window_t *w, const frame_info_t *info) {
+    if (info->type > IEEE80211_TYPE_DATA) {
+        return 0;
+    }
+    uint64_t bits = TRIGGER_FRAME_BIT(info->type, info->subtype);
+    if ((w->frames_mask & TRIGGER_FRAME_EAPOL) && info->type == IEEE80211_TYPE_DATA && ieee80211_is_eapol(info)) {
+        bits |= TRIGGER_FRAME_EAPOL;
+    }
+    return bits;
+}
+
+static bool addr_matches(const trigger_config_t *config, const frame_info_t *info) {
+    return (info->addr1 && memcmp(info->addr1, config->addr, 6) == 0) ||
+           (info->addr2 && memcmp(info->addr2, config->addr, 6) == 0) ||
+           (info->addr3 && memcmp(info->addr3, config->addr, 6) == 0);
+}
+
+// Count a match; true once burst matches fall within burst_ms
+static bool burst_reached(trigger_slot_t *slot, uint64_t now_us) {
+    uint8_t burst = slot->config.burst;
+    if (burst <= 1) {
+        return true;
+    }
+
+    slot->recent_us[slot->recent_next] = now_us;
+    slot->recent_next = (slot->recent_next + 1) % burst;
+    if (slot->recent_count < burst) {
+        slot->recent_count++;
+    }
+    // The next entry to be overwritten is the match burst - 1 matches ago
+    return slot->recent_count == burst &&
+           now_us - slot->recent_us[slot->recent_next] <= (uint64_t)slot->config.burst_ms * 1000;
+}
+
+// Fire a slot on the newest record
+static void fire(trigger_window_t *w, trigger_slot_t *slot, uint64_t now_us) {
+    uint32_t seq = w->next_seq - 1;
+    uint32_t held = seq - w->first_seq;
+
+    slot->trigger_seq = seq;
+    slot->first_seq = held < slot->config.pre ? w->first_seq : seq - slot->config.pre;
+    slot->end_seq = seq + 1 + slot->config.post;
+    slot->triggered_us = now_us;
+    slot->recent_count = 0;
+    slot->fired++;
+    slot->state = slot->config.post ? TRIGGER_COLLECTING : TRIGGER_READY;
+}
+
+// Initialize the window with all slots idle
+void trigger_window_init(trigger_window_t *w, uint8_t *memory, uint32_t size) {
+    memset(w, 0, sizeof(*w));
+    w->memory = memory;
+    w->size = size;
+}
+
+// Arm a slot
+bool trigger_window_arm(trigger_window_t *w, int slot, const trigger_config_t *config) {
+    if (slot < 0 || slot >= TRIGGER_SLOTS || !config->frames || config->burst > TRIGGER_MAX_BURST) {
+        return false;
+    }
+    // The capture, trigger frame included, plus the record lost at the wrap
+    // must fit, or its post frames would have nowhere to go
+    uint32_t records = (uint32_t)config->pre + config->post + 2;
+    if (records > TRIGGER_WINDOW_RECORDS || records * TRIGGER_RECORD_MAX_LEN > w->size) {
+        return false;
+    }
+
+    trigger_slot_t *s = &w->slots[slot];
+    s->config = *config;
+    s->state = TRIGGER_ARMED;
+    s->recent_next = 0;
+    s->recent_count = 0;
+    update_masks(w);
+    return true;
+}
+
+// Disarm a slot
+void trigger_window_disarm(trigger_window_t *w, int slot) {
+    if (slot < 0 || slot >= TRIGGER_SLOTS) {
+        return;
+    }
+    w->slots[slot].state = TRIGGER_IDLE;
+    update_masks(w);
+}
+
+// Append a frame to the window and evaluate the armed slots
+uint8_t trigger_window_push(trigger_window_t *w, const frame_info_t *info, const uint8_t *prefix, uint16_t prefix_len,
+                            const uint8_t *data, uint16_t data_len) {
+    if (!trigger_window_active(w)) {
+        return 0;
+    }
+    // A frame that is not in the window can neither fire a slot nor complete one
+    if (!append_record(w, prefix, prefix_len, data, data_len)) {
+        return 0;
+    }
+
+    uint8_t ready = 0;
+    bool changed = false;
+
+    // Collecting slots are complete once their last post frame is in
+    for (int i = 0; w->collecting && i < TRIGGER_SLOTS; i++) {
+        trigger_slot_t *slot = &w->slots[i];
+        if ((w->collecting & (1 << i)) && (int32_t)(w->next_seq - slot->end_seq) >= 0) {
+            slot->state = TRIGGER_READY;
+            ready |= 1 << i;
+            changed = true;
+        }
+    }
+
+    uint64_t bits = w->armed ? frame_bits(w, info) : 0;
+    if (bits & w->frames_mask) {
+        for (int i = 0; i < TRIGGER_SLOTS; i++) {
+            trigger_slot_t *slot = &w->slots[i];
+            if (!(w->armed & (1 << i)) || !(slot->config.frames & bits) ||
+                (slot->config.match_addr && !addr_matches(&slot->config, info))) {
+                continue;
+            }
+            slot->matches++;
+            if (burst_reached(slot, info->timestamp_us)) {
+                fire(w, slot, info->timestamp_us);
+                if (slot->state == TRIGGER_READY) {
+                    ready |= 1 << i;
+                }
+                changed = true;
+            }
+        }
+    }
+
+    if (changed) {
+        update_masks(w);
+    }
+    return ready;
+}
+
+// Close captures whose post frames are overdue
+uint8_t trigger_window_poll(trigger_window_t *w, uint64_t now_us) {
+    uint8_t ready = 0;
+    bool changed = false;
+
+    for (int i = 0; i < TRIGGER_SLOTS; i++) {
+        trigger_slot_t *slot = &w->slots[i];
+        if (slot->state == TRIGGER_COLLECTING &&
+            now_us - slot->triggered_us >= (uint64_t)TRIGGER_POST_TIMEOUT_MS * 1000) {
+            slot->end_seq = w->next_seq;
+            slot->state = TRIGGER_READY;
+            changed = true;
+        }
+        if (slot->state == TRIGGER_READY) {
+            ready |= 1 << i;
+        }
+    }
+
+    if (changed) {
+        update_masks(w);
+    }
+    return ready;
+}
+
+// Get a record of the window
+const uint8_t *trigger_window_record(const trigger_window_t *w, uint32_t seq, uint16_t *len) {
+    if (seq - w->first_seq >= w->next_seq - w->first_seq) {
+        return NULL;
+    }
+    const trigger_record_t *record = &w->records[seq % TRIGGER_WINDOW_RECORDS];
+    *len = record->len;
+    return w->memory + record->offset;
+}
+
+// Hand out a ready capture
+void trigger_window_saved(trigger_window_t *w, int slot, uint32_t fired, uint32_t lost) {
+    if (slot < 0 || slot >= TRIGGER_SLOTS) {
+        return;
+    }
+    trigger_slot_t *s = &w->slots[slot];
+    if (s->state != TRIGGER_READY || s->fired != fired) {
+        return;
+    }
+
+    s->saved++;
+    s->lost += lost;
+    s->state = s->config.rearm ? TRIGGER_ARMED : TRIGGER_IDLE;
+    update_masks(w);
+}
+
+// Parse a comma-separated list of frame kinds
+bool trigger_window_parse_frames(const char *text, uint64_t *frames) {
+    uint64_t mask = 0;
+    const char *p = text;
+
+    while (*p) {
+        size_t len = strcspn(p, ",");
+        size_t i;
+        for (i = 0; i < FRAME_NAME_COUNT; i++) {
+            if (strlen(frame_names[i].name) == len && strncmp(frame_names[i].name, p, len) == 0) {
+                mask |= frame_names[i].frames;
+                break;
+            }
+        }
+        if (i == FRAME_NAME_COUNT) {
+            return false;
+        }
+        p += len;
+        if (*p == ',') {
+            p++;
+        }
+    }
+
+    *frames = mask;
+    return mask != 0;
+}
+
+// Format a frame mask as a list of frame kinds
+int trigger_window_format_frames(uint64_t frames, char *out, size_t size) {
+    int len = 0;
+    out[0] = '\0';
+
+    for (size_t i = 0; i < FRAME_NAME_COUNT && frames; i++) {
+        if ((frames & frame_names[i].frames) != frame_names[i].frames) {
+            continue;
+        }
+        int n = snprintf(out + len, size - len, "%s%s", len ? "," : "", frame_names[i].name);
+        if (n < 0 || (size_t)n >= size - len) {
+            break;
+        }
+        len += n;
+        frames &= ~frame_names[i].frames;
+    }
+
+    // Kinds without a name
+    if (frames && (size_t)len < size) {
+        int n = snprintf(out + len, size - len, "%s0x%llx", len ? "," : "", (unsigned long long)frames);
+        if (n > 0 && (size_t)n < size - len) {
+            len += n;
+        }
+    }
+    return len;
+}
+
+// Get the name of a state
+const char *trigger_window_state_name(trigger_state_t state) {
+    return state <= TRIGGER_READY ? state_names[state] : "unknown";
+}
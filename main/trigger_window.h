@@ -0,0 +1,198 @@
+#ifndef TRIGGER_WINDOW_H
+#define TRIGGER_WINDOW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "ieee80211.h"
+#include "pcap.h"
+
+// Trigger slots armed in parallel
+#define TRIGGER_SLOTS                4
+// Memory and record index of the rolling pre-trigger window
+#define TRIGGER_WINDOW_BYTES         (48 * 1024)
+#define TRIGGER_WINDOW_RECORDS       1024
+// Frames are truncated to this in the window
+#define TRIGGER_SNAPLEN              512
+// Longest record in the window: pcap record prefix and truncated frame
+#define TRIGGER_RECORD_MAX_LEN       (PCAP_RECORD_PREFIX_LEN + TRIGGER_SNAPLEN)
+// Frames before plus after the trigger that one slot may keep: with the
+// trigger frame they must fit in the window at full length, less one
+// record's worth lost where the ring wraps
+#define TRIGGER_MAX_FRAMES           (TRIGGER_WINDOW_BYTES / TRIGGER_RECORD_MAX_LEN - 2)
+#define TRIGGER_MAX_BURST            32
+// A capture is closed this long after its trigger even if the post frames never came
+#define TRIGGER_POST_TIMEOUT_MS      10000
+
+// Frame masks: one bit per (type, subtype), plus one for EAPOL data frames
+#define TRIGGER_FRAME_BIT(type, subtype) (1ULL << ((type) * 16 + (subtype)))
+#define TRIGGER_FRAME_EAPOL          (1ULL << 63)
+#define TRIGGER_FRAMES_MGMT          0x000000000000FFFFULL
+#define TRIGGER_FRAMES_CTRL          0x00000000FFFF0000ULL
+#define TRIGGER_FRAMES_DATA          0x0000FFFF00000000ULL
+#define TRIGGER_FRAMES_ANY           (TRIGGER_FRAMES_MGMT | TRIGGER_FRAMES_CTRL | TRIGGER_FRAMES_DATA)
+
+typedef enum {
+    TRIGGER_IDLE = 0,
+    TRIGGER_ARMED,               // Waiting for the condition
+    TRIGGER_COLLECTING,          // Fired, collecting the post-trigger frames
+    TRIGGER_READY,               // Capture complete, waiting to be saved
+} trigger_state_t;
+
+/**
+ * @brief Condition and capture size of a trigger slot
+ *
+ * A frame matches when its kind is in frames and, if match_addr is set, addr
+ * is one of its addresses. The slot fires on the burst-th match within
+ * burst_ms, or on the first match when burst is 0 or 1.
+ */
+typedef struct {
+    uint64_t frames;             // TRIGGER_FRAME_BIT()s and TRIGGER_FRAME_EAPOL
+    bool match_addr;
+    uint8_t addr[6];
+    uint8_t burst;               // At most TRIGGER_MAX_BURST
+    uint32_t burst_ms;
+    uint16_t pre;                // Frames kept from before the trigger
+    uint16_t post;               // Frames collected after it
+    bool rearm;                  // Arm again once the capture is saved
+} trigger_config_t;
+
+/**
+ * @brief A trigger slot and its counters
+ */
+typedef struct {
+    trigger_config_t config;
+    trigger_state_t state;
+    uint64_t recent_us[TRIGGER_MAX_BURST];  // Times of the last matches, for bursts
+    uint8_t recent_next;
+    uint8_t recent_count;
+
+    // Capture of the last trigger: window records [first_seq, end_seq)
+    uint32_t first_seq;
+    uint32_t trigger_seq;
+    uint32_t end_seq;
+    uint64_t triggered_us;
+
+    uint32_t matches;            // Frames that met the condition
+    uint32_t fired;
+    uint32_t saved;
+    uint32_t lost;               // Records overwritten in the window before being saved
+} trigger_slot_t;
+
+typedef struct {
+    uint32_t offset;
+    uint16_t len;
+} trigger_record_t;
+
+/**
+ * @brief Rolling pre-trigger window shared by the trigger slots
+ *
+ * Every frame is appended to a byte ring while a slot is armed or
+ * collecting, overwriting the oldest records. A slot that fires marks the
+ * range of records to keep, from pre frames before the trigger to post
+ * frames after it, and pins them until the capture is handed out: a frame
+ * that would overwrite a pinned record is dropped instead. The records are
+ * read out with trigger_window_record() once the slot is ready. Records
+ * are opaque to the window (the caller stores pcap records).
+ */
+typedef struct {
+    uint8_t *memory;
+    uint32_t size;
+    uint32_t head;               // Write offset
+    trigger_record_t records[TRIGGER_WINDOW_RECORDS];  // By sequence number modulo the size
+    uint32_t first_seq;          // Oldest record still held
+    uint32_t next_seq;
+
+    uint64_t frames_mask;        // Frames any armed slot may match
+    uint8_t armed;               // One bit per slot in TRIGGER_ARMED
+    uint8_t collecting;          // One bit per slot in TRIGGER_COLLECTING
+    trigger_slot_t slots[TRIGGER_SLOTS];
+
+    uint64_t frames;             // Frames appended
+    uint64_t bytes;
+    uint32_t dropped;            // Frames left out because fired captures filled the window
+} trigger_window_t;
+
+/**
+ * @brief Initialize the window with all slots idle
+ *
+ * @param memory Ring memory of size bytes
+ */
+void trigger_window_init(trigger_window_t *w, uint8_t *memory, uint32_t size);
+
+/**
+ * @brief Arm a slot, dropping any capture it had not handed out
+ *
+ * @return false if the slot or the configuration is invalid, or if pre
+ *         plus post frames of TRIGGER_RECORD_MAX_LEN would not fit in the window
+ */
+bool trigger_window_arm(trigger_window_t *w, int slot, const trigger_config_t *config);
+
+/**
+ * @brief Disarm a slot, dropping any capture it had not handed out
+ */
+void trigger_window_disarm(trigger_window_t *w, int slot);
+
+/**
+ * @brief Check whether the window needs frames (a slot is armed or collecting)
+ */
+static inline bool trigger_window_active(const trigger_window_t *w) {
+    return w->armed || w->collecting;
+}
+
+/**
+ * @brief Append a frame to the window and evaluate the armed slots
+ *
+ * The record is prefix followed by data. While waiting, a frame costs the
+ * copy and one mask test; the slots are only looked at for frame kinds one
+ * of them matches.
+ *
+ * @param info Parsed frame
+ * @return One bit per slot whose capture became ready
+ */
+uint8_t trigger_window_push(trigger_window_t *w, const frame_info_t *info, const uint8_t *prefix, uint16_t prefix_len,
+                            const uint8_t *data, uint16_t data_len);
+
+/**
+ * @brief Close captures whose post frames are overdue
+ *
+ * @return One bit per slot with a ready capture
+ */
+uint8_t trigger_window_poll(trigger_window_t *w, uint64_t now_us);
+
+/**
+ * @brief Get a record of the window
+ *
+ * @return The record, or NULL if it was overwritten (or not written yet)
+ */
+const uint8_t *trigger_window_record(const trigger_window_t *w, uint32_t seq, uint16_t *len);
+
+/**
+ * @brief Hand out a ready capture: re-arm the slot or leave it idle
+ *
+ * @param fired The slot's fired counter when the capture was read, so a
+ *              slot re-armed meanwhile is left alone
+ * @param lost Records of the capture that had been overwritten
+ */
+void trigger_window_saved(trigger_window_t *w, int slot, uint32_t fired, uint32_t lost);
+
+/**
+ * @brief Parse a comma-separated list of frame kinds ("deauth,disassoc", "mgmt", "eapol")
+ *
+ * @return false if a name is unknown
+ */
+bool trigger_window_parse_frames(const char *text, uint64_t *frames);
+
+/**
+ * @brief Format a frame mask as a list of frame kinds
+ *
+ * @return Length of the text
+ */
+int trigger_window_format_frames(uint64_t frames, char *out, size_t size);
+
+/**
+ * @brief Get the name of a state
+ */
+const char *trigger_window_state_name(trigger_state_t state);
+
+#endif /* TRIGGER_WINDOW_H */
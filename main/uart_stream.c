@@ -0,0 +1,251 @@
+#include "uart_stream.h"
+#include "slip_frame.h"
+#include "pcap.h"
+#include "wifi_sniffer.h"
+#include "board_config.h"
+#include "driver/uart.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+static const char *TAG = "uart_stream";
+
+// The console UART, on GPIO_UART_TX/RX
+#ifdef CONFIG_ESP_CONSOLE_UART_NUM
+#define STREAM_UART             CONFIG_ESP_CONSOLE_UART_NUM
+#else
+#define STREAM_UART             UART_NUM_0
+#endif
+#ifdef CONFIG_ESP_CONSOLE_UART_BAUDRATE
+#define CONSOLE_BAUD            CONFIG_ESP_CONSOLE_UART_BAUDRATE
+#else
+#define CONSOLE_BAUD            115200
+#endif
+
+// Sender task settings; below the channel hopper so hops stay on time
+#define SENDER_TASK_STACK       4096
+#define SENDER_TASK_PRIORITY    4
+#define SENDER_IDLE_MS          10
+#define SENDER_BATCH_PACKETS    16
+
+static portMUX_TYPE stream_lock = portMUX_INITIALIZER_UNLOCKED;
+static uart_stream_status_t stream_status;
+static volatile bool stop_requested = false;
+static TaskHandle_t sender_task_handle = NULL;
+static bool installed_driver = false;
+static vprintf_like_t saved_vprintf = NULL;
+
+// One encoded frame: the largest record, every byte escaped
+static uint8_t frame_buf[SLIP_FRAME_BOUND(PCAP_RECORD_PREFIX_LEN + MAX_PACKET_SIZE)];
+
+// Offset from esp_timer time to wall clock time, taken at start
+static int64_t wall_offset_us = 0;
+
+// Log sink while streaming: count and discard
+static int discard_log(const char *format, va_list args) {
+    portENTER_CRITICAL(&stream_lock);
+    stream_status.suppressed_logs++;
+    portEXIT_CRITICAL(&stream_lock);
+    return 0;
+}
+
+// Frames the capture buffer rejected or evicted before anyone read them
+static uint32_t device_dropped(void) {
+    capture_class_stats_t stats[CAPTURE_CLASS_COUNT];
+    uint32_t dropped = 0;
+
+    wifi_sniffer_get_class_stats(stats);
+    for (int i = 0; i < CAPTURE_CLASS_COUNT; i++) {
+        dropped += stats[i].dropped + stats[i].evicted;
+    }
+    return dropped;
+}
+
+// Encode and write one frame according to the policy
+static void send_frame(uint8_t type, const uint8_t *head, size_t head_len, const uint8_t *data, size_t len) {
+    size_t encoded = slip_frame_encode(type, stream_status.next_seq, head, head_len, data, len,
+                                       frame_buf, sizeof(frame_buf));
+    if (encoded == 0) {
+        return;
+    }
+
+    // Records give way under DROP; headers and stats always go out
+    if (stream_status.policy == UART_STREAM_DROP && type == SLIP_FRAME_PCAP_RECORD) {
+        size_t free_space = 0;
+        uart_get_tx_buffer_free_size(STREAM_UART, &free_space);
+        if (free_space < encoded) {
+            portENTER_CRITICAL(&stream_lock);
+            stream_status.dropped++;
+            portEXIT_CRITICAL(&stream_lock);
+            return;
+        }
+    }
+
+    // The sequence number only advances for frames that are sent, so
+    // gaps at the host mean corruption on the line, not local drops
+    int written = uart_write_bytes(STREAM_UART, frame_buf, encoded);
+
+    portENTER_CRITICAL(&stream_lock);
+    stream_status.next_seq++;
+    if (written > 0) {
+        stream_status.bytes += written;
+    }
+    if (type == SLIP_FRAME_PCAP_RECORD) {
+        stream_status.frames++;
+    }
+    portEXIT_CRITICAL(&stream_lock);
+}
+
+// Send the in-band counters
+static void send_stats(void) {
+    uint8_t stats[16];
+    uint32_t values[4];
+    uint32_t dropped_in_buffer = device_dropped();
+
+    portENTER_CRITICAL(&stream_lock);
+    stream_status.device_dropped = dropped_in_buffer;
+    values[0] = stream_status.frames;
+    values[1] = stream_status.dropped;
+    values[2] = stream_status.device_dropped;
+    values[3] = stream_status.suppressed_logs;
+    portEXIT_CRITICAL(&stream_lock);
+
+    for (int i = 0; i < 4; i++) {
+        stats[i * 4] = values[i];
+        stats[i * 4 + 1] = values[i] >> 8;
+        stats[i * 4 + 2] = values[i] >> 16;
+        stats[i * 4 + 3] = values[i] >> 24;
+    }
+    send_frame(SLIP_FRAME_STATS, stats, sizeof(stats), NULL, 0);
+}
+
+// Sender task: drains the capture buffer onto the UART
+static void uart_sender_task(void *pvParameters) {
+    packet_info_t *packets[SENDER_BATCH_PACKETS];
+    uint8_t header[PCAP_GLOBAL_HEADER_LEN];
+    uint64_t last_stats_us = esp_timer_get_time();
+
+    pcap_global_header(header);
+    send_frame(SLIP_FRAME_PCAP_HEADER, header, sizeof(header), NULL, 0);
+
+    while (!stop_requested) {
+        int count = get_captured_packets((void **)packets, SENDER_BATCH_PACKETS);
+
+        for (int i = 0; i < count; i++) {
+            packet_info_t *p = packets[i];
+            uint8_t prefix[PCAP_RECORD_PREFIX_LEN];
+            pcap_record_prefix(prefix, p->timestamp_us + wall_offset_us, p->length, p->orig_length,
+                               p->rssi, p->channel, p->rate);
+            send_frame(SLIP_FRAME_PCAP_RECORD, prefix, sizeof(prefix), p->data, p->length);
+            free(p);
+        }
+
+        // Resend the header with the stats so a decoder attached mid-stream can start
+        uint64_t now_us = esp_timer_get_time();
+        if (now_us - last_stats_us >= (uint64_t)UART_STREAM_STATS_MS * 1000) {
+            last_stats_us = now_us;
+            send_frame(SLIP_FRAME_PCAP_HEADER, header, sizeof(header), NULL, 0);
+            send_stats();
+        }
+
+        if (count < SENDER_BATCH_PACKETS) {
+            vTaskDelay(pdMS_TO_TICKS(SENDER_IDLE_MS));
+        }
+    }
+
+    send_stats();
+    sender_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+// Switch the console UART to a SLIP-framed pcap stream
+bool uart_stream_start(uint32_t baud, uart_stream_policy_t policy) {
+    if (sender_task_handle) {
+        ESP_LOGW(TAG, "Stream already running, stopping first");
+        uart_stream_stop();
+    }
+
+    if (!uart_is_driver_installed(STREAM_UART)) {
+        esp_err_t err = uart_driver_install(STREAM_UART, 256, UART_STREAM_TX_BUFFER, 0, NULL, 0);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to install UART driver: %s", esp_err_to_name(err));
+            return false;
+        }
+        installed_driver = true;
+    }
+    uart_set_pin(STREAM_UART, GPIO_UART_TX, GPIO_UART_RX, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    wall_offset_us = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec - esp_timer_get_time();
+
+    portENTER_CRITICAL(&stream_lock);
+    memset(&stream_status, 0, sizeof(stream_status));
+    stream_status.baud = baud;
+    stream_status.policy = policy;
+    stream_status.running = true;
+    portEXIT_CRITICAL(&stream_lock);
+
+    ESP_LOGI(TAG, "Streaming captures on UART%d at %lu baud (%s); console muted", STREAM_UART,
+             (unsigned long)baud, uart_stream_policy_name(policy));
+    uart_wait_tx_done(STREAM_UART, pdMS_TO_TICKS(100));
+    saved_vprintf = esp_log_set_vprintf(discard_log);
+    uart_set_baudrate(STREAM_UART, baud);
+
+    stop_requested = false;
+    if (xTaskCreate(uart_sender_task, "uart_sender", SENDER_TASK_STACK, NULL, SENDER_TASK_PRIORITY,
+                    &sender_task_handle) != pdPASS) {
+        sender_task_handle = NULL;
+        uart_stream_stop();
+        ESP_LOGE(TAG, "Failed to create UART sender task");
+        return false;
+    }
+    return true;
+}
+
+// Stop streaming and give the UART back to the console
+void uart_stream_stop(void) {
+    if (!stream_status.running) {
+        return;
+    }
+
+    stop_requested = true;
+    for (int i = 0; i < 100 && sender_task_handle; i++) {
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+
+    uart_wait_tx_done(STREAM_UART, pdMS_TO_TICKS(500));
+    uart_set_baudrate(STREAM_UART, CONSOLE_BAUD);
+    if (installed_driver) {
+        uart_driver_delete(STREAM_UART);
+        installed_driver = false;
+    }
+    if (saved_vprintf) {
+        esp_log_set_vprintf(saved_vprintf);
+        saved_vprintf = NULL;
+    }
+
+    portENTER_CRITICAL(&stream_lock);
+    stream_status.running = false;
+    portEXIT_CRITICAL(&stream_lock);
+
+    ESP_LOGI(TAG, "UART stream stopped: %lu frames, %lu dropped, %lu log lines suppressed",
+             (unsigned long)stream_status.frames, (unsigned long)stream_status.dropped,
+             (unsigned long)stream_status.suppressed_logs);
+}
+
+// Get the stream state and counters
+void uart_stream_get_status(uart_stream_status_t *status) {
+    portENTER_CRITICAL(&stream_lock);
+    *status = stream_status;
+    portEXIT_CRITICAL(&stream_lock);
+}
+
+// Get the name of a policy
+const char *uart_stream_policy_name(uart_stream_policy_t policy) {
+    return policy == UART_STREAM_BLOCK ? "block" : "drop";
+}
@@ -0,0 +1,66 @@
+#ifndef UART_STREAM_H
+#define UART_STREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define UART_STREAM_DEFAULT_BAUD     2000000
+// Driver TX ring; frames wait here while the UART shifts them out
+#define UART_STREAM_TX_BUFFER        16384
+// A SLIP_FRAME_STATS frame is sent this often
+#define UART_STREAM_STATS_MS         1000
+
+/**
+ * @brief What to do when the UART cannot keep up
+ */
+typedef enum {
+    UART_STREAM_DROP = 0,        // Drop frames that do not fit in the TX ring (low latency)
+    UART_STREAM_BLOCK,           // Wait for the UART; the capture buffer absorbs bursts and evicts by class
+} uart_stream_policy_t;
+
+/**
+ * @brief Stream state and counters
+ *
+ * The counters are also sent in-band as a SLIP_FRAME_STATS frame: frames,
+ * dropped, device_dropped and suppressed_logs as u32 little endian.
+ */
+typedef struct {
+    bool running;
+    uint32_t baud;
+    uint8_t policy;              // uart_stream_policy_t
+    uint16_t next_seq;
+    uint32_t frames;             // Records sent
+    uint32_t dropped;            // Records dropped by the DROP policy
+    uint32_t device_dropped;     // Records the capture buffer dropped or evicted
+    uint32_t suppressed_logs;    // Log lines discarded to keep the stream clean
+    uint64_t bytes;              // Encoded bytes written to the UART
+} uart_stream_status_t;
+
+/**
+ * @brief Switch the console UART to a SLIP-framed pcap stream
+ *
+ * Logging is muted while streaming. A sender task drains the capture
+ * buffer, so frames no longer reach /api/sniff/packets.
+ *
+ * @param baud Baud rate
+ * @param policy Behaviour when the UART falls behind
+ * @return true if streaming started
+ */
+bool uart_stream_start(uint32_t baud, uart_stream_policy_t policy);
+
+/**
+ * @brief Stop streaming and give the UART back to the console
+ */
+void uart_stream_stop(void);
+
+/**
+ * @brief Get the stream state and counters
+ */
+void uart_stream_get_status(uart_stream_status_t *status);
+
+/**
+ * @brief Get the name of a policy
+ */
+const char *uart_stream_policy_name(uart_stream_policy_t policy);
+
+#endif /* UART_STREAM_H */
@@ -0,0 +1,191 @@
+#include "udp_export.h"
+#include "export_batch.h"
+#include "wifi_sniffer.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+static const char *TAG = "udp_export";
+
+// Sender task settings; below the channel hopper so hops stay on time
+#define SENDER_TASK_STACK       4096
+#define SENDER_TASK_PRIORITY    4
+#define SENDER_IDLE_MS          10
+// Frames taken from the capture buffer per pass
+#define SENDER_BATCH_PACKETS    16
+
+static portMUX_TYPE export_lock = portMUX_INITIALIZER_UNLOCKED;
+static udp_export_status_t export_status;
+static volatile bool stop_requested = false;
+static TaskHandle_t sender_task_handle = NULL;
+
+static int sock = -1;
+static struct sockaddr_in collector_addr;
+static export_batch_t batch;
+
+// Offset from esp_timer time to wall clock time, taken at start
+static int64_t wall_offset_us = 0;
+
+// Frames the capture buffer rejected or evicted before anyone read them
+static uint32_t device_dropped(void) {
+    capture_class_stats_t stats[CAPTURE_CLASS_COUNT];
+    uint32_t dropped = 0;
+
+    wifi_sniffer_get_class_stats(stats);
+    for (int i = 0; i < CAPTURE_CLASS_COUNT; i++) {
+        dropped += stats[i].dropped + stats[i].evicted;
+    }
+    return dropped;
+}
+
+// Send the current batch and start a new one
+static void send_batch(void) {
+    if (batch.count == 0) {
+        return;
+    }
+
+    // The sequence number advances even if sending fails, so the collector sees the loss
+    uint32_t seq = export_status.next_seq;
+    size_t len = export_batch_finish(&batch, seq, device_dropped());
+    int sent = sendto(sock, batch.data, len, 0, (struct sockaddr *)&collector_addr, sizeof(collector_addr));
+
+    portENTER_CRITICAL(&export_lock);
+    export_status.next_seq++;
+    if (sent == (int)len) {
+        export_status.batches++;
+        export_status.frames += batch.count;
+        export_status.bytes += len;
+    } else {
+        export_status.send_errors++;
+    }
+    portEXIT_CRITICAL(&export_lock);
+
+    if (sent != (int)len) {
+        ESP_LOGD(TAG, "Failed to send batch %lu: errno %d", (unsigned long)seq, errno);
+    }
+    export_batch_reset(&batch);
+}
+
+// Sender task: drains the capture buffer into datagrams
+static void udp_sender_task(void *pvParameters) {
+    packet_info_t *packets[SENDER_BATCH_PACKETS];
+
+    ESP_LOGI(TAG, "UDP sender task started");
+    export_batch_reset(&batch);
+
+    while (!stop_requested) {
+        int count = get_captured_packets((void **)packets, SENDER_BATCH_PACKETS);
+
+        for (int i = 0; i < count; i++) {
+            packet_info_t *p = packets[i];
+            uint64_t timestamp_us = p->timestamp_us + wall_offset_us;
+            if (!export_batch_add(&batch, p->data, p->length, p->orig_length, p->rssi, p->channel, p->rate,
+                                  timestamp_us)) {
+                send_batch();
+                export_batch_add(&batch, p->data, p->length, p->orig_length, p->rssi, p->channel, p->rate,
+                                 timestamp_us);
+            }
+            free(p);
+        }
+
+        // Keep latency bounded when traffic is light
+        uint64_t now_us = esp_timer_get_time() + wall_offset_us;
+        if (batch.count && now_us - batch.opened_us >= (uint64_t)UDP_EXPORT_FLUSH_MS * 1000) {
+            send_batch();
+        }
+
+        if (count < SENDER_BATCH_PACKETS) {
+            vTaskDelay(pdMS_TO_TICKS(SENDER_IDLE_MS));
+        }
+    }
+
+    send_batch();
+    ESP_LOGI(TAG, "UDP sender task stopped");
+    sender_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+// Start sending captured frames to a collector
+bool udp_export_start(const char *collector, uint16_t port) {
+    if (sender_task_handle) {
+        ESP_LOGW(TAG, "Export already running, stopping first");
+        udp_export_stop();
+    }
+
+    memset(&collector_addr, 0, sizeof(collector_addr));
+    collector_addr.sin_family = AF_INET;
+    collector_addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, collector, &collector_addr.sin_addr) != 1) {
+        ESP_LOGE(TAG, "Invalid collector address: %s", collector);
+        return false;
+    }
+
+    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Failed to create socket: errno %d", errno);
+        return false;
+    }
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    wall_offset_us = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec - esp_timer_get_time();
+
+    portENTER_CRITICAL(&export_lock);
+    memset(&export_status, 0, sizeof(export_status));
+    strncpy(export_status.collector, collector, sizeof(export_status.collector) - 1);
+    export_status.port = port;
+    export_status.running = true;
+    portEXIT_CRITICAL(&export_lock);
+
+    stop_requested = false;
+    if (xTaskCreate(udp_sender_task, "udp_sender", SENDER_TASK_STACK, NULL, SENDER_TASK_PRIORITY,
+                    &sender_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create UDP sender task");
+        sender_task_handle = NULL;
+        export_status.running = false;
+        close(sock);
+        sock = -1;
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Exporting captures to %s:%u", collector, port);
+    return true;
+}
+
+// Stop the export, sending any partial batch first
+void udp_export_stop(void) {
+    if (!sender_task_handle) {
+        return;
+    }
+
+    stop_requested = true;
+    for (int i = 0; i < 100 && sender_task_handle; i++) {
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+    if (sender_task_handle) {
+        ESP_LOGW(TAG, "UDP sender did not stop in time");
+        return;
+    }
+
+    close(sock);
+    sock = -1;
+    portENTER_CRITICAL(&export_lock);
+    export_status.running = false;
+    portEXIT_CRITICAL(&export_lock);
+
+    ESP_LOGI(TAG, "Export stopped: %lu batches, %lu frames, %lu send errors",
+             (unsigned long)export_status.batches, (unsigned long)export_status.frames,
+             (unsigned long)export_status.send_errors);
+}
+
+// Get the export state and counters
+void udp_export_get_status(udp_export_status_t *status) {
+    portENTER_CRITICAL(&export_lock);
+    *status = export_status;
+    portEXIT_CRITICAL(&export_lock);
+}
@@ -0,0 +1,48 @@
+#ifndef UDP_EXPORT_H
+#define UDP_EXPORT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define UDP_EXPORT_DEFAULT_PORT      37020
+// A partially filled batch is sent once its first frame is this old
+#define UDP_EXPORT_FLUSH_MS          100
+
+/**
+ * @brief Export state and counters
+ */
+typedef struct {
+    bool running;
+    char collector[16];          // Dotted IPv4 address
+    uint16_t port;
+    uint32_t next_seq;           // Sequence number of the next batch
+    uint32_t batches;
+    uint32_t frames;
+    uint64_t bytes;
+    uint32_t send_errors;        // Batches the stack refused (counted as lost by the collector)
+} udp_export_status_t;
+
+/**
+ * @brief Start sending captured frames to a collector
+ *
+ * A sender task drains the capture buffer into MTU-sized datagrams of
+ * pcap records (see export_batch.h). While it runs, frames no longer
+ * reach /api/sniff/packets.
+ *
+ * @param collector Dotted IPv4 address of the collector
+ * @param port UDP port of the collector
+ * @return true if the export started
+ */
+bool udp_export_start(const char *collector, uint16_t port);
+
+/**
+ * @brief Stop the export, sending any partial batch first
+ */
+void udp_export_stop(void);
+
+/**
+ * @brief Get the export state and counters
+ */
+void udp_export_get_status(udp_export_status_t *status);
+
+#endif /* UDP_EXPORT_H */
@@ -8,20 +8,15 @@
 #include "esp_chip_info.h"
 #include "esp_system.h"
 #include "nvs_flash.h"
-
-// Include our wifi sniffer functions
-extern bool start_wifi_sniffer(uint8_t channel, uint8_t filter_type);
-extern bool stop_wifi_sniffer(void);
-extern int get_captured_packets(void **packets, int max_packets);
-
-// Define struct to avoid including wifi_init.c header
-typedef struct {
-    uint8_t data[1024];
-    uint16_t length;
-    int8_t rssi;
-    uint8_t channel;
-    wifi_pkt_rx_ctrl_t rx_ctrl;
-} packet_info_t;
+#include "wifi_sniffer.h"
+#include "api_json.h"
+#include "frame_format.h"
+#include "capture_storage.h"
+#include "trigger_capture.h"
+#include "udp_export.h"
+#include "uart_stream.h"
+#include "load_gen.h"
+#include "radio_sched.h"
 
 static const char *TAG = "web_server";
 
@@ -596,6 +591,10 @@ static const char index_html[] =
 "                        </select>\n"
 "                    </div>\n"
 "                    <div class=\"form-group\">\n"
+"                        <label for=\"beacon-dedup\">D3dup B34c0ns:</label>\n"
+"                        <input type=\"checkbox\" id=\"beacon-dedup\">\n"
+"                    </div>\n"
+"                    <div class=\"form-group\">\n"
 "                        <button id=\"start-sniff\" class=\"btn\">ST4RT SN1FF1NG</button>\n"
 "                        <button id=\"stop-sniff\" class=\"btn\" disabled>ST0P SN1FF1NG</button>\n"
 "                        <button id=\"clear-packets\" class=\"btn\">CL34R L0G</button>\n"
@@ -725,20 +724,35 @@ static const char index_html[] =
 "            loaderElement.style.display = 'block';\n"
 "            tableElement.style.display = 'none';\n"
 "            \n"
-"            // Set a timeout for the scan request\n"
-"            const controller = new AbortController();\n"
-"            const timeoutId = setTimeout(() => controller.abort(), 30000); // 30 seconds timeout\n"
+"            // The device scans in the background; poll the job until it is done\n"
+"            const deadline = Date.now() + 60000; // 60 seconds timeout\n"
+"            const readJson = response => {\n"
+"                if (!response.ok) {\n"
+"                    throw new Error(`HTTP error: ${response.status}`);\n"
+"                }\n"
+"                return response.json();\n"
+"            };\n"
+"            const poll = job => new Promise(resolve => setTimeout(resolve, 1000))\n"
+"                .then(() => fetch('/api/scan/result?job=' + job))\n"
+"                .then(readJson)\n"
+"                .then(data => {\n"
+"                    if (data.status !== 'running') {\n"
+"                        return data;\n"
+"                    }\n"
+"                    statusElement.textContent = `SC4NNING... ${data.channels_scanned}/${data.channels_total} CH4NN3L5, ${data.found} F0UND`;\n"
+"                    if (Date.now() > deadline) {\n"
+"                        const error = new Error('Scan timed out');\n"
+"                        error.name = 'AbortError';\n"
+"                        throw error;\n"
+"                    }\n"
+"                    return poll(job);\n"
+"                });\n"
 "            \n"
 "            fetch('/api/scan', {\n"
-"                signal: controller.signal\n"
+"                method: 'POST'\n"
 "            })\n"
-"                .then(response => {\n"
-"                    clearTimeout(timeoutId);\n"
-"                    if (!response.ok) {\n"
-"                        throw new Error(`HTTP error: ${response.status}`);\n"
-"                    }\n"
-"                    return response.json();\n"
-"                })\n"
+"                .then(readJson)\n"
+"                .then(data => data.status === 'accepted' ? poll(data.job) : data)\n"
 "                .then(data => {\n"
 "                    loaderElement.style.display = 'none';\n"
 "                    console.log('%c [SCAN] Scan completed', 'color: #0f0; background: #000');\n"
@@ -780,7 +794,6 @@ static const char index_html[] =
 "                    buttonElement.textContent = 'SC4N F0R N3TW0RK5';\n"
 "                })\n"
 "                .catch(error => {\n"
-"                    clearTimeout(timeoutId);\n"
 "                    loaderElement.style.display = 'none';\n"
 "                    console.error('%c [ERROR] ' + error.message, 'color: #f00; background: #000');\n"
 "                    \n"
@@ -820,6 +833,7 @@ static const char index_html[] =
 "            \n"
 "            const channel = document.getElementById('sniff-channel').value;\n"
 "            const filter = document.getElementById('packet-filter').value;\n"
+"            const dedup = document.getElementById('beacon-dedup').checked ? 1 : 0;\n"
 "            const statusElement = document.getElementById('sniff-status');\n"
 "            \n"
 "            console.log(`%c [SNIFF] Starting packet capture on channel ${channel} with filter ${filter}`, 'color: #0f0; background: #000');\n"
@@ -832,7 +846,7 @@ static const char index_html[] =
 "            document.getElementById('stop-sniff').disabled = false;\n"
 "            \n"
 "            // Start sniffing API call\n"
-"            fetch(`/api/sniff/start?channel=${channel}&filter=${filter}`)\n"
+"            fetch(`/api/sniff/start?channel=${channel}&filter=${filter}&dedup=${dedup}`)\n"
 "                .then(response => response.json())\n"
 "                .then(data => {\n"
 "                    if (data.status === 'success') {\n"
@@ -1119,219 +1133,85 @@ static esp_err_t http_serve_file(httpd_req_t *req) {
     return ESP_FAIL;
 }
 
-// API handler for scanning WiFi networks
-static esp_err_t api_scan_networks_handler(httpd_req_t *req) {
-    // Set response type to JSON
+// API handler to start a WiFi scan; returns a job to poll on /api/scan/result
+static esp_err_t api_scan_start_handler(httpd_req_t *req) {
     httpd_resp_set_type(req, "application/json");
     
-    ESP_LOGI(TAG, "Starting WiFi scan...");
-    
-    // Get current WiFi mode and save it
-    wifi_mode_t original_mode;
-    esp_err_t mode_err = esp_wifi_get_mode(&original_mode);
-    if (mode_err != ESP_OK) {
-        ESP_LOGI(TAG, "Failed to get WiFi mode: %s", esp_err_to_name(mode_err));
-        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Failed to get WiFi mode\"}");
-        return ESP_OK;
-    }
-    
-    // Set to APSTA mode to ensure we keep the AP running while scanning
-    esp_err_t set_mode_err = esp_wifi_set_mode(WIFI_MODE_APSTA);
-    if (set_mode_err != ESP_OK) {
-        ESP_LOGI(TAG, "Failed to set WiFi mode to APSTA: %s", esp_err_to_name(set_mode_err));
-        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Failed to set WiFi mode\"}");
-        return ESP_OK;
-    }
-    
-    // Configure scan with shorter scan times to prevent timeouts
-    wifi_scan_config_t scan_config = {
-        .ssid = NULL,
-        .bssid = NULL,
-        .channel = 0,
-        .show_hidden = true,
-        .scan_type = WIFI_SCAN_TYPE_ACTIVE,
-        .scan_time.active.min = 50,
-        .scan_time.active.max = 100,
-        .scan_time.passive = 100
-    };
-    
-    // Start scan (blocking but faster)
-    ESP_LOGI(TAG, "Executing WiFi scan with scan_config...");
-    esp_err_t scan_status = esp_wifi_scan_start(&scan_config, true);
-    if (scan_status != ESP_OK) {
-        ESP_LOGI(TAG, "WiFi scan failed to start: %s", esp_err_to_name(scan_status));
-        
-        esp_err_t restore_err = esp_wifi_set_mode(original_mode);
-        if (restore_err != ESP_OK) {
-            ESP_LOGI(TAG, "Failed to restore original WiFi mode: %s", esp_err_to_name(restore_err));
-        }
-        
-        // Send error response with specific error message
-        char error_msg[100];
-        snprintf(error_msg, sizeof(error_msg), "{\"status\":\"error\",\"message\":\"Scan failed: %s\"}", esp_err_to_name(scan_status));
-        httpd_resp_sendstr(req, error_msg);
-        return ESP_OK;
-    }
-    
-    // Get results
-    uint16_t ap_count = 0;
-    esp_err_t count_err = esp_wifi_scan_get_ap_num(&ap_count);
-    if (count_err != ESP_OK) {
-        ESP_LOGI(TAG, "Failed to get AP count: %s", esp_err_to_name(count_err));
-        
-        esp_err_t restore_err = esp_wifi_set_mode(original_mode);
-        if (restore_err != ESP_OK) {
-            ESP_LOGI(TAG, "Failed to restore original WiFi mode: %s", esp_err_to_name(restore_err));
-        }
-        
-        // Send error response with specific error message
+    // The radio scheduler scans a few channels per slice, so the softAP and
+    // a running capture keep their share of the radio meanwhile, and the
+    // scan takes several periods: answer now instead of holding the server
+    uint32_t job = 0;
+    esp_err_t err = radio_sched_scan_start(&job);
+    if (err != ESP_OK) {
+        ESP_LOGI(TAG, "WiFi scan not started: %s", esp_err_to_name(err));
         char error_msg[100];
-        snprintf(error_msg, sizeof(error_msg), "{\"status\":\"error\",\"message\":\"Failed to get AP count: %s\"}", esp_err_to_name(count_err));
+        snprintf(error_msg, sizeof(error_msg), "{\"status\":\"error\",\"message\":\"Scan failed: %s\"}", esp_err_to_name(err));
         httpd_resp_sendstr(req, error_msg);
         return ESP_OK;
     }
     
-    ESP_LOGI(TAG, "Scan completed, found %d networks", ap_count);
+    ESP_LOGI(TAG, "WiFi scan job %lu queued", (unsigned long)job);
+    char response[64];
+    snprintf(response, sizeof(response), "{\"status\":\"accepted\",\"job\":%lu}", (unsigned long)job);
+    httpd_resp_set_status(req, "202 Accepted");
+    httpd_resp_sendstr(req, response);
+    return ESP_OK;
+}
+
+// API handler for the progress of a scan job, and its networks once done (?job=)
+static esp_err_t api_scan_result_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
     
-    if (ap_count == 0) {
-        // No networks found
-        esp_err_t restore_err = esp_wifi_set_mode(original_mode);
-        if (restore_err != ESP_OK) {
-            ESP_LOGI(TAG, "Failed to restore original WiFi mode: %s", esp_err_to_name(restore_err));
-        }
-        httpd_resp_sendstr(req, "{\"status\":\"success\",\"networks\":[]}");
-        return ESP_OK;
+    char buf[32];
+    char param[16];
+    uint32_t job = 0;
+    if (httpd_req_get_url_query_str(req, buf, sizeof(buf)) == ESP_OK &&
+        httpd_query_key_value(buf, "job", param, sizeof(param)) == ESP_OK) {
+        job = strtoul(param, NULL, 10);
     }
     
-    // Allocate memory for scan results
-    wifi_ap_record_t *ap_records = malloc(sizeof(wifi_ap_record_t) * ap_count);
+    wifi_ap_record_t *ap_records = malloc(sizeof(wifi_ap_record_t) * RADIO_SCAN_MAX_APS);
     if (ap_records == NULL) {
         ESP_LOGI(TAG, "Failed to allocate memory for scan results");
-        
-        esp_err_t restore_err = esp_wifi_set_mode(original_mode);
-        if (restore_err != ESP_OK) {
-            ESP_LOGI(TAG, "Failed to restore original WiFi mode: %s", esp_err_to_name(restore_err));
-        }
-        
         httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Out of memory\"}");
         return ESP_OK;
     }
     
-    // Get AP records
-    esp_err_t get_ap_err = esp_wifi_scan_get_ap_records(&ap_count, ap_records);
-    if (get_ap_err != ESP_OK) {
-        ESP_LOGI(TAG, "Failed to get AP records: %s", esp_err_to_name(get_ap_err));
-        
-        // Clean up and restore
+    radio_scan_status_t status;
+    if (!radio_sched_scan_get(job, &status, ap_records)) {
         free(ap_records);
-        esp_err_t restore_err = esp_wifi_set_mode(original_mode);
-        if (restore_err != ESP_OK) {
-            ESP_LOGI(TAG, "Failed to restore original WiFi mode: %s", esp_err_to_name(restore_err));
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Unknown scan job\"}");
+        return ESP_OK;
+    }
+    
+    cJSON *root = NULL;
+    if (!status.done) {
+        root = cJSON_CreateObject();
+        if (root) {
+            cJSON_AddStringToObject(root, "status", "running");
+            cJSON_AddNumberToObject(root, "channels_scanned", status.channels_scanned);
+            cJSON_AddNumberToObject(root, "channels_total", status.channels_total);
+            cJSON_AddNumberToObject(root, "found", status.count);
         }
+    } else if (status.result != ESP_OK) {
+        ESP_LOGI(TAG, "WiFi scan failed: %s", esp_err_to_name(status.result));
+        free(ap_records);
         
         // Send error response with specific error message
         char error_msg[100];
-        snprintf(error_msg, sizeof(error_msg), "{\"status\":\"error\",\"message\":\"Failed to get AP records: %s\"}", esp_err_to_name(get_ap_err));
+        snprintf(error_msg, sizeof(error_msg), "{\"status\":\"error\",\"message\":\"Scan failed: %s\"}", esp_err_to_name(status.result));
         httpd_resp_sendstr(req, error_msg);
         return ESP_OK;
+    } else {
+        root = api_json_scan_results(ap_records, status.count);
     }
-    
-    // Create JSON response
-    cJSON *root = cJSON_CreateObject();
-    cJSON *networks = cJSON_AddArrayToObject(root, "networks");
-    
-    if (!root || !networks) {
+    free(ap_records);
+    if (!root) {
         ESP_LOGI(TAG, "Failed to create JSON objects");
-        free(ap_records);
-        esp_err_t restore_err = esp_wifi_set_mode(original_mode);
-        if (restore_err != ESP_OK) {
-            ESP_LOGI(TAG, "Failed to restore original WiFi mode: %s", esp_err_to_name(restore_err));
-        }
         httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"JSON creation failed\"}");
         return ESP_OK;
     }
-    
-    cJSON_AddStringToObject(root, "status", "success");
-    
-    for (int i = 0; i < ap_count; i++) {
-        cJSON *network = cJSON_CreateObject();
-        if (!network) {
-            ESP_LOGI(TAG, "Failed to create network JSON object");
-            continue;
-        }
-        
-        // Add network details to JSON
-        cJSON_AddStringToObject(network, "ssid", (char*)ap_records[i].ssid);
-        
-        char bssid_str[18];
-        snprintf(bssid_str, sizeof(bssid_str), "%02x:%02x:%02x:%02x:%02x:%02x",
-                 ap_records[i].bssid[0], ap_records[i].bssid[1], ap_records[i].bssid[2],
-                 ap_records[i].bssid[3], ap_records[i].bssid[4], ap_records[i].bssid[5]);
-        cJSON_AddStringToObject(network, "bssid", bssid_str);
-        
-        cJSON_AddNumberToObject(network, "rssi", ap_records[i].rssi);
-        cJSON_AddNumberToObject(network, "channel", ap_records[i].primary);
-        
-        // Determine WiFi band (2.4GHz or 5GHz) based on channel
-        const char* band = (ap_records[i].primary > 14) ? "5 GHz" : "2.4 GHz";
-        cJSON_AddStringToObject(network, "band", band);
-        
-        // Add second channel if using 40MHz bandwidth
-        if (ap_records[i].second) {
-            cJSON_AddNumberToObject(network, "second_channel", ap_records[i].second);
-        }
-        
-        // Add PHY mode info
-        const char* phy_mode;
-        switch (ap_records[i].phy_11n) {
-            case true:
-                phy_mode = "802.11n";
-                break;
-            default:
-                if (band[0] == '5') {
-                    phy_mode = "802.11a";
-                } else {
-                    phy_mode = "802.11b/g";
-                }
-        }
-        cJSON_AddStringToObject(network, "phy_mode", phy_mode);
-        
-        // Convert auth mode to string
-        const char* auth_mode_str;
-        switch (ap_records[i].authmode) {
-            case WIFI_AUTH_OPEN:
-                auth_mode_str = "Open";
-                break;
-            case WIFI_AUTH_WEP:
-                auth_mode_str = "WEP";
-                break;
-            case WIFI_AUTH_WPA_PSK:
-                auth_mode_str = "WPA PSK";
-                break;
-            case WIFI_AUTH_WPA2_PSK:
-                auth_mode_str = "WPA2 PSK";
-                break;
-            case WIFI_AUTH_WPA_WPA2_PSK:
-                auth_mode_str = "WPA/WPA2 PSK";
-                break;
-            case WIFI_AUTH_WPA3_PSK:
-                auth_mode_str = "WPA3 PSK";
-                break;
-            case WIFI_AUTH_WPA2_WPA3_PSK:
-                auth_mode_str = "WPA2/WPA3 PSK";
-                break;
-            default:
-                auth_mode_str = "Unknown";
-        }
-        cJSON_AddStringToObject(network, "security", auth_mode_str);
-        
-        // Check if network is hidden
-        bool is_hidden = (ap_records[i].ssid[0] == 0);
-        cJSON_AddBoolToObject(network, "is_hidden", is_hidden);
-        
-        // Add this network to the networks array
-        cJSON_AddItemToArray(networks, network);
-    }
+    cJSON_AddNumberToObject(root, "job", status.job);
     
     // Generate JSON string
     char *json_response = cJSON_PrintUnformatted(root);
@@ -1339,20 +1219,11 @@ static esp_err_t api_scan_networks_handler(httpd_req_t *req) {
         ESP_LOGI(TAG, "Failed to print JSON");
         httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"JSON printing failed\"}");
     } else {
-        ESP_LOGI(TAG, "Sending scan results with %d networks", ap_count);
         httpd_resp_sendstr(req, json_response);
         free(json_response);
     }
     
-    // Clean up
     cJSON_Delete(root);
-    free(ap_records);
-    
-    esp_err_t restore_err = esp_wifi_set_mode(original_mode);
-    if (restore_err != ESP_OK) {
-        ESP_LOGI(TAG, "Failed to restore original WiFi mode: %s", esp_err_to_name(restore_err));
-    }
-    
     return ESP_OK;
 }
 
@@ -1537,6 +1408,20 @@ static esp_err_t api_sniff_start_handler(httpd_req_t *req) {
     // Convert filter string to numeric value
     uint8_t filter_type = get_filter_type(filter);
     
+    // Optional beacon dedup stage (dedup=1, keepalive in milliseconds)
+    bool dedup = false;
+    uint32_t keepalive_ms = 0;
+    if (buf[0] != '\0') {
+        char param[16];
+        if (httpd_query_key_value(buf, "dedup", param, sizeof(param)) == ESP_OK) {
+            dedup = (atoi(param) != 0);
+        }
+        if (httpd_query_key_value(buf, "keepalive", param, sizeof(param)) == ESP_OK) {
+            keepalive_ms = atoi(param);
+        }
+    }
+    wifi_sniffer_set_beacon_dedup(dedup, keepalive_ms);
+    
     // Start the sniffer
     bool success = start_wifi_sniffer(channel, filter_type);
     
@@ -1547,6 +1432,7 @@ static esp_err_t api_sniff_start_handler(httpd_req_t *req) {
         cJSON_AddStringToObject(root, "status", "success");
         cJSON_AddNumberToObject(root, "channel", channel);
         cJSON_AddStringToObject(root, "filter", filter);
+        cJSON_AddBoolToObject(root, "dedup", dedup);
         cJSON_AddStringToObject(root, "message", "Packet capture started");
     } else {
         cJSON_AddStringToObject(root, "status", "error");
@@ -1591,51 +1477,17 @@ static esp_err_t api_sniff_stop_handler(httpd_req_t *req) {
     return ESP_OK;
 }
 
-// Helper function to format MAC address
-static void format_mac_addr(char *dest, const uint8_t *addr) {
-    snprintf(dest, 18, "%02x:%02x:%02x:%02x:%02x:%02x",
-             addr[0], addr[1], addr[2],
-             addr[3], addr[4], addr[5]);
-}
-
-// Helper function to determine packet type from frame control
-static const char* get_frame_type_str(uint16_t frame_ctrl) {
-    uint8_t type = (frame_ctrl & 0x000C) >> 2;
-    uint8_t subtype = (frame_ctrl & 0x00F0) >> 4;
-    
-    switch (type) {
-        case 0: // Management
-            switch (subtype) {
-                case 0: return "ASSOC_REQ";
-                case 1: return "ASSOC_RES";
-                case 2: return "REASSOC_REQ";
-                case 3: return "REASSOC_RES";
-                case 4: return "PROBE_REQ";
-                case 5: return "PROBE_RES";
-                case 8: return "BEACON";
-                case 9: return "ATIM";
-                case 10: return "DISASSOC";
-                case 11: return "AUTH";
-                case 12: return "DEAUTH";
-                case 13: return "ACTION";
-                default: return "MGMT";
-            }
-        case 1: // Control
-            switch (subtype) {
-                case 8: return "BLOCK_ACK_REQ";
-                case 9: return "BLOCK_ACK";
-                case 10: return "PS_POLL";
-                case 11: return "RTS";
-                case 12: return "CTS";
-                case 13: return "ACK";
-                case 14: return "CF_END";
-                default: return "CTRL";
-            }
-        case 2: // Data
-            return "DATA";
-        default:
-            return "UNKNOWN";
+// Helper function to parse a MAC address string (xx:xx:xx:xx:xx:xx or xx-xx-...)
+static bool parse_mac_addr(const char *str, uint8_t *addr) {
+    unsigned int b[6];
+    if (sscanf(str, "%2x%*[:-]%2x%*[:-]%2x%*[:-]%2x%*[:-]%2x%*[:-]%2x",
+               &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != 6) {
+        return false;
     }
+    for (int i = 0; i < 6; i++) {
+        addr[i] = b[i];
+    }
+    return true;
 }
 
 // API handler for getting captured packets
@@ -1646,54 +1498,364 @@ static esp_err_t api_sniff_packets_handler(httpd_req_t *req) {
     packet_info_t *packets[10];
     int num_packets = get_captured_packets((void**)packets, 10);
     
+    cJSON *root = api_json_packets(packets, num_packets);
+    for (int i = 0; i < num_packets; i++) {
+        free(packets[i]);
+    }
+    if (!root) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Out of memory\"}");
+        return ESP_OK;
+    }
+    
+    char *json_response = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, json_response);
+    
+    free(json_response);
+    cJSON_Delete(root);
+    
+    return ESP_OK;
+}
+
+// API handler for per-BSSID beacon counters from the dedup stage
+static esp_err_t api_sniff_beacons_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    beacon_dedup_entry_t *entries = malloc(sizeof(beacon_dedup_entry_t) * BEACON_DEDUP_MAX_ENTRIES);
+    if (!entries) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Out of memory\"}");
+        return ESP_OK;
+    }
+    
+    uint32_t total_seen = 0, total_forwarded = 0;
+    int count = wifi_sniffer_get_beacon_stats(entries, BEACON_DEDUP_MAX_ENTRIES, &total_seen, &total_forwarded);
+    
     // Create response
     cJSON *root = cJSON_CreateObject();
-    cJSON *packets_array = cJSON_AddArrayToObject(root, "packets");
+    cJSON_AddStringToObject(root, "status", "success");
+    cJSON_AddNumberToObject(root, "seen", total_seen);
+    cJSON_AddNumberToObject(root, "forwarded", total_forwarded);
+    cJSON *bssids = cJSON_AddArrayToObject(root, "bssids");
     
-    for (int i = 0; i < num_packets; i++) {
-        packet_info_t *pkt = packets[i];
-        
-        // Create JSON object for this packet
-        cJSON *packet = cJSON_CreateObject();
-        
-        // Extract header info
-        uint16_t frame_ctrl = *(uint16_t*)pkt->data;
-        uint8_t *addr1 = pkt->data + 4;  // dst
-        uint8_t *addr2 = pkt->data + 10; // src
+    for (int i = 0; i < count; i++) {
+        beacon_dedup_entry_t *entry = &entries[i];
+        cJSON *item = cJSON_CreateObject();
         
-        // Format MAC addresses
-        char src_mac[18], dst_mac[18];
-        format_mac_addr(dst_mac, addr1);
-        format_mac_addr(src_mac, addr2);
-        
-        // Add packet information
-        cJSON_AddStringToObject(packet, "type", get_frame_type_str(frame_ctrl));
-        cJSON_AddStringToObject(packet, "src", src_mac);
-        cJSON_AddStringToObject(packet, "dst", dst_mac);
-        cJSON_AddNumberToObject(packet, "channel", pkt->channel);
-        cJSON_AddNumberToObject(packet, "rssi", pkt->rssi);
-        
-        // Format data as hex
-        if (pkt->length > 0) {
-            char *hex_data = malloc(pkt->length * 3 + 1);
-            if (hex_data) {
-                int pos = 0;
-                for (int j = 0; j < pkt->length && j < 64; j++) { // Only show first 64 bytes
-                    pos += snprintf(hex_data + pos, 4, "%02x ", pkt->data[j]);
-                }
-                if (pkt->length > 64) {
-                    strcat(hex_data, "...");
-                }
-                cJSON_AddStringToObject(packet, "data", hex_data);
-                free(hex_data);
+        char bssid_str[18];
+        format_mac_addr(bssid_str, entry->bssid);
+        cJSON_AddStringToObject(item, "bssid", bssid_str);
+        cJSON_AddStringToObject(item, "ssid", entry->ssid);
+        cJSON_AddNumberToObject(item, "channel", entry->channel);
+        cJSON_AddNumberToObject(item, "beacons", entry->beacons);
+        cJSON_AddNumberToObject(item, "forwarded", entry->forwarded);
+        cJSON_AddNumberToObject(item, "changes", entry->changes);
+        cJSON_AddNumberToObject(item, "rssi_min", entry->rssi_min);
+        cJSON_AddNumberToObject(item, "rssi_max", entry->rssi_max);
+        cJSON_AddNumberToObject(item, "rssi_avg", beacon_dedup_rssi_avg(entry));
+        cJSON_AddNumberToObject(item, "interval_tu", entry->interval_tu);
+        cJSON_AddNumberToObject(item, "jitter_avg_us", beacon_dedup_jitter_avg(entry));
+        cJSON_AddNumberToObject(item, "jitter_max_us", entry->jitter_max_us);
+        cJSON_AddNumberToObject(item, "age_ms", (double)(entry->last_seen_us - entry->first_seen_us) / 1000);
+        cJSON_AddItemToArray(bssids, item);
+    }
+    free(entries);
+    
+    char *json_response = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, json_response);
+    
+    free(json_response);
+    cJSON_Delete(root);
+    
+    return ESP_OK;
+}
+
+// API handler for capture buffer statistics
+static esp_err_t api_sniff_stats_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    capture_class_stats_t stats[CAPTURE_CLASS_COUNT];
+    wifi_sniffer_get_class_stats(stats);
+    uint16_t peak = wifi_sniffer_get_buffer_peak(false);
+    
+    // Create response
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "status", "success");
+    cJSON_AddNumberToObject(root, "capacity", CAPTURE_BUFFER_CAPACITY);
+    cJSON_AddNumberToObject(root, "peak", peak);
+    cJSON_AddNumberToObject(root, "unparsed", wifi_sniffer_get_unparsed_count());
+    cJSON *classes = cJSON_AddArrayToObject(root, "classes");
+    
+    for (int i = 0; i < CAPTURE_CLASS_COUNT; i++) {
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "class", capture_buffer_class_name(i));
+        cJSON_AddNumberToObject(item, "stored", stats[i].stored);
+        cJSON_AddNumberToObject(item, "reserved", stats[i].reserved);
+        cJSON_AddNumberToObject(item, "peak", stats[i].peak);
+        cJSON_AddNumberToObject(item, "captured", stats[i].captured);
+        cJSON_AddNumberToObject(item, "evicted", stats[i].evicted);
+        cJSON_AddNumberToObject(item, "dropped", stats[i].dropped);
+        cJSON_AddItemToArray(classes, item);
+    }
+    
+    // Capture fidelity the overload governor currently allows
+    load_governor_t governor;
+    wifi_sniffer_get_governor(&governor);
+    cJSON *gov = cJSON_AddObjectToObject(root, "governor");
+    cJSON_AddBoolToObject(gov, "enabled", governor.config.enabled);
+    cJSON_AddStringToObject(gov, "level", load_governor_level_name(governor.level));
+    cJSON_AddNumberToObject(gov, "level_index", governor.level);
+    cJSON_AddNumberToObject(gov, "busy_pct", governor.busy_pct);
+    cJSON_AddNumberToObject(gov, "churn_fps", governor.churn_fps);
+    cJSON_AddNumberToObject(gov, "free_heap", governor.free_heap);
+    cJSON_AddNumberToObject(gov, "hold_windows", governor.hold_windows);
+    cJSON_AddNumberToObject(gov, "steps_down", governor.steps_down);
+    cJSON_AddNumberToObject(gov, "steps_up", governor.steps_up);
+    cJSON_AddNumberToObject(gov, "truncated", governor.truncated);
+    cJSON_AddNumberToObject(gov, "skipped", governor.skipped);
+    cJSON *levels = cJSON_AddObjectToObject(gov, "levels");
+    for (int i = 0; i < LOAD_LEVEL_COUNT; i++) {
+        cJSON *level = cJSON_AddObjectToObject(levels, load_governor_level_name(i));
+        cJSON_AddNumberToObject(level, "frames", governor.frames[i]);
+        cJSON_AddNumberToObject(level, "ms", (double)(governor.level_us[i] / 1000));
+    }
+    
+    char *json_response = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, json_response);
+    
+    free(json_response);
+    cJSON_Delete(root);
+    
+    return ESP_OK;
+}
+
+// Traffic entries copied per critical section, and the longest one as JSON
+#define TRAFFIC_BATCH           8
+#define TRAFFIC_ENTRY_JSON_MAX  232
+
+// Write one traffic entry as a JSON object, with a leading comma unless first
+static int format_traffic_entry(char *out, const traffic_entry_t *entry, bool link, bool first) {
+    const traffic_counters_t *c = &entry->counters;
+    char addr[18], station[18];
+    int len;
+    
+    format_mac_addr(addr, entry->addr);
+    if (link) {
+        format_mac_addr(station, entry->station);
+        len = snprintf(out, TRAFFIC_ENTRY_JSON_MAX, "%s{\"bssid\":\"%s\",\"sta\":\"%s\",", first ? "" : ",",
+                       addr, station);
+    } else {
+        len = snprintf(out, TRAFFIC_ENTRY_JSON_MAX, "%s{\"mac\":\"%s\",", first ? "" : ",", addr);
+    }
+    len += snprintf(out + len, TRAFFIC_ENTRY_JSON_MAX - len,
+                    "\"frames\":[%lu,%lu,%lu],\"bytes\":%llu,\"rssi\":%d,\"ch\":%u,"
+                    "\"first_ms\":%llu,\"last_ms\":%llu}",
+                    (unsigned long)c->frames[0], (unsigned long)c->frames[1], (unsigned long)c->frames[2],
+                    (unsigned long long)c->bytes, c->rssi_ewma / 16, c->channel,
+                    (unsigned long long)(c->first_seen_us / 1000), (unsigned long long)(c->last_seen_us / 1000));
+    return len;
+}
+
+// Stream one traffic table as the body of a JSON array, a batch per chunk
+static esp_err_t send_traffic_table(httpd_req_t *req, bool links, traffic_entry_t *entries, char *chunk) {
+    esp_err_t err = ESP_OK;
+    int cursor = 0;
+    int count;
+    bool first = true;
+    
+    while (err == ESP_OK && (count = wifi_sniffer_get_traffic_entries(links, &cursor, entries, TRAFFIC_BATCH)) > 0) {
+        int len = 0;
+        for (int i = 0; i < count; i++) {
+            len += format_traffic_entry(chunk + len, &entries[i], links, first);
+            first = false;
+        }
+        err = httpd_resp_send_chunk(req, chunk, len);
+    }
+    return err;
+}
+
+// API handler for per-transmitter and per-(BSSID, station) traffic counters.
+// The tables are streamed a batch at a time, so neither a full snapshot nor
+// a JSON tree of up to 256 entries has to fit in the heap at once
+static esp_err_t api_stats_traffic_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    traffic_entry_t *entries = malloc(TRAFFIC_BATCH * sizeof(traffic_entry_t));
+    char *chunk = malloc(TRAFFIC_BATCH * TRAFFIC_ENTRY_JSON_MAX);
+    if (!entries || !chunk) {
+        free(entries);
+        free(chunk);
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Out of memory\"}");
+        return ESP_OK;
+    }
+    
+    uint32_t frames;
+    uint64_t bytes;
+    wifi_sniffer_get_traffic_totals(&frames, &bytes);
+    int len = snprintf(chunk, TRAFFIC_ENTRY_JSON_MAX,
+                       "{\"status\":\"success\",\"frames\":%lu,\"bytes\":%llu,\"transmitters\":[",
+                       (unsigned long)frames, (unsigned long long)bytes);
+    
+    esp_err_t err = httpd_resp_send_chunk(req, chunk, len);
+    if (err == ESP_OK) {
+        err = send_traffic_table(req, false, entries, chunk);
+    }
+    if (err == ESP_OK) {
+        err = httpd_resp_sendstr_chunk(req, "],\"links\":[");
+    }
+    if (err == ESP_OK) {
+        err = send_traffic_table(req, true, entries, chunk);
+    }
+    if (err == ESP_OK) {
+        err = httpd_resp_sendstr_chunk(req, "]}");
+    }
+    free(entries);
+    free(chunk);
+    
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Traffic export aborted: %s", esp_err_to_name(err));
+        return err;
+    }
+    httpd_resp_send_chunk(req, NULL, 0);
+    return ESP_OK;
+}
+
+// Compare edges by BSSID, then by most recent activity
+static int compare_assoc_edges(const void *a, const void *b) {
+    const assoc_edge_t *ea = a, *eb = b;
+    int cmp = memcmp(ea->bssid, eb->bssid, 6);
+    if (cmp != 0) return cmp;
+    return (eb->last_seen_us > ea->last_seen_us) - (eb->last_seen_us < ea->last_seen_us);
+}
+
+// API handler for the client-to-AP association graph (?bssid= limits it to one AP)
+static esp_err_t api_graph_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    // Optional BSSID filter
+    uint8_t bssid[6];
+    bool has_bssid = false;
+    char buf[64];
+    if (httpd_req_get_url_query_str(req, buf, sizeof(buf)) == ESP_OK) {
+        char param[24];
+        if (httpd_query_key_value(buf, "bssid", param, sizeof(param)) == ESP_OK) {
+            if (!parse_mac_addr(param, bssid)) {
+                httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Invalid BSSID\"}");
+                return ESP_OK;
             }
+            has_bssid = true;
         }
+    }
+    
+    assoc_edge_t *edges = malloc(sizeof(assoc_edge_t) * ASSOC_GRAPH_MAX_EDGES);
+    if (!edges) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Out of memory\"}");
+        return ESP_OK;
+    }
+    int count = wifi_sniffer_get_assoc_edges(has_bssid ? bssid : NULL, edges, ASSOC_GRAPH_MAX_EDGES);
+    qsort(edges, count, sizeof(assoc_edge_t), compare_assoc_edges);
+    
+    // Group edges by BSSID
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "status", "success");
+    cJSON_AddNumberToObject(root, "edges", count);
+    cJSON *aps = cJSON_AddArrayToObject(root, "aps");
+    cJSON *clients = NULL;
+    char mac_str[18];
+    
+    for (int i = 0; i < count; i++) {
+        assoc_edge_t *edge = &edges[i];
         
-        // Add packet to array
-        cJSON_AddItemToArray(packets_array, packet);
+        if (i == 0 || memcmp(edge->bssid, edges[i - 1].bssid, 6) != 0) {
+            cJSON *ap = cJSON_CreateObject();
+            format_mac_addr(mac_str, edge->bssid);
+            cJSON_AddStringToObject(ap, "bssid", mac_str);
+            clients = cJSON_AddArrayToObject(ap, "clients");
+            cJSON_AddItemToArray(aps, ap);
+        }
         
-        // Free the packet
-        free(pkt);
+        cJSON *client = cJSON_CreateObject();
+        format_mac_addr(mac_str, edge->station);
+        cJSON_AddStringToObject(client, "sta", mac_str);
+        cJSON_AddNumberToObject(client, "frames", edge->frames);
+        cJSON_AddNumberToObject(client, "last_ms", (double)(edge->last_seen_us / 1000));
+        cJSON_AddNumberToObject(client, "ch", edge->channel);
+        if (edge->aid) {
+            cJSON_AddNumberToObject(client, "aid", edge->aid);
+        }
+        cJSON_AddBoolToObject(client, "associated", edge->associated);
+        cJSON_AddItemToArray(clients, client);
+    }
+    free(edges);
+    
+    char *json_response = cJSON_PrintUnformatted(root);
+    if (!json_response) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"JSON printing failed\"}");
+    } else {
+        httpd_resp_sendstr(req, json_response);
+        free(json_response);
+    }
+    cJSON_Delete(root);
+    
+    return ESP_OK;
+}
+
+// Add one top-K ranking to a JSON object
+static bool add_top_talkers(cJSON *root, const char *name, uint16_t window_s, topk_metric_t metric, int max_results) {
+    topk_result_t results[TOPK_CAPACITY];
+    uint32_t max_error = 0, total = 0;
+    int count = wifi_sniffer_get_top_talkers(window_s, metric, results, max_results, &max_error, &total);
+    if (count < 0) {
+        return false;
+    }
+    
+    cJSON *ranking = cJSON_AddObjectToObject(root, name);
+    cJSON_AddNumberToObject(ranking, "total", total);
+    cJSON_AddNumberToObject(ranking, "max_error", max_error);
+    cJSON *top = cJSON_AddArrayToObject(ranking, "top");
+    
+    char mac_str[18];
+    for (int i = 0; i < count; i++) {
+        cJSON *item = cJSON_CreateObject();
+        format_mac_addr(mac_str, results[i].mac);
+        cJSON_AddStringToObject(item, "mac", mac_str);
+        cJSON_AddNumberToObject(item, "count", results[i].estimate);
+        cJSON_AddNumberToObject(item, "error", results[i].error);
+        cJSON_AddItemToArray(top, item);
+    }
+    return true;
+}
+
+// API handler for top talkers (?window=10|60|300&n=10)
+static esp_err_t api_stats_top_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    int window_s = 60;
+    int max_results = 10;
+    char buf[64];
+    if (httpd_req_get_url_query_str(req, buf, sizeof(buf)) == ESP_OK) {
+        char param[16];
+        if (httpd_query_key_value(buf, "window", param, sizeof(param)) == ESP_OK) {
+            window_s = atoi(param);
+        }
+        if (httpd_query_key_value(buf, "n", param, sizeof(param)) == ESP_OK) {
+            max_results = atoi(param);
+        }
+    }
+    if (max_results < 1 || max_results > TOPK_CAPACITY) {
+        max_results = TOPK_CAPACITY;
+    }
+    if (window_s != 10 && window_s != 60 && window_s != 300) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Window must be 10, 60 or 300\"}");
+        return ESP_OK;
+    }
+    
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "status", "success");
+    cJSON_AddNumberToObject(root, "window_s", window_s);
+    if (!add_top_talkers(root, "frames", window_s, TOPK_METRIC_FRAMES, max_results) ||
+        !add_top_talkers(root, "bytes", window_s, TOPK_METRIC_BYTES, max_results)) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Top talker query failed");
+        return ESP_FAIL;
     }
     
     char *json_response = cJSON_PrintUnformatted(root);
@@ -1705,30 +1867,1435 @@ static esp_err_t api_sniff_packets_handler(httpd_req_t *req) {
     return ESP_OK;
 }
 
-// API endpoint for rebooting the device
-static esp_err_t api_reboot_handler(httpd_req_t *req) {
+// API handler for unique device counts per channel and per BSSID
+static esp_err_t api_stats_devices_handler(httpd_req_t *req) {
     httpd_resp_set_type(req, "application/json");
     
-    // Send response before rebooting
-    httpd_resp_sendstr(req, "{\"status\":\"ok\",\"message\":\"Rebooting device...\"}");
+    hll_counts_t *counts = malloc(sizeof(hll_counts_t));
+    if (!counts || !wifi_sniffer_get_device_counts(counts)) {
+        free(counts);
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Out of memory\"}");
+        return ESP_OK;
+    }
     
-    // Schedule reboot after a short delay to allow the response to be sent
-    ESP_LOGI(TAG, "Reboot requested via web interface");
-    esp_restart();
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "status", "success");
+    cJSON_AddNumberToObject(root, "window_s", HLL_WINDOW_S);
+    cJSON_AddNumberToObject(root, "devices", counts->total_devices);
+    
+    cJSON *channels = cJSON_AddArrayToObject(root, "channels");
+    for (int i = 0; i < counts->channel_count; i++) {
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "ch", counts->channels[i].channel);
+        cJSON_AddNumberToObject(item, "devices", counts->channels[i].devices);
+        cJSON_AddItemToArray(channels, item);
+    }
+    
+    char mac_str[18];
+    cJSON *bssids = cJSON_AddArrayToObject(root, "bssids");
+    for (int i = 0; i < counts->bssid_count; i++) {
+        cJSON *item = cJSON_CreateObject();
+        format_mac_addr(mac_str, counts->bssids[i].bssid);
+        cJSON_AddStringToObject(item, "bssid", mac_str);
+        cJSON_AddNumberToObject(item, "devices", counts->bssids[i].devices);
+        cJSON_AddItemToArray(bssids, item);
+    }
+    free(counts);
+    
+    char *json_response = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, json_response);
+    
+    free(json_response);
+    cJSON_Delete(root);
     
     return ESP_OK;
 }
 
-// Register URI handlers
-esp_err_t register_uri_handlers(httpd_handle_t server) {
-    // API handler for scanning networks
-    httpd_uri_t scan_handler = {
-        .uri = "/api/scan",
-        .method = HTTP_GET,
-        .handler = api_scan_networks_handler,
-        .user_ctx = NULL
-    };
-    httpd_register_uri_handler(server, &scan_handler);
+// API handler for uploading a MAC watch/ignore list (?mode=watch|ignore|off)
+static esp_err_t api_maclist_upload_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    // Get mode parameter
+    mac_filter_mode_t mode = MAC_FILTER_IGNORE;
+    char buf[64];
+    if (httpd_req_get_url_query_str(req, buf, sizeof(buf)) == ESP_OK) {
+        char param[16];
+        if (httpd_query_key_value(buf, "mode", param, sizeof(param)) == ESP_OK) {
+            if (strcmp(param, "watch") == 0) mode = MAC_FILTER_WATCH;
+            else if (strcmp(param, "off") == 0) mode = MAC_FILTER_OFF;
+        }
+    }
+    
+    if (mode == MAC_FILTER_OFF) {
+        wifi_sniffer_set_mac_filter(NULL);
+        httpd_resp_sendstr(req, "{\"status\":\"success\",\"mode\":\"off\",\"count\":0}");
+        return ESP_OK;
+    }
+    
+    // Every address takes at least 12 characters plus a separator
+    mac_filter_t *filter = mac_filter_create(mode, req->content_len / 13 + 1);
+    if (!filter) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Out of memory\"}");
+        return ESP_OK;
+    }
+    
+    // Stream the body through the parser in chunks
+    mac_list_parser_t parser;
+    mac_list_parser_init(&parser);
+    uint32_t overflow = 0;
+    size_t remaining = req->content_len;
+    char chunk[512];
+    
+    while (remaining > 0) {
+        int ret_len = httpd_req_recv(req, chunk, MIN(remaining, sizeof(chunk)));
+        if (ret_len == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+        }
+        if (ret_len <= 0) {
+            mac_filter_destroy(filter);
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to receive data");
+            return ESP_FAIL;
+        }
+        overflow += mac_list_parse(&parser, chunk, ret_len, filter);
+        remaining -= ret_len;
+    }
+    overflow += mac_list_parse(&parser, NULL, 0, filter);
+    
+    mac_filter_finalize(filter);
+    uint32_t count = filter->count;
+    wifi_sniffer_set_mac_filter(filter);
+    
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "status", "success");
+    cJSON_AddStringToObject(root, "mode", mac_filter_mode_name(mode));
+    cJSON_AddNumberToObject(root, "count", count);
+    cJSON_AddNumberToObject(root, "rejected", parser.rejected);
+    cJSON_AddNumberToObject(root, "overflow", overflow);
+    
+    char *json_response = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, json_response);
+    
+    free(json_response);
+    cJSON_Delete(root);
+    
+    return ESP_OK;
+}
+
+// API handler for the current MAC watch/ignore list
+static esp_err_t api_maclist_get_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    mac_filter_t info;
+    bool present = wifi_sniffer_get_mac_filter_info(&info);
+    
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "status", "success");
+    cJSON_AddStringToObject(root, "mode", present ? mac_filter_mode_name(info.mode) : "off");
+    if (present) {
+        cJSON_AddNumberToObject(root, "count", info.count);
+        cJSON_AddNumberToObject(root, "bloom_bits", info.bloom_bits);
+        cJSON_AddNumberToObject(root, "bloom_rejects", info.bloom_rejects);
+        cJSON_AddNumberToObject(root, "exact_hits", info.exact_hits);
+        cJSON_AddNumberToObject(root, "false_positives", info.false_positives);
+    }
+    
+    char *json_response = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, json_response);
+    
+    free(json_response);
+    cJSON_Delete(root);
+    
+    return ESP_OK;
+}
+
+// Add a rate histogram entry to a JSON array, listing only non-empty bins
+static void add_rate_entries(cJSON *root, const char *name, const rate_entry_t *entries, int count) {
+    char mac_str[18];
+    cJSON *array = cJSON_AddArrayToObject(root, name);
+    
+    for (int i = 0; i < count; i++) {
+        const rate_hist_t *hist = &entries[i].hist;
+        cJSON *item = cJSON_CreateObject();
+        format_mac_addr(mac_str, entries[i].addr);
+        cJSON_AddStringToObject(item, "mac", mac_str);
+        cJSON_AddNumberToObject(item, "frames", hist->frames);
+        cJSON_AddNumberToObject(item, "retry_pct", hist->frames ? (double)(hist->retries * 1000ULL / hist->frames) / 10.0 : 0);
+        cJSON_AddNumberToObject(item, "nss", hist->max_nss);
+        cJSON_AddNumberToObject(item, "bw", hist->max_bandwidth);
+        
+        cJSON *rates = cJSON_AddObjectToObject(item, "rates");
+        for (int bin = 0; bin < RATE_BINS; bin++) {
+            if (hist->bins[bin]) {
+                cJSON_AddNumberToObject(rates, rate_stats_bin_name(bin), hist->bins[bin]);
+            }
+        }
+        cJSON_AddItemToArray(array, item);
+    }
+}
+
+// API handler for rate histograms and retry ratios (?n= entries per list)
+static esp_err_t api_stats_rates_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    int max_entries = 16;
+    char buf[64];
+    if (httpd_req_get_url_query_str(req, buf, sizeof(buf)) == ESP_OK) {
+        char param[16];
+        if (httpd_query_key_value(buf, "n", param, sizeof(param)) == ESP_OK) {
+            max_entries = atoi(param);
+        }
+    }
+    if (max_entries < 1 || max_entries > RATE_MAX_TRANSMITTERS) {
+        max_entries = RATE_MAX_TRANSMITTERS;
+    }
+    
+    rate_entry_t *entries = malloc(max_entries * sizeof(rate_entry_t));
+    if (!entries) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Out of memory\"}");
+        return ESP_OK;
+    }
+    
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "status", "success");
+    
+    int count = wifi_sniffer_get_rate_stats(true, entries, max_entries);
+    add_rate_entries(root, "bssids", entries, count);
+    count = wifi_sniffer_get_rate_stats(false, entries, max_entries);
+    add_rate_entries(root, "transmitters", entries, count);
+    free(entries);
+    
+    char *json_response = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, json_response);
+    
+    free(json_response);
+    cJSON_Delete(root);
+    
+    return ESP_OK;
+}
+
+// Add capture completeness counters to a JSON object
+static void add_seq_counters(cJSON *item, const seq_counters_t *c) {
+    cJSON_AddNumberToObject(item, "received", c->received);
+    cJSON_AddNumberToObject(item, "duplicates", c->duplicates);
+    cJSON_AddNumberToObject(item, "missed_on_ch", c->missed_on_channel);
+    cJSON_AddNumberToObject(item, "missed_off_ch", c->missed_off_channel);
+    cJSON_AddNumberToObject(item, "coverage_pct", seq_coverage_permille(c) / 10.0);
+}
+
+// API handler for capture completeness from sequence number gaps (?n= transmitters)
+static esp_err_t api_stats_coverage_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    int max_entries = 32;
+    char buf[64];
+    if (httpd_req_get_url_query_str(req, buf, sizeof(buf)) == ESP_OK) {
+        char param[16];
+        if (httpd_query_key_value(buf, "n", param, sizeof(param)) == ESP_OK) {
+            max_entries = atoi(param);
+        }
+    }
+    if (max_entries < 1 || max_entries > SEQ_MAX_TRANSMITTERS) {
+        max_entries = SEQ_MAX_TRANSMITTERS;
+    }
+    
+    seq_entry_t *entries = malloc((max_entries + SEQ_MAX_CHANNELS) * sizeof(seq_entry_t));
+    if (!entries) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Out of memory\"}");
+        return ESP_OK;
+    }
+    seq_entry_t *channel_entries = entries + max_entries;
+    int channel_count;
+    seq_counters_t total;
+    int count = wifi_sniffer_get_seq_coverage(entries, max_entries, channel_entries, &channel_count, &total);
+    
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "status", "success");
+    add_seq_counters(root, &total);
+    
+    cJSON *channels = cJSON_AddArrayToObject(root, "channels");
+    for (int i = 0; i < channel_count; i++) {
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "ch", channel_entries[i].channel);
+        add_seq_counters(item, &channel_entries[i].counters);
+        cJSON_AddItemToArray(channels, item);
+    }
+    
+    char mac_str[18];
+    cJSON *devices = cJSON_AddArrayToObject(root, "devices");
+    for (int i = 0; i < count; i++) {
+        cJSON *item = cJSON_CreateObject();
+        format_mac_addr(mac_str, entries[i].addr);
+        cJSON_AddStringToObject(item, "mac", mac_str);
+        cJSON_AddNumberToObject(item, "ch", entries[i].channel);
+        add_seq_counters(item, &entries[i].counters);
+        cJSON_AddItemToArray(devices, item);
+    }
+    free(entries);
+    
+    char *json_response = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, json_response);
+    
+    free(json_response);
+    cJSON_Delete(root);
+    
+    return ESP_OK;
+}
+
+// API handler for per-channel airtime, one busy sample per hopper dwell
+static esp_err_t api_stats_airtime_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    airtime_t *at = malloc(sizeof(airtime_t));
+    if (!at) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Out of memory\"}");
+        return ESP_OK;
+    }
+    wifi_sniffer_get_airtime(at);
+    
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "status", "success");
+    cJSON_AddNumberToObject(root, "evicted_channels", at->evictions);
+    cJSON_AddNumberToObject(root, "dropped_frames", at->dropped_frames);
+    
+    // Samples are [end_ms, dwell_ms, busy_permille], oldest first
+    cJSON *channels = cJSON_AddArrayToObject(root, "channels");
+    for (int i = 0; i < AIRTIME_MAX_CHANNELS; i++) {
+        const airtime_channel_t *ch = &at->channels[i];
+        if (ch->channel == 0) continue;
+        
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "ch", ch->channel);
+        cJSON_AddNumberToObject(item, "frames", ch->frames);
+        cJSON_AddNumberToObject(item, "dwell_ms", (double)(ch->dwell_us / 1000));
+        cJSON_AddNumberToObject(item, "busy_pct", ch->dwell_us ? (double)(ch->busy_us * 1000 / ch->dwell_us) / 10.0 : 0);
+        
+        cJSON *samples = cJSON_AddArrayToObject(item, "samples");
+        for (int j = 0; j < ch->count; j++) {
+            const airtime_sample_t *sample = airtime_sample(ch, j);
+            cJSON *point = cJSON_CreateArray();
+            cJSON_AddItemToArray(point, cJSON_CreateNumber(sample->end_ms));
+            cJSON_AddItemToArray(point, cJSON_CreateNumber(sample->dwell_ms));
+            cJSON_AddItemToArray(point, cJSON_CreateNumber(sample->busy_permille));
+            cJSON_AddItemToArray(samples, point);
+        }
+        cJSON_AddItemToArray(channels, item);
+    }
+    free(at);
+    
+    char *json_response = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, json_response);
+    
+    free(json_response);
+    cJSON_Delete(root);
+    
+    return ESP_OK;
+}
+
+// API handler for management frame flood alerts (?since=<last alert id>)
+static esp_err_t api_wids_alerts_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    uint32_t since_id = 0;
+    char buf[64];
+    if (httpd_req_get_url_query_str(req, buf, sizeof(buf)) == ESP_OK) {
+        char param[16];
+        if (httpd_query_key_value(buf, "since", param, sizeof(param)) == ESP_OK) {
+            since_id = strtoul(param, NULL, 10);
+        }
+    }
+    
+    wids_alert_t *alerts = malloc(WIDS_ALERT_RING * sizeof(wids_alert_t));
+    if (!alerts) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Out of memory\"}");
+        return ESP_OK;
+    }
+    int count = wifi_sniffer_get_wids_alerts(since_id, alerts, WIDS_ALERT_RING);
+    
+    uint32_t thresholds[WIDS_CAT_COUNT];
+    uint32_t frames[WIDS_CAT_COUNT];
+    wifi_sniffer_get_wids_config(thresholds, frames);
+    
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "status", "success");
+    cJSON_AddNumberToObject(root, "window_s", WIDS_BUCKETS);
+    
+    cJSON *categories = cJSON_AddObjectToObject(root, "categories");
+    for (int i = 0; i < WIDS_CAT_COUNT; i++) {
+        cJSON *item = cJSON_AddObjectToObject(categories, wids_category_name(i));
+        cJSON_AddNumberToObject(item, "threshold", thresholds[i]);
+        cJSON_AddNumberToObject(item, "frames", frames[i]);
+    }
+    
+    char mac_str[18];
+    cJSON *list = cJSON_AddArrayToObject(root, "alerts");
+    for (int i = 0; i < count; i++) {
+        cJSON *item = cJSON_CreateObject();
+        format_mac_addr(mac_str, alerts[i].mac);
+        cJSON_AddNumberToObject(item, "id", alerts[i].id);
+        cJSON_AddNumberToObject(item, "time_ms", (double)(alerts[i].timestamp_us / 1000));
+        cJSON_AddStringToObject(item, "type", wids_category_name(alerts[i].category));
+        cJSON_AddStringToObject(item, "scope", wids_scope_name(alerts[i].scope));
+        cJSON_AddStringToObject(item, "mac", mac_str);
+        cJSON_AddNumberToObject(item, "ch", alerts[i].channel);
+        cJSON_AddNumberToObject(item, "count", alerts[i].count);
+        cJSON_AddNumberToObject(item, "threshold", alerts[i].threshold);
+        cJSON_AddItemToArray(list, item);
+    }
+    free(alerts);
+    
+    char *json_response = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, json_response);
+    
+    free(json_response);
+    cJSON_Delete(root);
+    
+    return ESP_OK;
+}
+
+// API handler for flood thresholds ({"deauth":20,"auth":50,"probe":200})
+static esp_err_t api_wids_config_handler(httpd_req_t *req) {
+    char content[128];
+    size_t recv_size = MIN(req->content_len, sizeof(content) - 1);
+    
+    httpd_resp_set_type(req, "application/json");
+    
+    int ret_len = httpd_req_recv(req, content, recv_size);
+    if (ret_len <= 0) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to receive data");
+        return ESP_FAIL;
+    }
+    content[ret_len] = '\0';
+    
+    cJSON *root = cJSON_Parse(content);
+    if (!root) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Invalid JSON\"}");
+        return ESP_OK;
+    }
+    
+    for (int i = 0; i < WIDS_CAT_COUNT; i++) {
+        cJSON *value = cJSON_GetObjectItem(root, wids_category_name(i));
+        if (cJSON_IsNumber(value) && value->valuedouble >= 1) {
+            wifi_sniffer_set_wids_threshold(i, (uint32_t)value->valuedouble);
+        }
+    }
+    cJSON_Delete(root);
+    
+    uint32_t thresholds[WIDS_CAT_COUNT];
+    uint32_t frames[WIDS_CAT_COUNT];
+    wifi_sniffer_get_wids_config(thresholds, frames);
+    
+    cJSON *response = cJSON_CreateObject();
+    cJSON_AddStringToObject(response, "status", "success");
+    for (int i = 0; i < WIDS_CAT_COUNT; i++) {
+        cJSON_AddNumberToObject(response, wids_category_name(i), thresholds[i]);
+    }
+    
+    char *json_response = cJSON_PrintUnformatted(response);
+    httpd_resp_sendstr(req, json_response);
+    
+    free(json_response);
+    cJSON_Delete(response);
+    
+    return ESP_OK;
+}
+
+// API handler for the evil-twin index (?flagged=1 to only list divergent BSSs)
+static esp_err_t api_rogue_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    bool flagged_only = false;
+    char buf[64];
+    if (httpd_req_get_url_query_str(req, buf, sizeof(buf)) == ESP_OK) {
+        char param[8];
+        if (httpd_query_key_value(buf, "flagged", param, sizeof(param)) == ESP_OK) {
+            flagged_only = atoi(param) != 0;
+        }
+    }
+    
+    rogue_ap_t *index = malloc(sizeof(rogue_ap_t));
+    if (!index) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Out of memory\"}");
+        return ESP_OK;
+    }
+    wifi_sniffer_get_rogue_index(index);
+    
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "status", "success");
+    cJSON_AddNumberToObject(root, "baseline_entries", index->baseline_count);
+    cJSON_AddNumberToObject(root, "alerts", index->alerts);
+    
+    char mac_str[18];
+    cJSON *ssids = cJSON_AddArrayToObject(root, "ssids");
+    for (uint16_t slot = index->ssid_table.lru_head; slot != MAC_TABLE_NONE;
+         slot = index->ssid_nodes[slot].lru_next) {
+        const rogue_ssid_t *entry = &index->ssids[slot];
+        cJSON *bss_list = cJSON_CreateArray();
+        
+        for (int i = 0; i < entry->bss_count; i++) {
+            const rogue_bss_t *bss = &entry->bss[i];
+            if (flagged_only && !bss->flags) continue;
+            
+            cJSON *item = cJSON_CreateObject();
+            format_mac_addr(mac_str, bss->bssid);
+            cJSON_AddStringToObject(item, "bssid", mac_str);
+            cJSON_AddNumberToObject(item, "ch", bss->channel);
+            cJSON_AddStringToObject(item, "auth", rogue_ap_auth_name(bss->auth));
+            cJSON_AddNumberToObject(item, "fingerprint", bss->fingerprint);
+            cJSON_AddNumberToObject(item, "rssi", bss->rssi);
+            cJSON_AddNumberToObject(item, "seen", bss->seen);
+            cJSON_AddBoolToObject(item, "scanned", bss->sources & ROGUE_SOURCE_SCAN);
+            cJSON_AddBoolToObject(item, "captured", bss->sources & ROGUE_SOURCE_BEACON);
+            
+            cJSON *flags = cJSON_AddArrayToObject(item, "flags");
+            if (bss->flags & ROGUE_FLAG_UNKNOWN_BSSID) cJSON_AddItemToArray(flags, cJSON_CreateString("unknown_bssid"));
+            if (bss->flags & ROGUE_FLAG_CHANNEL) cJSON_AddItemToArray(flags, cJSON_CreateString("channel"));
+            if (bss->flags & ROGUE_FLAG_DOWNGRADE) cJSON_AddItemToArray(flags, cJSON_CreateString("downgrade"));
+            if (bss->flags & ROGUE_FLAG_FINGERPRINT) cJSON_AddItemToArray(flags, cJSON_CreateString("fingerprint"));
+            cJSON_AddItemToArray(bss_list, item);
+        }
+        
+        if (flagged_only && cJSON_GetArraySize(bss_list) == 0) {
+            cJSON_Delete(bss_list);
+            continue;
+        }
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "ssid", entry->ssid);
+        cJSON_AddBoolToObject(item, "baselined", rogue_ap_is_baselined(index, entry->ssid));
+        cJSON_AddItemToObject(item, "bss", bss_list);
+        cJSON_AddItemToArray(ssids, item);
+    }
+    free(index);
+    
+    char *json_response = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, json_response);
+    
+    free(json_response);
+    cJSON_Delete(root);
+    
+    return ESP_OK;
+}
+
+// API handler for uploading the evil-twin baseline
+// Body: [{"ssid":"...","bssid":"aa:bb:cc:dd:ee:ff","channel":6,"auth":"wpa2"}, ...],
+// or ?learn=1 to accept everything observed so far
+static esp_err_t api_rogue_baseline_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    char buf[64];
+    if (httpd_req_get_url_query_str(req, buf, sizeof(buf)) == ESP_OK) {
+        char param[8];
+        if (httpd_query_key_value(buf, "learn", param, sizeof(param)) == ESP_OK && atoi(param)) {
+            int installed = wifi_sniffer_set_rogue_baseline(NULL, 0);
+            snprintf(buf, sizeof(buf), "{\"status\":\"success\",\"installed\":%d}", installed);
+            httpd_resp_sendstr(req, buf);
+            return ESP_OK;
+        }
+    }
+    
+    // Room for a full baseline with some formatting slack
+    if (req->content_len == 0 || req->content_len > 16384) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Invalid body size\"}");
+        return ESP_OK;
+    }
+    char *content = malloc(req->content_len + 1);
+    const int max_entries = ROGUE_MAX_BASELINE_SSIDS * ROGUE_MAX_BSS_PER_SSID;
+    rogue_baseline_entry_t *entries = malloc(max_entries * sizeof(rogue_baseline_entry_t));
+    if (!content || !entries) {
+        free(content);
+        free(entries);
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Out of memory\"}");
+        return ESP_OK;
+    }
+    
+    size_t received = 0;
+    while (received < req->content_len) {
+        int ret_len = httpd_req_recv(req, content + received, req->content_len - received);
+        if (ret_len == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+        }
+        if (ret_len <= 0) {
+            free(content);
+            free(entries);
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to receive data");
+            return ESP_FAIL;
+        }
+        received += ret_len;
+    }
+    content[received] = '\0';
+    
+    cJSON *root = cJSON_Parse(content);
+    free(content);
+    if (!cJSON_IsArray(root)) {
+        cJSON_Delete(root);
+        free(entries);
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Expected a JSON array\"}");
+        return ESP_OK;
+    }
+    
+    int count = 0;
+    int rejected = 0;
+    cJSON *item;
+    cJSON_ArrayForEach(item, root) {
+        cJSON *ssid = cJSON_GetObjectItem(item, "ssid");
+        cJSON *bssid = cJSON_GetObjectItem(item, "bssid");
+        cJSON *channel = cJSON_GetObjectItem(item, "channel");
+        cJSON *auth = cJSON_GetObjectItem(item, "auth");
+        rogue_baseline_entry_t *entry = &entries[count];
+        
+        if (count >= max_entries || !cJSON_IsString(ssid) || !cJSON_IsString(bssid) ||
+            strlen(ssid->valuestring) == 0 || strlen(ssid->valuestring) > 32 ||
+            !parse_mac_addr(bssid->valuestring, entry->bssid)) {
+            rejected++;
+            continue;
+        }
+        strcpy(entry->ssid, ssid->valuestring);
+        entry->channel = cJSON_IsNumber(channel) ? channel->valueint : 0;
+        entry->auth = cJSON_IsString(auth) ? rogue_ap_auth_from_name(auth->valuestring) : ROGUE_AUTH_WPA2;
+        if (entry->auth >= ROGUE_AUTH_COUNT) {
+            rejected++;
+            continue;
+        }
+        count++;
+    }
+    cJSON_Delete(root);
+    
+    int installed = wifi_sniffer_set_rogue_baseline(entries, count);
+    free(entries);
+    
+    cJSON *response = cJSON_CreateObject();
+    cJSON_AddStringToObject(response, "status", "success");
+    cJSON_AddNumberToObject(response, "installed", installed);
+    cJSON_AddNumberToObject(response, "rejected", rejected + count - installed);
+    
+    char *json_response = cJSON_PrintUnformatted(response);
+    httpd_resp_sendstr(req, json_response);
+    
+    free(json_response);
+    cJSON_Delete(response);
+    
+    return ESP_OK;
+}
+
+// API handler to start recording to flash (?max_kb=&max_s=&files=&compress=1)
+static esp_err_t api_storage_start_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    uint32_t max_kb = 0, max_s = 0, files = 0;
+    bool compress = false;
+    char buf[96];
+    if (httpd_req_get_url_query_str(req, buf, sizeof(buf)) == ESP_OK) {
+        char param[16];
+        if (httpd_query_key_value(buf, "max_kb", param, sizeof(param)) == ESP_OK) {
+            max_kb = strtoul(param, NULL, 10);
+        }
+        if (httpd_query_key_value(buf, "max_s", param, sizeof(param)) == ESP_OK) {
+            max_s = strtoul(param, NULL, 10);
+        }
+        if (httpd_query_key_value(buf, "files", param, sizeof(param)) == ESP_OK) {
+            files = strtoul(param, NULL, 10);
+        }
+        if (httpd_query_key_value(buf, "compress", param, sizeof(param)) == ESP_OK) {
+            compress = atoi(param) != 0;
+        }
+    }
+    if (max_kb > 4096 || files > 1000 || max_s > 86400) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Invalid segment limits\"}");
+        return ESP_OK;
+    }
+    
+    if (!capture_storage_start(max_kb * 1024, max_s * 1000, files, compress)) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Failed to start recording\"}");
+        return ESP_OK;
+    }
+    
+    httpd_resp_sendstr(req, "{\"status\":\"success\",\"message\":\"Recording started\"}");
+    return ESP_OK;
+}
+
+// API handler to stop recording to flash
+static esp_err_t api_storage_stop_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    capture_storage_stop();
+    
+    httpd_resp_sendstr(req, "{\"status\":\"success\",\"message\":\"Recording stopped\"}");
+    return ESP_OK;
+}
+
+// API handler for recording state and stored segments
+static esp_err_t api_storage_status_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    capture_storage_status_t status;
+    capture_storage_get_status(&status);
+    
+    pcap_segment_t *segments = malloc(64 * sizeof(pcap_segment_t));
+    if (!segments) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Out of memory\"}");
+        return ESP_OK;
+    }
+    int count = capture_storage_list(segments, 64);
+    
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "status", "success");
+    cJSON_AddBoolToObject(root, "mounted", status.mounted);
+    cJSON_AddBoolToObject(root, "running", status.running);
+    cJSON_AddNumberToObject(root, "segment_kb", status.config.max_segment_bytes / 1024);
+    cJSON_AddNumberToObject(root, "segment_s", status.config.max_segment_ms / 1000);
+    cJSON_AddNumberToObject(root, "max_files", status.config.max_files);
+    cJSON_AddNumberToObject(root, "frames", status.frames);
+    cJSON_AddNumberToObject(root, "dropped", status.dropped_frames);
+    cJSON_AddNumberToObject(root, "dropped_bytes", (double)status.dropped_bytes);
+    cJSON_AddNumberToObject(root, "pending_buffers", status.buffers_pending);
+    cJSON_AddNumberToObject(root, "segments", status.segments);
+    cJSON_AddNumberToObject(root, "removed", status.removed);
+    cJSON_AddNumberToObject(root, "bytes", (double)status.bytes);
+    cJSON_AddBoolToObject(root, "compress", status.config.compress);
+    if (status.raw_bytes) {
+        cJSON_AddNumberToObject(root, "raw_bytes", (double)status.raw_bytes);
+        cJSON_AddNumberToObject(root, "ratio", (double)status.raw_bytes / status.compressed_bytes);
+        cJSON_AddNumberToObject(root, "cpu_ms_per_mb", (double)status.compress_us * 1048.576 / status.raw_bytes);
+    }
+    cJSON_AddNumberToObject(root, "write_errors", status.write_errors);
+    cJSON_AddNumberToObject(root, "total_bytes", (double)status.total_bytes);
+    cJSON_AddNumberToObject(root, "free_bytes", (double)status.free_bytes);
+    
+    cJSON *files = cJSON_AddArrayToObject(root, "files");
+    for (int i = 0; i < count; i++) {
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "name", segments[i].name);
+        cJSON_AddNumberToObject(item, "size", segments[i].size);
+        cJSON_AddBoolToObject(item, "lz4", segments[i].compressed);
+        cJSON_AddBoolToObject(item, "active", segments[i].active);
+        cJSON_AddItemToArray(files, item);
+    }
+    free(segments);
+    
+    char *json_response = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, json_response);
+    
+    free(json_response);
+    cJSON_Delete(root);
+    
+    return ESP_OK;
+}
+
+// API handler to download a stored segment (?name=&lz4=1 compresses plain segments on the fly)
+static esp_err_t api_storage_file_handler(httpd_req_t *req) {
+    char buf[80];
+    char name[PCAP_STORE_MAX_NAME] = {0};
+    bool lz4 = false;
+    if (httpd_req_get_url_query_str(req, buf, sizeof(buf)) == ESP_OK) {
+        char param[8];
+        httpd_query_key_value(buf, "name", name, sizeof(name));
+        if (httpd_query_key_value(buf, "lz4", param, sizeof(param)) == ESP_OK) {
+            lz4 = atoi(param) != 0;
+        }
+    }
+    
+    bool compressed = false;
+    FILE *file = capture_storage_open_segment(name, &compressed);
+    if (!file) {
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Unknown or active segment\"}");
+        return ESP_OK;
+    }
+    lz4 = lz4 && !compressed;
+    
+    // Stream in chunks; segments are far larger than any heap buffer
+    size_t chunk_size = lz4 ? PCAP_STORE_BUFFER_SIZE : 2048;
+    char *chunk = malloc(chunk_size);
+    lz4_state_t *state = lz4 ? malloc(sizeof(lz4_state_t)) : NULL;
+    uint8_t *block = lz4 ? malloc(LZ4_FRAME_BLOCK_BOUND(PCAP_STORE_BUFFER_SIZE)) : NULL;
+    if (!chunk || (lz4 && (!state || !block))) {
+        free(chunk);
+        free(state);
+        free(block);
+        fclose(file);
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+    
+    char disposition[PCAP_STORE_MAX_NAME + 40];
+    snprintf(disposition, sizeof(disposition), "attachment; filename=\"%s%s\"", name, lz4 ? ".lz4" : "");
+    httpd_resp_set_type(req, compressed || lz4 ? "application/x-lz4" : "application/vnd.tcpdump.pcap");
+    httpd_resp_set_hdr(req, "Content-Disposition", disposition);
+    
+    esp_err_t err = ESP_OK;
+    if (lz4) {
+        uint8_t header[LZ4_FRAME_HEADER_LEN];
+        err = httpd_resp_send_chunk(req, (const char *)header, lz4_frame_header(header));
+    }
+    size_t len;
+    while (err == ESP_OK && (len = fread(chunk, 1, chunk_size, file)) > 0) {
+        if (lz4) {
+            size_t block_len = lz4_frame_block(state, (const uint8_t *)chunk, len, block);
+            err = httpd_resp_send_chunk(req, (const char *)block, block_len);
+        } else {
+            err = httpd_resp_send_chunk(req, chunk, len);
+        }
+    }
+    if (err == ESP_OK && lz4) {
+        uint8_t end[LZ4_FRAME_END_LEN];
+        err = httpd_resp_send_chunk(req, (const char *)end, lz4_frame_end(end));
+    }
+    free(chunk);
+    free(state);
+    free(block);
+    fclose(file);
+    
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Segment download aborted: %s", esp_err_to_name(err));
+        return err;
+    }
+    httpd_resp_send_chunk(req, NULL, 0);
+    return ESP_OK;
+}
+
+// API handler to arm a trigger slot
+// (?slot=&frames=deauth,disassoc&addr=&burst=&window=&pre=&post=&rearm=)
+static esp_err_t api_trigger_arm_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    trigger_config_t config = {
+        .frames = 0,
+        .burst = 1,
+        .burst_ms = 1000,
+        .pre = 50,
+        .post = 50,
+        .rearm = false,
+    };
+    int slot = -1;
+    bool valid = true;
+    char buf[256];
+    if (httpd_req_get_url_query_str(req, buf, sizeof(buf)) == ESP_OK) {
+        char param[160];
+        if (httpd_query_key_value(buf, "slot", param, sizeof(param)) == ESP_OK) {
+            slot = atoi(param);
+        }
+        if (httpd_query_key_value(buf, "frames", param, sizeof(param)) == ESP_OK) {
+            valid = trigger_window_parse_frames(param, &config.frames);
+        }
+        if (httpd_query_key_value(buf, "addr", param, sizeof(param)) == ESP_OK) {
+            config.match_addr = true;
+            valid = valid && parse_mac_addr(param, config.addr);
+        }
+        if (httpd_query_key_value(buf, "burst", param, sizeof(param)) == ESP_OK) {
+            int burst = atoi(param);
+            valid = valid && burst >= 0 && burst <= TRIGGER_MAX_BURST;
+            config.burst = burst;
+        }
+        if (httpd_query_key_value(buf, "window", param, sizeof(param)) == ESP_OK) {
+            config.burst_ms = strtoul(param, NULL, 10);
+        }
+        if (httpd_query_key_value(buf, "pre", param, sizeof(param)) == ESP_OK) {
+            config.pre = atoi(param) > 0 ? atoi(param) : 0;
+        }
+        if (httpd_query_key_value(buf, "post", param, sizeof(param)) == ESP_OK) {
+            config.post = atoi(param) > 0 ? atoi(param) : 0;
+        }
+        if (httpd_query_key_value(buf, "rearm", param, sizeof(param)) == ESP_OK) {
+            config.rearm = atoi(param) != 0;
+        }
+    }
+    // A MAC alone triggers on any frame carrying it
+    if (valid && !config.frames) {
+        config.frames = config.match_addr ? TRIGGER_FRAMES_ANY : 0;
+    }
+    if (slot < 0 || slot >= TRIGGER_SLOTS || !valid || !config.frames ||
+        config.pre + config.post > TRIGGER_MAX_FRAMES) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Invalid slot, frames, address, burst or capture size\"}");
+        return ESP_OK;
+    }
+    
+    if (!trigger_capture_arm(slot, &config)) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Failed to arm trigger\"}");
+        return ESP_OK;
+    }
+    
+    httpd_resp_sendstr(req, "{\"status\":\"success\",\"message\":\"Trigger armed\"}");
+    return ESP_OK;
+}
+
+// API handler to disarm a trigger slot (?slot=)
+static esp_err_t api_trigger_disarm_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    int slot = -1;
+    char buf[32];
+    if (httpd_req_get_url_query_str(req, buf, sizeof(buf)) == ESP_OK) {
+        char param[8];
+        if (httpd_query_key_value(buf, "slot", param, sizeof(param)) == ESP_OK) {
+            slot = atoi(param);
+        }
+    }
+    
+    if (slot < 0 || !trigger_capture_disarm(slot)) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Invalid slot\"}");
+        return ESP_OK;
+    }
+    
+    httpd_resp_sendstr(req, "{\"status\":\"success\",\"message\":\"Trigger disarmed\"}");
+    return ESP_OK;
+}
+
+// API handler for the trigger slots: conditions, states and saved captures
+static esp_err_t api_trigger_status_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    trigger_capture_status_t *status = malloc(sizeof(trigger_capture_status_t));
+    if (!status) {
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+    trigger_capture_get_status(status);
+    
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "status", "success");
+    cJSON_AddBoolToObject(root, "active", status->active);
+    cJSON_AddNumberToObject(root, "window_frames", status->window_frames);
+    cJSON_AddNumberToObject(root, "frames", (double)status->frames);
+    cJSON_AddNumberToObject(root, "bytes", (double)status->bytes);
+    cJSON_AddNumberToObject(root, "dropped", status->dropped);
+    cJSON_AddNumberToObject(root, "write_errors", status->write_errors);
+    
+    cJSON *slots = cJSON_AddArrayToObject(root, "slots");
+    for (int i = 0; i < TRIGGER_SLOTS; i++) {
+        const trigger_slot_t *slot = &status->slots[i];
+        char frames[160];
+        trigger_window_format_frames(slot->config.frames, frames, sizeof(frames));
+        
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "slot", i);
+        cJSON_AddStringToObject(item, "state", trigger_window_state_name(slot->state));
+        cJSON_AddStringToObject(item, "frames", frames);
+        if (slot->config.match_addr) {
+            char addr_str[18];
+            format_mac_addr(addr_str, slot->config.addr);
+            cJSON_AddStringToObject(item, "addr", addr_str);
+        }
+        cJSON_AddNumberToObject(item, "burst", slot->config.burst);
+        cJSON_AddNumberToObject(item, "window_ms", slot->config.burst_ms);
+        cJSON_AddNumberToObject(item, "pre", slot->config.pre);
+        cJSON_AddNumberToObject(item, "post", slot->config.post);
+        cJSON_AddBoolToObject(item, "rearm", slot->config.rearm);
+        cJSON_AddNumberToObject(item, "matches", slot->matches);
+        cJSON_AddNumberToObject(item, "fired", slot->fired);
+        cJSON_AddNumberToObject(item, "saved", slot->saved);
+        cJSON_AddNumberToObject(item, "lost", slot->lost);
+        cJSON_AddStringToObject(item, "file", status->files[i]);
+        cJSON_AddItemToArray(slots, item);
+    }
+    free(status);
+    
+    char *json_response = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, json_response);
+    
+    free(json_response);
+    cJSON_Delete(root);
+    
+    return ESP_OK;
+}
+
+// API handler to download a saved trigger capture (?name=)
+static esp_err_t api_trigger_file_handler(httpd_req_t *req) {
+    char buf[64];
+    char name[TRIGGER_CAPTURE_MAX_NAME] = {0};
+    if (httpd_req_get_url_query_str(req, buf, sizeof(buf)) == ESP_OK) {
+        httpd_query_key_value(buf, "name", name, sizeof(name));
+    }
+    
+    FILE *file = trigger_capture_open(name);
+    if (!file) {
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Unknown capture\"}");
+        return ESP_OK;
+    }
+    
+    char *chunk = malloc(2048);
+    if (!chunk) {
+        fclose(file);
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+    
+    char disposition[TRIGGER_CAPTURE_MAX_NAME + 40];
+    snprintf(disposition, sizeof(disposition), "attachment; filename=\"%s\"", name);
+    httpd_resp_set_type(req, "application/vnd.tcpdump.pcap");
+    httpd_resp_set_hdr(req, "Content-Disposition", disposition);
+    
+    esp_err_t err = ESP_OK;
+    size_t len;
+    while (err == ESP_OK && (len = fread(chunk, 1, 2048, file)) > 0) {
+        err = httpd_resp_send_chunk(req, chunk, len);
+    }
+    free(chunk);
+    fclose(file);
+    
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Trigger capture download aborted: %s", esp_err_to_name(err));
+        return err;
+    }
+    httpd_resp_send_chunk(req, NULL, 0);
+    return ESP_OK;
+}
+
+// API handler to start the UDP export (?ip=<collector>&port=)
+static esp_err_t api_export_udp_start_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    char ip[16] = {0};
+    uint32_t port = UDP_EXPORT_DEFAULT_PORT;
+    char buf[64];
+    if (httpd_req_get_url_query_str(req, buf, sizeof(buf)) == ESP_OK) {
+        char param[8];
+        httpd_query_key_value(buf, "ip", ip, sizeof(ip));
+        if (httpd_query_key_value(buf, "port", param, sizeof(param)) == ESP_OK) {
+            port = strtoul(param, NULL, 10);
+        }
+    }
+    if (ip[0] == '\0' || port == 0 || port > 65535) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Missing collector ip or invalid port\"}");
+        return ESP_OK;
+    }
+    
+    if (!udp_export_start(ip, port)) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Failed to start export\"}");
+        return ESP_OK;
+    }
+    
+    httpd_resp_sendstr(req, "{\"status\":\"success\",\"message\":\"Export started\"}");
+    return ESP_OK;
+}
+
+// API handler to stop the UDP export
+static esp_err_t api_export_udp_stop_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    udp_export_stop();
+    
+    httpd_resp_sendstr(req, "{\"status\":\"success\",\"message\":\"Export stopped\"}");
+    return ESP_OK;
+}
+
+// API handler for UDP export counters
+static esp_err_t api_export_udp_status_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    udp_export_status_t status;
+    udp_export_get_status(&status);
+    
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "status", "success");
+    cJSON_AddBoolToObject(root, "running", status.running);
+    cJSON_AddStringToObject(root, "collector", status.collector);
+    cJSON_AddNumberToObject(root, "port", status.port);
+    cJSON_AddNumberToObject(root, "next_seq", status.next_seq);
+    cJSON_AddNumberToObject(root, "batches", status.batches);
+    cJSON_AddNumberToObject(root, "frames", status.frames);
+    cJSON_AddNumberToObject(root, "bytes", (double)status.bytes);
+    cJSON_AddNumberToObject(root, "send_errors", status.send_errors);
+    
+    char *json_response = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, json_response);
+    
+    free(json_response);
+    cJSON_Delete(root);
+    
+    return ESP_OK;
+}
+
+// API handler to start the UART capture stream (?baud=&policy=drop|block)
+static esp_err_t api_uart_start_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    uint32_t baud = UART_STREAM_DEFAULT_BAUD;
+    uart_stream_policy_t policy = UART_STREAM_DROP;
+    char buf[64];
+    if (httpd_req_get_url_query_str(req, buf, sizeof(buf)) == ESP_OK) {
+        char param[16];
+        if (httpd_query_key_value(buf, "baud", param, sizeof(param)) == ESP_OK) {
+            baud = strtoul(param, NULL, 10);
+        }
+        if (httpd_query_key_value(buf, "policy", param, sizeof(param)) == ESP_OK) {
+            policy = strcmp(param, "block") == 0 ? UART_STREAM_BLOCK : UART_STREAM_DROP;
+        }
+    }
+    if (baud < 9600 || baud > 5000000) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Invalid baud rate\"}");
+        return ESP_OK;
+    }
+    
+    // Reply first: the console goes quiet once the stream starts
+    httpd_resp_sendstr(req, "{\"status\":\"success\",\"message\":\"UART stream starting\"}");
+    if (!uart_stream_start(baud, policy)) {
+        ESP_LOGW(TAG, "Failed to start UART stream");
+    }
+    return ESP_OK;
+}
+
+// API handler to stop the UART capture stream
+static esp_err_t api_uart_stop_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    uart_stream_stop();
+    
+    httpd_resp_sendstr(req, "{\"status\":\"success\",\"message\":\"UART stream stopped\"}");
+    return ESP_OK;
+}
+
+// API handler for UART capture stream counters
+static esp_err_t api_uart_status_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    uart_stream_status_t status;
+    uart_stream_get_status(&status);
+    
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "status", "success");
+    cJSON_AddBoolToObject(root, "running", status.running);
+    cJSON_AddNumberToObject(root, "baud", status.baud);
+    cJSON_AddStringToObject(root, "policy", uart_stream_policy_name(status.policy));
+    cJSON_AddNumberToObject(root, "frames", status.frames);
+    cJSON_AddNumberToObject(root, "dropped", status.dropped);
+    cJSON_AddNumberToObject(root, "device_dropped", status.device_dropped);
+    cJSON_AddNumberToObject(root, "suppressed_logs", status.suppressed_logs);
+    cJSON_AddNumberToObject(root, "bytes", (double)status.bytes);
+    
+    char *json_response = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, json_response);
+    
+    free(json_response);
+    cJSON_Delete(root);
+    
+    return ESP_OK;
+}
+
+// API handler to start a synthetic load test
+// (?fps=&seconds=&aps=&stations=&mix=<beacon,probe,data,control>&channels=1,6,11&rssi=&seed=)
+static esp_err_t api_loadgen_start_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    traffic_gen_config_t config;
+    traffic_gen_default_config(&config);
+    uint32_t fps = 1000;
+    uint32_t seconds = 10;
+    bool valid = true;
+    char buf[256];
+    if (httpd_req_get_url_query_str(req, buf, sizeof(buf)) == ESP_OK) {
+        char param[64];
+        if (httpd_query_key_value(buf, "fps", param, sizeof(param)) == ESP_OK) {
+            fps = strtoul(param, NULL, 10);
+        }
+        if (httpd_query_key_value(buf, "seconds", param, sizeof(param)) == ESP_OK) {
+            seconds = strtoul(param, NULL, 10);
+        }
+        if (httpd_query_key_value(buf, "aps", param, sizeof(param)) == ESP_OK) {
+            config.aps = strtoul(param, NULL, 10);
+        }
+        if (httpd_query_key_value(buf, "stations", param, sizeof(param)) == ESP_OK) {
+            config.stations = strtoul(param, NULL, 10);
+        }
+        if (httpd_query_key_value(buf, "rssi", param, sizeof(param)) == ESP_OK) {
+            config.rssi_mean = atoi(param);
+        }
+        if (httpd_query_key_value(buf, "seed", param, sizeof(param)) == ESP_OK) {
+            config.seed = strtoul(param, NULL, 10);
+        }
+        if (httpd_query_key_value(buf, "mix", param, sizeof(param)) == ESP_OK) {
+            valid &= traffic_gen_parse_list(param, config.mix, TRAFFIC_GEN_KIND_COUNT) == TRAFFIC_GEN_KIND_COUNT;
+        }
+        if (httpd_query_key_value(buf, "channels", param, sizeof(param)) == ESP_OK) {
+            int count = traffic_gen_parse_list(param, config.channels, TRAFFIC_GEN_MAX_CHANNELS);
+            valid &= count > 0;
+            config.channel_count = count > 0 ? count : 0;
+        }
+    }
+    if (!valid || seconds == 0 || seconds * 1000 > LOAD_GEN_MAX_DURATION_MS) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Invalid mix, channels or duration\"}");
+        return ESP_OK;
+    }
+    
+    if (!load_gen_start(&config, fps, seconds * 1000)) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Failed to start load test (is the sniffer running?)\"}");
+        return ESP_OK;
+    }
+    
+    httpd_resp_sendstr(req, "{\"status\":\"success\",\"message\":\"Load test started\"}");
+    return ESP_OK;
+}
+
+// API handler to stop a load test early
+static esp_err_t api_loadgen_stop_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    load_gen_stop();
+    
+    httpd_resp_sendstr(req, "{\"status\":\"success\",\"message\":\"Load test stopped\"}");
+    return ESP_OK;
+}
+
+// API handler for load test results
+static esp_err_t api_loadgen_status_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    load_gen_status_t status;
+    load_gen_get_status(&status);
+    
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "status", "success");
+    cJSON_AddBoolToObject(root, "running", status.running);
+    cJSON_AddNumberToObject(root, "target_fps", status.target_fps);
+    cJSON_AddNumberToObject(root, "achieved_fps",
+                            status.elapsed_ms ? (double)status.injected * 1000 / status.elapsed_ms : 0);
+    cJSON_AddNumberToObject(root, "duration_ms", status.duration_ms);
+    cJSON_AddNumberToObject(root, "elapsed_ms", status.elapsed_ms);
+    cJSON_AddNumberToObject(root, "injected", status.injected);
+    cJSON_AddNumberToObject(root, "rejected", status.rejected);
+    cJSON *kinds = cJSON_AddObjectToObject(root, "kinds");
+    for (int i = 0; i < TRAFFIC_GEN_KIND_COUNT; i++) {
+        cJSON_AddNumberToObject(kinds, traffic_gen_kind_name(i), status.kinds[i]);
+    }
+    
+    // Loss is relative to the frames that reached the capture buffer
+    uint32_t offered = status.captured + status.dropped;
+    cJSON *buffer = cJSON_AddObjectToObject(root, "buffer");
+    cJSON_AddNumberToObject(buffer, "captured", status.captured);
+    cJSON_AddNumberToObject(buffer, "evicted", status.evicted);
+    cJSON_AddNumberToObject(buffer, "dropped", status.dropped);
+    cJSON_AddNumberToObject(buffer, "loss_pct",
+                            offered ? (double)(status.evicted + status.dropped) * 100 / offered : 0);
+    cJSON_AddNumberToObject(buffer, "peak", status.buffer_peak);
+    cJSON_AddNumberToObject(buffer, "capacity", CAPTURE_BUFFER_CAPACITY);
+    
+    cJSON *handler = cJSON_AddObjectToObject(root, "handler_ns");
+    cJSON_AddNumberToObject(handler, "mean", status.handler_mean_ns);
+    cJSON_AddNumberToObject(handler, "p50", status.handler_p50_ns);
+    cJSON_AddNumberToObject(handler, "p99", status.handler_p99_ns);
+    cJSON_AddNumberToObject(handler, "p999", status.handler_p999_ns);
+    cJSON_AddNumberToObject(handler, "max", status.handler_max_ns);
+    
+    char *json_response = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, json_response);
+    
+    free(json_response);
+    cJSON_Delete(root);
+    
+    return ESP_OK;
+}
+
+// API handler to lock the sniffer onto a BSS (?bssid=&channel=, channel 0 or absent to search)
+static esp_err_t api_sniff_follow_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    uint8_t bssid[6];
+    bool has_bssid = false;
+    uint8_t channel = 0;
+    char buf[64];
+    if (httpd_req_get_url_query_str(req, buf, sizeof(buf)) == ESP_OK) {
+        char param[24];
+        if (httpd_query_key_value(buf, "bssid", param, sizeof(param)) == ESP_OK) {
+            has_bssid = parse_mac_addr(param, bssid);
+        }
+        if (httpd_query_key_value(buf, "channel", param, sizeof(param)) == ESP_OK) {
+            channel = atoi(param);
+        }
+    }
+    if (!has_bssid) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Invalid BSSID\"}");
+        return ESP_OK;
+    }
+    
+    if (!wifi_sniffer_follow(bssid, channel)) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Failed to follow (is the sniffer running?)\"}");
+        return ESP_OK;
+    }
+    
+    httpd_resp_sendstr(req, "{\"status\":\"success\",\"message\":\"Following BSSID\"}");
+    return ESP_OK;
+}
+
+// API handler to stop following and return to the capture's own channel
+static esp_err_t api_sniff_unfollow_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    if (!wifi_sniffer_unfollow()) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Not following a BSSID\"}");
+        return ESP_OK;
+    }
+    
+    httpd_resp_sendstr(req, "{\"status\":\"success\",\"message\":\"Stopped following\"}");
+    return ESP_OK;
+}
+
+// API handler for the follow session: lock state, channel switches and reacquisitions
+static esp_err_t api_sniff_follow_status_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    follow_target_t follow;
+    bool active = wifi_sniffer_get_follow(&follow);
+    
+    char bssid_str[18];
+    format_mac_addr(bssid_str, follow.bssid);
+    uint64_t total_us = follow.locked_us + follow.searching_us;
+    
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "status", "success");
+    cJSON_AddBoolToObject(root, "following", active);
+    cJSON_AddStringToObject(root, "bssid", bssid_str);
+    cJSON_AddStringToObject(root, "state", follow_target_state_name(follow.state));
+    cJSON_AddNumberToObject(root, "channel", follow.channel);
+    cJSON_AddNumberToObject(root, "beacon_interval_us", (double)follow.interval_us);
+    cJSON_AddBoolToObject(root, "csa_pending", follow.csa_pending);
+    if (follow.csa_pending) {
+        cJSON_AddNumberToObject(root, "csa_channel", follow.csa_channel);
+    }
+    cJSON_AddNumberToObject(root, "beacons", follow.beacons);
+    cJSON_AddNumberToObject(root, "announcements", follow.announcements);
+    cJSON_AddNumberToObject(root, "csa_switches", follow.csa_switches);
+    cJSON_AddNumberToObject(root, "moves", follow.moves);
+    cJSON_AddNumberToObject(root, "losses", follow.losses);
+    cJSON_AddNumberToObject(root, "reacquisitions", follow.reacquisitions);
+    cJSON_AddNumberToObject(root, "sweeps", follow.sweeps);
+    cJSON_AddNumberToObject(root, "reacquire_mean_ms",
+                            follow.reacquisitions ? (double)follow.reacquire_total_us / follow.reacquisitions / 1000 : 0);
+    cJSON_AddNumberToObject(root, "reacquire_max_ms", (double)follow.reacquire_max_us / 1000);
+    cJSON_AddNumberToObject(root, "locked_ms", (double)(follow.locked_us / 1000));
+    cJSON_AddNumberToObject(root, "searching_ms", (double)(follow.searching_us / 1000));
+    cJSON_AddNumberToObject(root, "locked_pct", total_us ? (double)follow.locked_us * 100 / total_us : 0);
+    
+    char *json_response = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, json_response);
+    
+    free(json_response);
+    cJSON_Delete(root);
+    
+    return ESP_OK;
+}
+
+// API handler for how the radio's time was split between its clients
+static esp_err_t api_radio_status_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    radio_sched_status_t status;
+    radio_sched_get_status(&status);
+    
+    uint64_t total_ms = status.parked_ms;
+    for (int c = 0; c < RADIO_CLIENT_COUNT; c++) {
+        total_ms += status.granted_ms[c];
+    }
+    
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "status", "success");
+    cJSON_AddStringToObject(root, "current", radio_sched_client_name(status.current));
+    cJSON_AddNumberToObject(root, "channel", status.channel);
+    cJSON_AddBoolToObject(root, "sniffing", status.sniffing);
+    cJSON_AddNumberToObject(root, "sniffer_channel", status.sniffer_channel);
+    cJSON_AddBoolToObject(root, "scan_pending", status.scan_pending);
+    cJSON_AddNumberToObject(root, "ap_stations", status.ap_stations);
+    cJSON_AddNumberToObject(root, "total_ms", (double)total_ms);
+    cJSON *clients = cJSON_AddObjectToObject(root, "clients");
+    for (int c = 0; c < RADIO_CLIENT_COUNT; c++) {
+        cJSON *client = cJSON_AddObjectToObject(clients, radio_sched_client_name(c));
+        cJSON_AddNumberToObject(client, "granted_ms", (double)status.granted_ms[c]);
+        cJSON_AddNumberToObject(client, "pct", total_ms ? (double)status.granted_ms[c] * 100 / total_ms : 0);
+        cJSON_AddNumberToObject(client, "slices", status.slices[c]);
+    }
+    cJSON *parked = cJSON_AddObjectToObject(clients, radio_sched_client_name(RADIO_CLIENT_COUNT));
+    cJSON_AddNumberToObject(parked, "granted_ms", (double)status.parked_ms);
+    cJSON_AddNumberToObject(parked, "pct", total_ms ? (double)status.parked_ms * 100 / total_ms : 0);
+    cJSON_AddNumberToObject(root, "switches", status.switches);
+    cJSON_AddNumberToObject(root, "switch_failures", status.switch_failures);
+    cJSON_AddNumberToObject(root, "scans", status.scans);
+    cJSON_AddNumberToObject(root, "scan_channels", status.scan_channels);
+    
+    char *json_response = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, json_response);
+    
+    free(json_response);
+    cJSON_Delete(root);
+    
+    return ESP_OK;
+}
+
+// API handler to get or set the radio duty ratios (?ap=&scan=&sniff=&period=)
+static esp_err_t api_radio_config_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    radio_sched_config_t config;
+    radio_sched_get_config(&config);
+    
+    char buf[128];
+    if (httpd_req_get_url_query_str(req, buf, sizeof(buf)) == ESP_OK) {
+        static const char *keys[RADIO_CLIENT_COUNT] = {"ap", "scan", "sniff"};
+        char param[16];
+        bool changed = false;
+        for (int c = 0; c < RADIO_CLIENT_COUNT; c++) {
+            if (httpd_query_key_value(buf, keys[c], param, sizeof(param)) == ESP_OK) {
+                unsigned long pct = strtoul(param, NULL, 10);
+                config.share_pct[c] = pct > 100 ? 101 : pct;
+                changed = true;
+            }
+        }
+        if (httpd_query_key_value(buf, "period", param, sizeof(param)) == ESP_OK) {
+            unsigned long period = strtoul(param, NULL, 10);
+            config.period_ms = period > UINT16_MAX ? UINT16_MAX : period;
+            changed = true;
+        }
+        if (changed && !radio_sched_set_config(&config)) {
+            httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"Shares must sum to 100 and the period must be 100-5000 ms\"}");
+            return ESP_OK;
+        }
+    }
+    
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "status", "success");
+    cJSON_AddNumberToObject(root, "ap", config.share_pct[RADIO_CLIENT_AP]);
+    cJSON_AddNumberToObject(root, "scan", config.share_pct[RADIO_CLIENT_SCAN]);
+    cJSON_AddNumberToObject(root, "sniff", config.share_pct[RADIO_CLIENT_SNIFFER]);
+    cJSON_AddNumberToObject(root, "period", config.period_ms);
+    
+    char *json_response = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, json_response);
+    
+    free(json_response);
+    cJSON_Delete(root);
+    
+    return ESP_OK;
+}
+
+// API endpoint for rebooting the device
+static esp_err_t api_reboot_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    
+    // Send response before rebooting
+    httpd_resp_sendstr(req, "{\"status\":\"ok\",\"message\":\"Rebooting device...\"}");
+    
+    // Schedule reboot after a short delay to allow the response to be sent
+    ESP_LOGI(TAG, "Reboot requested via web interface");
+    esp_restart();
+    
+    return ESP_OK;
+}
+
+// Register URI handlers
+esp_err_t register_uri_handlers(httpd_handle_t server) {
+    // API handlers for scanning networks
+    httpd_uri_t scan_handler = {
+        .uri = "/api/scan",
+        .method = HTTP_POST,
+        .handler = api_scan_start_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &scan_handler);
+    
+    httpd_uri_t scan_result_handler = {
+        .uri = "/api/scan/result",
+        .method = HTTP_GET,
+        .handler = api_scan_result_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &scan_result_handler);
     
     // API handler for system info
     httpd_uri_t sysinfo_handler = {
@@ -1764,6 +3331,310 @@ esp_err_t register_uri_handlers(httpd_handle_t server) {
     };
     httpd_register_uri_handler(server, &sniff_packets_handler);
     
+    httpd_uri_t sniff_beacons_handler = {
+        .uri = "/api/sniff/beacons",
+        .method = HTTP_GET,
+        .handler = api_sniff_beacons_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &sniff_beacons_handler);
+    
+    httpd_uri_t sniff_stats_handler = {
+        .uri = "/api/sniff/stats",
+        .method = HTTP_GET,
+        .handler = api_sniff_stats_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &sniff_stats_handler);
+    
+    httpd_uri_t maclist_upload_uri = {
+        .uri = "/api/sniff/maclist",
+        .method = HTTP_POST,
+        .handler = api_maclist_upload_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &maclist_upload_uri);
+    
+    httpd_uri_t maclist_get_uri = {
+        .uri = "/api/sniff/maclist",
+        .method = HTTP_GET,
+        .handler = api_maclist_get_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &maclist_get_uri);
+    
+    httpd_uri_t sniff_follow_uri = {
+        .uri = "/api/sniff/follow",
+        .method = HTTP_GET,
+        .handler = api_sniff_follow_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &sniff_follow_uri);
+    
+    httpd_uri_t sniff_unfollow_uri = {
+        .uri = "/api/sniff/unfollow",
+        .method = HTTP_GET,
+        .handler = api_sniff_unfollow_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &sniff_unfollow_uri);
+    
+    httpd_uri_t sniff_follow_status_uri = {
+        .uri = "/api/sniff/follow/status",
+        .method = HTTP_GET,
+        .handler = api_sniff_follow_status_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &sniff_follow_status_uri);
+    
+    // Register analytics endpoints
+    httpd_uri_t stats_traffic_handler = {
+        .uri = "/api/stats/traffic",
+        .method = HTTP_GET,
+        .handler = api_stats_traffic_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &stats_traffic_handler);
+    
+    httpd_uri_t graph_handler = {
+        .uri = "/api/graph",
+        .method = HTTP_GET,
+        .handler = api_graph_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &graph_handler);
+    
+    httpd_uri_t stats_top_handler = {
+        .uri = "/api/stats/top",
+        .method = HTTP_GET,
+        .handler = api_stats_top_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &stats_top_handler);
+    
+    httpd_uri_t stats_devices_handler = {
+        .uri = "/api/stats/devices",
+        .method = HTTP_GET,
+        .handler = api_stats_devices_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &stats_devices_handler);
+    
+    httpd_uri_t stats_airtime_handler = {
+        .uri = "/api/stats/airtime",
+        .method = HTTP_GET,
+        .handler = api_stats_airtime_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &stats_airtime_handler);
+    
+    httpd_uri_t stats_rates_handler = {
+        .uri = "/api/stats/rates",
+        .method = HTTP_GET,
+        .handler = api_stats_rates_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &stats_rates_handler);
+    
+    httpd_uri_t stats_coverage_handler = {
+        .uri = "/api/stats/coverage",
+        .method = HTTP_GET,
+        .handler = api_stats_coverage_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &stats_coverage_handler);
+    
+    // Register flood detector endpoints
+    httpd_uri_t wids_alerts_uri = {
+        .uri = "/api/wids/alerts",
+        .method = HTTP_GET,
+        .handler = api_wids_alerts_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &wids_alerts_uri);
+    
+    httpd_uri_t wids_config_uri = {
+        .uri = "/api/wids/config",
+        .method = HTTP_POST,
+        .handler = api_wids_config_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &wids_config_uri);
+    
+    // Register evil-twin index endpoints
+    httpd_uri_t rogue_uri = {
+        .uri = "/api/rogue",
+        .method = HTTP_GET,
+        .handler = api_rogue_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &rogue_uri);
+    
+    httpd_uri_t rogue_baseline_uri = {
+        .uri = "/api/rogue/baseline",
+        .method = HTTP_POST,
+        .handler = api_rogue_baseline_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &rogue_baseline_uri);
+    
+    // Register flash recording endpoints
+    httpd_uri_t storage_start_uri = {
+        .uri = "/api/storage/start",
+        .method = HTTP_GET,
+        .handler = api_storage_start_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &storage_start_uri);
+    
+    httpd_uri_t storage_stop_uri = {
+        .uri = "/api/storage/stop",
+        .method = HTTP_GET,
+        .handler = api_storage_stop_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &storage_stop_uri);
+    
+    httpd_uri_t storage_status_uri = {
+        .uri = "/api/storage/status",
+        .method = HTTP_GET,
+        .handler = api_storage_status_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &storage_status_uri);
+    
+    httpd_uri_t storage_file_uri = {
+        .uri = "/api/storage/file",
+        .method = HTTP_GET,
+        .handler = api_storage_file_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &storage_file_uri);
+    
+    // Register trigger capture endpoints
+    httpd_uri_t trigger_arm_uri = {
+        .uri = "/api/trigger/arm",
+        .method = HTTP_GET,
+        .handler = api_trigger_arm_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &trigger_arm_uri);
+    
+    httpd_uri_t trigger_disarm_uri = {
+        .uri = "/api/trigger/disarm",
+        .method = HTTP_GET,
+        .handler = api_trigger_disarm_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &trigger_disarm_uri);
+    
+    httpd_uri_t trigger_status_uri = {
+        .uri = "/api/trigger/status",
+        .method = HTTP_GET,
+        .handler = api_trigger_status_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &trigger_status_uri);
+    
+    httpd_uri_t trigger_file_uri = {
+        .uri = "/api/trigger/file",
+        .method = HTTP_GET,
+        .handler = api_trigger_file_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &trigger_file_uri);
+    
+    // Register UDP export endpoints
+    httpd_uri_t export_udp_start_uri = {
+        .uri = "/api/export/udp/start",
+        .method = HTTP_GET,
+        .handler = api_export_udp_start_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &export_udp_start_uri);
+    
+    httpd_uri_t export_udp_stop_uri = {
+        .uri = "/api/export/udp/stop",
+        .method = HTTP_GET,
+        .handler = api_export_udp_stop_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &export_udp_stop_uri);
+    
+    httpd_uri_t export_udp_status_uri = {
+        .uri = "/api/export/udp/status",
+        .method = HTTP_GET,
+        .handler = api_export_udp_status_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &export_udp_status_uri);
+    
+    // Register UART stream endpoints
+    httpd_uri_t uart_start_uri = {
+        .uri = "/api/uart/start",
+        .method = HTTP_GET,
+        .handler = api_uart_start_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &uart_start_uri);
+    
+    httpd_uri_t uart_stop_uri = {
+        .uri = "/api/uart/stop",
+        .method = HTTP_GET,
+        .handler = api_uart_stop_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &uart_stop_uri);
+    
+    httpd_uri_t uart_status_uri = {
+        .uri = "/api/uart/status",
+        .method = HTTP_GET,
+        .handler = api_uart_status_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &uart_status_uri);
+    
+    // Register load test endpoints
+    httpd_uri_t loadgen_start_uri = {
+        .uri = "/api/loadgen/start",
+        .method = HTTP_GET,
+        .handler = api_loadgen_start_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &loadgen_start_uri);
+    
+    httpd_uri_t loadgen_stop_uri = {
+        .uri = "/api/loadgen/stop",
+        .method = HTTP_GET,
+        .handler = api_loadgen_stop_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &loadgen_stop_uri);
+    
+    httpd_uri_t loadgen_status_uri = {
+        .uri = "/api/loadgen/status",
+        .method = HTTP_GET,
+        .handler = api_loadgen_status_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &loadgen_status_uri);
+    
+    httpd_uri_t radio_status_uri = {
+        .uri = "/api/radio/status",
+        .method = HTTP_GET,
+        .handler = api_radio_status_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &radio_status_uri);
+    
+    httpd_uri_t radio_config_uri = {
+        .uri = "/api/radio/config",
+        .method = HTTP_GET,
+        .handler = api_radio_config_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &radio_config_uri);
+    
     // Register antenna settings endpoints
     httpd_uri_t antenna_settings_uri = {
         .uri = "/api/antenna",
@@ -1826,7 +3697,7 @@ httpd_handle_t start_webserver(void) {
     config.recv_wait_timeout = 20;                // Longer receive timeout (seconds)
     config.send_wait_timeout = 20;                // Longer send timeout (seconds)
     config.lru_purge_enable = true;               // Enable LRU connection purging
-    config.max_uri_handlers = 16;                 // Support more URI handlers
+    config.max_uri_handlers = 52;                 // Support more URI handlers
     config.max_open_sockets = 7;                  // More concurrent connections
     config.keep_alive_enable = true;              // Enable keep-alive connections
     config.keep_alive_idle = 30;                  // Keep-alive idle time (seconds)
@@ -0,0 +1,187 @@
+#include "wids.h"
+#include <string.h>
+
+// Default thresholds per WIDS_BUCKETS-second window
+static const uint32_t default_thresholds[WIDS_CAT_COUNT] = {
+    [WIDS_CAT_DEAUTH] = WIDS_DEFAULT_DEAUTH,
+    [WIDS_CAT_AUTH]   = WIDS_DEFAULT_AUTH,
+    [WIDS_CAT_PROBE]  = WIDS_DEFAULT_PROBE,
+};
+
+static const char *category_names[WIDS_CAT_COUNT] = {
+    [WIDS_CAT_DEAUTH] = "deauth",
+    [WIDS_CAT_AUTH]   = "auth",
+    [WIDS_CAT_PROBE]  = "probe",
+};
+
+static const char *scope_names[WIDS_SCOPE_COUNT] = {
+    [WIDS_SCOPE_BSSID]   = "bssid",
+    [WIDS_SCOPE_SOURCE]  = "source",
+    [WIDS_SCOPE_CHANNEL] = "channel",
+};
+
+// Map a frame to a watched category, -1 if it is not watched
+static int frame_category(const frame_info_t *info) {
+    if (info->type != IEEE80211_TYPE_MGMT) {
+        return -1;
+    }
+    switch (info->subtype) {
+        case IEEE80211_STYPE_DEAUTH:
+        case IEEE80211_STYPE_DISASSOC:
+            return WIDS_CAT_DEAUTH;
+        case IEEE80211_STYPE_AUTH:
+            return WIDS_CAT_AUTH;
+        case IEEE80211_STYPE_PROBE_REQ:
+            return WIDS_CAT_PROBE;
+        default:
+            return -1;
+    }
+}
+
+// Slide a counter's window forward to the given second
+static void advance_window(wids_counter_t *counter, uint32_t second) {
+    uint32_t elapsed = second - counter->last_second;
+    if (elapsed == 0) {
+        return;
+    }
+
+    // Clear the buckets we skipped (bounded by the window size)
+    uint32_t steps = elapsed > WIDS_BUCKETS ? WIDS_BUCKETS : elapsed;
+    for (uint32_t i = 1; i <= steps; i++) {
+        uint32_t idx = (counter->last_second + i) % WIDS_BUCKETS;
+        for (int c = 0; c < WIDS_CAT_COUNT; c++) {
+            counter->sum[c] -= counter->buckets[c][idx];
+            counter->buckets[c][idx] = 0;
+        }
+    }
+    counter->last_second = second;
+}
+
+// Record an alert in the ring
+static void raise_alert(wids_t *wids, const frame_info_t *info, const uint8_t *key,
+                        wids_scope_t scope, int category, uint32_t count, uint32_t threshold) {
+    uint32_t id = ++wids->next_alert_id;
+    wids_alert_t *alert = &wids->alerts[id % WIDS_ALERT_RING];
+
+    alert->id = id;
+    alert->timestamp_us = info->timestamp_us;
+    if (scope == WIDS_SCOPE_CHANNEL) {
+        memset(alert->mac, 0, 6);
+    } else {
+        memcpy(alert->mac, key, 6);
+    }
+    alert->category = category;
+    alert->scope = scope;
+    alert->channel = info->channel;
+    alert->count = count;
+    alert->threshold = threshold;
+}
+
+// Count a frame against one key and check its threshold
+static void count_frame(wids_t *wids, mac_table_t *table, wids_counter_t *counters, wids_scope_t scope,
+                        const uint8_t *key, int category, const frame_info_t *info) {
+    bool is_new;
+    int slot = mac_table_touch(table, key, &is_new);
+    wids_counter_t *counter = &counters[slot];
+    uint32_t second = (uint32_t)(info->timestamp_us / 1000000);
+
+    if (is_new) {
+        memset(counter, 0, sizeof(*counter));
+        counter->last_second = second;
+    }
+    advance_window(counter, second);
+
+    // Re-arm once the window has drained below half the threshold
+    uint32_t threshold = wids->thresholds[category];
+    if (scope == WIDS_SCOPE_CHANNEL) {
+        threshold *= WIDS_CHANNEL_SCALE;
+    }
+    uint8_t bit = 1 << category;
+    if ((counter->alerting & bit) && counter->sum[category] < (threshold + 1) / 2) {
+        counter->alerting &= ~bit;
+    }
+
+    uint16_t *bucket = &counter->buckets[category][second % WIDS_BUCKETS];
+    if (*bucket < UINT16_MAX) {
+        (*bucket)++;
+        counter->sum[category]++;
+    }
+
+    // Alert once on the rising edge
+    if (!(counter->alerting & bit) && counter->sum[category] >= threshold) {
+        counter->alerting |= bit;
+        raise_alert(wids, info, key, scope, category, counter->sum[category], threshold);
+    }
+}
+
+// Reset the detector
+void wids_init(wids_t *wids, const uint32_t *thresholds) {
+    memset(wids->bssids, 0, sizeof(wids->bssids));
+    memset(wids->sources, 0, sizeof(wids->sources));
+    memset(wids->channels, 0, sizeof(wids->channels));
+    memset(wids->alerts, 0, sizeof(wids->alerts));
+    memset(wids->frames, 0, sizeof(wids->frames));
+    memcpy(wids->thresholds, thresholds ? thresholds : default_thresholds, sizeof(wids->thresholds));
+    wids->next_alert_id = 0;
+
+    mac_table_init(&wids->bssid_table, wids->bssid_nodes, wids->bssid_buckets,
+                   WIDS_MAX_BSSIDS, WIDS_HASH_BUCKETS, 6);
+    mac_table_init(&wids->source_table, wids->source_nodes, wids->source_buckets,
+                   WIDS_MAX_SOURCES, WIDS_HASH_BUCKETS, 6);
+    mac_table_init(&wids->channel_table, wids->channel_nodes, wids->channel_buckets,
+                   WIDS_MAX_CHANNELS, WIDS_CHANNEL_BUCKETS, 1);
+}
+
+// Set the flood threshold of a category
+void wids_set_threshold(wids_t *wids, wids_category_t category, uint32_t threshold) {
+    if (category < WIDS_CAT_COUNT && threshold > 0) {
+        wids->thresholds[category] = threshold;
+    }
+}
+
+// Account one frame
+void wids_update(wids_t *wids, const frame_info_t *info) {
+    int category = frame_category(info);
+    if (category < 0 || !info->addr2) {
+        return;
+    }
+
+    wids->frames[category]++;
+
+    count_frame(wids, &wids->source_table, wids->sources, WIDS_SCOPE_SOURCE,
+                info->addr2, category, info);
+
+    if (info->bssid && !ieee80211_is_group_addr(info->bssid)) {
+        count_frame(wids, &wids->bssid_table, wids->bssids, WIDS_SCOPE_BSSID,
+                    info->bssid, category, info);
+    }
+
+    // Floods from randomized sources or at the broadcast BSSID spread over
+    // many keys above; the channel sees them all
+    count_frame(wids, &wids->channel_table, wids->channels, WIDS_SCOPE_CHANNEL,
+                &info->channel, category, info);
+}
+
+// Copy alerts newer than an alert ID, oldest first
+int wids_get_alerts(const wids_t *wids, uint32_t since_id, wids_alert_t *out, int max_alerts) {
+    uint32_t first = wids->next_alert_id >= WIDS_ALERT_RING ? wids->next_alert_id - WIDS_ALERT_RING + 1 : 1;
+    if (since_id + 1 > first) {
+        first = since_id + 1;
+    }
+
+    int count = 0;
+    for (uint32_t id = first; id <= wids->next_alert_id && count < max_alerts; id++) {
+        out[count++] = wids->alerts[id % WIDS_ALERT_RING];
+    }
+    return count;
+}
+
+// Get the name of a category
+const char *wids_category_name(wids_category_t category) {
+    return category < WIDS_CAT_COUNT ? category_names[category] : "unknown";
+}
+
+// Get the name of a scope
+const char *wids_scope_name(wids_scope_t scope) {
+    return scope < WIDS_SCOPE_COUNT ? scope_names[scope] : "unknown";
+}
@@ -0,0 +1,131 @@
+#ifndef WIDS_H
+#define WIDS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ieee80211.h"
+#include "mac_table.h"
+
+// Sliding window: WIDS_BUCKETS buckets of one second each
+#define WIDS_BUCKETS                 10
+#define WIDS_MAX_BSSIDS              32
+#define WIDS_MAX_SOURCES             64
+#define WIDS_HASH_BUCKETS            32
+#define WIDS_MAX_CHANNELS            16
+#define WIDS_CHANNEL_BUCKETS         16
+#define WIDS_ALERT_RING              32
+
+// Default thresholds in frames per window
+#define WIDS_DEFAULT_DEAUTH          20
+#define WIDS_DEFAULT_AUTH            50
+#define WIDS_DEFAULT_PROBE           200
+// Channel-wide thresholds are this multiple of the per-BSSID and per-source ones
+#define WIDS_CHANNEL_SCALE           4
+
+/**
+ * @brief Management frame categories watched for floods
+ */
+typedef enum {
+    WIDS_CAT_DEAUTH = 0,         // Deauthentication and disassociation
+    WIDS_CAT_AUTH,               // Authentication
+    WIDS_CAT_PROBE,              // Probe requests
+    WIDS_CAT_COUNT
+} wids_category_t;
+
+typedef enum {
+    WIDS_SCOPE_BSSID = 0,        // Frames aimed at or sent by one BSS
+    WIDS_SCOPE_SOURCE,           // Frames sent by one transmitter
+    WIDS_SCOPE_CHANNEL,          // All frames on one channel (randomized sources, broadcast BSSID)
+    WIDS_SCOPE_COUNT
+} wids_scope_t;
+
+/**
+ * @brief Sliding-window counters of one key
+ */
+typedef struct {
+    uint16_t buckets[WIDS_CAT_COUNT][WIDS_BUCKETS];
+    uint32_t sum[WIDS_CAT_COUNT];        // Running total over the window
+    uint32_t last_second;                // Second of the most recent bucket
+    uint8_t alerting;                    // Bit per category while above threshold
+} wids_counter_t;
+
+/**
+ * @brief Flood alert
+ */
+typedef struct {
+    uint32_t id;                 // Increasing alert number
+    uint64_t timestamp_us;
+    uint8_t mac[6];              // Zero for WIDS_SCOPE_CHANNEL
+    uint8_t category;            // wids_category_t
+    uint8_t scope;               // wids_scope_t
+    uint8_t channel;
+    uint32_t count;              // Frames in the window when the alert fired
+    uint32_t threshold;
+} wids_alert_t;
+
+/**
+ * @brief Flood detector state
+ */
+typedef struct {
+    uint32_t thresholds[WIDS_CAT_COUNT]; // Frames per WIDS_BUCKETS seconds
+
+    mac_table_t bssid_table;
+    mac_table_node_t bssid_nodes[WIDS_MAX_BSSIDS];
+    uint16_t bssid_buckets[WIDS_HASH_BUCKETS];
+    wids_counter_t bssids[WIDS_MAX_BSSIDS];
+
+    mac_table_t source_table;
+    mac_table_node_t source_nodes[WIDS_MAX_SOURCES];
+    uint16_t source_buckets[WIDS_HASH_BUCKETS];
+    wids_counter_t sources[WIDS_MAX_SOURCES];
+
+    mac_table_t channel_table;           // Keyed by the channel number alone
+    mac_table_node_t channel_nodes[WIDS_MAX_CHANNELS];
+    uint16_t channel_buckets[WIDS_CHANNEL_BUCKETS];
+    wids_counter_t channels[WIDS_MAX_CHANNELS];
+
+    wids_alert_t alerts[WIDS_ALERT_RING];
+    uint32_t next_alert_id;
+    uint32_t frames[WIDS_CAT_COUNT];     // Total frames seen per category
+} wids_t;
+
+/**
+ * @brief Reset the detector
+ *
+ * @param wids Detector
+ * @param thresholds WIDS_CAT_COUNT thresholds, or NULL for the defaults
+ */
+void wids_init(wids_t *wids, const uint32_t *thresholds);
+
+/**
+ * @brief Set the flood threshold of a category (frames per window)
+ */
+void wids_set_threshold(wids_t *wids, wids_category_t category, uint32_t threshold);
+
+/**
+ * @brief Account one frame (O(1))
+ */
+void wids_update(wids_t *wids, const frame_info_t *info);
+
+/**
+ * @brief Copy alerts newer than an alert ID, oldest first
+ *
+ * @param wids Detector
+ * @param since_id Only copy alerts with a larger ID (0 for all)
+ * @param out Output array
+ * @param max_alerts Size of the output array
+ * @return Number of alerts copied
+ */
+int wids_get_alerts(const wids_t *wids, uint32_t since_id, wids_alert_t *out, int max_alerts);
+
+/**
+ * @brief Get the name of a category
+ */
+const char *wids_category_name(wids_category_t category);
+
+/**
+ * @brief Get the name of a scope
+ */
+const char *wids_scope_name(wids_scope_t scope);
+
+#endif /* WIDS_H */
@@ -1,46 +1,150 @@
 #include "wifi_sniffer.h"
+#include "ieee80211.h"
+#include "beacon_dedup.h"
+#include "capture_buffer.h"
+#include "traffic_stats.h"
+#include "assoc_graph.h"
+#include "topk_sketch.h"
+#include "hll.h"
+#include "mac_filter.h"
+#include "wids.h"
+#include "rogue_ap.h"
+#include "airtime.h"
+#include "rate_stats.h"
+#include "seq_tracker.h"
+#include "capture_storage.h"
+#include "trigger_capture.h"
+#include "sniffer_profile.h"
+#include "radio_sched.h"
+#include "follow_target.h"
+#include "load_governor.h"
+#include "sdkconfig.h"
 #include "esp_wifi.h"
 #include "esp_log.h"
 #include "esp_system.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
 #include "freertos/semphr.h"
 #include <string.h>
 #include <stdlib.h>
 
 static const char *TAG = "wifi_sniffer";
 
-// Maximum number of packets to store
-#define MAX_PACKETS_QUEUE 32
-#define MAX_PACKET_SIZE 1024
-
-// Structure to hold packet info
-typedef struct {
-    uint8_t data[MAX_PACKET_SIZE];
-    uint16_t length;
-    int8_t rssi;
-    uint8_t channel;
-    wifi_pkt_rx_ctrl_t rx_ctrl;
-} packet_info_t;
-
 // Global variables
-static QueueHandle_t packet_queue = NULL;
+static portMUX_TYPE capture_lock = portMUX_INITIALIZER_UNLOCKED;
+static capture_buffer_t capture_buffer;
 static SemaphoreHandle_t sniffer_running_mutex = NULL;
 static bool is_sniffer_running = false;
 static uint8_t current_channel = 0;
 static uint8_t current_filter = 0;
-static TaskHandle_t channel_hopper_task_handle = NULL;
 
-// Channel hopping settings
-#define CHANNEL_HOP_INTERVAL_MS 200
-static const uint8_t channels[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13};
-static const uint8_t channels_count = sizeof(channels)/sizeof(channels[0]);
+// Beacon dedup stage (shared between the RX callback and the web server)
+static portMUX_TYPE beacon_dedup_lock = portMUX_INITIALIZER_UNLOCKED;
+static beacon_dedup_t beacon_dedup;
+static bool beacon_dedup_enabled = false;
+static uint32_t beacon_dedup_keepalive_ms = BEACON_DEDUP_KEEPALIVE_MS;
+
+// MAC watch/ignore list, applied before anything else looks at a frame
+static portMUX_TYPE mac_filter_lock = portMUX_INITIALIZER_UNLOCKED;
+static mac_filter_t *mac_filter = NULL;
+
+// Traffic analytics, updated for every received frame. Each module has its
+// own lock so a web request reading one of them only holds off that module,
+// and large tables are copied out a slot at a time
+static portMUX_TYPE traffic_lock = portMUX_INITIALIZER_UNLOCKED;
+static traffic_stats_t traffic_stats;
+static portMUX_TYPE assoc_lock = portMUX_INITIALIZER_UNLOCKED;
+static assoc_graph_t assoc_graph;
+static portMUX_TYPE topk_lock = portMUX_INITIALIZER_UNLOCKED;
+static topk_sketch_t topk_sketch;
+static portMUX_TYPE hll_lock = portMUX_INITIALIZER_UNLOCKED;
+static hll_stats_t hll_stats;
+
+// Management frame flood detector; thresholds survive capture restarts
+static portMUX_TYPE wids_lock = portMUX_INITIALIZER_UNLOCKED;
+static wids_t wids;
+static uint32_t wids_thresholds[WIDS_CAT_COUNT] = {
+    WIDS_DEFAULT_DEAUTH, WIDS_DEFAULT_AUTH, WIDS_DEFAULT_PROBE
+};
+
+// Estimated channel airtime, closed into a sample at every hop
+static portMUX_TYPE airtime_lock = portMUX_INITIALIZER_UNLOCKED;
+static airtime_t airtime;
+
+// PHY rate histograms and retry ratios of data frames
+static portMUX_TYPE rate_lock = portMUX_INITIALIZER_UNLOCKED;
+static rate_stats_t rate_stats;
+
+// Sequence gap tracking; channel_tuned_us is when the radio last changed channel
+static portMUX_TYPE seq_lock = portMUX_INITIALIZER_UNLOCKED;
+static seq_tracker_t seq_tracker;
+static uint64_t channel_tuned_us = 0;
+
+// Evil-twin index fed by scans and beacons; kept across capture sessions
+// so the baseline survives, initialized on first use
+static portMUX_TYPE rogue_lock = portMUX_INITIALIZER_UNLOCKED;
+static rogue_ap_t rogue_index;
+static bool rogue_index_ready = false;
+
+// Follow-target mode: the poll task retunes the sniffer to wherever the
+// target beacons
+#define FOLLOW_POLL_MS 20
+static portMUX_TYPE follow_lock = portMUX_INITIALIZER_UNLOCKED;
+static follow_target_t follow;
+static bool following = false;
+static TaskHandle_t follow_task_handle = NULL;
+
+// Frames whose MAC header could not be parsed; captured without analytics
+static uint32_t unparsed_frames = 0;
+
+// Channels swept when the target is lost; 1, 6 and 11 also hear most of
+// the 2.4 GHz channels next to them
+static const uint8_t follow_plan[] = {
+    1, 6, 11, 3, 9, 13, 2, 4, 5, 7, 8, 10, 12,
+#if CONFIG_SOC_WIFI_SUPPORT_5G
+    36, 40, 44, 48, 149, 153, 157, 161, 165, 52, 56, 60, 64,
+    100, 104, 108, 112, 116, 120, 124, 128, 132, 136, 140, 144,
+#endif
+};
+
+// Overload governor: lowers capture fidelity while the callback, the
+// capture buffer or the heap is overloaded. The thresholds survive
+// capture restarts; the level starts at full with each capture
+static portMUX_TYPE governor_lock = portMUX_INITIALIZER_UNLOCKED;
+static load_governor_t governor;
+static load_governor_config_t governor_config;
+static bool governor_config_ready = false;
 
 // Forward declaration
 static void wifi_sniffer_packet_handler(void *buf, wifi_promiscuous_pkt_type_t type);
-static void channel_hopper_task(void *pvParameters);
-static void single_channel_retry_task(void *pvParameters);
+static void end_follow(void);
+
+// Promiscuous filter mask of a sniffer filter type
+static uint32_t filter_mask_for(uint8_t filter_type) {
+    switch (filter_type) {
+        case 1: // Management frames
+            return WIFI_PROMIS_FILTER_MASK_MGMT;
+        case 2: // Data frames
+            return WIFI_PROMIS_FILTER_MASK_DATA;
+        case 3: // Control frames
+            return WIFI_PROMIS_FILTER_MASK_CTRL;
+        case 4: // Beacon frames only
+        case 5: // Probe frames only
+            // The callback keeps only beacons or probes
+            return WIFI_PROMIS_FILTER_MASK_MGMT;
+        default: // All packets
+            return WIFI_PROMIS_FILTER_MASK_ALL;
+    }
+}
+
+// Initialize the evil-twin index on first use (call with rogue_lock held)
+static void prepare_rogue_index(void) {
+    if (!rogue_index_ready) {
+        rogue_ap_init(&rogue_index);
+        rogue_index_ready = true;
+    }
+}
 
 // Start WiFi sniffer
 bool start_wifi_sniffer(uint8_t channel, uint8_t filter_type) {
@@ -67,57 +171,73 @@ bool start_wifi_sniffer(uint8_t channel, uint8_t filter_type) {
         stop_wifi_sniffer();
     }
     
-    // Create packet queue if not already created
-    if (packet_queue == NULL) {
-        packet_queue = xQueueCreate(MAX_PACKETS_QUEUE, sizeof(packet_info_t*));
-        if (packet_queue == NULL) {
-            ESP_LOGI(TAG, "Failed to create packet queue");
-            xSemaphoreGive(sniffer_running_mutex);
-            return false;
-        }
-    } else {
-        // Queue exists, make sure it's empty
-        packet_info_t *packet;
-        while (xQueueReceive(packet_queue, &packet, 0) == pdTRUE) {
-            if (packet) free(packet);
-        }
-    }
+    // Make sure the capture buffer is empty and reset its counters
+    packet_info_t *packet;
+    do {
+        portENTER_CRITICAL(&capture_lock);
+        packet = capture_buffer_pop(&capture_buffer);
+        portEXIT_CRITICAL(&capture_lock);
+        if (packet) free(packet);
+    } while (packet);
+    portENTER_CRITICAL(&capture_lock);
+    capture_buffer_init(&capture_buffer);
+    portEXIT_CRITICAL(&capture_lock);
     
     // Save configuration
     current_channel = channel;
     current_filter = filter_type;
     
-    // Get current WiFi mode and save it
-    wifi_mode_t original_mode;
-    ESP_ERROR_CHECK(esp_wifi_get_mode(&original_mode));
+    // Start every capture with a fresh dedup table
+    portENTER_CRITICAL(&beacon_dedup_lock);
+    beacon_dedup_init(&beacon_dedup, beacon_dedup_keepalive_ms);
+    portEXIT_CRITICAL(&beacon_dedup_lock);
     
-    // Set to APSTA mode to ensure we keep the AP running while scanning
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_APSTA));
+    // Analytics also restart with each capture session
+    uint64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&traffic_lock);
+    traffic_stats_init(&traffic_stats);
+    portEXIT_CRITICAL(&traffic_lock);
+    portENTER_CRITICAL(&assoc_lock);
+    assoc_graph_init(&assoc_graph);
+    portEXIT_CRITICAL(&assoc_lock);
+    portENTER_CRITICAL(&topk_lock);
+    topk_sketch_init(&topk_sketch);
+    portEXIT_CRITICAL(&topk_lock);
+    portENTER_CRITICAL(&hll_lock);
+    hll_stats_init(&hll_stats);
+    portEXIT_CRITICAL(&hll_lock);
+    portENTER_CRITICAL(&wids_lock);
+    wids_init(&wids, wids_thresholds);
+    portEXIT_CRITICAL(&wids_lock);
+    portENTER_CRITICAL(&airtime_lock);
+    airtime_init(&airtime, now_us);
+    portEXIT_CRITICAL(&airtime_lock);
+    portENTER_CRITICAL(&rate_lock);
+    rate_stats_init(&rate_stats);
+    portEXIT_CRITICAL(&rate_lock);
+    portENTER_CRITICAL(&seq_lock);
+    seq_tracker_init(&seq_tracker);
+    channel_tuned_us = now_us;
+    portEXIT_CRITICAL(&seq_lock);
+    unparsed_frames = 0;
+    // The evil-twin index and its baseline outlive the session; they only
+    // need to exist before the first beacon arrives
+    portENTER_CRITICAL(&rogue_lock);
+    prepare_rogue_index();
+    portEXIT_CRITICAL(&rogue_lock);
     
-    // Set sniffer filter based on packet type
-    wifi_promiscuous_filter_t filter = {0};
-    switch (filter_type) {
-        case 1: // Management frames
-            filter.filter_mask = WIFI_PROMIS_FILTER_MASK_MGMT;
-            break;
-        case 2: // Data frames
-            filter.filter_mask = WIFI_PROMIS_FILTER_MASK_DATA;
-            break;
-        case 3: // Control frames
-            filter.filter_mask = WIFI_PROMIS_FILTER_MASK_CTRL;
-            break;
-        case 4: // Beacon frames only
-            filter.filter_mask = WIFI_PROMIS_FILTER_MASK_MGMT;
-            // We'll filter in the callback for beacon frames only
-            break;
-        case 5: // Probe frames only
-            filter.filter_mask = WIFI_PROMIS_FILTER_MASK_MGMT;
-            // We'll filter in the callback for probe frames only
-            break;
-        default: // All packets
-            filter.filter_mask = WIFI_PROMIS_FILTER_MASK_ALL;
+    portENTER_CRITICAL(&governor_lock);
+    if (!governor_config_ready) {
+        load_governor_default_config(&governor_config);
+        governor_config_ready = true;
     }
+    load_governor_init(&governor, &governor_config, esp_timer_get_time());
+    portEXIT_CRITICAL(&governor_lock);
     
+    // Set sniffer filter based on packet type
+    wifi_promiscuous_filter_t filter = {
+        .filter_mask = filter_mask_for(filter_type),
+    };
     esp_wifi_set_promiscuous_filter(&filter);
     
     // Register packet handler
@@ -126,29 +246,12 @@ bool start_wifi_sniffer(uint8_t channel, uint8_t filter_type) {
     // Enable promiscuous mode
     esp_wifi_set_promiscuous(true);
     
-    // Set the channel or start channel hopping
-    if (channel == 0) {
-        // Start channel hopping task
-        xTaskCreate(channel_hopper_task, "channel_hopper", 2048, NULL, 5, &channel_hopper_task_handle);
-    } else {
-        // Set specific channel
-        esp_err_t err = esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
-        if (err != ESP_OK) {
-            ESP_LOGW(TAG, "Failed to set initial channel %d: %s", channel, esp_err_to_name(err));
-            ESP_LOGI(TAG, "Will retry setting channel in background");
-            
-            // Create a parameter structure to pass the channel
-            uint8_t *channel_param = malloc(sizeof(uint8_t));
-            if (channel_param) {
-                *channel_param = channel;
-                
-                // Start a task to keep trying to set the channel
-                xTaskCreate(single_channel_retry_task, "channel_retry", 2048, channel_param, 5, &channel_hopper_task_handle);
-            }
-        }
-    }
-    
     is_sniffer_running = true;
+    
+    // The radio scheduler tunes to the channel (or hops) during the sniffer's slices
+    if (!radio_sched_set_sniffer(channel)) {
+        ESP_LOGW(TAG, "Radio scheduler unavailable, sniffer stays on the current channel");
+    }
     xSemaphoreGive(sniffer_running_mutex);
     
     ESP_LOGI(TAG, "WiFi sniffer started successfully");
@@ -172,22 +275,28 @@ bool stop_wifi_sniffer(void) {
         return false;
     }
     
-    // Disable promiscuous mode
+    // Disable promiscuous mode and hand the sniffer's slices back
     esp_wifi_set_promiscuous(false);
+    end_follow();
+    is_sniffer_running = false;
+    radio_sched_release_sniffer();
     
-    // Stop channel hopping task if running
-    if (channel_hopper_task_handle != NULL) {
-        vTaskDelete(channel_hopper_task_handle);
-        channel_hopper_task_handle = NULL;
-    }
+    // Record the partial dwell the capture ended on
+    portENTER_CRITICAL(&airtime_lock);
+    airtime_dwell_end(&airtime, esp_timer_get_time());
+    portEXIT_CRITICAL(&airtime_lock);
     
-    is_sniffer_running = false;
     xSemaphoreGive(sniffer_running_mutex);
     
     ESP_LOGI(TAG, "WiFi sniffer stopped successfully");
     return true;
 }
 
+// Check whether the sniffer is running
+bool wifi_sniffer_is_running(void) {
+    return is_sniffer_running;
+}
+
 // Get captured packets
 int get_captured_packets(void **packets, int max_packets) {
     // Take mutex
@@ -202,153 +311,823 @@ int get_captured_packets(void **packets, int max_packets) {
         return 0;
     }
     
-    // Get packets from queue (up to max_packets)
+    // Get packets from the capture buffer in arrival order (up to max_packets)
     int count = 0;
-    packet_info_t *packet;
     
-    while (count < max_packets && xQueueReceive(packet_queue, &packet, 0) == pdTRUE) {
+    portENTER_CRITICAL(&capture_lock);
+    while (count < max_packets) {
+        packet_info_t *packet = capture_buffer_pop(&capture_buffer);
+        if (!packet) break;
         packets[count++] = packet;
     }
+    portEXIT_CRITICAL(&capture_lock);
     
     xSemaphoreGive(sniffer_running_mutex);
     return count;
 }
 
-// Channel hopper task
-static void channel_hopper_task(void *pvParameters) {
-    int current_idx = 0;
-    int failed_attempts = 0;
+// Configure the beacon dedup stage
+void wifi_sniffer_set_beacon_dedup(bool enabled, uint32_t keepalive_ms) {
+    portENTER_CRITICAL(&beacon_dedup_lock);
+    beacon_dedup_enabled = enabled;
+    if (keepalive_ms > 0) {
+        beacon_dedup_keepalive_ms = keepalive_ms;
+        beacon_dedup.keepalive_ms = keepalive_ms;
+    }
+    portEXIT_CRITICAL(&beacon_dedup_lock);
     
-    ESP_LOGI(TAG, "Channel hopper task started");
+    ESP_LOGI(TAG, "Beacon dedup %s (keepalive %lu ms)", enabled ? "enabled" : "disabled",
+             (unsigned long)beacon_dedup_keepalive_ms);
+}
+
+// Get per-BSSID beacon counters from the dedup stage
+int wifi_sniffer_get_beacon_stats(beacon_dedup_entry_t *entries, int max_entries,
+                                  uint32_t *total_seen, uint32_t *total_forwarded) {
+    int count = 0;
     
-    while (1) {
-        // Use each channel in sequence
-        uint8_t new_channel = channels[current_idx];
-        
-        // Try to set the channel and check for errors
-        esp_err_t err = esp_wifi_set_channel(new_channel, WIFI_SECOND_CHAN_NONE);
-        
-        if (err == ESP_OK) {
-            // Channel set successfully
-            ESP_LOGD(TAG, "Hopped to channel %d", new_channel);
-            current_idx = (current_idx + 1) % channels_count;
-            failed_attempts = 0;
-        } else {
-            // Failed to set channel
-            failed_attempts++;
-            ESP_LOGD(TAG, "Failed to hop to channel %d: %s (attempt %d)", 
-                    new_channel, esp_err_to_name(err), failed_attempts);
-            
-            // If we've failed multiple times, wait longer before trying again
-            if (failed_attempts > 5) {
-                ESP_LOGW(TAG, "Multiple channel hop failures, waiting longer...");
-                vTaskDelay((CHANNEL_HOP_INTERVAL_MS * 5) / portTICK_PERIOD_MS);
-                
-                // Reset failed attempts counter after waiting
-                failed_attempts = 0;
-                continue;
-            }
+    portENTER_CRITICAL(&beacon_dedup_lock);
+    for (int i = 0; i < BEACON_DEDUP_MAX_ENTRIES && count < max_entries; i++) {
+        if (beacon_dedup.entries[i].in_use) {
+            entries[count++] = beacon_dedup.entries[i];
         }
-        
-        // Wait before hopping again
-        vTaskDelay(CHANNEL_HOP_INTERVAL_MS / portTICK_PERIOD_MS);
     }
+    if (total_seen) *total_seen = beacon_dedup.total_seen;
+    if (total_forwarded) *total_forwarded = beacon_dedup.total_forwarded;
+    portEXIT_CRITICAL(&beacon_dedup_lock);
+    
+    return count;
 }
 
-// Packet handler
-static void wifi_sniffer_packet_handler(void *buf, wifi_promiscuous_pkt_type_t type) {
-    if (!buf) return;
+// Get per-class capture buffer counters
+void wifi_sniffer_get_class_stats(capture_class_stats_t stats[CAPTURE_CLASS_COUNT]) {
+    portENTER_CRITICAL(&capture_lock);
+    memcpy(stats, capture_buffer.stats, sizeof(capture_buffer.stats));
+    portEXIT_CRITICAL(&capture_lock);
+}
+
+// Get (and optionally restart) the capture buffer high-water mark
+uint16_t wifi_sniffer_get_buffer_peak(bool reset) {
+    portENTER_CRITICAL(&capture_lock);
+    uint16_t peak = capture_buffer.peak;
+    if (reset) {
+        capture_buffer_reset_peaks(&capture_buffer);
+    }
+    portEXIT_CRITICAL(&capture_lock);
+    return peak;
+}
+
+// Set the overload governor's thresholds
+void wifi_sniffer_set_governor(const load_governor_config_t *config) {
+    portENTER_CRITICAL(&governor_lock);
+    governor_config = *config;
+    governor_config_ready = true;
+    governor.config = *config;
+    portEXIT_CRITICAL(&governor_lock);
+}
+
+// Get the overload governor's level, signals and counters
+void wifi_sniffer_get_governor(load_governor_t *copy) {
+    portENTER_CRITICAL(&governor_lock);
+    *copy = governor;
+    if (!governor_config_ready) {
+        load_governor_default_config(&copy->config);
+    }
+    portEXIT_CRITICAL(&governor_lock);
+}
+
+// Get the frame and byte totals of the traffic counters
+void wifi_sniffer_get_traffic_totals(uint32_t *frames, uint64_t *bytes) {
+    portENTER_CRITICAL(&traffic_lock);
+    *frames = traffic_stats.total_frames;
+    *bytes = traffic_stats.total_bytes;
+    portEXIT_CRITICAL(&traffic_lock);
+}
+
+// Get a batch of per-transmitter or per-(BSSID, station) counters
+int wifi_sniffer_get_traffic_entries(bool links, int *cursor, traffic_entry_t *entries, int max_entries) {
+    portENTER_CRITICAL(&traffic_lock);
+    int count = traffic_stats_export(&traffic_stats, links, cursor, entries, max_entries);
+    portEXIT_CRITICAL(&traffic_lock);
+    return count;
+}
+
+// Get client-to-AP edges of the association graph
+int wifi_sniffer_get_assoc_edges(const uint8_t *bssid, assoc_edge_t *edges, int max_edges) {
+    portENTER_CRITICAL(&assoc_lock);
+    int count = assoc_graph_get_edges(&assoc_graph, bssid, edges, max_edges);
+    portEXIT_CRITICAL(&assoc_lock);
+    return count;
+}
+
+// Get the top transmitters of a sliding window
+int wifi_sniffer_get_top_talkers(uint16_t window_s, topk_metric_t metric, topk_result_t *results,
+                                 int max_results, uint32_t *max_error, uint32_t *total) {
+    // Copy the window one epoch summary at a time and merge outside the lock;
+    // an epoch rolling over meanwhile only shifts which epoch a count lands in
+    topk_window_t *window = malloc(sizeof(topk_window_t));
+    if (!window) {
+        return TOPK_ERR_NO_MEMORY;
+    }
     
-    // Check if sniffer is running
-    if (!is_sniffer_running) return;
+    portENTER_CRITICAL(&topk_lock);
+    const topk_window_t *live = topk_sketch_window(&topk_sketch, window_s);
+    if (live) {
+        window->window_s = live->window_s;
+        window->epoch_us = live->epoch_us;
+        window->epoch_count = live->epoch_count;
+        window->current = live->current;
+        window->current_start_us = live->current_start_us;
+    }
+    portEXIT_CRITICAL(&topk_lock);
+    if (!live) {
+        free(window);
+        return TOPK_ERR_NO_WINDOW;
+    }
+    for (int m = 0; m < TOPK_METRIC_COUNT; m++) {
+        for (int e = 0; e < TOPK_MAX_EPOCHS; e++) {
+            portENTER_CRITICAL(&topk_lock);
+            window->epochs[m][e] = live->epochs[m][e];
+            portEXIT_CRITICAL(&topk_lock);
+        }
+    }
     
-    wifi_promiscuous_pkt_t *pkt = (wifi_promiscuous_pkt_t*)buf;
-    wifi_pkt_rx_ctrl_t *rx_ctrl = &pkt->rx_ctrl;
+    int count = topk_window_query(window, metric, esp_timer_get_time(), results, max_results, max_error, total);
+    free(window);
+    return count;
+}
+
+// Get distinct-device estimates per channel and per BSSID
+bool wifi_sniffer_get_device_counts(hll_counts_t *counts) {
+    // Copy the sketches one slot at a time and estimate outside the lock
+    hll_stats_t *copy = malloc(sizeof(hll_stats_t));
+    if (!copy) {
+        return false;
+    }
     
-    // If we have a specific filter for beacon or probe, check it here
-    if (current_filter == 4 || current_filter == 5) {
-        // Get frame control field to determine if it's a beacon or probe
-        const uint8_t *frame = pkt->payload;
-        uint16_t frame_control = frame[0] | (frame[1] << 8);
-        uint8_t type = (frame_control & 0x000C) >> 2;
-        uint8_t subtype = (frame_control & 0x00F0) >> 4;
+    for (int i = 0; i < HLL_MAX_CHANNELS; i++) {
+        portENTER_CRITICAL(&hll_lock);
+        copy->channels[i] = hll_stats.channels[i];
+        copy->channel_sketches[i] = hll_stats.channel_sketches[i];
+        portEXIT_CRITICAL(&hll_lock);
+    }
+    for (int i = 0; i < HLL_MAX_BSSIDS; i++) {
+        portENTER_CRITICAL(&hll_lock);
+        copy->bssid_nodes[i] = hll_stats.bssid_nodes[i];
+        copy->bssid_sketches[i] = hll_stats.bssid_sketches[i];
+        portEXIT_CRITICAL(&hll_lock);
+    }
+    
+    hll_stats_counts(copy, counts);
+    free(copy);
+    return true;
+}
+
+// Set the flood threshold of a management frame category
+void wifi_sniffer_set_wids_threshold(wids_category_t category, uint32_t threshold) {
+    if (category >= WIDS_CAT_COUNT || threshold == 0) {
+        return;
+    }
+    
+    portENTER_CRITICAL(&wids_lock);
+    wids_thresholds[category] = threshold;
+    wids_set_threshold(&wids, category, threshold);
+    portEXIT_CRITICAL(&wids_lock);
+}
+
+// Get the flood thresholds and per-category frame totals
+void wifi_sniffer_get_wids_config(uint32_t thresholds[WIDS_CAT_COUNT], uint32_t frames[WIDS_CAT_COUNT]) {
+    portENTER_CRITICAL(&wids_lock);
+    memcpy(thresholds, wids_thresholds, sizeof(wids_thresholds));
+    memcpy(frames, wids.frames, sizeof(wids.frames));
+    portEXIT_CRITICAL(&wids_lock);
+}
+
+// Get flood alerts raised after an alert ID
+int wifi_sniffer_get_wids_alerts(uint32_t since_id, wids_alert_t *alerts, int max_alerts) {
+    portENTER_CRITICAL(&wids_lock);
+    int count = wids_get_alerts(&wids, since_id, alerts, max_alerts);
+    portEXIT_CRITICAL(&wids_lock);
+    return count;
+}
+
+// Get a copy of the per-channel airtime counters
+void wifi_sniffer_get_airtime(airtime_t *copy) {
+    // One channel slot per critical section
+    portENTER_CRITICAL(&airtime_lock);
+    copy->session_start_us = airtime.session_start_us;
+    copy->dwell_slot = airtime.dwell_slot;
+    copy->dwell_start_us = airtime.dwell_start_us;
+    copy->dwell_busy_us = airtime.dwell_busy_us;
+    copy->dwell_frames = airtime.dwell_frames;
+    copy->evictions = airtime.evictions;
+    copy->dropped_frames = airtime.dropped_frames;
+    portEXIT_CRITICAL(&airtime_lock);
+    for (int i = 0; i < AIRTIME_MAX_CHANNELS; i++) {
+        portENTER_CRITICAL(&airtime_lock);
+        copy->channels[i] = airtime.channels[i];
+        portEXIT_CRITICAL(&airtime_lock);
+    }
+}
+
+// Get the rate histograms of transmitters or BSSIDs
+int wifi_sniffer_get_rate_stats(bool bssids, rate_entry_t *entries, int max_entries) {
+    portENTER_CRITICAL(&rate_lock);
+    int count = rate_stats_export(&rate_stats, bssids, entries, max_entries);
+    portEXIT_CRITICAL(&rate_lock);
+    return count;
+}
+
+// Get capture completeness per transmitter, per channel and overall
+int wifi_sniffer_get_seq_coverage(seq_entry_t *entries, int max_entries, seq_entry_t *channels,
+                                  int *channel_count, seq_counters_t *total) {
+    portENTER_CRITICAL(&seq_lock);
+    int count = seq_tracker_export(&seq_tracker, entries, max_entries);
+    *channel_count = 0;
+    for (int i = 0; i < SEQ_MAX_CHANNELS; i++) {
+        if (seq_tracker.channels[i] == 0) continue;
+        seq_entry_t *ch = &channels[(*channel_count)++];
+        memset(ch->addr, 0, 6);
+        ch->channel = seq_tracker.channels[i];
+        ch->counters = seq_tracker.channel_counters[i];
+    }
+    *total = seq_tracker.total;
+    portEXIT_CRITICAL(&seq_lock);
+    return count;
+}
+
+// Get the number of frames captured without a parsable MAC header
+uint32_t wifi_sniffer_get_unparsed_count(void) {
+    return unparsed_frames;
+}
+
+// Map the driver's auth mode to the weakest security the BSS accepts
+static rogue_auth_t rogue_auth_from_wifi(wifi_auth_mode_t mode) {
+    switch (mode) {
+        case WIFI_AUTH_OPEN:
+            return ROGUE_AUTH_OPEN;
+        case WIFI_AUTH_WEP:
+            return ROGUE_AUTH_WEP;
+        case WIFI_AUTH_WPA_PSK:
+        case WIFI_AUTH_WPA_WPA2_PSK:
+            return ROGUE_AUTH_WPA;
+        case WIFI_AUTH_WPA3_PSK:
+            return ROGUE_AUTH_WPA3;
+        default:
+            return ROGUE_AUTH_WPA2;
+    }
+}
+
+// Feed scan results into the evil-twin index
+void wifi_sniffer_observe_scan(const wifi_ap_record_t *records, uint16_t count) {
+    uint64_t now_us = esp_timer_get_time();
+    
+    for (uint16_t i = 0; i < count; i++) {
+        portENTER_CRITICAL(&rogue_lock);
+        prepare_rogue_index();
+        rogue_ap_observe(&rogue_index, (const char *)records[i].ssid, records[i].bssid, records[i].primary,
+                         rogue_auth_from_wifi(records[i].authmode), 0, records[i].rssi,
+                         ROGUE_SOURCE_SCAN, now_us);
+        portEXIT_CRITICAL(&rogue_lock);
+    }
+}
+
+// Replace the evil-twin baseline
+int wifi_sniffer_set_rogue_baseline(const rogue_baseline_entry_t *entries, int count) {
+    portENTER_CRITICAL(&rogue_lock);
+    prepare_rogue_index();
+    int installed = entries ? rogue_ap_set_baseline(&rogue_index, entries, count)
+                            : rogue_ap_learn_baseline(&rogue_index);
+    portEXIT_CRITICAL(&rogue_lock);
+    
+    ESP_LOGI(TAG, "Evil-twin baseline set: %d entries", installed);
+    return installed;
+}
+
+// Get a copy of the evil-twin index
+void wifi_sniffer_get_rogue_index(rogue_ap_t *index) {
+    // The hash tables are copied whole so their links stay consistent, the
+    // SSID entries one at a time; an entry may be newer than the table
+    portENTER_CRITICAL(&rogue_lock);
+    prepare_rogue_index();
+    index->ssid_table = rogue_index.ssid_table;
+    memcpy(index->ssid_nodes, rogue_index.ssid_nodes, sizeof(index->ssid_nodes));
+    memcpy(index->ssid_buckets, rogue_index.ssid_buckets, sizeof(index->ssid_buckets));
+    index->baseline_table = rogue_index.baseline_table;
+    memcpy(index->baseline_nodes, rogue_index.baseline_nodes, sizeof(index->baseline_nodes));
+    memcpy(index->baseline_buckets, rogue_index.baseline_buckets, sizeof(index->baseline_buckets));
+    index->baseline_count = rogue_index.baseline_count;
+    index->alerts = rogue_index.alerts;
+    portEXIT_CRITICAL(&rogue_lock);
+    
+    for (int i = 0; i < ROGUE_MAX_SSIDS; i++) {
+        portENTER_CRITICAL(&rogue_lock);
+        index->ssids[i] = rogue_index.ssids[i];
+        portEXIT_CRITICAL(&rogue_lock);
+    }
+    for (int i = 0; i < ROGUE_MAX_BASELINE_SSIDS; i++) {
+        portENTER_CRITICAL(&rogue_lock);
+        index->baseline[i] = rogue_index.baseline[i];
+        portEXIT_CRITICAL(&rogue_lock);
+    }
+    
+    // Point the copy's tables at its own arrays
+    index->ssid_table.nodes = index->ssid_nodes;
+    index->ssid_table.buckets = index->ssid_buckets;
+    index->baseline_table.nodes = index->baseline_nodes;
+    index->baseline_table.buckets = index->baseline_buckets;
+}
+
+// Replace the MAC watch/ignore list
+void wifi_sniffer_set_mac_filter(mac_filter_t *filter) {
+    portENTER_CRITICAL(&mac_filter_lock);
+    mac_filter_t *old = mac_filter;
+    mac_filter = filter;
+    portEXIT_CRITICAL(&mac_filter_lock);
+    
+    // Safe to free: the callback only uses the list while holding the lock
+    mac_filter_destroy(old);
+    
+    if (filter) {
+        ESP_LOGI(TAG, "MAC filter set: %s, %lu entries, %lu bloom bits", mac_filter_mode_name(filter->mode),
+                 (unsigned long)filter->count, (unsigned long)filter->bloom_bits);
+    } else {
+        ESP_LOGI(TAG, "MAC filter cleared");
+    }
+}
+
+// Get the MAC watch/ignore list settings and counters
+bool wifi_sniffer_get_mac_filter_info(mac_filter_t *info) {
+    bool present;
+    
+    portENTER_CRITICAL(&mac_filter_lock);
+    present = (mac_filter != NULL);
+    if (present) {
+        *info = *mac_filter;
+    }
+    portEXIT_CRITICAL(&mac_filter_lock);
+    
+    // Only the header is copied; the entries stay owned by the sniffer
+    if (present) {
+        info->entries = NULL;
+        info->bloom = NULL;
+    }
+    return present;
+}
+
+// Follow task: apply the channel the follow session asks for
+static void follow_task(void *pvParameters) {
+    (void)pvParameters;
+    uint8_t applied = 0;
+    
+    ESP_LOGI(TAG, "Follow task started");
+    
+    while (following) {
+        portENTER_CRITICAL(&follow_lock);
+        uint8_t channel = follow_target_poll(&follow, esp_timer_get_time());
+        portEXIT_CRITICAL(&follow_lock);
         
-        if (current_filter == 4) { // Beacon frames only
-            if (!(type == 0 && subtype == 8)) { // Not a beacon
-                return;
-            }
-        } else if (current_filter == 5) { // Probe frames only
-            if (!(type == 0 && (subtype == 4 || subtype == 5))) { // Not a probe request/response
-                return;
-            }
+        if (channel != applied && radio_sched_set_sniffer(channel)) {
+            ESP_LOGD(TAG, "Following on channel %d", channel);
+            applied = channel;
         }
+        vTaskDelay(pdMS_TO_TICKS(FOLLOW_POLL_MS));
     }
     
-    // Allocate memory for packet info
-    packet_info_t *packet_info = malloc(sizeof(packet_info_t));
-    if (!packet_info) {
-        ESP_LOGI(TAG, "Failed to allocate memory for packet info");
+    // Delete self
+    follow_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+// Stop the follow task and wait for it to exit
+static void end_follow(void) {
+    following = false;
+    for (int i = 0; i < 100 && follow_task_handle != NULL; i++) {
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+    portENTER_CRITICAL(&follow_lock);
+    follow.state = FOLLOW_IDLE;
+    portEXIT_CRITICAL(&follow_lock);
+}
+
+// Lock the sniffer onto a BSS's channel and keep it there
+bool wifi_sniffer_follow(const uint8_t *bssid, uint8_t channel) {
+    if (!is_sniffer_running) {
+        return false;
+    }
+    end_follow();
+    
+    portENTER_CRITICAL(&follow_lock);
+    follow_target_init(&follow, bssid, channel, follow_plan, sizeof(follow_plan), esp_timer_get_time());
+    portEXIT_CRITICAL(&follow_lock);
+    
+    // Beacons are needed to track the target whatever the capture filter
+    wifi_promiscuous_filter_t filter = {
+        .filter_mask = filter_mask_for(current_filter) | WIFI_PROMIS_FILTER_MASK_MGMT,
+    };
+    esp_wifi_set_promiscuous_filter(&filter);
+    
+    following = true;
+    if (xTaskCreate(follow_task, "follow_target", 2048, NULL, 5, &follow_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create follow task");
+        following = false;
+        follow_task_handle = NULL;
+        return false;
+    }
+    return true;
+}
+
+// Stop following and return to the channel (or hopping) the capture started with
+bool wifi_sniffer_unfollow(void) {
+    if (!following) {
+        return false;
+    }
+    end_follow();
+    
+    if (is_sniffer_running) {
+        wifi_promiscuous_filter_t filter = {
+            .filter_mask = filter_mask_for(current_filter),
+        };
+        esp_wifi_set_promiscuous_filter(&filter);
+        radio_sched_set_sniffer(current_channel);
+    }
+    return true;
+}
+
+// Get the follow session (the last one after it ended)
+bool wifi_sniffer_get_follow(follow_target_t *copy) {
+    portENTER_CRITICAL(&follow_lock);
+    *copy = follow;
+    portEXIT_CRITICAL(&follow_lock);
+    return following;
+}
+
+// The radio scheduler moved the radio (0: it left for a scan)
+void wifi_sniffer_radio_tuned(uint8_t channel) {
+    if (!is_sniffer_running) {
         return;
     }
     
-    // Copy packet data
-    uint16_t payload_len = rx_ctrl->sig_len - 4; // Remove FCS
+    uint64_t now_us = esp_timer_get_time();
+    if (channel != 0) {
+        portENTER_CRITICAL(&seq_lock);
+        channel_tuned_us = now_us;
+        portEXIT_CRITICAL(&seq_lock);
+    }
+    
+    portENTER_CRITICAL(&airtime_lock);
+    if (channel == 0) {
+        airtime_dwell_end(&airtime, now_us);
+    } else {
+        airtime_dwell_begin(&airtime, channel, now_us);
+    }
+    portEXIT_CRITICAL(&airtime_lock);
+}
+
+#if CONFIG_SOC_WIFI_HE_SUPPORT
+// Values of rx_ctrl.cur_bb_format
+#define BB_FORMAT_11B       0
+#define BB_FORMAT_11G       1
+#define BB_FORMAT_HT        2
+#define BB_FORMAT_VHT       3
+#define BB_FORMAT_HE_SU     4
+#define BB_FORMAT_HE_MU     5
+#define BB_FORMAT_HE_ERSU   6
+#define BB_FORMAT_HE_TB     7
+#endif
+
+// Describe the PHY a frame was received with, for the airtime estimate
+static bool rx_ctrl_to_phy(const wifi_pkt_rx_ctrl_t *rx_ctrl, airtime_phy_t *phy) {
+    memset(phy, 0, sizeof(*phy));
+    phy->nss = 1;
+    phy->bandwidth = 20;
+    phy->gi_ns = 800;
+    
+#if CONFIG_SOC_WIFI_HE_SUPPORT
+    // he_siga1/he_siga2 hold the HT-SIG, VHT-SIG-A or HE-SIG-A of the frame
+    uint32_t siga1 = rx_ctrl->he_siga1;
+    uint32_t siga2 = rx_ctrl->he_siga2;
+    static const uint16_t he_gi_ns[4] = {800, 800, 1600, 3200};
+    
+    switch (rx_ctrl->cur_bb_format) {
+        case BB_FORMAT_11B:
+        case BB_FORMAT_11G:
+            return airtime_phy_from_legacy_code(rx_ctrl->rate, phy);
+        case BB_FORMAT_HT:
+            // HT-SIG1: MCS in bits 0-6, 40 MHz in bit 7; HT-SIG2 short GI lands in bit 31
+            phy->format = AIRTIME_PHY_HT;
+            phy->rate = siga1 & 0x7F;
+            phy->bandwidth = (siga1 & 0x80) ? 40 : 20;
+            phy->gi_ns = (siga1 >> 31) ? 400 : 800;
+            return true;
+        case BB_FORMAT_VHT:
+            // VHT-SIG-A1: bandwidth in bits 0-1, NSTS-1 in bits 10-12;
+            // VHT-SIG-A2: short GI in bit 0, MCS in bits 4-7
+            phy->format = AIRTIME_PHY_VHT;
+            phy->rate = (siga2 >> 4) & 0x0F;
+            phy->bandwidth = 20 << (siga1 & 0x03);
+            phy->nss = ((siga1 >> 10) & 0x07) + 1;
+            phy->gi_ns = (siga2 & 0x01) ? 400 : 800;
+            return true;
+        case BB_FORMAT_HE_SU:
+        case BB_FORMAT_HE_ERSU:
+            // HE-SIG-A1: MCS in bits 3-6, bandwidth in bits 19-20, GI+LTF in
+            // bits 21-22, NSTS-1 in bits 23-25 (ER SU is always 20 MHz or less)
+            phy->format = AIRTIME_PHY_HE;
+            phy->rate = (siga1 >> 3) & 0x0F;
+            if (rx_ctrl->cur_bb_format == BB_FORMAT_HE_SU) {
+                phy->bandwidth = 20 << ((siga1 >> 19) & 0x03);
+            }
+            phy->gi_ns = he_gi_ns[(siga1 >> 21) & 0x03];
+            phy->nss = ((siga1 >> 23) & 0x07) + 1;
+            return true;
+        case BB_FORMAT_HE_MU:
+        case BB_FORMAT_HE_TB:
+            // The per-user MCS and RU are not reported; assume a mid-range 20 MHz rate
+            phy->format = AIRTIME_PHY_HE;
+            phy->rate = 4;
+            return true;
+        default:
+            return false;
+    }
+#else
+    switch (rx_ctrl->sig_mode) {
+        case 0: // Non-HT
+            return airtime_phy_from_legacy_code(rx_ctrl->rate, phy);
+        case 1: // HT
+            phy->format = AIRTIME_PHY_HT;
+            phy->rate = rx_ctrl->mcs;
+            phy->bandwidth = rx_ctrl->cwb ? 40 : 20;
+            phy->gi_ns = rx_ctrl->sgi ? 400 : 800;
+            return true;
+        case 3: // VHT
+            phy->format = AIRTIME_PHY_VHT;
+            phy->rate = rx_ctrl->mcs & 0x0F;
+            phy->bandwidth = rx_ctrl->cwb ? 40 : 20;
+            phy->gi_ns = rx_ctrl->sgi ? 400 : 800;
+            return true;
+        default:
+            return false;
+    }
+#endif
+}
+
+// Record a frame to flash, the trigger slots and the capture buffer, keeping
+// as much of it as the overload governor allows
+static void store_frame(const wifi_promiscuous_pkt_t *pkt, const frame_info_t *info, capture_class_t cls,
+                        uint16_t header_len, uint8_t rate, bool parsed) {
+    // Under overload, capture less of each frame, or fewer frames, or none
+    portENTER_CRITICAL(&governor_lock);
+    uint16_t caplen = load_governor_admit(&governor, info->length, header_len, cls <= CAPTURE_CLASS_DEAUTH);
+    portEXIT_CRITICAL(&governor_lock);
+    if (caplen == 0) {
+        return;
+    }
+    
+    // Record to flash (buffered; the writer task does the I/O), no more of
+    // the frame than the governor lets through. Trigger conditions match on
+    // header fields, so unparsed frames are left out
+    capture_storage_push(pkt->payload, caplen, info->length, pkt->rx_ctrl.rssi, pkt->rx_ctrl.channel, rate,
+                         info->timestamp_us);
+    if (parsed) {
+        trigger_capture_push(info, pkt->payload, caplen, rate);
+    }
+    
+    // Copy packet data, allocating only what the governor lets through
+    uint16_t payload_len = caplen;
     if (payload_len > MAX_PACKET_SIZE) {
         payload_len = MAX_PACKET_SIZE;
     }
+    packet_info_t *packet_info = malloc(PACKET_INFO_SIZE(payload_len));
+    if (!packet_info) {
+        ESP_LOGI(TAG, "Failed to allocate memory for packet info");
+        return;
+    }
     
     // Fill packet info
-    packet_info->rx_ctrl = *rx_ctrl;
+    packet_info->rx_ctrl = pkt->rx_ctrl;
     packet_info->length = payload_len;
-    packet_info->rssi = rx_ctrl->rssi;
-    packet_info->channel = rx_ctrl->channel;
+    packet_info->orig_length = info->length;
+    packet_info->rssi = pkt->rx_ctrl.rssi;
+    packet_info->channel = pkt->rx_ctrl.channel;
+    packet_info->rate = rate;
+    packet_info->timestamp_us = info->timestamp_us;
     memcpy(packet_info->data, pkt->payload, payload_len);
     
-    // Add to queue, if queue is full, discard oldest packet
-    packet_info_t *old_packet;
-    if (xQueueSend(packet_queue, &packet_info, 0) != pdTRUE) {
-        if (xQueueReceive(packet_queue, &old_packet, 0) == pdTRUE) {
-            if (old_packet) free(old_packet);
-            xQueueSend(packet_queue, &packet_info, 0);
-        } else {
-            // This shouldn't happen, but free the packet if we can't add it
-            free(packet_info);
+    // Add to the capture buffer; when it is full, the oldest frame of the
+    // lowest priority class is evicted (or this one dropped if nothing ranks lower)
+    void *evicted = NULL;
+    
+    portENTER_CRITICAL(&capture_lock);
+    bool stored = capture_buffer_push(&capture_buffer, cls, packet_info, &evicted);
+    portEXIT_CRITICAL(&capture_lock);
+    
+    if (evicted) free(evicted);
+    if (!stored) free(packet_info);
+}
+
+// Run a frame through the filtering, analytics and capture stages
+static void handle_frame(void *buf, uint64_t now_us) {
+    wifi_promiscuous_pkt_t *pkt = (wifi_promiscuous_pkt_t*)buf;
+    wifi_pkt_rx_ctrl_t *rx_ctrl = &pkt->rx_ctrl;
+    sniffer_profile_begin();
+    
+    // Parse the MAC header once for all filtering stages (sig_len includes the FCS)
+    frame_info_t info;
+    uint16_t length = rx_ctrl->sig_len > 4 ? rx_ctrl->sig_len - 4 : 0;
+    bool parsed = ieee80211_parse_frame(pkt->payload, length, &info);
+    if (!parsed) {
+        memset(&info, 0, sizeof(info));
+        info.length = length;
+    }
+    info.rssi = rx_ctrl->rssi;
+    info.channel = rx_ctrl->channel;
+    info.timestamp_us = now_us;
+    
+    // On-air duration, from the PHY rate and the length including the FCS
+    airtime_phy_t phy;
+    bool have_phy = rx_ctrl_to_phy(rx_ctrl, &phy);
+    uint32_t airtime_us = have_phy ? airtime_duration_us(&phy, rx_ctrl->sig_len) : 0;
+    uint8_t rate = have_phy && phy.format <= AIRTIME_PHY_OFDM ? phy.rate : 0;
+    sniffer_profile_mark(SNIFFER_STAGE_PARSE);
+    
+    // Runts and malformed headers skip the filters and analytics, which all
+    // need the header, but are still captured with the other frames. They
+    // cannot be beacons or probes, so the beacon and probe filters drop them,
+    // and no address in them can be shown to be on a watch list
+    if (!parsed) {
+        unparsed_frames++;
+        portENTER_CRITICAL(&mac_filter_lock);
+        bool watching = mac_filter && mac_filter->mode == MAC_FILTER_WATCH;
+        portEXIT_CRITICAL(&mac_filter_lock);
+        if (length > 0 && !watching && current_filter != 4 && current_filter != 5) {
+            store_frame(pkt, &info, CAPTURE_CLASS_OTHER, length, rate, false);
+        }
+        sniffer_profile_mark(SNIFFER_STAGE_STORE);
+        return;
+    }
+    
+    // Retransmissions still occupy the air and count as retries, but are
+    // not counted as traffic a second time nor captured again.
+    portENTER_CRITICAL(&seq_lock);
+    bool duplicate = seq_tracker_update(&seq_tracker, &info, channel_tuned_us);
+    portEXIT_CRITICAL(&seq_lock);
+    
+    // Flood detection and the evil-twin index watch the whole channel: an
+    // attacker is rarely on the watch list, and may well be on the ignore list
+    if (!duplicate) {
+        portENTER_CRITICAL(&wids_lock);
+        wids_update(&wids, &info);
+        portEXIT_CRITICAL(&wids_lock);
+        portENTER_CRITICAL(&rogue_lock);
+        rogue_ap_update(&rogue_index, &info);
+        portEXIT_CRITICAL(&rogue_lock);
+    }
+    sniffer_profile_mark(SNIFFER_STAGE_SECURITY);
+    
+    // MAC watch/ignore list: Bloom filter reject, then exact confirm
+    portENTER_CRITICAL(&mac_filter_lock);
+    bool accepted = mac_filter_accept(mac_filter, &info);
+    portEXIT_CRITICAL(&mac_filter_lock);
+    sniffer_profile_mark(SNIFFER_STAGE_FILTER);
+    if (!accepted) {
+        return;
+    }
+    
+    // The other analytics see every frame the list lets in, independent of
+    // the capture filter
+    portENTER_CRITICAL(&airtime_lock);
+    airtime_update(&airtime, info.channel, airtime_us, info.timestamp_us);
+    portEXIT_CRITICAL(&airtime_lock);
+    portENTER_CRITICAL(&rate_lock);
+    rate_stats_update(&rate_stats, &info, have_phy ? &phy : NULL);
+    portEXIT_CRITICAL(&rate_lock);
+    if (!duplicate) {
+        portENTER_CRITICAL(&traffic_lock);
+        traffic_stats_update(&traffic_stats, &info);
+        portEXIT_CRITICAL(&traffic_lock);
+        portENTER_CRITICAL(&assoc_lock);
+        assoc_graph_update(&assoc_graph, &info);
+        portEXIT_CRITICAL(&assoc_lock);
+        portENTER_CRITICAL(&topk_lock);
+        topk_sketch_update(&topk_sketch, &info);
+        portEXIT_CRITICAL(&topk_lock);
+        portENTER_CRITICAL(&hll_lock);
+        hll_stats_update(&hll_stats, &info);
+        portEXIT_CRITICAL(&hll_lock);
+        if (following) {
+            portENTER_CRITICAL(&follow_lock);
+            follow_target_observe(&follow, &info);
+            portEXIT_CRITICAL(&follow_lock);
+        }
+    }
+    sniffer_profile_mark(SNIFFER_STAGE_ANALYTICS);
+    if (duplicate) {
+        return;
+    }
+    
+    // If we have a specific filter for beacon or probe, check it here
+    if (current_filter == 4) { // Beacon frames only
+        if (!(info.type == IEEE80211_TYPE_MGMT && info.subtype == IEEE80211_STYPE_BEACON)) {
+            return;
+        }
+    } else if (current_filter == 5) { // Probe frames only
+        if (!(info.type == IEEE80211_TYPE_MGMT &&
+              (info.subtype == IEEE80211_STYPE_PROBE_REQ || info.subtype == IEEE80211_STYPE_PROBE_RESP))) {
+            return;
+        }
+    } else if (following && (current_filter == 2 || current_filter == 3) && info.type == IEEE80211_TYPE_MGMT) {
+        // Management frames are only let in to track the followed BSS
+        return;
+    }
+    
+    // Collapse repeated beacons into counters, only forwarding changes and keepalives
+    if (beacon_dedup_enabled && info.type == IEEE80211_TYPE_MGMT && info.subtype == IEEE80211_STYPE_BEACON) {
+        portENTER_CRITICAL(&beacon_dedup_lock);
+        bool forward = beacon_dedup_check(&beacon_dedup, &info);
+        portEXIT_CRITICAL(&beacon_dedup_lock);
+        if (!forward) {
+            sniffer_profile_mark(SNIFFER_STAGE_DEDUP);
+            return;
         }
     }
+    sniffer_profile_mark(SNIFFER_STAGE_DEDUP);
+    
+    uint16_t header_len = info.body ? info.body - pkt->payload : info.length;
+    store_frame(pkt, &info, capture_buffer_classify(&info), header_len, rate, true);
+    sniffer_profile_mark(SNIFFER_STAGE_STORE);
 }
 
-// Task to retry setting a single channel
-static void single_channel_retry_task(void *pvParameters) {
-    uint8_t target_channel = *(uint8_t*)pvParameters;
-    int retry_count = 0;
+// Close a governor window with the buffer churn and free heap, and log level changes
+static void evaluate_governor(uint64_t now_us) {
+    uint32_t churn = 0;
+    portENTER_CRITICAL(&capture_lock);
+    for (int i = 0; i < CAPTURE_CLASS_COUNT; i++) {
+        churn += capture_buffer.stats[i].evicted + capture_buffer.stats[i].dropped;
+    }
+    portEXIT_CRITICAL(&capture_lock);
+    uint32_t free_heap = esp_get_free_heap_size();
     
-    // Free the parameter memory
-    free(pvParameters);
+    portENTER_CRITICAL(&governor_lock);
+    load_level_t previous = governor.level;
+    bool changed = load_governor_evaluate(&governor, now_us, churn, free_heap);
+    load_level_t level = governor.level;
+    uint8_t busy_pct = governor.busy_pct;
+    uint32_t churn_fps = governor.churn_fps;
+    portEXIT_CRITICAL(&governor_lock);
     
-    ESP_LOGI(TAG, "Channel retry task started for channel %d", target_channel);
+    if (changed) {
+        ESP_LOGW(TAG, "Capture fidelity %s -> %s (callback %u%%, churn %lu/s, free heap %lu)",
+                 load_governor_level_name(previous), load_governor_level_name(level), busy_pct,
+                 (unsigned long)churn_fps, (unsigned long)free_heap);
+    }
+}
+
+// Packet handler: times each frame for the overload governor
+static void wifi_sniffer_packet_handler(void *buf, wifi_promiscuous_pkt_type_t type) {
+    (void)type;
+    if (!buf) return;
     
-    while (is_sniffer_running && retry_count < 20) { // Limit retries to avoid infinite loop
-        esp_err_t err = esp_wifi_set_channel(target_channel, WIFI_SECOND_CHAN_NONE);
-        
-        if (err == ESP_OK) {
-            ESP_LOGI(TAG, "Successfully set channel to %d after %d retries", target_channel, retry_count);
-            break;
-        }
-        
-        retry_count++;
-        ESP_LOGD(TAG, "Retry %d: Failed to set channel %d: %s", 
-                retry_count, target_channel, esp_err_to_name(err));
-        
-        // Exponential backoff for retries
-        int delay_ms = CHANNEL_HOP_INTERVAL_MS * (1 << (retry_count > 5 ? 5 : retry_count));
-        vTaskDelay(delay_ms / portTICK_PERIOD_MS);
+    // Check if sniffer is running
+    if (!is_sniffer_running) return;
+    
+    uint64_t start_us = esp_timer_get_time();
+    handle_frame(buf, start_us);
+    uint64_t end_us = esp_timer_get_time();
+    
+    portENTER_CRITICAL(&governor_lock);
+    bool due = load_governor_account(&governor, end_us - start_us, end_us);
+    portEXIT_CRITICAL(&governor_lock);
+    if (due) {
+        evaluate_governor(end_us);
+    }
+}
+
+// Feed a synthetic frame to the packet handler, as if the radio had received it
+bool wifi_sniffer_inject(wifi_promiscuous_pkt_t *pkt, uint16_t len, int8_t rssi, uint8_t channel, uint8_t rate) {
+    if (!is_sniffer_running || len < 10 || len + 4 > 4095) {
+        return false;
     }
     
-    if (retry_count >= 20) {
-        ESP_LOGW(TAG, "Failed to set channel %d after maximum retries", target_channel);
+    int code = airtime_legacy_code(rate);
+    if (code < 0) {
+        code = channel > 14 ? 0x0B : 0x00;
     }
     
-    // Delete self
-    channel_hopper_task_handle = NULL;
-    vTaskDelete(NULL);
-} 
\ No newline at end of file
+    // Metadata as the driver fills it for a legacy-rate frame; sig_len counts the FCS
+    wifi_pkt_rx_ctrl_t *rx_ctrl = &pkt->rx_ctrl;
+    memset(rx_ctrl, 0, sizeof(*rx_ctrl));
+    rx_ctrl->rssi = rssi;
+    rx_ctrl->rate = code;
+    rx_ctrl->channel = channel;
+    rx_ctrl->sig_len = len + 4;
+#if CONFIG_SOC_WIFI_HE_SUPPORT
+    rx_ctrl->cur_bb_format = code < 0x08 ? BB_FORMAT_11B : BB_FORMAT_11G;
+#endif
+    memset(pkt->payload + len, 0, 4);
+    
+    static const wifi_promiscuous_pkt_type_t types[4] = {
+        WIFI_PKT_MGMT, WIFI_PKT_CTRL, WIFI_PKT_DATA, WIFI_PKT_MISC
+    };
+    wifi_sniffer_packet_handler(pkt, types[(pkt->payload[0] >> 2) & 0x03]);
+    return true;
+}
@@ -2,8 +2,47 @@
 #define WIFI_SNIFFER_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include "esp_wifi_types.h"
+#include "beacon_dedup.h"
+#include "capture_buffer.h"
+#include "traffic_stats.h"
+#include "assoc_graph.h"
+#include "topk_sketch.h"
+#include "hll.h"
+#include "mac_filter.h"
+#include "wids.h"
+#include "rogue_ap.h"
+#include "airtime.h"
+#include "rate_stats.h"
+#include "seq_tracker.h"
+#include "follow_target.h"
+#include "load_governor.h"
+
+// Maximum size of a stored packet
+#define MAX_PACKET_SIZE 1024
+
+/**
+ * @brief Captured frame, as handed out by get_captured_packets()
+ *
+ * Only PACKET_INFO_SIZE(length) bytes are allocated, so data must not be
+ * read past length.
+ */
+typedef struct {
+    uint16_t length;             // Bytes in data (frame truncated to MAX_PACKET_SIZE or by the governor, no FCS)
+    uint16_t orig_length;        // Frame length on air, without the FCS
+    int8_t rssi;
+    uint8_t channel;
+    uint8_t rate;                // Legacy rate in 500 kbps units, 0 for HT and later
+    uint64_t timestamp_us;       // esp_timer time of reception
+    wifi_pkt_rx_ctrl_t rx_ctrl;
+    uint8_t data[MAX_PACKET_SIZE];
+} packet_info_t;
+
+// Bytes to allocate for a packet_info_t holding len bytes of frame; at
+// least a full MAC header so the addresses can always be read
+#define PACKET_INFO_SIZE(len) (offsetof(packet_info_t, data) + ((len) > 24 ? (len) : 24))
 
 /**
  * @brief Start WiFi packet sniffer
@@ -27,13 +66,276 @@ bool start_wifi_sniffer(uint8_t channel, uint8_t filter_type);
  */
 bool stop_wifi_sniffer(void);
 
+/**
+ * @brief Check whether the sniffer is running
+ */
+bool wifi_sniffer_is_running(void);
+
+/**
+ * @brief Note that the radio scheduler moved the radio
+ *
+ * Starts a new airtime dwell and sequence-gap window on the channel.
+ *
+ * @param channel New channel, 0 when the radio left for a scan
+ */
+void wifi_sniffer_radio_tuned(uint8_t channel);
+
+/**
+ * @brief Lock the sniffer onto a BSS's channel and keep it there
+ *
+ * The sniffer follows channel switch announcements and, if the BSS goes
+ * quiet, sweeps the channels until it hears it again. Management frames
+ * are received whatever the filter type so beacons can be tracked.
+ *
+ * @param bssid BSS to follow
+ * @param channel Channel it is believed to be on, 0 to search for it
+ * @return false if the sniffer is not running or the follow task could not start
+ */
+bool wifi_sniffer_follow(const uint8_t *bssid, uint8_t channel);
+
+/**
+ * @brief Stop following and return to the channel (or hopping) the capture started with
+ *
+ * @return false if no BSS was being followed
+ */
+bool wifi_sniffer_unfollow(void);
+
+/**
+ * @brief Get the follow session (the last one after it ended)
+ *
+ * @return true while following
+ */
+bool wifi_sniffer_get_follow(follow_target_t *copy);
+
 /**
  * @brief Get captured packets
  * 
+ * Packets are returned oldest first. When the capture buffer overflows,
+ * frames are evicted by retention class (handshake > deauth > probe >
+ * beacon > other) rather than strictly by age.
+ * 
  * @param packets Array of pointers to store packet data (must be freed by caller)
  * @param max_packets Maximum number of packets to retrieve
  * @return Number of packets retrieved
  */
 int get_captured_packets(void **packets, int max_packets);
 
+/**
+ * @brief Enable or disable the beacon dedup stage
+ * 
+ * When enabled, repeated beacons from the same BSSID are collapsed into
+ * counters and only forwarded to the capture buffer when the SSID or IEs
+ * change, or when the keepalive interval expires.
+ * 
+ * @param enabled true to enable deduplication
+ * @param keepalive_ms Forward an unchanged beacon at least this often (0 keeps the current value)
+ */
+void wifi_sniffer_set_beacon_dedup(bool enabled, uint32_t keepalive_ms);
+
+/**
+ * @brief Get per-BSSID beacon counters from the dedup stage
+ * 
+ * @param entries Array to copy the counters into
+ * @param max_entries Size of the entries array
+ * @param total_seen Total beacons seen by the dedup stage (may be NULL)
+ * @param total_forwarded Total beacons forwarded to the capture buffer (may be NULL)
+ * @return Number of entries copied
+ */
+int wifi_sniffer_get_beacon_stats(beacon_dedup_entry_t *entries, int max_entries,
+                                  uint32_t *total_seen, uint32_t *total_forwarded);
+
+/**
+ * @brief Get per-class capture buffer counters
+ * 
+ * @param stats Array of CAPTURE_CLASS_COUNT entries to fill
+ */
+void wifi_sniffer_get_class_stats(capture_class_stats_t stats[CAPTURE_CLASS_COUNT]);
+
+/**
+ * @brief Get the most frames the capture buffer has held at once
+ * 
+ * @param reset Restart the overall and per-class high-water marks afterwards
+ * @return High-water mark across all classes
+ */
+uint16_t wifi_sniffer_get_buffer_peak(bool reset);
+
+/**
+ * @brief Set the overload governor's thresholds
+ * 
+ * The thresholds are kept across capture restarts.
+ */
+void wifi_sniffer_set_governor(const load_governor_config_t *config);
+
+/**
+ * @brief Get the overload governor's fidelity level, load signals and counters
+ */
+void wifi_sniffer_get_governor(load_governor_t *copy);
+
+/**
+ * @brief Get the frame and byte totals of the traffic counters
+ */
+void wifi_sniffer_get_traffic_totals(uint32_t *frames, uint64_t *bytes);
+
+/**
+ * @brief Get a batch of per-transmitter or per-(BSSID, station) counters
+ * 
+ * Each batch is copied in its own critical section; see traffic_stats_export().
+ * 
+ * @param links Read the (BSSID, station) table instead of the transmitters
+ * @param cursor 0 for the first batch; advanced by each call
+ * @param entries Array for the entries
+ * @param max_entries Size of the entries array
+ * @return Number of entries copied, 0 once the table is exhausted
+ */
+int wifi_sniffer_get_traffic_entries(bool links, int *cursor, traffic_entry_t *entries, int max_entries);
+
+/**
+ * @brief Get client-to-AP edges of the association graph
+ * 
+ * @param bssid Only return this BSSID's clients (NULL for the whole graph)
+ * @param edges Array to copy the edges into
+ * @param max_edges Size of the edges array
+ * @return Number of edges copied, most recently active first
+ */
+int wifi_sniffer_get_assoc_edges(const uint8_t *bssid, assoc_edge_t *edges, int max_edges);
+
+/**
+ * @brief Get the top transmitters of a sliding window
+ * 
+ * @param window_s Window length: 10, 60 or 300 seconds
+ * @param metric Rank by frames or by bytes
+ * @param results Array to store the results in, heaviest first
+ * @param max_results Size of the results array
+ * @param max_error Guaranteed bound on the error of any estimate (may be NULL)
+ * @param total Total weight seen in the window (may be NULL)
+ * @return Number of results, TOPK_ERR_NO_WINDOW if the window is not tracked
+ *         or TOPK_ERR_NO_MEMORY if the query could not allocate its copy
+ */
+int wifi_sniffer_get_top_talkers(uint16_t window_s, topk_metric_t metric, topk_result_t *results,
+                                 int max_results, uint32_t *max_error, uint32_t *total);
+
+/**
+ * @brief Get distinct-device estimates per channel and per BSSID
+ * 
+ * @param counts Estimates over the last one to two HLL_WINDOW_S windows
+ * @return true on success, false if out of memory
+ */
+bool wifi_sniffer_get_device_counts(hll_counts_t *counts);
+
+/**
+ * @brief Set the flood threshold of a management frame category
+ * 
+ * The threshold is kept across capture restarts.
+ * 
+ * @param category Category to configure
+ * @param threshold Frames per WIDS_BUCKETS seconds from one BSSID or source
+ */
+void wifi_sniffer_set_wids_threshold(wids_category_t category, uint32_t threshold);
+
+/**
+ * @brief Get the flood thresholds and per-category frame totals
+ */
+void wifi_sniffer_get_wids_config(uint32_t thresholds[WIDS_CAT_COUNT], uint32_t frames[WIDS_CAT_COUNT]);
+
+/**
+ * @brief Get flood alerts raised after an alert ID
+ * 
+ * @param since_id Last alert ID the caller has seen (0 for all)
+ * @param alerts Array to copy the alerts into, oldest first
+ * @param max_alerts Size of the alerts array
+ * @return Number of alerts copied
+ */
+int wifi_sniffer_get_wids_alerts(uint32_t since_id, wids_alert_t *alerts, int max_alerts);
+
+/**
+ * @brief Get a copy of the per-channel airtime counters
+ * 
+ * @param copy Copy to fill (large; allocate on the heap)
+ */
+void wifi_sniffer_get_airtime(airtime_t *copy);
+
+/**
+ * @brief Get the rate histograms of transmitters or BSSIDs
+ * 
+ * @param bssids true for per-BSSID histograms, false for per-transmitter
+ * @param entries Array to copy the histograms into, most recently heard first
+ * @param max_entries Size of the entries array
+ * @return Number of entries copied
+ */
+int wifi_sniffer_get_rate_stats(bool bssids, rate_entry_t *entries, int max_entries);
+
+/**
+ * @brief Get capture completeness per transmitter, per channel and overall
+ * 
+ * @param entries Array for the per-transmitter counters, most recently heard first
+ * @param max_entries Size of the entries array
+ * @param channels Array of SEQ_MAX_CHANNELS for the per-channel counters (addr is zeroed)
+ * @param channel_count Set to the number of channels filled in
+ * @param total Set to the counters over all transmitters
+ * @return Number of transmitter entries copied
+ */
+int wifi_sniffer_get_seq_coverage(seq_entry_t *entries, int max_entries, seq_entry_t *channels,
+                                  int *channel_count, seq_counters_t *total);
+
+/**
+ * @brief Get the number of frames whose MAC header could not be parsed
+ * 
+ * Such frames bypass the analytics but are still captured in the "other" class,
+ * unless a watch list is installed.
+ */
+uint32_t wifi_sniffer_get_unparsed_count(void);
+
+/**
+ * @brief Feed scan results into the evil-twin index
+ */
+void wifi_sniffer_observe_scan(const wifi_ap_record_t *records, uint16_t count);
+
+/**
+ * @brief Replace the evil-twin baseline
+ * 
+ * @param entries Expected BSSs, or NULL to learn everything observed so far
+ * @param count Number of entries
+ * @return Number of entries installed
+ */
+int wifi_sniffer_set_rogue_baseline(const rogue_baseline_entry_t *entries, int count);
+
+/**
+ * @brief Get a copy of the evil-twin index
+ * 
+ * @param index Copy to fill (large; allocate on the heap)
+ */
+void wifi_sniffer_get_rogue_index(rogue_ap_t *index);
+
+/**
+ * @brief Replace the MAC watch/ignore list
+ * 
+ * The list is checked in the RX callback before any copy is made. The flood
+ * detector and the evil-twin index run ahead of it and see every frame.
+ * 
+ * @param filter Finalized list; the sniffer takes ownership (NULL disables filtering)
+ */
+void wifi_sniffer_set_mac_filter(mac_filter_t *filter);
+
+/**
+ * @brief Get the MAC watch/ignore list settings and counters
+ * 
+ * @param info Filled with the list header (entries and bloom are set to NULL)
+ * @return false if no list is installed
+ */
+bool wifi_sniffer_get_mac_filter_info(mac_filter_t *info);
+
+/**
+ * @brief Feed a synthetic frame to the packet handler, as if the radio had received it
+ * 
+ * Used for load testing; the frame goes through every stage the RX callback runs.
+ * 
+ * @param pkt Buffer with the frame in payload and room for 4 more bytes (FCS); rx_ctrl is overwritten
+ * @param len Frame length without the FCS
+ * @param rssi Signal strength to report
+ * @param channel Channel to report
+ * @param rate Legacy rate in 500 kbps units (0 for the basic rate of the band)
+ * @return false if the sniffer is not running or the length is out of range
+ */
+bool wifi_sniffer_inject(wifi_promiscuous_pkt_t *pkt, uint16_t len, int8_t rssi, uint8_t channel, uint8_t rate);
+
 #endif /* WIFI_SNIFFER_H */ 
\ No newline at end of file
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""Decode the SLIP-framed UART capture stream into a pcap stream.
+
+Start the stream with /api/uart/start?baud=2000000, then pipe into Wireshark:
+
+    python3 tools/slip_decoder.py /dev/ttyUSB0 -b 2000000 | wireshark -k -i -
+
+or write a file with -o capture.pcap. Any serial device, pseudo-terminal
+or file works as input.
+"""
+
+import argparse
+import errno
+import os
+import struct
+import sys
+import termios
+import tty
+
+SLIP_END, SLIP_ESC, SLIP_ESC_END, SLIP_ESC_ESC = 0xC0, 0xDB, 0xDC, 0xDD
+FRAME_PCAP_HEADER, FRAME_PCAP_RECORD, FRAME_STATS = 1, 2, 3
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE, as in slip_frame.c."""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def slip_frames(fd):
+    """Yield unescaped frames between END markers."""
+    frame, escaped = bytearray(), False
+    while True:
+        try:
+            chunk = os.read(fd, 4096)
+        except OSError as err:
+            # A pty whose other end closed reports EIO instead of EOF
+            if err.errno == errno.EIO:
+                return
+            raise
+        if not chunk:
+            return
+        for byte in chunk:
+            if byte == SLIP_END:
+                if frame:
+                    yield bytes(frame)
+                frame, escaped = bytearray(), False
+            elif escaped:
+                frame.append(SLIP_END if byte == SLIP_ESC_END else SLIP_ESC if byte == SLIP_ESC_ESC else byte)
+                escaped = False
+            elif byte == SLIP_ESC:
+                escaped = True
+            else:
+                frame.append(byte)
+
+
+def open_input(path, baud):
+    fd = os.open(path, os.O_RDONLY | os.O_NOCTTY)
+    if os.isatty(fd):
+        tty.setraw(fd)
+        if baud:
+            attrs = termios.tcgetattr(fd)
+            speed = getattr(termios, "B%d" % baud)
+            attrs[4] = attrs[5] = speed
+            termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    return fd
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("device", help="serial port, pty or file to read")
+    parser.add_argument("-b", "--baud", type=int, default=2000000, help="baud rate (0 to leave as is)")
+    parser.add_argument("-o", "--output", default="-", help="pcap file to write, - for stdout")
+    args = parser.parse_args()
+
+    fd = open_input(args.device, args.baud)
+    out = sys.stdout.buffer if args.output == "-" else open(args.output, "wb")
+    stats = {"records": 0, "bad": 0, "lost": 0}
+    header_written, expected = False, None
+
+    try:
+        for frame in slip_frames(fd):
+            # Console noise and line errors fail the length or CRC check
+            if len(frame) < 7:
+                stats["bad"] += 1
+                continue
+            ftype, seq, length = struct.unpack_from("<BHH", frame)
+            if length != len(frame) - 7 or crc16(frame[:-2]) != struct.unpack_from("<H", frame, len(frame) - 2)[0]:
+                stats["bad"] += 1
+                continue
+            if expected is not None and seq != expected:
+                stats["lost"] += (seq - expected) & 0xFFFF
+            expected = (seq + 1) & 0xFFFF
+            content = frame[5:-2]
+
+            if ftype == FRAME_PCAP_HEADER:
+                if not header_written:
+                    out.write(content)
+                    header_written = True
+            elif ftype == FRAME_PCAP_RECORD and header_written:
+                out.write(content)
+                stats["records"] += 1
+            elif ftype == FRAME_STATS:
+                sent, dropped, device_dropped, logs = struct.unpack("<IIII", content)
+                print("device: {} sent, {} dropped (uart), {} dropped (buffer), {} log lines muted | "
+                      "host: {records} records, {lost} frames lost, {bad} bad".format(
+                          sent, dropped, device_dropped, logs, **stats), file=sys.stderr)
+            out.flush()
+    except (KeyboardInterrupt, BrokenPipeError):
+        pass
+    print("{records} records, {lost} frames lost, {bad} bad frames".format(**stats), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
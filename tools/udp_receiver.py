@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+"""Receive capture batches from the UDP export and write them to a pcap file.
+
+Start the export on the device with /api/export/udp/start?ip=<this host>&port=37020,
+then run:
+
+    python3 tools/udp_receiver.py -o capture.pcap
+
+The output can be opened in Wireshark while it grows (or piped live with -o -).
+"""
+
+import argparse
+import signal
+import socket
+import struct
+import sys
+
+MAGIC = 0x4B43344A
+VERSION = 1
+HEADER = struct.Struct("<IBBHII")
+# Classic pcap, microsecond timestamps, 802.11 with radiotap
+PCAP_HEADER = struct.pack("<IHHiIII", 0xA1B2C3D4, 2, 4, 0, 0, 4096, 127)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("-o", "--output", default="capture.pcap", help="pcap file to write, - for stdout")
+    parser.add_argument("-p", "--port", type=int, default=37020, help="UDP port to listen on")
+    parser.add_argument("-b", "--bind", default="0.0.0.0", help="address to listen on")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1 << 20)
+    sock.bind((args.bind, args.port))
+
+    out = sys.stdout.buffer if args.output == "-" else open(args.output, "wb")
+    out.write(PCAP_HEADER)
+    out.flush()
+
+    stats = {"batches": 0, "frames": 0, "lost": 0, "reordered": 0, "bad": 0, "device_dropped": 0}
+    expected = None
+
+    def report(*_):
+        print("\r{batches} batches, {frames} frames, {lost} batches lost, {reordered} late, "
+              "{bad} malformed, {device_dropped} dropped on device".format(**stats), file=sys.stderr)
+        if _:
+            out.close()
+            sys.exit(0)
+
+    signal.signal(signal.SIGINT, report)
+    signal.signal(signal.SIGTERM, report)
+    print("Listening on {}:{}".format(args.bind, args.port), file=sys.stderr)
+
+    while True:
+        data, _ = sock.recvfrom(65535)
+        if len(data) < HEADER.size:
+            stats["bad"] += 1
+            continue
+        magic, version, _, count, seq, dropped = HEADER.unpack_from(data)
+        if magic != MAGIC or version != VERSION:
+            stats["bad"] += 1
+            continue
+
+        # Sequence numbers count batches; a gap is a lost datagram
+        if expected is None or seq == expected:
+            pass
+        elif (seq - expected) & 0xFFFFFFFF < 0x80000000:
+            stats["lost"] += (seq - expected) & 0xFFFFFFFF
+        else:
+            stats["reordered"] += 1
+            stats["lost"] = max(0, stats["lost"] - 1)
+        if expected is None or (seq - expected) & 0xFFFFFFFF < 0x80000000:
+            expected = (seq + 1) & 0xFFFFFFFF
+
+        # Check the records before writing so a bad datagram cannot corrupt the file
+        offset, records = HEADER.size, 0
+        while offset + 16 <= len(data):
+            incl_len = struct.unpack_from("<I", data, offset + 8)[0]
+            offset += 16 + incl_len
+            records += 1
+        if offset != len(data) or records != count:
+            stats["bad"] += 1
+            continue
+
+        out.write(data[HEADER.size:])
+        out.flush()
+        stats["batches"] += 1
+        stats["frames"] += count
+        stats["device_dropped"] = dropped
+        if stats["batches"] % 100 == 0:
+            report()
+
+
+if __name__ == "__main__":
+    main()